@@ -24,7 +24,8 @@
 
 #define U_OPTIONS \
 "purpose 'application server by ULib' \n" \
-"option c config 1 'path of configuration file' ''\n"
+"option c config 1 'path of configuration file' ''\n" \
+"option s stat   1 'dump the statistics of a running server (path of STATISTICS_FILE)' ''\n"
 
 #include <ulib/application.h>
 
@@ -53,9 +54,33 @@ public:
 
       // manage options
 
-      UString cfg_str;
+      UString cfg_str, stat_str;
 
-      if (UApplication::isOptions()) cfg_str = opt['c'];
+      if (UApplication::isOptions())
+         {
+         cfg_str  = opt['c'];
+         stat_str = opt['s'];
+         }
+
+      // dump the statistics of a running server
+
+      if (stat_str)
+         {
+         UFile stat_file(stat_str);
+
+         if (stat_file.open() == false ||
+             stat_file.size() < (off_t)sizeof(UServer_Base::shared_data_child) ||
+             stat_file.memmap(PROT_READ) == false)
+            {
+            U_ERROR("Sorry, I can't map the statistics file %V", stat_str.rep);
+            }
+
+         UString x = UServer_Base::getStatistics((const UServer_Base::shared_data_child*)stat_file.getMap(), stat_file.getSize() / sizeof(UServer_Base::shared_data_child));
+
+         (void) write(STDOUT_FILENO, x.data(), x.size());
+
+         return;
+         }
 
       // manage file configuration
 
@@ -76,12 +101,16 @@ public:
       // ALLOWED_IP_PRIVATE    list of comma separated client private address for IP-based access control (IPADDR[/MASK]) for public server
       // ENABLE_RFC1918_FILTER reject request from private IP to public server address
       // MIN_SIZE_FOR_SENDFILE for major size it is better to use sendfile() to serve static content
+      // MIN_SIZE_FOR_ZEROCOPY for major size the body of the response is sent with MSG_ZEROCOPY (0 => disabled, default)
       //
       // LISTEN_BACKLOG             max number of ready to be delivered connections to accept()
       // SET_REALTIME_PRIORITY      flag indicating that the preforked processes will be scheduled under the real-time policies SCHED_FIFO
+      // TCP_REUSEPORT_BPF          flag indicating to steer (SO_REUSEPORT) new connection to the preforked process of the cpu that received it
+      // USE_IO_URING               flag indicating to use io_uring (if available) instead of epoll for the event notification
       // CLIENT_FOR_PARALLELIZATION min number of clients to active parallelization 
       //
       // PID_FILE       write pid on file indicated
+      // STATISTICS_FILE map the per-child statistics on file indicated (it can be dumped with the command 'userver -s <file>')
       // WELCOME_MSG    message of welcome to send initially to client
       // RUN_AS_USER    downgrade security to that user account
       // DOCUMENT_ROOT  The directory out of which you will serve your documents
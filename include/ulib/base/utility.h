@@ -148,6 +148,27 @@ U_EXPORT uint32_t    u_findEndHeader( const char* restrict s, uint32_t n) __pure
 U_EXPORT uint32_t    u_findEndHeader1(const char* restrict s, uint32_t n) __pure; /* find sequence of U_CRLF2 */
 U_EXPORT const char* u_get_mimetype(const char* restrict suffix, int* pmime_index);
 
+/**
+ * Scan in one pass the header of a HTTP message (it start after the U_CRLF of the first line): return the position after the sequence
+ * of U_CRLF2 (U_NOT_FOUND if missing) and store for every line the offset of the first ':' (U_NOT_FOUND if missing) and of the U_CRLF.
+ * If the lines are more than max we store nothing (*pnum = 0). The vector implementation (SSE2, AVX2) is selected at run-time by u_init_ulib()
+ */
+
+typedef struct uhttpline {
+   uint32_t colon, end;
+} uhttpline;
+
+typedef uint32_t (*uPFscanHeader)(const char* restrict s, uint32_t n, uhttpline* restrict vline, uint32_t max, uint32_t* restrict pnum);
+
+extern U_EXPORT uPFscanHeader u_scanHeader;
+
+U_EXPORT uint32_t u_scanHeader_c(   const char* restrict s, uint32_t n, uhttpline* restrict vline, uint32_t max, uint32_t* restrict pnum);
+#if defined(__SSE2__) && GCC_VERSION_NUM >= 40900
+#  define U_SCAN_HEADER_SIMD
+U_EXPORT uint32_t u_scanHeader_sse2(const char* restrict s, uint32_t n, uhttpline* restrict vline, uint32_t max, uint32_t* restrict pnum);
+U_EXPORT uint32_t u_scanHeader_avx2(const char* restrict s, uint32_t n, uhttpline* restrict vline, uint32_t max, uint32_t* restrict pnum);
+#endif
+
 U_EXPORT char*       u_memoryDump( char* restrict bp, unsigned char* restrict cp, uint32_t n);
 U_EXPORT uint32_t    u_memory_dump(char* restrict bp, unsigned char* restrict cp, uint32_t n);
 
@@ -79,6 +79,10 @@ public:
    bool open(const UString& path, uint32_t size,               const UString* environment = 0);
    bool open(const UString& path, const UString& dir_template, const UString* environment = 0, bool brdonly = false);
 
+   // USE a memory area as cache (f.e. the shared memory of the server, so that the cache is visible to all the preforked children)
+
+   void setMemory(char* ptr, uint32_t size);
+
    // OPERATION
 
    uint32_t getHSize(uint32_t size) const
@@ -236,6 +240,7 @@ protected:
 private:
    inline uint32_t hash(const char* key, uint32_t keylen) U_NO_EXPORT;
           void     init(UFile& _x, uint32_t size, bool bexist, bool brdonly) U_NO_EXPORT;
+          void   format(char* ptr, uint32_t size)                          U_NO_EXPORT;
 
 #ifdef U_COMPILER_DELETE_MEMBERS
    UCache(const UCache&) = delete;
@@ -80,6 +80,11 @@ public:
    virtual int handlerWrite()   { return U_NOTIFIER_DELETE; }
    virtual int handlerTimeout() { return U_NOTIFIER_DELETE; }
 
+   // NB: EPOLLERR is notified also when there is something in the error queue of the socket (ex: completion of a MSG_ZEROCOPY send),
+   //     if the method return U_NOTIFIER_OK the other events (if any) are processed as usual...
+
+   virtual int handlerError()   { return U_NOTIFIER_DELETE; }
+
    virtual void handlerDelete() { delete this; }
 
 #ifdef USE_LIBEVENT
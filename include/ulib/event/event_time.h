@@ -111,6 +111,7 @@ public:
 #endif
 
 protected:
+   UTimer* ptimer; // entry of the timer queue that hold us (if any)
    long tolerance;
 
    static long diff1, diff2;
@@ -123,7 +123,7 @@
 /**
  * HTTP header representation
  *
- * sizeof(struct uhttpinfo) 64bit == 144
+ * sizeof(struct uhttpinfo) 64bit == 160
  */
 
 typedef struct uhttpinfo {
@@ -138,9 +138,11 @@ typedef struct uhttpinfo {
    const char* user_agent;
    const char* content_type;
    const char* accept_language;
+   const char* if_none_match;
+   const char* if_match;
 
-   /* RESET == 52 */
-   uint16_t nResponseCode, cookie_len, referer_len, user_agent_len;
+   /* RESET == 56 */
+   uint16_t nResponseCode, cookie_len, referer_len, user_agent_len, if_none_match_len, if_match_len;
    uint32_t if_modified_since, startHeader, endHeader, clength, uri_len, query_len, method_type;
    unsigned char flag[16];
 } uhttpinfo;
@@ -235,7 +237,7 @@ extern U_EXPORT uclientimage_info u_clientimage_info;
 #define U_http_accept_language_len     u_clientimage_info.http_info.flag[15]
 
 #define U_HTTP_INFO_INIT(c)  (void) U_SYSCALL(memset, "%p,%d,%u", &(u_clientimage_info.http_info),               c, sizeof(uhttpinfo))
-#define U_HTTP_INFO_RESET(c) (void) U_SYSCALL(memset, "%p,%d,%u", &(u_clientimage_info.http_info.nResponseCode), c, 52)
+#define U_HTTP_INFO_RESET(c) (void) U_SYSCALL(memset, "%p,%d,%u", &(u_clientimage_info.http_info.nResponseCode), c, 56)
 
 #define U_HTTP_URI_TO_PARAM u_clientimage_info.http_info.uri, u_clientimage_info.http_info.uri_len
 #define U_HTTP_URI_TO_TRACE u_clientimage_info.http_info.uri_len, u_clientimage_info.http_info.uri
@@ -230,6 +230,7 @@ public:
       }
 
    bool isPrivate() __pure;
+   bool isLoopback() __pure;
    bool isWildCard() __pure;
 
    static UString toString(uint8_t* paddr);
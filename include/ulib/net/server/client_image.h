@@ -42,10 +42,14 @@ class UServer_Base;
 class UStreamPlugIn;
 class UBandWidthThrottling;
 
+template <class T> class UVector;
+
 template <class T> class UServer;
 
 #define U_ClientImage_idle(obj)   (obj)->UClientImage_Base::flag.c[0]
 #define U_ClientImage_pclose(obj) (obj)->UClientImage_Base::flag.c[1]
+#define U_ClientImage_rearm(obj)  (obj)->UClientImage_Base::flag.c[2]
+#define U_ClientImage_tunnel(obj) (obj)->UClientImage_Base::flag.c[3]
 
 #define U_ClientImage_request_is_cached UClientImage_Base::cbuffer[0]
 
@@ -68,17 +72,55 @@ public:
       {
       U_TRACE_NO_PARAM(0, "UClientImage_Base::isPendingSendfile()")
 
-      if (count > 0) U_RETURN(true);
+      if (count > 0 ||
+          sendfile_part_len) // NB: multipart/byteranges, the delimiter (maybe the close delimiter) is not yet sent...
+         {
+         U_RETURN(true);
+         }
 
       U_RETURN(false);
       }
 
+   // NB: the response can be written asynchronously by another handler of the event manager (ex: the connection to the server of mod_proxy),
+   //     in the meanwhile we don't read other request on this connection and the notification that the socket is writable is forwarded to it...
+
+   bool isAsyncResponse(UEventFd* item) const { return (async_response == item); }
+
+   void setAsyncResponse(UEventFd* item)
+      {
+      U_TRACE(0, "UClientImage_Base::setAsyncResponse(%p)", item)
+
+      U_INTERNAL_ASSERT_POINTER(item)
+      U_INTERNAL_ASSERT_EQUALS(count, 0)
+      U_INTERNAL_ASSERT_EQUALS(async_response, 0)
+
+      async_response = item;
+      }
+
+   // NB: in a tunnel (ex: WebSocket) also the notification that the socket is readable is forwarded to the handler of the response...
+
+   void setAsyncTunnel()
+      {
+      U_TRACE_NO_PARAM(0, "UClientImage_Base::setAsyncTunnel()")
+
+      U_INTERNAL_ASSERT_POINTER(async_response)
+
+      U_ClientImage_tunnel(this) = U_YES;
+      U_ClientImage_rearm(this)  = 0;
+      }
+
+   void  endAsyncResponse(bool bclose);
+   void waitForAsyncResponse(bool bwrite);
+
    // define method VIRTUAL of class UEventFd
 
    virtual int  handlerRead() U_DECL_OVERRIDE;
    virtual int  handlerWrite() U_DECL_FINAL;
    virtual int  handlerTimeout() U_DECL_FINAL;
    virtual void handlerDelete() U_DECL_FINAL;
+#ifdef U_ZEROCOPY_SUPPORT
+   virtual int  handlerError() U_DECL_FINAL;
+#endif
 
    static void setNoHeaderForResponse()
       {
@@ -366,10 +408,33 @@ protected:
    uint32_t min_limit, max_limit, started_at;
 #endif
    UString* data_pending;
-   uint32_t start, count;
+   UEventFd* async_response;
+   UString sendfile_part; // NB: multipart/byteranges with sendfile(): the next ranges of the file, each with the delimiter to write before it...
+   uint32_t start, count, sendfile_part_pos, sendfile_part_len; // NB: sendfile_part_len is the part of the delimiter not yet sent (it end at sendfile_part_pos)...
    int sfd;
    uucflag flag;
    time_t last_event;
+   UClientImage_Base* prev_idle; // NB: list of the connections ordered by last_event, so that the check
+   UClientImage_Base* next_idle; //     for idle connections costs only the number of expired connections...
+
+   static UClientImage_Base* first_idle;
+   static UClientImage_Base* last_idle;
+
+#ifdef U_ZEROCOPY_SUPPORT
+   uint32_t zc_next, zc_done; // NB: the kernel number the MSG_ZEROCOPY send of the socket, [zc_done,zc_next) are the send not completed
+   uint32_t zc_mask;          //     (the bit of the slot is set if the send is completed out of order)...
+   UStringRep* zc_rep[U_ZEROCOPY_MAX_PENDING]; // the body held until the completion of the send
+
+   static time_t zc_orphan_time;
+   static UVector<UString>* vzc_orphan[2]; // NB: after close() the kernel can still send the pages of the send not completed...
+
+   int  writeZeroCopy();
+   void releaseZeroCopy(bool bopen);
+   void readZeroCopyCompletion();
+#endif
+
+   void setLastEvent();
+   void removeFromIdleList();
 
    void   set();
    void reset()
@@ -378,9 +443,12 @@ protected:
 
       UEventFd::op_mask = EPOLLIN | EPOLLRDHUP | EPOLLET;
 
-      start =
-      count = 0;
-      sfd   = -1;
+      start             =
+      count             =
+      sendfile_part_len = 0;
+      sfd               = -1;
+
+      if (sendfile_part) sendfile_part.clear();
       }
 
    int manageRead()
@@ -431,6 +499,11 @@ protected:
       }
 
    static void setSendfile(int _sfd, uint32_t _start, uint32_t _count);
+   static void setSendfilePart(const UString& buffer);
+   static void addSendfilePart(UString& buffer, uint32_t _start, uint32_t _count, const char* delimiter, uint32_t len);
+
+   bool writeSendfilePart();
+   void nextSendfilePart();
 
 #ifndef U_LOG_DISABLE
    void logRequest();
@@ -444,6 +517,7 @@ protected:
    static UTimeVal* chronometer;
    static bool log_request_partial;
    static long time_between_request, time_run;
+   static uint64_t time_stat, time_phase; // start (in microseconds) of the request and of the current phase (statistics)
    static uint32_t ncount, nrequest, resto, uri_offset;
 
    static void resetReadBuffer();
@@ -453,6 +527,7 @@ protected:
 
    static void   endRequest();
    static bool startRequest();
+   static void setStatPhase(int phase);
 
    static void do_nothing() {}
 
@@ -488,6 +563,7 @@ private:
                       friend class UNoCatPlugIn;
                       friend class UServer_Base;
                       friend class UStreamPlugIn;
+                      friend class UProxyConnection;
                       friend class UBandWidthThrottling;
 
    template <class T> friend class UServer;
@@ -50,11 +50,15 @@ public:
 protected:
    static bool fcgi_keep_conn;
    static char environment_type;
+   static u_short request_id;
    static UClient_Base* connection;
+   static uint32_t fcgi_max_conns, fcgi_max_reqs, fcgi_mpxs_conns; // the limits of the application (see FCGI_GET_VALUES)
 
           void  set_FCGIBeginRequest();
    static void fill_FCGIBeginRequest(u_char type, u_short content_length);
 
+   static bool getValues();
+
 private:
 #ifdef U_COMPILER_DELETE_MEMBERS
    UFCGIPlugIn(const UFCGIPlugIn&) = delete;
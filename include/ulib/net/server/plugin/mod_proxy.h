@@ -15,9 +15,170 @@
 #define U_MOD_PROXY_H 1
 
 #include <ulib/net/tcpsocket.h>
+#include <ulib/event/event_time.h>
 #include <ulib/net/client/http.h>
 #include <ulib/net/server/server_plugin.h>
 
+class UProxyPlugIn;
+class UProxyUpstream;
+class UProxyConnection;
+class UModProxyService;
+class UClientImage_Base;
+
+/**
+ * splice() (linux): the body of the response is moved from the socket of the server to the socket of the client through a pipe,
+ * without copy in user space (not possible if the client is SSL). We use it only if there are enough data to relay...
+ */
+
+#if defined(U_LINUX) && defined(SPLICE_F_MOVE)
+#  define U_PROXY_SPLICE_SUPPORT
+#  define U_PROXY_PIPE_SIZE            (64U * 1024U)
+#  define U_PROXY_MIN_SIZE_FOR_SPLICE  (64U * 1024U)
+#endif
+
+/**
+ * The timer of the response of the server: if the header of the response don't arrive within RESPONSE_TIMEOUT seconds from the
+ * request the server is considered failed (see UProxyConnection::handlerTimeout())...
+ */
+
+class U_EXPORT UProxyTimeout : public UEventTime {
+public:
+
+   // COSTRUTTORI
+
+   UProxyTimeout(UProxyConnection* _conn, long sec) : UEventTime(sec, 0L)
+      {
+      U_TRACE_REGISTER_OBJECT(0, UProxyTimeout, "%p,%ld", _conn, sec)
+
+      conn = _conn;
+      }
+
+   virtual ~UProxyTimeout() U_DECL_FINAL
+      {
+      U_TRACE_UNREGISTER_OBJECT(0, UProxyTimeout)
+      }
+
+   // define method VIRTUAL of class UEventTime
+
+   virtual int handlerTime() U_DECL_FINAL;
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool _reset) const { return UEventTime::dump(_reset); }
+#endif
+
+protected:
+   UProxyConnection* conn;
+
+private:
+   UProxyTimeout(const UProxyTimeout&) : UEventTime() {}
+   UProxyTimeout& operator=(const UProxyTimeout&)     { return *this; }
+};
+
+/**
+ * Connection (not blocking) to the server of a proxy service: the request is sent and the response is read when the event manager
+ * notify us that the socket is ready, and every block of the response is written to the client as soon as it arrive (if the client
+ * is not writable we stop to read from the server until it become writable again). At the end of the response (we follow the framing
+ * of HTTP/1.1: Content-Length, chunked or close) the connection return in the pool of the server (of the upstream group of the service)
+ * to be reused by the next request.
+ * If the server switch protocol (101, ex: WebSocket) the connection become a tunnel and the data are relayed in both directions...
+ */
+
+class U_EXPORT UProxyConnection : public UEventFd {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   // COSTRUTTORI
+
+            UProxyConnection(UModProxyService* _service);
+   virtual ~UProxyConnection();
+
+   // define method VIRTUAL of class UEventFd
+
+   virtual int  handlerRead() U_DECL_FINAL;
+   virtual int  handlerWrite() U_DECL_FINAL;
+   virtual int  handlerTimeout() U_DECL_FINAL;
+   virtual void handlerDelete() U_DECL_FINAL;
+
+   // SERVICES
+
+   static bool sendRequest(UModProxyService* _service, UClientImage_Base* _client, const UString& _request, bool _bhead, bool _bclose, uint32_t _nretry = 0);
+
+   // DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   enum State {
+      IDLE          = 0, // connected to the server and not in use
+      CONNECT       = 1, // waiting for the completion of the connect()
+      REQUEST       = 2, // sending the request
+      HEADER        = 3, // reading the header of the response
+      BODY          = 4, // reading a body with Content-Length
+      BODY_TO_CLOSE = 5, // reading a body delimited by the close of the connection
+      CHUNK_SIZE    = 6, // reading the line with the size of a chunk
+      CHUNK_DATA    = 7, // reading the data of a chunk (with the CRLF that follow)
+      CHUNK_TRAILER = 8, // reading the trailer after the last chunk
+      DONE          = 9, // the response is complete
+      TUNNEL        = 10 // switched protocol (101), relaying in both directions until one of the sides close
+   };
+
+   UTCPSocket socket;
+   UString request, header, pending;
+   UModProxyService* service;
+   UProxyUpstream* peer; // the server of the upstream group
+   UClientImage_Base* client;
+   UProxyConnection* next;
+   UProxyTimeout timer; // the timer of the response of the server (if RESPONSE_TIMEOUT is set)
+   uint64_t remain; // number of bytes of the body (or of the chunk) still to read
+   uint32_t sent, nline, nrequest, npipe, nretry; // npipe: number of bytes in the pipe not yet written to the client
+   int state, pipefd[2];
+   bool bhead, bclose, bkeep_alive, bchunk_ext, bresponse, bactive, btimeout; // bactive: the connection is counted as in use by the server
+
+   bool connect();
+   bool relay();
+   bool flush();
+   bool retry();
+   bool finish();
+   bool upstream();
+   void release();
+   void abortResponse();
+   bool write(const char* ptr, uint32_t len);
+   bool start(UClientImage_Base* _client, const UString& _request, bool _bhead, bool _bclose);
+
+   bool     parseHeader(const char* ptr, uint32_t len);
+   uint32_t parseResponse(const char* ptr, uint32_t len);
+
+#ifdef U_PROXY_SPLICE_SUPPORT
+   bool drain();
+   bool splice();
+   bool isSplice();
+#endif
+
+   static UProxyConnection* get(UModProxyService* _service);
+
+private:
+#ifdef U_COMPILER_DELETE_MEMBERS
+   UProxyConnection(const UProxyConnection&) = delete;
+   UProxyConnection& operator=(const UProxyConnection&) = delete;
+#else
+   UProxyConnection(const UProxyConnection&) : UEventFd(), timer(0, 0L) {}
+   UProxyConnection& operator=(const UProxyConnection&)   { return *this; }
+#endif
+
+   friend class UProxyPlugIn;
+   friend class UProxyTimeout;
+   friend class UProxyUpstream;
+   friend class UModProxyService;
+};
+
 class U_EXPORT UProxyPlugIn : public UServerPlugIn {
 public:
 
@@ -35,6 +196,8 @@ public:
 
    virtual int handlerConfig(UFileConfig& cfg) U_DECL_FINAL;
    virtual int handlerInit() U_DECL_FINAL;
+   virtual int handlerRun() U_DECL_FINAL;
+   virtual int handlerFork() U_DECL_FINAL;
 
    // Connection-wide hooks
 
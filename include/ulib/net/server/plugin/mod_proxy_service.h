@@ -14,7 +14,7 @@
 #ifndef U_MOD_PROXY_SERVICE_H
 #define U_MOD_PROXY_SERVICE_H 1
 
-#include <ulib/internal/common.h>
+#include <ulib/net/ipaddress.h>
 
 #ifdef USE_LIBPCRE
 #  include <ulib/pcre/pcre.h>
@@ -23,6 +23,11 @@
 class UHTTP;
 class UCommand;
 class UFileConfig;
+class UProxyPlugIn;
+class UProxyUpstream;
+class UProxyHealthProbe;
+class UProxyHealthCheck;
+class UProxyConnection;
 
 class U_EXPORT UModProxyService {
 public:
@@ -47,6 +52,13 @@ public:
       ERROR_A_X509_NOBASICAUTH  = 10
    };
 
+   enum Balance {
+      ROUND_ROBIN = 0, // weighted round-robin (default)
+      LEAST_CONN  = 1, // the server with less connections in use (respect to its weight)
+      HASH_URI    = 2, // consistent hash of the uri
+      HASH_COOKIE = 3  // consistent hash of the value of a cookie (round-robin if the request don't have it)
+   };
+
    // COSTRUTTORI
 
     UModProxyService();
@@ -59,6 +71,7 @@ public:
    UString getServer() const;
    UString getPassword() const       { return password; }
 
+   bool isAsync() const              { return async; }
    bool isWebSocket() const          { return websocket; }
    bool isReplaceResponse() const    { return (vreplace_response.empty() == false); }
    bool isFollowRedirects() const    { return follow_redirects; }
@@ -94,6 +107,14 @@ public:
 
    static UModProxyService* findService(const UString& host, const UString& uri) { return findService(U_STRING_TO_PARAM(host), U_STRING_TO_PARAM(uri)); }
 
+   // UPSTREAM GROUP
+
+   UProxyUpstream* getUpstream(); // select the server of the group for the current request (0 if the server to connect change at runtime)
+
+   static void mapUpstreamData();
+   static void allocUpstreamData();
+   static void startHealthCheck();
+
    // DEBUG
 
 #if defined(U_STDCPP_ENABLE) && defined(DEBUG)
@@ -110,7 +131,26 @@ protected:
    UString uri_mask;
 #endif
    int port, method_mask;
-   bool request_cert, follow_redirects, response_client, websocket;
+   bool request_cert, follow_redirects, response_client, websocket, async;
+
+   // NB: the connections kept alive (not in use) of this process are in the pool of every server of the group, here we have the unconnected ones...
+
+   UProxyConnection* unused;
+   uint32_t pool_size;
+
+   UVector<UProxyUpstream*> vupstream;
+   UString hash_cookie, health_check_uri;
+   uint64_t* vring; // NB: the ring of the consistent hash (hash << 32 | index of the server)...
+   uint32_t nring, rr_index, max_fails, fail_timeout, response_timeout, health_check_interval;
+   int balance;
+
+   static void* upstream_data; // NB: the state of the servers of the groups is shared between the processes...
+   static uint32_t nupstream;
+
+   void buildRing();
+   bool addUpstream(const UString& x);
+
+   UProxyUpstream* getUpstreamByHash(const char* key, uint32_t key_len) __pure;
 
 private:
 #ifdef U_COMPILER_DELETE_MEMBERS
@@ -120,6 +160,97 @@ private:
 #endif
 
    friend class UHTTP;
+   friend class UProxyUpstream;
+   friend class UProxyHealthProbe;
+   friend class UProxyHealthCheck;
+   friend class UProxyConnection;
+};
+
+/**
+ * A server of the upstream group of a service: it keep the pool of the connections kept alive of this process, and the state that
+ * is shared between the processes. The server is ejected for FAIL_TIMEOUT seconds after MAX_FAILS consecutive failures (connect,
+ * error or timeout), and if HEALTH_CHECK_URI is set it is probed every HEALTH_CHECK_INTERVAL seconds (see UProxyHealthCheck)...
+ */
+
+class U_EXPORT UProxyUpstream {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // Allocator e Deallocator
+   U_MEMORY_ALLOCATOR
+   U_MEMORY_DEALLOCATOR
+
+   typedef struct upstream_data {
+      long     down_until; // passive ejection (until this time)
+      uint32_t nfail;      // consecutive failures
+      uint32_t bdown;      // active health check failed
+   } upstream_data;
+
+   // COSTRUTTORI
+
+    UProxyUpstream(UModProxyService* _service, const UString& _server, int _port, uint32_t _weight);
+   ~UProxyUpstream();
+
+   // SERVICES
+
+   int     getPort() const   { return port; }
+   UString getServer() const { return server; }
+
+   bool isAvailable() const
+      {
+      U_TRACE_NO_PARAM(0, "UProxyUpstream::isAvailable()")
+
+      U_INTERNAL_DUMP("bdown = %u down_until = %ld", data->bdown, data->down_until)
+
+      if (data->bdown == 0 &&
+          data->down_until <= u_now->tv_sec)
+         {
+         U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+
+   void setSuccess()
+      {
+      U_TRACE_NO_PARAM(0, "UProxyUpstream::setSuccess()")
+
+      if (data->nfail) data->nfail = 0; // NB: we avoid to write the shared memory if not needed...
+      }
+
+   void setFailure();
+   void setHealth(bool bup);
+
+   // DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+   const char* dump(bool reset) const;
+#endif
+
+protected:
+   upstream_data local;
+   UIPAddress addr;
+   UString server;
+   UModProxyService* service;
+   UProxyConnection* idle;
+   upstream_data* data;
+   uint32_t nidle, nactive, weight, index; // NB: nactive is the number of connections in use of this process (for LEAST_CONN)...
+   int port, current_weight;
+
+private:
+#ifdef U_COMPILER_DELETE_MEMBERS
+   UProxyUpstream& operator=(const UProxyUpstream&) = delete;
+#else
+   UProxyUpstream& operator=(const UProxyUpstream&) { return *this; }
+#endif
+
+   friend class UProxyPlugIn;
+   friend class UModProxyService;
+   friend class UProxyHealthProbe;
+   friend class UProxyHealthCheck;
+   friend class UProxyConnection;
 };
 
 #endif
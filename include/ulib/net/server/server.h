@@ -113,6 +113,7 @@ class UProxyPlugIn;
 class UDataStorage;
 class UStreamPlugIn;
 class UModNoCatPeer;
+class UClientQueue;
 class UClientThread;
 class UHttpClient_Base;
 class UWebSocketPlugIn;
@@ -144,14 +145,18 @@ public:
    // ALLOWED_IP_PRIVATE    list of comma separated client private address for IP-based access control (IPADDR[/MASK]) for public server
    // ENABLE_RFC1918_FILTER reject request from private IP to public server address
    // MIN_SIZE_FOR_SENDFILE for major size it is better to use sendfile() to serve static content
+   // MIN_SIZE_FOR_ZEROCOPY for major size the body of the response is sent with MSG_ZEROCOPY (0 => disabled, default)
    //
    // LISTEN_BACKLOG             max number of ready to be delivered connections to accept()
    // SET_REALTIME_PRIORITY      flag indicating that the preforked processes will be scheduled under the real-time policies SCHED_FIFO
+   // TCP_REUSEPORT_BPF          flag indicating to steer (SO_REUSEPORT) new connection to the preforked process of the cpu that received it
+   // USE_IO_URING               flag indicating to use io_uring (if available) instead of epoll for the event notification
    //
    // CLIENT_THRESHOLD           min number of clients to active polling
    // CLIENT_FOR_PARALLELIZATION min number of clients to active parallelization 
    //
    // PID_FILE      write pid on file indicated
+   // STATISTICS_FILE map the per-child statistics on file indicated (it can be dumped with the command 'userver -s <file>')
    // WELCOME_MSG   message of welcome to send initially to client
    // RUN_AS_USER   downgrade the privileges to that of user account
    // DOCUMENT_ROOT The directory out of which you will serve your documents
@@ -251,7 +256,7 @@ public:
    // ----------------------------------------------------------------------------------------------------------------------------
    // Manage process server
    // ----------------------------------------------------------------------------------------------------------------------------
-   // PREFORK_CHILD number of child server processes created at startup: -1 - thread approach (experimental)
+   // PREFORK_CHILD number of child server processes created at startup: -1 - thread approach (accept and event loop thread)
    //                                                                     0 - serialize, no forking
    //                                                                     1 - classic, forking after client accept
    //                                                                    >1 - pool of serialized processes plus monitoring process
@@ -286,12 +291,14 @@ public:
       sem_t lock_rdb_server;
       sem_t lock_data_session;
       sem_t lock_db_not_found;
+      sem_t lock_micro_cache;
       char spinlock_user1[1];
       char spinlock_user2[1];
       char spinlock_throttling[1];
       char spinlock_rdb_server[1];
       char spinlock_data_session[1];
       char spinlock_db_not_found[1];
+      char spinlock_micro_cache[1];
 #  ifdef USE_LIBSSL
       sem_t    lock_ssl_session;
       char spinlock_ssl_session[1];
@@ -336,6 +343,7 @@ public:
 #define U_SRV_LOCK_SSL_SESSION    &(UServer_Base::ptr_shared_data->lock_ssl_session)
 #define U_SRV_LOCK_DATA_SESSION   &(UServer_Base::ptr_shared_data->lock_data_session)
 #define U_SRV_LOCK_DB_NOT_FOUND   &(UServer_Base::ptr_shared_data->lock_db_not_found)
+#define U_SRV_LOCK_MICRO_CACHE    &(UServer_Base::ptr_shared_data->lock_micro_cache)
 #define U_SRV_SPINLOCK_USER1        UServer_Base::ptr_shared_data->spinlock_user1
 #define U_SRV_SPINLOCK_USER2        UServer_Base::ptr_shared_data->spinlock_user2
 #define U_SRV_SPINLOCK_THROTTLING   UServer_Base::ptr_shared_data->spinlock_throttling
@@ -343,11 +351,130 @@ public:
 #define U_SRV_SPINLOCK_SSL_SESSION  UServer_Base::ptr_shared_data->spinlock_ssl_session
 #define U_SRV_SPINLOCK_DATA_SESSION UServer_Base::ptr_shared_data->spinlock_data_session
 #define U_SRV_SPINLOCK_DB_NOT_FOUND UServer_Base::ptr_shared_data->spinlock_db_not_found
+#define U_SRV_SPINLOCK_MICRO_CACHE  UServer_Base::ptr_shared_data->spinlock_micro_cache
+
+   // NB: per-child data, one slot for every preforked process (it is allocated after the shared_data struct or on STATISTICS_FILE)...
+   //     The statistics are always on: the slot is updated only by the process that own it with relaxed atomic add (no lock), it is
+   //     padded to the cache line to avoid false sharing between the processes and it is aggregated lock-free by the reader (that can
+   //     see a counter not yet updated, never a torn one). The latency of every phase of the request is recorded (in microseconds) on a
+   //     log-linear histogram: U_STAT_SUB_BUCKET linear sub-buckets for every power of 2 (relative error <= 12.5%, 1us ... ~2min)
+
+#  define U_STAT_CACHE_LINE  64
+#  define U_STAT_SUB_BUCKET   8
+#  define U_STAT_NUM_BUCKET (U_STAT_SUB_BUCKET * 25)
+
+   enum StatPhaseType {
+      STAT_READ    = 0, // read of the request
+      STAT_PROCESS = 1, // processing of the request (plugins)
+      STAT_WRITE   = 2, // write of the response
+      STAT_TOTAL   = 3, // from the read of the request to the end of processing
+      STAT_NUM_PHASE
+   };
+
+   typedef struct shared_data_child {
+      pid_t    pid;
+      uint32_t cnt_accept;
+      uint32_t cnt_active;       // active connections
+      uint32_t cnt_error_accept;
+      uint32_t cnt_error_read;
+      uint32_t cnt_error_write;
+      uint32_t cnt_fcgi_wait;    // requests waiting the response of the FastCGI application (the sum on the children is the depth of its queue)
+      uint32_t cnt_fcgi_error;   // requests to the FastCGI application failed
+      uint64_t cnt_request;
+      uint64_t cnt_bytes_read;
+      uint64_t cnt_bytes_write;
+      uint64_t cnt_bytes_splice; // bytes written with splice() (without copy in user space, ex: the body relayed by mod_proxy)
+      uint64_t cnt_fcgi_request; // requests forwarded to the FastCGI application (mod_fcgi)
+      uint64_t cnt_micro_hit;    // dynamic responses served by the micro cache
+      uint64_t cnt_micro_stale;  // dynamic responses served stale by the micro cache while another process regenerate them
+      uint64_t cnt_micro_miss;   // dynamic responses generated and stored in the micro cache
+      uint64_t cnt_bytes_saved[3]; // bytes not sent serving the compressed variants of the file cache (gzip, brotli, zstd)
+      uint64_t cnt_file_hit;     // requests served with the content of the file cache in memory (CACHE_FILE_MEMORY)
+      uint64_t cnt_file_miss;    // requests of file that can be cached but that are not in memory
+      uint64_t cnt_file_evict;   // entries of the file cache whose content is evicted from memory
+      uint64_t cnt_status[6];    // 1xx, 2xx, 3xx, 4xx, 5xx, other (not HTTP)
+      uint64_t histogram[STAT_NUM_PHASE][U_STAT_NUM_BUCKET];
+   } __attribute__((aligned(U_STAT_CACHE_LINE))) shared_data_child;
+
+#define U_SRV_CHILD(i)              UServer_Base::ptr_shared_child[(i)]
+#define U_SRV_CNT_ACCEPT            UServer_Base::ptr_shared_child[UServer_Base::child_index].cnt_accept
+
+#ifdef HAVE_GCC_ATOMICS
+#  define U_SRV_STAT_ADD(field,n)   (void) __atomic_fetch_add(&(UServer_Base::ptr_shared_child[UServer_Base::child_index].field), (n), __ATOMIC_RELAXED)
+#  define U_SRV_STAT_SUB(field,n)   (void) __atomic_fetch_sub(&(UServer_Base::ptr_shared_child[UServer_Base::child_index].field), (n), __ATOMIC_RELAXED)
+#  define U_SRV_STAT_GET(x)                __atomic_load_n(&(x), __ATOMIC_RELAXED)
+#else
+#  define U_SRV_STAT_ADD(field,n)   UServer_Base::ptr_shared_child[UServer_Base::child_index].field += (n)
+#  define U_SRV_STAT_SUB(field,n)   UServer_Base::ptr_shared_child[UServer_Base::child_index].field -= (n)
+#  define U_SRV_STAT_GET(x)         (x)
+#endif
+
+   static uint64_t getStatTime() // monotonic clock in microseconds
+      {
+      U_TRACE_NO_PARAM(0, "UServer_Base::getStatTime()")
+
+      struct timespec ts;
+
+      (void) U_SYSCALL(clock_gettime, "%d,%p", CLOCK_MONOTONIC, &ts);
+
+      U_RETURN((uint64_t)ts.tv_sec * 1000000ULL + (ts.tv_nsec / 1000L));
+      }
+
+   static uint32_t getStatBucket(uint64_t usec)
+      {
+      U_TRACE(0, "UServer_Base::getStatBucket(%llu)", usec)
+
+      if (usec < U_STAT_SUB_BUCKET) U_RETURN((uint32_t)usec);
+
+      uint32_t e = 63 - __builtin_clzll(usec), // floor(log2(usec)) >= 3
+               b = ((e - 2) * U_STAT_SUB_BUCKET) + ((usec >> (e - 3)) & (U_STAT_SUB_BUCKET - 1));
+
+      if (b >= U_STAT_NUM_BUCKET) b = U_STAT_NUM_BUCKET - 1;
+
+      U_RETURN(b);
+      }
+
+   static uint64_t getStatBucketValue(uint32_t b) // lower bound (in microseconds) of the bucket
+      {
+      U_TRACE(0, "UServer_Base::getStatBucketValue(%u)", b)
+
+      if (b < U_STAT_SUB_BUCKET) U_RETURN(b);
+
+      uint64_t value = (uint64_t)(U_STAT_SUB_BUCKET + (b % U_STAT_SUB_BUCKET)) << ((b / U_STAT_SUB_BUCKET) - 1);
+
+      U_RETURN(value);
+      }
+
+   static void statLatency(int phase, uint64_t usec)
+      {
+      U_TRACE(0, "UServer_Base::statLatency(%d,%llu)", phase, usec)
+
+      U_INTERNAL_ASSERT_RANGE(0, phase, STAT_NUM_PHASE-1)
+
+      U_SRV_STAT_ADD(histogram[phase][getStatBucket(usec)], 1);
+      }
+
+   static void statRequest(uint32_t status, uint64_t usec)
+      {
+      U_TRACE(0, "UServer_Base::statRequest(%u,%llu)", status, usec)
+
+      uint32_t k = status / 100;
+
+      U_SRV_STAT_ADD(cnt_request, 1);
+      U_SRV_STAT_ADD(cnt_status[k >= 1 && k <= 5 ? k-1 : 5], 1);
+
+      statLatency(STAT_TOTAL, usec);
+      }
+
+   static UString getStatistics(); // aggregate the statistics of all the children (used by HTTP status endpoint)
+   static UString getStatistics(const shared_data_child* vchild, uint32_t n);
 
    static ULock* lock_user1;
    static ULock* lock_user2;
    static int preforked_num_kids; // keeping a pool of children and that they accept connections themselves
    static shared_data* ptr_shared_data;
+   static shared_data_child* ptr_shared_child;
+   static uint32_t child_index; // slot of this process in ptr_shared_child
    static uint32_t shared_data_add, map_size;
    static bool update_date, update_date1, update_date2, update_date3;
 
@@ -499,7 +626,7 @@ public:
 
    static char* client_address;
    static int iAddressType, socket_flags, tcp_linger_set;
-   static uint32_t client_address_len, min_size_for_sendfile;
+   static uint32_t client_address_len, min_size_for_sendfile, min_size_for_zerocopy;
 
 #define U_CLIENT_ADDRESS_TO_PARAM  UServer_Base::client_address, UServer_Base::client_address_len
 #define U_CLIENT_ADDRESS_TO_TRACE  UServer_Base::client_address_len, UServer_Base::client_address
@@ -557,7 +684,8 @@ protected:
    static UString* cenvironment;
    static UString* senvironment;
    static UString* str_preforked_num_kids;
-   static bool flag_sigterm, monitoring_process, set_realtime_priority, public_address, binsert, set_tcp_keep_alive, called_from_handlerTime;
+   static UString* statistics_file; // map the per-child statistics on file (to be read by external tool)
+   static bool flag_sigterm, monitoring_process, set_realtime_priority, public_address, binsert, set_tcp_keep_alive, set_tcp_reuseport_bpf, called_from_handlerTime;
 
 
    static uint32_t                 vplugin_size;
@@ -569,6 +697,13 @@ protected:
    static void loadConfigParam();
    static void runLoop(const char* user);
    static bool handlerTimeoutConnection(void* cimg);
+   static void handlerTimeoutIdleConnection();
+
+#if defined(ENABLE_THREAD) && !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
+   static UClientQueue* client_queue; // NB: new connection accepted by the main thread for the event loop thread (PREFORK_CHILD == -1)
+
+   static void handlerNewClient(UClientImage_Base* ptr) U_NO_EXPORT;
+#endif
 
 #ifdef U_WELCOME_SUPPORT
    static UString* msg_welcome;
@@ -593,6 +728,8 @@ protected:
    static UString getStats();
 #endif
 
+   static UString getAcceptStats();
+
 #ifdef U_THROTTLING_SUPPORT
    static bool         throttling_chk;
    static UEventTime*  throttling_time;
@@ -677,6 +814,7 @@ private:
    friend class UGeoIPPlugIn;
    friend class UClient_Base;
    friend class UStreamPlugIn;
+   friend class UClientQueue;
    friend class UClientThread;
    friend class UModNoCatPeer;
    friend class UHttpClient_Base;
@@ -687,6 +825,7 @@ private:
    friend class UBandWidthThrottling;
 
    static void manageSigHUP() U_NO_EXPORT;
+   static void waitForEvent() U_NO_EXPORT;
    static bool clientImageHandlerRead() U_NO_EXPORT;
    static void logMemUsage(const char* signame) U_NO_EXPORT;
    static void loadStaticLinkedModules(const char* name) U_NO_EXPORT;
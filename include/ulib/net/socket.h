@@ -25,6 +25,9 @@
 #  if defined(U_LINUX) && !defined(SO_INCOMING_CPU)
 #     define SO_INCOMING_CPU 49
 #  endif
+#  if defined(U_LINUX) && !defined(SO_ATTACH_REUSEPORT_EBPF)
+#     define SO_ATTACH_REUSEPORT_EBPF 52
+#  endif
 #endif
 
 #include <errno.h>
@@ -650,6 +653,7 @@ protected:
    void setMsgError();
    void setReusePort();
    void setReuseAddress();
+   void setReusePortBPF();
    void setAddress(void* address);
    void setLocal(const UIPAddress& addr);
    bool setHostName(const UString& pcNewHostName);
@@ -671,8 +675,12 @@ protected:
    void _closesocket();
 
    static SocketAddress* cLocal;
-   static bool tcp_reuseport, bincoming_cpu;
+   static bool tcp_reuseport, bincoming_cpu, breuseport_bpf;
    static int iBackLog, incoming_cpu, accept4_flags; // If flags is 0, then accept4() is the same as accept()
+   static int reuseport_map, reuseport_prog; // socket array (slot of the preforked process -> listening socket) and program for the cpu steering (bpf)
+   static uint32_t reuseport_group, reuseport_slot; // number of preforked process that share the port (SO_REUSEPORT) and slot of this process
+
+   static bool createReusePortBPF(uint32_t group, uint32_t ncpu);
 
    /**
     * The _socket() function is called to create the socket of the specified type.
@@ -700,6 +708,8 @@ private:
                       friend class UClient_Base;
                       friend class UServer_Base;
                       friend class UStreamPlugIn;
+                      friend class UProxyConnection;
+                      friend class UProxyHealthProbe;
                       friend class URDBClientImage;
                       friend class UHttpClient_Base;
                       friend class UWebSocketPlugIn;
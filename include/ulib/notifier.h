@@ -33,6 +33,25 @@
 #  endif
 #endif
 
+/**
+ * io_uring (linux >= 5.13): the readiness of the fd is notified by multishot poll requests (with the same mask of epoll) and
+ * the registration of the new fd are queued in the submission ring, so that they are submitted together with the wait for events
+ * in a single io_uring_enter() (it is selectable at runtime, if the kernel don't support it we fall back to epoll)
+ */
+
+#if defined(U_IO_URING_SUPPORT) && (!defined(HAVE_EPOLL_WAIT) || defined(USE_LIBEVENT) || !defined(U_LINUX))
+#  undef U_IO_URING_SUPPORT
+#endif
+
+#ifdef U_IO_URING_SUPPORT
+#  include <linux/io_uring.h>
+#  ifndef IORING_POLL_ADD_MULTI
+#     undef U_IO_URING_SUPPORT
+#  else
+#     define U_IO_URING_SQ_SIZE 1024
+#  endif
+#endif
+
 #ifndef EPOLLEXCLUSIVE // Provides exclusive wakeups when attaching multiple epoll fds to a shared wakeup source
 #define EPOLLEXCLUSIVE 0 // (1 << 28)
 #endif
@@ -123,6 +142,19 @@ public:
 
    static void batch((UEventFd* handler_event);
 # endif
+
+# ifdef U_IO_URING_SUPPORT
+   static bool bio_uring; // flag indicating to use io_uring instead of epoll (runtime)
+
+   static bool isIOUring()
+      {
+      U_TRACE_NO_PARAM(0, "UNotifier::isIOUring()")
+
+      if (ring_fd > 0) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+# endif
 #else
    static void init(bool bacquisition)
       {
@@ -220,6 +252,23 @@ protected:
    static int ctl_cmd_cnt;
    static struct epoll_ctl_cmd ctl_cmd[U_EPOLL_CTL_CMD_SIZE];
 #  endif
+#  ifdef U_IO_URING_SUPPORT
+   static int ring_fd;
+   static void* ring_ptr[2];
+   static size_t ring_sz[2];
+   static struct io_uring_sqe* sqes;
+   static struct io_uring_cqe* cqes;
+   static uint32_t sq_mask, cq_mask, sq_tail_local, sq_to_submit;
+   static uint32_t *sq_head, *sq_tail, *sq_array, *cq_head, *cq_tail;
+
+   static bool ringInit();
+   static void ringClose();
+   static void ringSubmit();
+   static void ringPollAdd(UEventFd* item);
+   static void ringPollRemove(UEventFd* item);
+   static void ringWaitForEvent(UEventTime* ptimeout);
+   static struct io_uring_sqe* ringGetSqe();
+#  endif
 # elif defined(HAVE_KQUEUE)
    static int kq, nkqevents;
    static struct kevent* kqevents;
@@ -252,22 +301,29 @@ protected:
 private:
    static void handlerDelete(int fd, int mask);
 
+#if defined(HAVE_EPOLL_WAIT) && !defined(USE_LIBEVENT)
+   static bool isEventError(uint32_t revents)
+      {
+      U_TRACE(0, "UNotifier::isEventError(%B)", revents)
+
+      U_INTERNAL_ASSERT_POINTER(handler_event)
+
+      if ((revents & EPOLLHUP) != 0 ||
+          handler_event->handlerError() == U_NOTIFIER_DELETE)
+         {
+         U_RETURN(true);
+         }
+
+      U_RETURN(false);
+      }
+#endif
+
 #ifndef USE_LIBEVENT
    static void notifyHandlerEvent() U_NO_EXPORT;
 #endif
 
 #if defined(ENABLE_THREAD) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
-   static UThread* pthread;
-# ifdef _MSWINDOWS_
-   static CRITICAL_SECTION mutex;
-# else
-   static pthread_mutex_t mutex;
-# endif
-   static void   lock() { if (pthread) UThread::lock(&mutex); }
-   static void unlock() { if (pthread) UThread::unlock(&mutex); }
-#else
-   static void   lock() {}
-   static void unlock() {}
+   static UThread* pthread; // NB: the event loop thread (PREFORK_CHILD == -1) is the only one that use the event manager...
 #endif
 
 #ifdef U_COMPILER_DELETE_MEMBERS
@@ -285,6 +341,7 @@ private:
    friend class USocketExt;
    friend class UHttpPlugIn;
    friend class UServer_Base;
+   friend class UProxyConnection;
    friend class UClientImage_Base;
    friend class UClientThrottling;
 };
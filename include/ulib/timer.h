@@ -19,7 +19,18 @@
 
 class UNotifier;
 
-// UNotifier use this class to notify a timeout from select()
+/**
+ * UNotifier use this class to notify a timeout from select()
+ *
+ * The timers are kept in a hashed timing wheel: every timer is mapped on a tick (granularity of 2^U_TIMER_TICK_SHIFT ms)
+ * and the timers that expire after the current horizon are stored unsorted in the slot (tick % U_TIMER_WHEEL_SIZE) of the
+ * wheel, while the timers that expire within the horizon (usually a single tick) are kept in a (short) list sorted by expire
+ * time whose head is always the nearest timer. In this way insert and erase are O(1) whatever the number of active timers...
+ */
+
+#define U_TIMER_TICK_SHIFT  4    // ~16ms
+#define U_TIMER_WHEEL_SIZE  4096 // ~65sec for a full revolution of the wheel
+#define U_TIMER_WHEEL_MASK  (U_TIMER_WHEEL_SIZE-1)
 
 class U_EXPORT UTimer {
 public:
@@ -40,6 +51,7 @@ public:
       U_TRACE_REGISTER_OBJECT(0, UTimer, "", 0)
 
       next  = 0;
+      prev  = 0;
       alarm = 0;
       }
 
@@ -57,7 +69,7 @@ public:
       {
       U_TRACE_NO_PARAM(0, "UTimer::empty()")
 
-      if (first == 0) U_RETURN(true);
+      if (num_timer == 0) U_RETURN(true);
 
       U_RETURN(false);
       }
@@ -92,7 +104,7 @@ public:
       {
       U_TRACE_NO_PARAM(0, "UTimer::getTimeout()")
 
-      if (        first &&
+      if (num_timer &&
           (run(), first))
          {
          UEventTime* a = first->alarm;
@@ -109,9 +121,10 @@ public:
       {
       U_TRACE(0, "UTimer::isHandler(%p)", palarm)
 
-      for (UTimer* item = first; item; item = item->next)
+      if (palarm->ptimer &&
+          palarm->ptimer->alarm == palarm)
          {
-         if (item->alarm == palarm) U_RETURN(true);
+         U_RETURN(true);
          }
 
       U_RETURN(false);
@@ -143,11 +156,15 @@ public:
 
 protected:
    UTimer* next;
+   UTimer** prev; // address of the pointer that point to us (for O(1) unlink)
    UEventTime* alarm;
 
    static int mode;
    static UTimer* pool;  //   free list 
-   static UTimer* first; // active list 
+   static UTimer* first; // active list (sorted, the timers that expire within the horizon)
+   static uint64_t horizon;   // tick up to which the timers are in the active list
+   static uint32_t num_timer; // number of timers in the active list and in the wheel
+   static UTimer* wheel[U_TIMER_WHEEL_SIZE]; // the timers that expire after the horizon
 
    static void callHandlerTimeout();
 
@@ -158,6 +175,52 @@ protected:
 private:
    void insertEntry() U_NO_EXPORT;
 
+   uint64_t getTick() const
+      {
+      U_TRACE_NO_PARAM(0, "UTimer::getTick()")
+
+      uint64_t tick = (((uint64_t)alarm->xtime.tv_sec  * 1000ULL) +
+                       ((uint64_t)alarm->xtime.tv_usec / 1000ULL)) >> U_TIMER_TICK_SHIFT;
+
+      U_RETURN(tick);
+      }
+
+   void link(UTimer** ptr)
+      {
+      U_TRACE(0, "UTimer::link(%p)", ptr)
+
+      if ((next = *ptr)) next->prev = &next;
+
+      *(prev = ptr) = this;
+      }
+
+   void unlink()
+      {
+      U_TRACE_NO_PARAM(0, "UTimer::unlink()")
+
+      U_INTERNAL_ASSERT_POINTER(prev)
+
+      if ((*prev = next)) next->prev = prev;
+      }
+
+   void freeEntry()
+      {
+      U_TRACE_NO_PARAM(0, "UTimer::freeEntry()")
+
+      U_INTERNAL_ASSERT_POINTER(alarm)
+
+      // put it on the free list
+
+      alarm->ptimer = 0;
+
+      alarm = 0;
+      next  = pool;
+      pool  = this;
+      }
+
+   static void advance() U_NO_EXPORT;
+   static void deleteList(UTimer* item) U_NO_EXPORT;
+
    bool operator< (const UTimer& t) const { return (*alarm < *t.alarm); }
    bool operator> (const UTimer& t) const { return  t.operator<(*this); }
    bool operator<=(const UTimer& t) const { return !t.operator<(*this); }
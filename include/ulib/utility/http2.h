@@ -19,8 +19,21 @@
 
 #define HTTP2_CONNECTION_PREFACE "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n" // (24 bytes)
 
+#define HTTP2_INLINE_STREAMS  4 // the streams embedded in the connection, the others are taken from a pool shared by all the connections
+#define HTTP2_POOL_STREAMS   64 // the number of streams allocated each time the pool is empty
+
+#define HTTP2_HPACK_ENTRIES     64 // max number of entries of the HPACK encoder dynamic table
+#define HTTP2_HPACK_MAX_SIZE  4096 // max size of the HPACK encoder dynamic table (the peer can ask for less with SETTINGS_HEADER_TABLE_SIZE)
+#define HTTP2_HPACK_CACHE_MAX 1024 // max number of header blocks of the file cache encoded in advance
+
+#define HTTP2_PUSH_MAX        16 // max number of resources pushed with a page
+#define HTTP2_PUSH_CACHE_MAX 256 // max number of pages of the file cache with the list of the linked resources discovered from the content
+
+#define HTTP2_DEFAULT_URGENCY 3 // RFC 9218: the urgency of a stream without priority signal (0 is the highest, 7 the lowest)
+
 class UHTTP;
 class UHashMap<UString>;
+class UHttpPlugIn;
 class UClientImage_Base;
 
 class U_EXPORT UHTTP2 {
@@ -62,17 +75,40 @@ public:
       int32_t id;
       int32_t state;
    // internal
-   // int32_t out_window;
+      int32_t out_window; // sender flow control window
    // int32_t inp_window;
-   // priority
-   // uint32_t priority_dependency; // 0 if not set
-   //     char priority_weight;     // 0 if not set
-   //     bool priority_exclusive;
+   // output (the body of the response, sent in DATA frames: first the data in memory and then the range of the file with sendfile())
+      const char* data;
+      uint32_t data_len, start, count;
+      int32_t sfd;
+      bool bpart; // multipart/byteranges: the next ranges of the file are in UClientImage_Base::sendfile_part
+      Stream* next; // the next stream of the connection (or of the free list of the pool)
+   // priority (RFC 9218: urgency and incremental delivery, the dependency tree of RFC 7540 is deprecated by RFC 9113)
+      uint8_t urgency;
+      bool incremental;
+      char priority_signal; // PRIORITY_NONE, PRIORITY_WEIGHT (PRIORITY frame or HEADERS with FLAG_PRIORITY) or PRIORITY_FIELD (priority header or PRIORITY_UPDATE frame)
+   };
+
+   enum PrioritySignal {
+      PRIORITY_NONE   = 0x000,
+      PRIORITY_WEIGHT = 0x001,
+      PRIORITY_FIELD  = 0x002
    };
 
    static void ctor();
    static void dtor();
 
+   /**
+    * The encoder side of the dynamic table (RFC 7541 2.3.2): a ring of entries where the newest has the index 62. We insert only if
+    * there is a free slot in the ring, and we evict by size exactly as the decoder of the peer does, so that the indexes match...
+    */
+
+   struct HpackDynamicTable {
+      UString name[HTTP2_HPACK_ENTRIES], value[HTTP2_HPACK_ENTRIES];
+      uint32_t num_entries, entry_start, size, max_size;
+      bool bsize_update; // we must signal a dynamic table size update at the beginning of the next header block
+   };
+
    class Connection {
    public:
 
@@ -87,13 +123,14 @@ public:
    Settings peer_settings; // settings
    ConnectionState state; // state
    // internal
-// int32_t out_window; //   sender flow control window
+   int32_t out_window; //   sender flow control window
    int32_t inp_window; // receiver flow control window
    int32_t hpack_max_capacity; // the value set by SETTINGS_HEADER_TABLE_SIZE
+   HpackDynamicTable* hpack_encoder; // the dynamic table of the peer decoder as we fill it (allocated at the first use)
    // streams
    int32_t max_open_stream_id;
    int32_t max_processed_stream_id;
-   Stream streams[100];
+   Stream streams[HTTP2_INLINE_STREAMS]; // NB: the list of the streams starts here, after the last inline stream we have those taken from the pool...
 
    // COSTRUTTORI
 
@@ -101,6 +138,8 @@ public:
    ~Connection()
       {
       U_TRACE_UNREGISTER_OBJECT(0, Connection)
+
+      if (hpack_encoder) delete hpack_encoder;
       }
 
    // SERVICES
@@ -134,16 +173,17 @@ public:
 
 protected:
    enum FrameTypesId {
-      DATA          = 0x00,
-      HEADERS       = 0x01,
-      PRIORITY      = 0x02,
-      RST_STREAM    = 0x03,
-      SETTINGS      = 0x04,
-      PUSH_PROMISE  = 0x05,
-      PING          = 0x06,
-      GOAWAY        = 0x07,
-      WINDOW_UPDATE = 0x08,
-      CONTINUATION  = 0x09
+      DATA            = 0x00,
+      HEADERS         = 0x01,
+      PRIORITY        = 0x02,
+      RST_STREAM      = 0x03,
+      SETTINGS        = 0x04,
+      PUSH_PROMISE    = 0x05,
+      PING            = 0x06,
+      GOAWAY          = 0x07,
+      WINDOW_UPDATE   = 0x08,
+      CONTINUATION    = 0x09,
+      PRIORITY_UPDATE = 0x10 // RFC 9218
    };
 
    enum FrameFlagsId {
@@ -208,9 +248,26 @@ protected:
    static bool settings_ack;
    static Connection* vConnection;
    static Connection* pConnection;
+   static Stream* pool_stream; // free list of the pool
+   static Stream* pool_chunk;  // the chunks allocated by the pool (the first stream of each chunk links the next chunk)
+   static bool ext_from_cache; // the headers of the response (UHTTP::ext) are those of an entry of the file cache
+   static UHashMap<UString>* hpack_cache; // header of the file cache => encoded header block (without reference to the dynamic table)
+   static bool push_enable;              // HTTP2_PUSH: we send PUSH_PROMISE for the resources linked from the pages of the file cache
+   static UHashMap<UString>* push_manifest; // HTTP2_PUSH_MANIFEST: path of a page => the resources to push (separated by '\n')
+   static UString* push_list;            // the resources (path of the file cache, separated by '\n') to push with the current response
+   static UString* push_frames;          // PUSH_PROMISE frames followed by the HEADERS frames of the pushed responses
+   static UVector<UString>* push_body;   // the bodies of the pushed responses (they must stay alive while we send them)
+   static UHashMap<UString>* push_cache; // path of a page of the file cache (with "@mtime" if discovered from the content) => the linked resources
    static const Settings settings;
    static const char* upgrade_settings;
 
+   // DATA frame scheduler
+
+   static int data_iovcnt;
+   static uint32_t data_iovlen;
+   static struct iovec data_iov[16];
+   static char data_frame_header[8*9]; // NB: 9 is the size of the frame header...
+
    static uint32_t               hash_static_table[61];
    static HpackHeaderTableEntry hpack_static_table[61];
 
@@ -218,13 +275,26 @@ protected:
 
    static void readFrame();
    static void sendError();
-   static void openStream();
+   static bool openStream();
+   static void releaseStreams();
+   static Stream* allocStream();
    static void manageData();
    static void manageHeaders();
    static void resetDataRead();
    static int  handlerRequest();
    static void handlerResponse();
    static bool readBodyRequest();
+   static bool updateWindow();
+   static bool writeResponse();
+   static bool readControlFrame();
+   static void updatePriority();
+   static void setPriority(Stream* pStreamTmp, uint32_t weight);
+   static void setPriority(Stream* pStreamTmp, const char* ptr, uint32_t len);
+   static void setPriority(Stream* pStreamTmp, int mime_index);
+   static void checkPush();
+   static void loadPushManifest(const UString& pathname);
+   static void pushResources();
+   static UString getLinkedResources(const char* path, uint32_t len, const UString& content);
    static bool updateSetting(unsigned char*  ptr, uint32_t len);
    static void decodeHeaders(unsigned char*  ptr, unsigned char*  endptr);
 
@@ -232,6 +302,49 @@ protected:
    static const char* getFrameTypeDescription(char type);
 #endif      
 
+   static Stream* findStream(int32_t id)
+      {
+      U_TRACE(0, "UHTTP2::findStream(%d)", id)
+
+      U_INTERNAL_ASSERT_POINTER(pConnection)
+
+      for (Stream* pStreamTmp = pConnection->streams; pStreamTmp; pStreamTmp = pStreamTmp->next)
+         {
+         if (pStreamTmp->id == id) U_RETURN_POINTER(pStreamTmp, Stream);
+         }
+
+      U_RETURN_POINTER(0, Stream);
+      }
+
+   static uint32_t getSendWindow(Stream* pStreamData) // the size of the next DATA frame of the stream (0 if we must wait for WINDOW_UPDATE)
+      {
+      U_TRACE(0, "UHTTP2::getSendWindow(%p)", pStreamData)
+
+      U_INTERNAL_ASSERT_POINTER(pConnection)
+
+      int32_t n = U_min(pStreamData->out_window, pConnection->out_window);
+
+      if (n <= 0) U_RETURN(0);
+
+      if (n > (int32_t)pConnection->peer_settings.max_frame_size) n = pConnection->peer_settings.max_frame_size;
+
+      U_RETURN(n);
+      }
+
+   static bool isMoreUrgent(Stream* a, Stream* b) // RFC 9218 10: lower urgency first, then the non incremental streams, then the lowest id
+      {
+      U_TRACE(0, "UHTTP2::isMoreUrgent(%p,%p)", a, b)
+
+      if (a->urgency     != b->urgency)     U_RETURN(a->urgency < b->urgency);
+      if (a->incremental != b->incremental) U_RETURN(b->incremental);
+
+      U_RETURN(a->id < b->id);
+      }
+
+   static bool flushData();
+   static bool sendData(Stream* pStreamData, uint32_t n);
+   static void addData(const char* ptr, uint32_t len);
+
    static bool setIndexStaticTable(UHashMap<void*>* ptable, const char* key, uint32_t length)
       {
       U_TRACE(0, "UHTTP2::setIndexStaticTable(%p,%.*S,%u)", ptable, length, key, length)
@@ -284,12 +397,18 @@ protected:
    static unsigned char* hpackDecodeString(unsigned char* src, unsigned char* src_end, UString* pvalue);
 
    static unsigned char* hpackEncodeInt(   unsigned char* dst,                         uint32_t   value, uint8_t prefix_max);
+
+   static unsigned char* hpackEncodeHeader(unsigned char* dst, uint32_t index, const char* name, uint32_t name_len, const char* value, uint32_t value_len, bool bindex);
+   static unsigned char* hpackEncodeHeaders(unsigned char* dst, const UString& ext, bool bindex);
+   static unsigned char* hpackEncodeHeadersFromCache(unsigned char* dst, const UString& ext);
+   static unsigned char* hpackEncodeSizeUpdate(unsigned char* dst);
    static unsigned char* hpackDecodeInt(   unsigned char* src, unsigned char* src_end,  int32_t* pvalue, uint8_t prefix_max);
 
 private:
    static UVector<UString>* vext;
 
    friend class UHTTP;
+   friend class UHttpPlugIn;
    friend class UClientImage_Base;
 
 #ifdef U_COMPILER_DELETE_MEMBERS
@@ -17,6 +17,16 @@
 #include <ulib/string.h>
 #include <ulib/net/socket.h>
 
+/**
+ * MSG_ZEROCOPY (linux >= 4.14): the pages of the buffer are sent without copy, the kernel notify the completion of the send
+ * on the error queue of the socket, until then the buffer must not be modified or freed...
+ */
+
+#if defined(U_LINUX) && !defined(_MSWINDOWS_) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#  define U_ZEROCOPY_SUPPORT
+#  define U_ZEROCOPY_MAX_PENDING 4 // max number of MSG_ZEROCOPY send not completed for connection
+#endif
+
 typedef void (*vPFsu)(UString&,uint32_t);
 
 class URPC;
@@ -195,6 +205,13 @@ private:
    static int _writev(USocket* sk, struct iovec* iov, int iovcnt, uint32_t count, int timeoutMS);
    static int  writev(USocket* sk, struct iovec* iov, int iovcnt, uint32_t count, int timeoutMS, uint32_t cloop);
 
+#ifdef U_ZEROCOPY_SUPPORT
+   // NB: only the last buffer (the body) is sent with MSG_ZEROCOPY, the others (the headers) are copied with MSG_MORE.
+   //     The flag bzerocopy is set if the send is numbered by the kernel (so that the caller must hold the body until the completion)...
+
+   static int writev_zerocopy(USocket* sk, struct iovec* iov, int iovcnt, uint32_t count, bool& bzerocopy);
+#endif
+
    /**
     * sendfile() copies data between one file descriptor and another. Either or both of these file descriptors may refer to a socket.
     * OUT_FD should be a descriptor opened for writing. POFFSET is a pointer to a variable holding the input file pointer position from
@@ -75,6 +75,14 @@ public:
    static UString deflate(const UString& s, int type)             { return deflate(U_STRING_TO_PARAM(s), type); }
    static UString  gunzip(const UString& s, uint32_t sz_orig = 0) { return  gunzip(U_STRING_TO_PARAM(s), sz_orig); }
 
+   // BROTLI - ZSTD method (NB: they return a null string if the library is not available...)
+
+   static UString brotli(const char* s, uint32_t n, int quality); // .br  compress
+   static UString   zstd(const char* s, uint32_t n, int level);   // .zst compress
+
+   static UString brotli(const UString& s, int quality = 11) { return brotli(U_STRING_TO_PARAM(s), quality); }
+   static UString   zstd(const UString& s, int level   = 19) { return   zstd(U_STRING_TO_PARAM(s), level); }
+
    // Convert numeric to string
 
    static UString printSize(off_t n);
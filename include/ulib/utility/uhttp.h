@@ -33,12 +33,14 @@
 
 #define U_MAX_UPLOAD_PROGRESS   16
 #define U_MIN_SIZE_FOR_DEFLATE 150 // NB: google advice...
+#define U_HTTP_MAX_HEADER_LINE  64 // max number of lines of the header of the request indexed in one pass by u_scanHeader()
 
 #define U_HTTP_URI_EQUAL(str)               ((str).equal(U_HTTP_URI_TO_PARAM))
 #define U_HTTP_URI_DOSMATCH(mask,len,flags) (UServices::dosMatchWithOR(U_HTTP_URI_TO_PARAM, mask, len, flags))
 
 class UFile;
 class ULock;
+class UCache;
 class UEventFd;
 class UCommand;
 class UPageSpeed;
@@ -189,9 +191,11 @@ public:
    static UString* suffix;
    static UString* request;
    static UString* qcontent;
+   static UString* sendfile_part; // the next parts (after the first) of a multipart/byteranges response sent with sendfile()
    static UString* pathname;
    static UString* rpathname;
    static UString* mount_point;
+   static UString* status_uri; // URI where the statistics of the server are served
    static UString* string_HTTP_Variables;
 
    static URDB* db_not_found;
@@ -409,6 +413,13 @@ public:
    static UMimeMultipart* formMulti;
    static UVector<UString>* form_name_value;
 
+   // NB: a multipart/form-data body not smaller than form_stream_min_size is parsed while it arrives, the uploaded files
+   //     are written directly in tmpdir and only the fields (max form_field_max_size bytes for request) are kept in memory...
+
+   static bool form_stream;
+   static UString* form_stream_buffer;
+   static uint32_t form_stream_min_size, form_field_max_size;
+
    static int getFormFirstNumericValue(int _min, int _max) __pure;
 
    static uint32_t processForm();
@@ -881,7 +892,7 @@ public:
    U_MEMORY_DEALLOCATOR
 
    void* ptr;               // data
-   UVector<UString>* array; // content, header, gzip(content, header)
+   UVector<UString>* array; // content, header, gzip(content, header), brotli(content, header), zstd(content, header)
    time_t mtime;            // time of last modification
    time_t expire;           // expire time of the entry
    uint32_t size;           // size content
@@ -889,6 +900,15 @@ public:
    mode_t mode;             // file type
    int mime_index;          // index file mime type
    int fd;                  // file descriptor
+   int shared;              // index of the entry in the shared file cache (-1 => not shared)
+   uint32_t generation;     // generation of the shared entry that the array point to (0 => private copy)
+   UFileCacheData* prev;    // list in order of use of the entries with the content in memory (CACHE_FILE_MEMORY)
+   UFileCacheData* next;
+   uint32_t nbytes;         // bytes of the data in the array (0 => not in the list)
+   uint32_t hash;           // hash of the pathname (for the frequency sketch)
+   uint32_t etag;           // hash of the content (strong ETag: "size-hash", 0 => no ETag)
+   uint8_t segment;         // segment of the list (0 => probation, 1 => protected)
+   bool evicted;            // true => the content can be cached but it is not in memory (it is served from the file)
    bool link;               // true => ptr point to another entry
 
    // COSTRUTTORI
@@ -939,14 +959,33 @@ public:
       U_RETURN(false);
       }
 
-   static bool isDataCompressFromCache()
+   // NB: the compressed variant of the content for a coding is in the array of the cache entry at position (2 * coding)...
+
+   enum ContentEncodingType {
+      U_ENCODING_IDENTITY = 0,
+      U_ENCODING_GZIP     = 1,
+      U_ENCODING_BROTLI   = 2,
+      U_ENCODING_ZSTD     = 3,
+      U_ENCODING_NUM      = 4
+   };
+
+   static uint16_t accept_encoding[U_ENCODING_NUM]; // q-value (x 1000) of the codings accepted by the client (Accept-Encoding)
+
+   static void setAcceptEncoding(const char* ptr, uint32_t len);
+
+   static bool isDataCompressFromCache(int encoding = U_ENCODING_GZIP)
       {
-      U_TRACE_NO_PARAM(0, "UHTTP::isDataCompressFromCache()")
+      U_TRACE(0, "UHTTP::isDataCompressFromCache(%d)", encoding)
 
       U_INTERNAL_ASSERT_POINTER(file_data)
       U_INTERNAL_ASSERT_POINTER(file_data->array)
+      U_INTERNAL_ASSERT_RANGE(1,encoding,U_ENCODING_NUM-1)
 
-      if (file_data->array->size() > 2) U_RETURN(true);
+      if (file_data->array->size() > (uint32_t)(encoding * 2) &&
+          file_data->array->getStringRep(encoding * 2)->empty() == false)
+         {
+         U_RETURN(true);
+         }
 
       U_RETURN(false);
       }
@@ -995,8 +1034,115 @@ public:
    static UString   getBodyCompressFromCache() { return getDataFromCache(2); }
    static UString getHeaderCompressFromCache() { return getDataFromCache(3); };
 
+   static UString   getBodyCompressFromCache(int encoding) { return getDataFromCache(encoding * 2); }
+   static UString getHeaderCompressFromCache(int encoding) { return getDataFromCache(encoding * 2 + 1); };
+
    static UFileCacheData* getFileInCache(const char* path, uint32_t len);
 
+   // SHARED FILE CACHE: the data of the file cache (content, header, compressed variants) moved at startup in shared memory (index + data),
+   // so that there is only one copy for all the preforked children. The children don't touch the reference counts of these strings, and the
+   // entry renewed by a process (inotify) is published with a new generation that the other processes attach without rebuilding it...
+
+   typedef struct file_cache_shared_entry {
+      uint32_t generation; // even => stable, odd => a process is writing a new version of the entry
+      uint32_t hash;       // hash of the pathname of the entry
+      uint32_t size;       // size content
+      uint32_t num;        // number of data (content, header, gzip(content, header), ...)
+      uint32_t etag;       // hash of the content (strong ETag)
+      time_t mtime;        // time of last modification
+      uint32_t offset[U_ENCODING_NUM * 2]; // position of the data in the data area
+      uint32_t length[U_ENCODING_NUM * 2];
+   } file_cache_shared_entry;
+
+   typedef struct file_cache_shared_info {
+      uint32_t num_entry; // number of entries of the index
+      uint32_t size;      // size of the data area
+      uint32_t used;      // bytes used of the data area (append only)
+   // ------> num_entry array of file_cache_shared_entry (index)...
+   // ------> array of char (data)...
+   } file_cache_shared_info;
+
+   static bool cache_file_shared;
+   static int cache_file_shared_idx;
+   static void* cache_file_shared_ptr; // NB: offset, after pointer, to the shared memory...
+   static file_cache_shared_info* cache_file_shared_info;
+   static uint32_t cache_file_shared_size, cache_file_shared_num;
+
+   static void setCacheFileShared();
+   static void initCacheFileShared();
+
+   static file_cache_shared_entry* getCacheFileSharedEntry(int idx)
+      {
+      U_TRACE(0, "UHTTP::getCacheFileSharedEntry(%d)", idx)
+
+      U_INTERNAL_ASSERT_POINTER(cache_file_shared_info)
+      U_INTERNAL_ASSERT_MINOR((uint32_t)idx, cache_file_shared_info->num_entry)
+
+      return ((file_cache_shared_entry*)(cache_file_shared_info + 1)) + idx;
+      }
+
+   static char* getCacheFileSharedData()
+      {
+      U_TRACE_NO_PARAM(0, "UHTTP::getCacheFileSharedData()")
+
+      U_INTERNAL_ASSERT_POINTER(cache_file_shared_info)
+
+      return (char*)(((file_cache_shared_entry*)(cache_file_shared_info + 1)) + cache_file_shared_info->num_entry);
+      }
+
+   static bool isCacheFileSharedChanged()
+      {
+      U_TRACE_NO_PARAM(0, "UHTTP::isCacheFileSharedChanged()")
+
+      U_INTERNAL_ASSERT_POINTER(file_data)
+
+      U_INTERNAL_DUMP("file_data->shared = %d file_data->generation = %u", file_data->shared, file_data->generation)
+
+      if (file_data->generation) // NB: only the process that have attached a version of the entry follow the new ones...
+         {
+         uint32_t generation = __atomic_load_n(&(getCacheFileSharedEntry(file_data->shared)->generation), __ATOMIC_ACQUIRE);
+
+         if ((generation & 1) == 0 &&
+             generation != file_data->generation)
+            {
+            U_RETURN(true);
+            }
+         }
+
+      U_RETURN(false);
+      }
+
+   // MEMORY BUDGET OF THE FILE CACHE: segmented LRU (probation, protected) with TinyLFU admission (frequency sketch of the requests)
+
+   static uint8_t* cache_file_sketch;
+   static UFileCacheData* cache_file_lru_head[2];
+   static UFileCacheData* cache_file_lru_tail[2];
+   static uint32_t cache_file_memory_max, cache_file_memory, cache_file_lru_memory[2], cache_file_sketch_bits, cache_file_sketch_count;
+   static bool cache_file_admit;
+
+   static void checkFileDataForMemoryBudget();
+
+   // MICRO CACHE: cache of the dynamic responses (USP/CGI) in shared memory, visible to all the preforked children
+
+   typedef struct micro_cache_entry {
+      long expire;      // time after that the response is stale
+      long updating;    // time until that a process is regenerating the response (the others serve it stale or wait for it)
+      uint32_t code;    // status of the response (0 => marker of a response in-flight, it is not cacheable until expire)
+      uint32_t ext_len; // size of the header of the response
+   // ------> ext_len array of char (header)...
+   // ------> array of char (body)...
+   } micro_cache_entry;
+
+   static UCache* micro_cache;
+   static ULock* micro_cache_lock;
+   static void* micro_cache_ptr; // NB: offset, after pointer, to the shared memory...
+   static UString* micro_cache_key;
+   static UVector<UString>* micro_cache_vary;
+   static UVector<UString>* micro_cache_rule; // (mask ttl) ...
+   static uint32_t micro_cache_size, micro_cache_stale, micro_cache_ttl;
+
+   static void initMicroCache();
+
 private:
    static void    handlerResponse();
    static UString getHTMLDirectoryList() U_NO_EXPORT;
@@ -1039,6 +1185,11 @@ private:
    static bool checkForInotifyDirectory(UStringRep* key, void* value) U_NO_EXPORT;
 #endif
 
+   // lines of the header of the request found by readHeaderRequest() with u_scanHeader() (0 => checkRequestForHeader() scan byte-by-byte)
+
+   static uhttpline header_line[U_HTTP_MAX_HEADER_LINE];
+   static uint32_t  header_line_num;
+
 #ifdef U_STATIC_ONLY
    static uint32_t getHtmlEncodedForResponse(char* buffer, uint32_t size, const char* fmt);
    static void     loadStaticLinkedServlet(const char* name, uint32_t len, vPFi runDynamicPage) U_NO_EXPORT;
@@ -1046,16 +1197,22 @@ private:
 
    static void checkPath() U_NO_EXPORT;
    static bool callService() U_NO_EXPORT;
+   static void putMicroCache() U_NO_EXPORT;
    static bool runDynamicPage() U_NO_EXPORT;
    static bool readBodyRequest() U_NO_EXPORT;
+   static bool readFormStream(uint32_t body_byte_read) U_NO_EXPORT;
+   static bool checkMicroCache() U_NO_EXPORT;
    static bool processFileCache() U_NO_EXPORT;
    static bool readHeaderRequest() U_NO_EXPORT;
+   static void releaseMicroCache() U_NO_EXPORT;
    static void processGetRequest() U_NO_EXPORT;
    static void manageDataForCache() U_NO_EXPORT;
    static bool processAuthorization() U_NO_EXPORT;
    static bool checkPath(uint32_t len) U_NO_EXPORT;
    static void checkRequestForHeader() U_NO_EXPORT;
    static bool checkGetRequestIfRange() U_NO_EXPORT;
+   static bool checkGetRequestForETag(int encoding) U_NO_EXPORT;
+   static bool findETag(const char* ptr, uint32_t sz, const char* tag, uint32_t len, bool weak) __pure U_NO_EXPORT;
    static bool checkGetRequestIfModified() U_NO_EXPORT;
    static void setCGIShellScript(UString& command) U_NO_EXPORT;
    static bool checkIfSourceHasChangedAndCompileUSP() U_NO_EXPORT;
@@ -1068,6 +1225,21 @@ private:
    static bool addHTTPVariables(UStringRep* key, void* value) U_NO_EXPORT;
    static bool splitCGIOutput(const char*& ptr1, const char* ptr2) U_NO_EXPORT;
    static void putDataInCache(const UString& fmt, UString& content) U_NO_EXPORT;
+   static int  getAcceptEncodingFromCache() U_NO_EXPORT;
+   static void addBytesSavedFromCache(int encoding) U_NO_EXPORT;
+   static uint32_t getETagFromCache(char* buffer, int encoding) U_NO_EXPORT;
+   static void addETagToHeader(UString& header, int encoding) U_NO_EXPORT;
+   static void admitFileDataInCache() U_NO_EXPORT;
+   static void evictFileDataFromCache(UFileCacheData* ptr) U_NO_EXPORT;
+   static void insertFileDataInLRU(UFileCacheData* ptr, int segment) U_NO_EXPORT;
+   static void removeFileDataFromLRU(UFileCacheData* ptr) U_NO_EXPORT;
+   static void incrementFrequencyInSketch(uint32_t hash) U_NO_EXPORT;
+   static uint32_t getFrequencyFromSketch(uint32_t hash) __pure U_NO_EXPORT;
+   static void putFileDataInCacheShared(const UStringRep* key) U_NO_EXPORT;
+   static bool getFileDataFromCacheShared(const UStringRep* key) U_NO_EXPORT;
+   static bool countFileDataForCacheShared(UStringRep* key, void* value) U_NO_EXPORT;
+   static bool moveFileDataInCacheShared(UStringRep* key, void* value) U_NO_EXPORT;
+   static bool putDataCompressInCache(int encoding, const UString& fmt, const UString& content, const char* motivation) U_NO_EXPORT;
    static bool checkDataSession(const UString& token, time_t expire) U_NO_EXPORT;
    static bool readDataChunked(USocket* sk, UString* pbuffer, UString& body) U_NO_EXPORT;
    static void setResponseForRange(uint32_t start, uint32_t end, uint32_t header) U_NO_EXPORT;
@@ -1080,6 +1252,7 @@ private:
    UHTTP& operator=(const UHTTP&) { return *this; }
 #endif      
 
+   friend class UHTTP2;
    friend class USSIPlugIn;
    friend class UHttpPlugIn;
 };
@@ -141,6 +141,92 @@ AC_DEFUN([AC_CHECK_PACKAGE],[
 	fi
 	], [AC_MSG_RESULT(no)])
 
+	AC_MSG_CHECKING(if brotli library is wanted)
+	wanted=1;
+	if test -z "$with_libbrotli" ; then
+		wanted=0;
+		with_libbrotli="${CROSS_ENVIRONMENT}/usr";
+	fi
+	AC_ARG_WITH(libbrotli, [  --with-libbrotli        use system   brotli library - [[will check /usr /usr/local]] [[default=use if present]]], [
+	if test "$withval" = "no"; then
+		AC_MSG_RESULT(no)
+	else
+		AC_MSG_RESULT(yes)
+		for dir in $withval ${CROSS_ENVIRONMENT}/ ${CROSS_ENVIRONMENT}/usr ${CROSS_ENVIRONMENT}/usr/local; do
+			libbrotlidir="$dir"
+			if test -f "$dir/include/brotli/encode.h"; then
+				found_libbrotli="yes";
+				break;
+			fi
+		done
+		if test x_$found_libbrotli != x_yes; then
+			msg="Cannot find libbrotli library";
+			if test $wanted = 1; then
+				AC_MSG_ERROR($msg)
+			else
+				AC_MSG_RESULT($msg)
+			fi
+		else
+			echo "${T_MD}libbrotli found in $libbrotlidir${T_ME}"
+			USE_LIBBROTLI=yes
+			AC_DEFINE(USE_LIBBROTLI, 1, [Define if enable libbrotli support])
+			libbrotli_version=$(ls $libbrotlidir/lib*/libbrotlienc.so.*.* 2>/dev/null | head -n 1 | awk -F'.so.' '{n=2; print $n}' 2>/dev/null)
+			if test -z "${libbrotli_version}"; then
+				libbrotli_version="unknown"
+			fi
+         ULIB_LIBS="$ULIB_LIBS -lbrotlienc";
+			if test $libbrotlidir != "${CROSS_ENVIRONMENT}/" -a $libbrotlidir != "${CROSS_ENVIRONMENT}/usr" -a $libbrotlidir != "${CROSS_ENVIRONMENT}/usr/local"; then
+				CPPFLAGS="$CPPFLAGS -I$libbrotlidir/include"
+				LDFLAGS="$LDFLAGS -L$libbrotlidir/lib -Wl,-R$libbrotlidir/lib";
+				PRG_LDFLAGS="$PRG_LDFLAGS -L$libbrotlidir/lib";
+			fi
+		fi
+	fi
+	], [AC_MSG_RESULT(no)])
+
+	AC_MSG_CHECKING(if zstd library is wanted)
+	wanted=1;
+	if test -z "$with_libzstd" ; then
+		wanted=0;
+		with_libzstd="${CROSS_ENVIRONMENT}/usr";
+	fi
+	AC_ARG_WITH(libzstd, [  --with-libzstd          use system     zstd library - [[will check /usr /usr/local]] [[default=use if present]]], [
+	if test "$withval" = "no"; then
+		AC_MSG_RESULT(no)
+	else
+		AC_MSG_RESULT(yes)
+		for dir in $withval ${CROSS_ENVIRONMENT}/ ${CROSS_ENVIRONMENT}/usr ${CROSS_ENVIRONMENT}/usr/local; do
+			libzstddir="$dir"
+			if test -f "$dir/include/zstd.h"; then
+				found_libzstd="yes";
+				break;
+			fi
+		done
+		if test x_$found_libzstd != x_yes; then
+			msg="Cannot find libzstd library";
+			if test $wanted = 1; then
+				AC_MSG_ERROR($msg)
+			else
+				AC_MSG_RESULT($msg)
+			fi
+		else
+			echo "${T_MD}libzstd found in $libzstddir${T_ME}"
+			USE_LIBZSTD=yes
+			AC_DEFINE(USE_LIBZSTD, 1, [Define if enable libzstd support])
+			libzstd_version=$(ls $libzstddir/lib*/libzstd.so.*.* 2>/dev/null | head -n 1 | awk -F'.so.' '{n=2; print $n}' 2>/dev/null)
+			if test -z "${libzstd_version}"; then
+				libzstd_version="unknown"
+			fi
+         ULIB_LIBS="$ULIB_LIBS -lzstd";
+			if test $libzstddir != "${CROSS_ENVIRONMENT}/" -a $libzstddir != "${CROSS_ENVIRONMENT}/usr" -a $libzstddir != "${CROSS_ENVIRONMENT}/usr/local"; then
+				CPPFLAGS="$CPPFLAGS -I$libzstddir/include"
+				LDFLAGS="$LDFLAGS -L$libzstddir/lib -Wl,-R$libzstddir/lib";
+				PRG_LDFLAGS="$PRG_LDFLAGS -L$libzstddir/lib";
+			fi
+		fi
+	fi
+	], [AC_MSG_RESULT(no)])
+
 	AC_MSG_CHECKING(if MAGIC library is wanted)
 	wanted=1;
 	if test -z "$with_magic" ; then
@@ -225,6 +225,17 @@ AC_DEFUN([AC_COMPILATION_OPTIONS],[
 	fi
 	AC_MSG_RESULT([$enable_http2])
 
+	AC_MSG_CHECKING(if you want to enable io_uring support for the event notification)
+	AC_ARG_ENABLE(io-uring,
+				[  --enable-io-uring         enable io_uring support for the event notification [[default=no]]])
+	if test -z "$enable_io_uring"; then
+		enable_io_uring="no"
+	fi
+	if test "$enable_io_uring" = "yes"; then
+		AC_DEFINE(U_IO_URING_SUPPORT, 1, [enable io_uring support for the event notification])
+	fi
+	AC_MSG_RESULT([$enable_io_uring])
+
 	AC_MSG_CHECKING(if you want to enable server classic model support)
 	AC_ARG_ENABLE(classic,
 				[  --enable-classic          enable server classic model support [[default=no]]])
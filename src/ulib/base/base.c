@@ -547,6 +547,12 @@ void u_init_ulib(char** restrict argv)
       }
 #endif
 
+#if defined(U_SCAN_HEADER_SIMD) && defined(HAVE_BUILTIN_CPU_INIT)
+   __builtin_cpu_init();
+
+   if (__builtin_cpu_supports("avx2")) u_scanHeader = u_scanHeader_avx2;
+#endif
+
 #ifdef _MSWINDOWS_
    u_init_ulib_mingw();
 #endif
@@ -752,6 +752,147 @@ __pure uint32_t u_findEndHeader(const char* restrict str, uint32_t n)
    return endHeader;
 }
 
+/* scan in one pass the header of a HTTP message: find sequence of U_CRLF2 and store the offset of the first ':' and of the U_CRLF of every line */
+
+#ifdef U_SCAN_HEADER_SIMD
+#  include <immintrin.h>
+#endif
+
+typedef struct uscanheader {
+   uhttpline* restrict vline;
+   uint32_t start, colon, num, max;
+} uscanheader;
+
+/* NB: called for every ':' or '\r' in order of position - return 0 to continue, otherwise the end of header (U_NOT_FOUND if the data are incomplete) */
+
+static inline uint32_t u_scanHeaderMark(const char* restrict s, uint32_t n, uint32_t pos, uscanheader* restrict st)
+{
+   if (s[pos] == ':')
+      {
+      if (st->colon == U_NOT_FOUND) st->colon = pos;
+
+      return 0;
+      }
+
+   U_INTERNAL_ASSERT_EQUALS(s[pos], '\r')
+
+   if ((pos+1) >= n) return U_NOT_FOUND;
+
+   if (s[pos+1] != '\n') return 0;
+
+   if (pos == st->start) return pos + 2; /* the blank line */
+
+   if (st->num < st->max)
+      {
+      st->vline[st->num].colon = st->colon;
+      st->vline[st->num].end   = pos;
+      }
+
+   st->num++;
+
+   st->start = pos + 2;
+   st->colon = U_NOT_FOUND;
+
+   return 0;
+}
+
+static inline uint32_t u_scanHeaderTail(const char* restrict s, uint32_t n, uint32_t pos, uscanheader* restrict st, uint32_t* restrict pnum)
+{
+   uint32_t endHeader = 0;
+
+   for (; pos < n; ++pos)
+      {
+      if ((s[pos] == '\r' || s[pos] == ':') &&
+          (endHeader = u_scanHeaderMark(s, n, pos, st)))
+         {
+         break;
+         }
+      }
+
+   if (endHeader == 0) endHeader = U_NOT_FOUND;
+
+   *pnum = (endHeader != U_NOT_FOUND && st->num <= st->max ? st->num : 0);
+
+   return endHeader;
+}
+
+uint32_t u_scanHeader_c(const char* restrict s, uint32_t n, uhttpline* restrict vline, uint32_t max, uint32_t* restrict pnum)
+{
+   uscanheader st = { vline, 0, U_NOT_FOUND, 0, max };
+
+   U_INTERNAL_TRACE("u_scanHeader_c(%.*s,%u,%p,%u,%p)", U_min(n,128), s, n, vline, max, pnum)
+
+   U_INTERNAL_ASSERT_POINTER(s)
+
+   return u_scanHeaderTail(s, n, 0, &st, pnum);
+}
+
+#ifdef U_SCAN_HEADER_SIMD
+uint32_t u_scanHeader_sse2(const char* restrict s, uint32_t n, uhttpline* restrict vline, uint32_t max, uint32_t* restrict pnum)
+{
+   uint32_t i, m, r;
+   uscanheader st = { vline, 0, U_NOT_FOUND, 0, max };
+   const __m128i cr = _mm_set1_epi8('\r'), colon = _mm_set1_epi8(':');
+
+   U_INTERNAL_TRACE("u_scanHeader_sse2(%.*s,%u,%p,%u,%p)", U_min(n,128), s, n, vline, max, pnum)
+
+   U_INTERNAL_ASSERT_POINTER(s)
+
+   for (i = 0; (i + 16) <= n; i += 16)
+      {
+      __m128i v = _mm_loadu_si128((const __m128i*)(s + i));
+
+      m = (uint32_t) _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, colon)));
+
+      for (; m; m &= m - 1)
+         {
+         if ((r = u_scanHeaderMark(s, n, i + __builtin_ctz(m), &st)))
+            {
+            *pnum = (r != U_NOT_FOUND && st.num <= max ? st.num : 0);
+
+            return r;
+            }
+         }
+      }
+
+   return u_scanHeaderTail(s, n, i, &st, pnum);
+}
+
+__attribute__((target("avx2"))) uint32_t u_scanHeader_avx2(const char* restrict s, uint32_t n, uhttpline* restrict vline, uint32_t max, uint32_t* restrict pnum)
+{
+   uint32_t i, m, r;
+   uscanheader st = { vline, 0, U_NOT_FOUND, 0, max };
+   const __m256i cr = _mm256_set1_epi8('\r'), colon = _mm256_set1_epi8(':');
+
+   U_INTERNAL_TRACE("u_scanHeader_avx2(%.*s,%u,%p,%u,%p)", U_min(n,128), s, n, vline, max, pnum)
+
+   U_INTERNAL_ASSERT_POINTER(s)
+
+   for (i = 0; (i + 32) <= n; i += 32)
+      {
+      __m256i v = _mm256_loadu_si256((const __m256i*)(s + i));
+
+      m = (uint32_t) _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, colon)));
+
+      for (; m; m &= m - 1)
+         {
+         if ((r = u_scanHeaderMark(s, n, i + __builtin_ctz(m), &st)))
+            {
+            *pnum = (r != U_NOT_FOUND && st.num <= max ? st.num : 0);
+
+            return r;
+            }
+         }
+      }
+
+   return u_scanHeaderTail(s, n, i, &st, pnum);
+}
+
+uPFscanHeader u_scanHeader = u_scanHeader_sse2;
+#else
+uPFscanHeader u_scanHeader = u_scanHeader_c;
+#endif
+
 /* Determine the width of the terminal we're running on */
 
 __pure int u_getScreenWidth(void)
@@ -41,26 +41,48 @@ U_NO_EXPORT void UCache::init(UFile& _x, uint32_t size, bool bexist, bool brdonl
 
    char* ptr = _x.getMap();
 
+   if (bexist == false) format(ptr, size);
+   else
+      {
+      info = (cache_info*)ptr;
+         x =              ptr + sizeof(UCache::cache_info);
+
+      start = (_x.fstat(), _x.st_mtime);
+      }
+}
+
+U_NO_EXPORT void UCache::format(char* ptr, uint32_t size)
+{
+   U_TRACE(0, "UCache::format(%p,%u)", ptr, size)
+
+   // 100 <= size <= 1000000000
+
+   U_INTERNAL_ASSERT_RANGE(100U, size, 1000U * 1000U * 1000U)
+
    info = (cache_info*)ptr;
       x =              ptr + sizeof(UCache::cache_info);
 
-   if (bexist) start = (_x.fstat(), _x.st_mtime);
-   else
-      {
-      // 100 <= size <= 1000000000
+   // hsize <= writer <= oldest <= unused <= size
 
-      U_INTERNAL_ASSERT_RANGE(100U, size, 1000U * 1000U * 1000U)
+   info->hsize = info->writer = getHSize((info->oldest = info->unused = info->size = (size - sizeof(UCache::cache_info))));
 
-      // hsize <= writer <= oldest <= unused <= size
+   U_INTERNAL_DUMP("hsize = %u writer = %u oldest = %u unused = %u size = %u", info->hsize, info->writer, info->oldest, info->unused, info->size)
 
-      info->hsize = info->writer = getHSize((info->oldest = info->unused = info->size = (size - sizeof(UCache::cache_info))));
+   U_gettimeofday; // NB: optimization if it is enough a time resolution of one second...
 
-      U_INTERNAL_DUMP("hsize = %u writer = %u oldest = %u unused = %u size = %u", info->hsize, info->writer, info->oldest, info->unused, info->size)
+   start = u_now->tv_sec;
+}
 
-      U_gettimeofday; // NB: optimization if it is enough a time resolution of one second...
+void UCache::setMemory(char* ptr, uint32_t size)
+{
+   U_TRACE(0, "UCache::setMemory(%p,%u)", ptr, size)
 
-      start = u_now->tv_sec;
-      }
+   U_CHECK_MEMORY
+
+   U_INTERNAL_ASSERT_POINTER(ptr)
+   U_INTERNAL_ASSERT_EQUALS(fd, -1) // NB: the destructor don't unmap the memory area...
+
+   format(ptr, size);
 }
 
 bool UCache::open(const UString& path, uint32_t size, const UString* environment)
@@ -28,6 +28,8 @@ UEventTime::UEventTime(long sec, long micro_sec) : UTimeVal(sec, micro_sec)
 
    setTolerance();
 
+   ptimer = 0;
+
    xtime.tv_sec =
    xtime.tv_usec = 0L;
 
@@ -108,7 +110,8 @@ const char* UEventTime::dump(bool _reset) const
    *UObjectIO::os << '\n'
                   << "xtime   " << "{ " << xtime.tv_sec
                                 << " "  << xtime.tv_usec
-                                << " }";
+                                << " }\n"
+                  << "ptimer  (UTimer " << (void*)ptimer << ')';
 
    if (_reset)
       {
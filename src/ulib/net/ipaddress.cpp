@@ -586,6 +586,31 @@ __pure bool UIPAddress::isPrivate()
    U_RETURN(false);
 }
 
+__pure bool UIPAddress::isLoopback()
+{
+   U_TRACE_NO_PARAM(0, "UIPAddress::isLoopback()")
+
+   U_CHECK_MEMORY
+
+#ifdef ENABLE_IPV6
+   if (iAddressType == AF_INET6)
+      {
+      if (memcmp(pcAddress.p, &in6addr_loopback, sizeof(in6_addr)) == 0) U_RETURN(true); // ::1
+
+      U_RETURN(false);
+      }
+   else
+#endif
+      {
+      U_INTERNAL_ASSERT_EQUALS(iAddressType, AF_INET)
+      U_INTERNAL_ASSERT_EQUALS(iAddressLength, sizeof(in_addr))
+
+      if ((htonl(pcAddress.i) >> 24) == 127) U_RETURN(true); // 127.0.0.0/8
+      }
+
+   U_RETURN(false);
+}
+
 __pure bool UIPAddress::isWildCard()
 {
    U_TRACE_NO_PARAM(0, "UIPAddress::isWildCard()")
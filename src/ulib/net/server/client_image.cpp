@@ -21,6 +21,10 @@
 #ifndef U_HTTP2_DISABLE
 #  include <ulib/utility/http2.h>
 #endif
+#ifdef U_ZEROCOPY_SUPPORT
+#  include <linux/errqueue.h>
+#  define U_ZEROCOPY_GRACE_TIME 60 // NB: the time (in seconds) for which we hold the body of the send not completed after the close()...
+#endif
 
 #ifdef U_SERVER_CHECK_TIME_BETWEEN_REQUEST
 #  define U_NUM_CLIENT_THRESHOLD 128
@@ -38,6 +42,8 @@ bool          UClientImage_Base::log_request_partial;
 char          UClientImage_Base::cbuffer[128];
 long          UClientImage_Base::time_run;
 long          UClientImage_Base::time_between_request = 10;
+uint64_t      UClientImage_Base::time_stat;
+uint64_t      UClientImage_Base::time_phase;
 bPFpc         UClientImage_Base::callerIsValidMethod = isValidMethod;
 bPFpcu        UClientImage_Base::callerIsValidRequest = isValidRequest;
 bPFpcu        UClientImage_Base::callerIsValidRequestExt = isValidRequestExt;
@@ -58,6 +64,14 @@ struct iovec  UClientImage_Base::iov_sav[4];
 struct iovec  UClientImage_Base::iov_vec[4];
 struct iovec* UClientImage_Base::piov;
 
+UClientImage_Base* UClientImage_Base::first_idle;
+UClientImage_Base* UClientImage_Base::last_idle;
+
+#ifdef U_ZEROCOPY_SUPPORT
+time_t             UClientImage_Base::zc_orphan_time;
+UVector<UString>*  UClientImage_Base::vzc_orphan[2];
+#endif
+
 // NB: these are for ULib Servlet Page (USP) - USP_PRINTF...
 
 UString* UClientImage_Base::_value;
@@ -132,11 +146,20 @@ UClientImage_Base::UClientImage_Base()
    socket       = 0;
    logbuf       = (UServer_Base::isLog() ? U_NEW(UString(200U)) : 0);
    data_pending = 0;
+   async_response = 0;
 
    reset();
 
    flag.u     = 0;
    last_event = u_now->tv_sec;
+   prev_idle  =
+   next_idle  = 0;
+
+#ifdef U_ZEROCOPY_SUPPORT
+   zc_next =
+   zc_done =
+   zc_mask = 0;
+#endif
 
    // NB: array are not pointers (virtual table can shift the address of 'this')...
 
@@ -396,6 +419,138 @@ void UClientImage_Base::setSendfile(int _sfd, uint32_t _start, uint32_t _count)
    UServer_Base::pClientImage->sfd   = _sfd;
 }
 
+/**
+ * multipart/byteranges with sendfile(): the first part is sent as usual (the first delimiter with the header and the range with sendfile()),
+ * for each of the next parts we have a record with the range of the file and the delimiter (with the header of the part) to write before it.
+ * The last record has the close delimiter and no range...
+ */
+
+typedef struct usendfilepart {
+   uint32_t start, count, len; // NB: followed by len bytes of the delimiter...
+} usendfilepart;
+
+void UClientImage_Base::addSendfilePart(UString& buffer, uint32_t _start, uint32_t _count, const char* delimiter, uint32_t len)
+{
+   U_TRACE(0, "UClientImage_Base::addSendfilePart(%V,%u,%u,%.*S,%u)", buffer.rep, _start, _count, len, delimiter, len)
+
+   usendfilepart part = { _start, _count, len };
+
+   (void) buffer.append((const char*)&part, sizeof(usendfilepart));
+   (void) buffer.append(delimiter, len);
+}
+
+void UClientImage_Base::setSendfilePart(const UString& buffer)
+{
+   U_TRACE(0, "UClientImage_Base::setSendfilePart(%V)", buffer.rep)
+
+   U_INTERNAL_ASSERT(buffer)
+   U_INTERNAL_ASSERT_MAJOR(UServer_Base::pClientImage->count, 0)
+
+   UServer_Base::pClientImage->sendfile_part     = buffer;
+   UServer_Base::pClientImage->sendfile_part_pos = 0;
+}
+
+const char* UClientImage_Base::nextSendfilePart(uint32_t* plen)
+{
+   U_TRACE(0, "UClientImage_Base::nextSendfilePart(%p)", plen)
+
+   U_INTERNAL_ASSERT(sendfile_part)
+   U_INTERNAL_ASSERT_MINOR(sendfile_part_pos, sendfile_part.size())
+
+   usendfilepart part;
+   const char* ptr = sendfile_part.c_pointer(sendfile_part_pos);
+
+   U_MEMCPY(&part, ptr, sizeof(usendfilepart));
+
+   U_INTERNAL_DUMP("part.start = %u part.count = %u part.len = %u", part.start, part.count, part.len)
+
+   sendfile_part_pos += sizeof(usendfilepart) + part.len;
+
+   start = part.start;
+   count = part.count; // NB: 0 for the close delimiter...
+   *plen = part.len;
+
+   U_RETURN_POINTER(ptr + sizeof(usendfilepart), char);
+}
+
+bool UClientImage_Base::writeSendfilePart()
+{
+   U_TRACE_NO_PARAM(0, "UClientImage_Base::writeSendfilePart()")
+
+   uint32_t len;
+   const char* delimiter = nextSendfilePart(&len);
+
+   // NB: the delimiter is small, so we can wait for the socket to become writable...
+
+   int iBytesWrite = USocketExt::write(socket, delimiter, len, U_TIMEOUT_MS);
+
+   if (iBytesWrite > 0) U_SRV_STAT_ADD(cnt_bytes_write, iBytesWrite);
+
+   if (iBytesWrite != (int)len)
+      {
+      U_SRV_LOG("sendfile of multipart response failed - sock_fd %d sfd %d (%d bytes of %u)", socket->iSockDesc, sfd, iBytesWrite, len);
+
+      U_ClientImage_pclose(this) |= U_YES; // NB: we must close the connection...
+
+      count = 0;
+      }
+
+   if (count == 0) // NB: close delimiter...
+      {
+      sendfile_part.clear();
+
+      U_RETURN(false);
+      }
+
+   U_RETURN(true);
+}
+
+void UClientImage_Base::setLastEvent()
+{
+   U_TRACE_NO_PARAM(0, "UClientImage_Base::setLastEvent()")
+
+   last_event = u_now->tv_sec;
+
+   // NB: the list is needed only to check for idle connection (REQ_TIMEOUT)...
+
+   if (UServer_Base::ptime &&
+       last_idle != this)
+      {
+      removeFromIdleList();
+
+      // we put it at the end of the list (the more recent event)
+
+      prev_idle = last_idle;
+      next_idle = 0;
+
+      if (last_idle) last_idle->next_idle = this;
+      else           first_idle           = this;
+
+      last_idle = this;
+      }
+
+   U_INTERNAL_DUMP("first_idle = %p last_idle = %p", first_idle, last_idle)
+}
+
+void UClientImage_Base::removeFromIdleList()
+{
+   U_TRACE_NO_PARAM(0, "UClientImage_Base::removeFromIdleList()")
+
+   if (prev_idle) prev_idle->next_idle = next_idle;
+   else
+      {
+      if (first_idle != this) return; // not in the list
+
+      first_idle = next_idle;
+      }
+
+   if (next_idle) next_idle->prev_idle = prev_idle;
+   else           last_idle            = prev_idle;
+
+   prev_idle =
+   next_idle = 0;
+}
+
 // define method VIRTUAL of class UEventFd
 
 void UClientImage_Base::handlerDelete()
@@ -404,6 +559,8 @@ void UClientImage_Base::handlerDelete()
 
    bool bsocket_open = socket->isOpen();
 
+   removeFromIdleList();
+
 #if !defined(USE_LIBEVENT) && defined(HAVE_EPOLL_WAIT) && defined(DEBUG)
    if (UNLIKELY(UNotifier::num_connection <= UNotifier::min_connection))
       {
@@ -449,10 +606,30 @@ void UClientImage_Base::handlerDelete()
 
    U_INTERNAL_DUMP("tot_connection = %d", U_SRV_TOT_CONNECTION)
 
+   U_SRV_STAT_SUB(cnt_active, 1);
+
 #ifdef U_CLASSIC_SUPPORT
    if (UServer_Base::isClassic()) U_EXIT(0);
 #endif
 
+#ifdef U_ZEROCOPY_SUPPORT
+   if (zc_next != zc_done) releaseZeroCopy(bsocket_open);
+
+   zc_next =
+   zc_done =
+   zc_mask = 0;
+#endif
+
+   if (async_response)
+      {
+      UEventFd* item = async_response;
+                       async_response = 0;
+
+      UNotifier::handlerDelete(item); // NB: with isAsyncResponse() the handler know that the client is gone...
+
+      UEventFd::op_mask = EPOLLIN | EPOLLRDHUP | EPOLLET;
+      }
+
    if (bsocket_open) socket->close();
 
    --UNotifier::num_connection;
@@ -498,7 +675,11 @@ void UClientImage_Base::handlerDelete()
 
    flag.u = 0;
 
+#if defined(ENABLE_THREAD) && !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
+   __atomic_store_n(&(UEventFd::fd), -1, __ATOMIC_RELEASE); // NB: with PREFORK_CHILD == -1 now the main thread can reuse this client image...
+#else
    UEventFd::fd = -1;
+#endif
 
    U_INTERNAL_ASSERT_EQUALS(data_pending, 0)
    U_INTERNAL_ASSERT_EQUALS(UEventFd::op_mask, EPOLLIN | EPOLLRDHUP | EPOLLET)
@@ -533,7 +714,7 @@ int UClientImage_Base::handlerTimeout()
                 UEventFd::fd, socket->iSockDesc, UNotifier::num_connection, UNotifier::min_connection,
                 UServer_Base::isParallelizationChild(), sfd, UEventFd::op_mask);
 
-      last_event = u_now->tv_sec;
+      setLastEvent();
 
       U_RETURN(U_NOTIFIER_OK);
       }
@@ -643,10 +824,27 @@ bool UClientImage_Base::startRequest()
    U_RETURN(false);
 }
 
+void UClientImage_Base::setStatPhase(int phase)
+{
+   U_TRACE(0, "UClientImage_Base::setStatPhase(%d)", phase)
+
+   uint64_t now = UServer_Base::getStatTime();
+
+   UServer_Base::statLatency(phase, now - time_phase);
+
+   time_phase = now;
+}
+
 void UClientImage_Base::endRequest()
 {
    U_TRACE_NO_PARAM(0, "UClientImage_Base::endRequest()")
 
+   uint64_t now = UServer_Base::getStatTime();
+
+   UServer_Base::statRequest(U_http_info.nResponseCode, now - time_stat);
+
+   time_stat = time_phase = now; // NB: with pipeline the next request start here...
+
 #ifndef U_SERVER_CHECK_TIME_BETWEEN_REQUEST
    U_gettimeofday; // NB: optimization if it is enough a time resolution of one second...
 #else
@@ -965,6 +1163,8 @@ bool UClientImage_Base::genericRead()
       u__memcpy(rbuffer->data(), data_pending->data(), rbuffer->rep->_length = data_pending->size(), __PRETTY_FUNCTION__);
       }
 
+   uint32_t sz = rbuffer->size();
+
    socket->iState = USocket::CONNECT; // prepare socket before read
 
    if (USocketExt::read(socket, *rbuffer, U_SINGLE_READ, 0) == false) // NB: timeout == 0 means that we put the socket fd on epoll queue if EAGAIN...
@@ -975,6 +1175,8 @@ bool UClientImage_Base::genericRead()
       U_RETURN(false);
       }
 
+   U_SRV_STAT_ADD(cnt_bytes_read, rbuffer->size() - sz);
+
    if (data_pending)
       {
       if (callerIsValidRequestExt(U_STRING_TO_PARAM(*rbuffer)) == false) // partial valid (not complete)
@@ -1021,12 +1223,31 @@ int UClientImage_Base::handlerRead() // Connection-wide hooks
    int result;
    uint32_t sz;
 
+   if (async_response)
+      {
+      if (U_ClientImage_tunnel(this))
+         {
+         U_ClientImage_state = U_PLUGIN_HANDLER_AGAIN; // NB: the tunnel read from our socket until EAGAIN (see UProxyConnection::handlerRead())...
+
+         return async_response->handlerRead();
+         }
+
+      // NB: the response to the previous request is not yet terminated, we read the next request after (see endAsyncResponse())...
+
+      U_ClientImage_rearm(this) = U_YES;
+      U_ClientImage_state       = U_PLUGIN_HANDLER_AGAIN;
+
+      U_RETURN(U_NOTIFIER_OK);
+      }
+
    prepareForRead();
 
 start:
    U_INTERNAL_ASSERT_EQUALS(U_ClientImage_pipeline,     false)
    U_INTERNAL_ASSERT_EQUALS(U_ClientImage_data_missing, false)
 
+   time_stat = time_phase = UServer_Base::getStatTime();
+
    if (genericRead() == false)
       {
       if (U_ClientImage_state == U_PLUGIN_HANDLER_AGAIN &&
@@ -1048,6 +1269,8 @@ start:
    UServer_Base::nread++;
 #endif
 
+   setStatPhase(UServer_Base::STAT_READ);
+
    U_INTERNAL_ASSERT(socket->isOpen())
 
    rstart = 0;
@@ -1312,6 +1535,19 @@ processing:
 
       U_INTERNAL_ASSERT_DIFFERS(U_ClientImage_parallelization, U_PARALLELIZATION_PARENT)
 
+#  ifndef U_HTTP2_DISABLE
+      if (U_http_version == '2')
+         {
+         // NB: with HTTP/2 the body (also with sendfile()) is sent in DATA frames, within the flow control windows of the peer...
+
+         setStatPhase(UServer_Base::STAT_PROCESS);
+
+         if (UHTTP2::writeResponse() == false) goto error;
+
+         setStatPhase(UServer_Base::STAT_WRITE);
+         }
+      else
+#  endif
       if (count == 0)
          {
 #ifndef U_PIPELINE_HOMOGENEOUS_DISABLE
@@ -1319,8 +1555,12 @@ write:
 #endif
          U_INTERNAL_DUMP("U_ClientImage_pipeline = %b U_ClientImage_data_missing = %b", U_ClientImage_pipeline, U_ClientImage_data_missing)
 
+         setStatPhase(UServer_Base::STAT_PROCESS);
+
          result = handlerResponse();
 
+         setStatPhase(UServer_Base::STAT_WRITE);
+
 #     ifndef U_PIPELINE_HOMOGENEOUS_DISABLE
          U_INTERNAL_DUMP("nrequest = %u resto = %u U_ClientImage_pipeline = %b U_ClientImage_close = %b rstart = %u",
                           nrequest,     resto,     U_ClientImage_pipeline,     U_ClientImage_close,     rstart)
@@ -1357,11 +1597,15 @@ write:
          U_INTERNAL_ASSERT_EQUALS(nrequest, 0)
          U_INTERNAL_ASSERT_EQUALS(UEventFd::op_mask, EPOLLIN | EPOLLRDHUP | EPOLLET)
 
+         setStatPhase(UServer_Base::STAT_PROCESS);
+
          if (writeResponse() == false ||
              UClientImage_Base::handlerWrite() == U_NOTIFIER_DELETE)
             {
             goto error;
             }
+
+         setStatPhase(UServer_Base::STAT_WRITE);
          }
       }
 
@@ -1413,7 +1657,7 @@ death:
       UServer_Base::endNewChild(); // no return;
       }
 
-   last_event = u_now->tv_sec;
+   setLastEvent();
 
    U_INTERNAL_ASSERT(socket->isOpen())
    U_INTERNAL_ASSERT_DIFFERS(U_ClientImage_parallelization, U_PARALLELIZATION_CHILD)
@@ -1496,6 +1740,10 @@ bool UClientImage_Base::writeResponse()
    {
    U_INTERNAL_ASSERT_EQUALS(nrequest, 0)
 
+#ifdef U_ZEROCOPY_SUPPORT
+   if (sz2 >= UServer_Base::min_size_for_zerocopy) iBytesWrite = writeZeroCopy();
+   else
+#endif
 #if defined(USE_LIBSSL) || defined(_MSWINDOWS_)
    iBytesWrite = USocketExt::writev( socket, iov_vec+idx, iovcnt, ncount, 0);
 #else
@@ -1506,13 +1754,19 @@ bool UClientImage_Base::writeResponse()
 #ifdef U_THROTTLING_SUPPORT
    if (iBytesWrite > 0) bytes_sent += iBytesWrite;
 #endif
+   if (iBytesWrite > 0) U_SRV_STAT_ADD(cnt_bytes_write, iBytesWrite);
 #ifdef DEBUG
    if (iBytesWrite > 0) UServer_Base::stats_bytes += iBytesWrite;
 #endif
 
    if (iBytesWrite == (int)ncount) U_RETURN(true);
 
-   if (socket->isClosed()) U_RETURN(false);
+   if (socket->isClosed())
+      {
+      U_SRV_STAT_ADD(cnt_error_write, 1);
+
+      U_RETURN(false);
+      }
 
    if (iBytesWrite == 0)
       {
@@ -1599,6 +1853,7 @@ loop:
 #ifdef U_THROTTLING_SUPPORT
    if (iBytesWrite > 0) bytes_sent += iBytesWrite;
 #endif
+   if (iBytesWrite > 0) U_SRV_STAT_ADD(cnt_bytes_write, iBytesWrite);
 #ifdef DEBUG
    if (iBytesWrite > 0) UServer_Base::stats_bytes += iBytesWrite;
 #endif
@@ -1626,6 +1881,8 @@ loop:
 
       U_SRV_LOG_WITH_ADDR("sending partial response: failed - sk %s, (%u bytes of %u)%.*s to", bopen ? "open" : "close", iBytesWrite, ncount, msg_len, " [pipeline]");
 
+      U_SRV_STAT_ADD(cnt_error_write, 1);
+
       if (bopen) socket->abortive_close();
 
       goto end;
@@ -1645,6 +1902,187 @@ end:
    U_RETURN(result);
 }
 
+#ifdef U_ZEROCOPY_SUPPORT
+int UClientImage_Base::writeZeroCopy()
+{
+   U_TRACE_NO_PARAM(0, "UClientImage_Base::writeZeroCopy()")
+
+   U_INTERNAL_DUMP("zc_next = %u zc_done = %u zc_mask = %B", zc_next, zc_done, zc_mask)
+
+   U_INTERNAL_ASSERT_EQUALS(UServer_Base::bssl, false)
+
+   if ((zc_next - zc_done) == U_ZEROCOPY_MAX_PENDING) readZeroCopyCompletion();
+
+   if ((zc_next - zc_done) == U_ZEROCOPY_MAX_PENDING) // NB: too many send not completed, we use the copy path...
+      {
+      return USocketExt::_writev(socket, iov_vec+idx, iovcnt, ncount, 0);
+      }
+
+   if (zc_next == 0 &&
+       socket->setSockOpt(SOL_SOCKET, SO_ZEROCOPY, (const int[]){ 1 }) == false)
+      {
+      U_WARNING("MSG_ZEROCOPY is not supported by the kernel (SO_ZEROCOPY failed), it is disabled");
+
+      UServer_Base::min_size_for_zerocopy = U_NOT_FOUND;
+
+      return USocketExt::_writev(socket, iov_vec+idx, iovcnt, ncount, 0);
+      }
+
+   bool bzerocopy;
+   int iBytesWrite = USocketExt::writev_zerocopy(socket, iov_vec+idx, iovcnt, ncount, bzerocopy);
+
+   if (bzerocopy)
+      {
+      UStringRep* rep = body->rep;
+
+      rep->hold(); // NB: the kernel read from the pages of the body until the completion, so the next response must not reuse it...
+
+      zc_rep[zc_next++ % U_ZEROCOPY_MAX_PENDING] = rep;
+      }
+
+   U_RETURN(iBytesWrite);
+}
+
+void UClientImage_Base::readZeroCopyCompletion()
+{
+   U_TRACE_NO_PARAM(1, "UClientImage_Base::readZeroCopyCompletion()")
+
+   U_INTERNAL_DUMP("zc_next = %u zc_done = %u zc_mask = %B", zc_next, zc_done, zc_mask)
+
+   uint32_t id, slot;
+   struct msghdr msg;
+   struct cmsghdr* cm;
+   char control[128];
+   struct sock_extended_err* serr;
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", &msg, 0, sizeof(struct msghdr));
+
+loop:
+   msg.msg_control    = control;
+   msg.msg_controllen = sizeof(control);
+
+   // NB: the read of the error queue never block, with the queue empty we have EAGAIN...
+
+   if (U_SYSCALL(recvmsg, "%d,%p,%d", socket->iSockDesc, &msg, MSG_ERRQUEUE) != -1)
+      {
+      for (cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm))
+         {
+         if ((cm->cmsg_level == SOL_IP   && cm->cmsg_type == IP_RECVERR) ||
+             (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))
+            {
+            serr = (struct sock_extended_err*) CMSG_DATA(cm);
+
+            U_INTERNAL_DUMP("ee_errno = %u ee_origin = %u ee_code = %u ee_info = %u ee_data = %u",
+                             serr->ee_errno, serr->ee_origin, serr->ee_code, serr->ee_info, serr->ee_data)
+
+            if (serr->ee_errno  == 0 &&
+                serr->ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+               {
+               // NB: the range [ee_info,ee_data] of send is completed (if the kernel has copied the data ee_code is SO_EE_CODE_ZEROCOPY_COPIED)...
+
+               id = serr->ee_info;
+
+               do {
+                  if ((id - zc_done) < (zc_next - zc_done)) zc_mask |= (1U << (id % U_ZEROCOPY_MAX_PENDING));
+                  }
+               while (id++ != serr->ee_data);
+               }
+            }
+         }
+
+      goto loop;
+      }
+
+   while (zc_done != zc_next)
+      {
+      slot = zc_done % U_ZEROCOPY_MAX_PENDING;
+
+      if ((zc_mask & (1U << slot)) == 0) break;
+
+      zc_mask &= ~(1U << slot);
+
+      zc_rep[slot]->release();
+
+      ++zc_done;
+      }
+
+   U_INTERNAL_DUMP("zc_next = %u zc_done = %u zc_mask = %B", zc_next, zc_done, zc_mask)
+}
+
+void UClientImage_Base::releaseZeroCopy(bool bopen)
+{
+   U_TRACE(0, "UClientImage_Base::releaseZeroCopy(%b)", bopen)
+
+   U_INTERNAL_ASSERT_DIFFERS(zc_next, zc_done)
+
+   if (bopen)
+      {
+      readZeroCopyCompletion();
+
+      if (zc_next == zc_done) return;
+      }
+
+   // NB: the body of the send not completed are held in two generations, each one is released after the grace time...
+
+   if (vzc_orphan[0] == 0)
+      {
+      vzc_orphan[0] = U_NEW(UVector<UString>);
+      vzc_orphan[1] = U_NEW(UVector<UString>);
+
+      zc_orphan_time = u_now->tv_sec;
+      }
+   else if ((u_now->tv_sec - zc_orphan_time) >= U_ZEROCOPY_GRACE_TIME)
+      {
+      UVector<UString>* tmp = vzc_orphan[1];
+
+      tmp->clear();
+
+      vzc_orphan[1] = vzc_orphan[0];
+      vzc_orphan[0] = tmp;
+
+      zc_orphan_time = u_now->tv_sec;
+      }
+
+   UStringRep* rep;
+
+   for (; zc_done != zc_next; ++zc_done)
+      {
+      rep = zc_rep[zc_done % U_ZEROCOPY_MAX_PENDING];
+
+      vzc_orphan[0]->push(rep);
+
+      rep->release();
+      }
+
+   U_INTERNAL_DUMP("vzc_orphan[0]->size() = %u vzc_orphan[1]->size() = %u", vzc_orphan[0]->size(), vzc_orphan[1]->size())
+}
+
+int UClientImage_Base::handlerError()
+{
+   U_TRACE_NO_PARAM(0, "UClientImage_Base::handlerError()")
+
+   U_INTERNAL_DUMP("zc_next = %u zc_done = %u", zc_next, zc_done)
+
+   // NB: EPOLLERR can be the notification of the completion of a MSG_ZEROCOPY send, the connection is good if there is no pending error...
+
+   if (zc_next != zc_done)
+      {
+      readZeroCopyCompletion();
+
+      int error = 0;
+      uint32_t len = sizeof(int);
+
+      if (socket->getSockOpt(SOL_SOCKET, SO_ERROR, (void*)&error, len) &&
+          error == 0)
+         {
+         U_RETURN(U_NOTIFIER_OK);
+         }
+      }
+
+   U_RETURN(U_NOTIFIER_DELETE);
+}
+#endif
+
 void UClientImage_Base::close()
 {
    U_TRACE_NO_PARAM(0, "UClientImage_Base::close()")
@@ -1762,10 +2200,62 @@ int UClientImage_Base::handlerResponse()
    U_RETURN(U_NOTIFIER_DELETE);
 }
 
+void UClientImage_Base::waitForAsyncResponse(bool bwrite)
+{
+   U_TRACE(0, "UClientImage_Base::waitForAsyncResponse(%b)", bwrite)
+
+   U_INTERNAL_ASSERT_POINTER(async_response)
+   U_INTERNAL_ASSERT(socket->isOpen())
+
+   // NB: if bwrite we wait for the socket to become writable, otherwise we come back to wait for the next request...
+
+   uint32_t mask = (bwrite ? EPOLLOUT : EPOLLIN | EPOLLRDHUP | EPOLLET);
+
+   if (UEventFd::op_mask != mask)
+      {
+      UEventFd::op_mask = mask;
+
+      UNotifier::modify(this);
+      }
+}
+
+void UClientImage_Base::endAsyncResponse(bool bclose)
+{
+   U_TRACE(0, "UClientImage_Base::endAsyncResponse(%b)", bclose)
+
+   U_INTERNAL_ASSERT_POINTER(async_response)
+
+   async_response = 0;
+
+   U_ClientImage_tunnel(this) = 0;
+
+   if (socket->isOpen())
+      {
+      if (UEventFd::op_mask == EPOLLOUT ||
+          U_ClientImage_rearm(this))
+         {
+         // NB: we must be notified for the data that maybe has arrived in the meanwhile...
+
+         UEventFd::op_mask = EPOLLIN | EPOLLRDHUP | EPOLLET;
+
+         U_ClientImage_rearm(this) = 0;
+
+         UNotifier::modify(this);
+         }
+
+      // NB: we are inside the handler of another event, so the close is done when the event manager notify us the hangup...
+
+      if (bclose) (void) socket->shutdown(SHUT_RDWR);
+      else        setLastEvent();
+      }
+}
+
 int UClientImage_Base::handlerWrite()
 {
    U_TRACE_NO_PARAM(0, "UClientImage_Base::handlerWrite()")
 
+   if (async_response) return async_response->handlerWrite(); // NB: the socket is writable, the handler can continue to write the response...
+
 #if !defined(USE_LIBEVENT) && defined(HAVE_EPOLL_WAIT) && defined(DEBUG)
    if (UNLIKELY(count == 0))
       {
@@ -1804,6 +2294,7 @@ write:
 #ifdef U_THROTTLING_SUPPORT
    if (iBytesWrite > 0) bytes_sent += iBytesWrite;
 #endif
+   if (iBytesWrite > 0) U_SRV_STAT_ADD(cnt_bytes_write, iBytesWrite);
 #ifdef DEBUG
    if (iBytesWrite > 0) UServer_Base::stats_bytes += iBytesWrite;
 #endif
@@ -1812,6 +2303,12 @@ write:
       {
       U_SRV_LOG_WITH_ADDR("sending sendfile response completed (%u bytes of %u) to", iBytesWrite, count);
 
+      if (sendfile_part &&
+          writeSendfilePart()) // NB: multipart/byteranges, we continue with the next range of the file...
+         {
+         goto write;
+         }
+
       if (bwrite)
          {
          UEventFd::op_mask = EPOLLIN | EPOLLRDHUP | EPOLLET;
@@ -1846,6 +2343,8 @@ write:
 
       U_INTERNAL_ASSERT_MAJOR(count, 0)
 
+      setLastEvent(); // NB: the connection is not idle while we are sending the response...
+
       if (bwrite) U_RETURN(U_NOTIFIER_OK);
 
       if (U_ClientImage_parallelization == U_PARALLELIZATION_CHILD)
@@ -1879,6 +2378,8 @@ wait:    if (UNotifier::waitForWrite(socket->iSockDesc, U_TIMEOUT_MS) == 1) goto
    count =  0;
    sfd   = -1;
 
+   if (sendfile_part) sendfile_part.clear();
+
    U_ClientImage_pclose(this) = 0;
 
    U_RETURN(U_NOTIFIER_DELETE);
@@ -1894,6 +2395,8 @@ const char* UClientImage_Base::dump(bool _reset) const
                   << "count                              " << count               << '\n'
                   << "bIPv6                              " << bIPv6               << '\n'
                   << "last_event                         " << last_event          << '\n'
+                  << "prev_idle       (UClientImage_Base " << (void*)prev_idle    << ")\n"
+                  << "next_idle       (UClientImage_Base " << (void*)next_idle    << ")\n"
                   << "socket          (USocket           " << (void*)socket       << ")\n"
                   << "body            (UString           " << (void*)body         << ")\n"
                   << "logbuf          (UString           " << (void*)logbuf       << ")\n"
@@ -1901,7 +2404,8 @@ const char* UClientImage_Base::dump(bool _reset) const
                   << "wbuffer         (UString           " << (void*)wbuffer      << ")\n"
                   << "request         (UString           " << (void*)request      << ")\n"
                   << "environment     (UString           " << (void*)environment  << ")\n"
-                  << "data_pending    (UString           " << (void*)data_pending << ')';
+                  << "data_pending    (UString           " << (void*)data_pending << ")\n"
+                  << "async_response  (UEventFd          " << (void*)async_response << ')';
 
    if (_reset)
       {
@@ -134,12 +134,97 @@ void UFCGIPlugIn::fill_FCGIBeginRequest(u_char type, u_short content_length)
 
 // beginRecord.header.version        = FCGI_VERSION_1;
    beginRecord.header.type           = type;
-   beginRecord.header.request_id     = htons((uint16_t)u_pid);
+   beginRecord.header.request_id     = htons(request_id);
    beginRecord.header.content_length = htons(content_length);
 // beginRecord.header.padding_length = padding_length;
 // beginRecord.header.reserved       = 0;
 }
 
+// Read the length of a name-value pair (1 or 4 bytes)
+
+static inline uint32_t getLength(const unsigned char*& ptr)
+{
+   if ((*ptr & 0x80) == 0) return *ptr++;
+
+   uint32_t len = ((ptr[0] & 0x7f) << 24) | (ptr[1] << 16) | (ptr[2] << 8) | ptr[3];
+
+   ptr += 4;
+
+   return len;
+}
+
+bool UFCGIPlugIn::getValues()
+{
+   U_TRACE_NO_PARAM(0, "UFCGIPlugIn::getValues()")
+
+   // NB: we ask the limits of the application with the name-value pairs of the variables with the value empty...
+
+   static const char names[] = "\016\000" "FCGI_MAX_CONNS"
+                               "\015\000" "FCGI_MAX_REQS"
+                               "\017\000" "FCGI_MPXS_CONNS";
+
+   FCGI_Header* h;
+   uint32_t clength, name_len, value_len, value;
+   const unsigned char* ptr;
+   const unsigned char* end;
+   UString request(FCGI_HEADER_LEN + U_CONSTANT_SIZE(names));
+
+   request_id = FCGI_NULL_REQUEST_ID; // NB: it is a management record...
+
+   fill_FCGIBeginRequest(FCGI_GET_VALUES, U_CONSTANT_SIZE(names));
+
+   (void) request.append((const char*)&beginRecord, FCGI_HEADER_LEN);
+   (void) request.append(names, U_CONSTANT_SIZE(names));
+
+   connection->prepareRequest(request);
+
+   if (connection->sendRequestAndReadResponse() == false                ||
+       (connection->response.size() < FCGI_HEADER_LEN                   &&
+        connection->readResponse(FCGI_HEADER_LEN - connection->response.size()) == false))
+      {
+      U_RETURN(false);
+      }
+
+   h = (FCGI_Header*)connection->response.data();
+
+   U_INTERNAL_DUMP("version = %C type = %C request_id = %u", h->version, h->type, ntohs(h->request_id))
+
+   if (h->type != FCGI_GET_VALUES_RESULT) U_RETURN(false); // NB: ex. FCGI_UNKNOWN_TYPE...
+
+   clength = FCGI_HEADER_LEN + ntohs(h->content_length);
+
+   if (connection->response.size() < clength &&
+       connection->readResponse(clength - connection->response.size()) == false)
+      {
+      U_RETURN(false);
+      }
+
+   ptr = (const unsigned char*)connection->response.c_pointer(FCGI_HEADER_LEN);
+   end = (const unsigned char*)connection->response.c_pointer(clength);
+
+   while (ptr < end)
+      {
+       name_len = getLength(ptr);
+      value_len = getLength(ptr);
+
+      if ((ptr + name_len + value_len) > end) break;
+
+      value = u_strtoul((const char*)ptr + name_len, (const char*)ptr + name_len + value_len);
+
+      U_INTERNAL_DUMP("name = %.*S value = %u", name_len, ptr, value)
+
+           if (name_len == U_CONSTANT_SIZE("FCGI_MAX_CONNS")  && memcmp(ptr, U_CONSTANT_TO_PARAM("FCGI_MAX_CONNS"))  == 0) fcgi_max_conns  = value;
+      else if (name_len == U_CONSTANT_SIZE("FCGI_MAX_REQS")   && memcmp(ptr, U_CONSTANT_TO_PARAM("FCGI_MAX_REQS"))   == 0) fcgi_max_reqs   = value;
+      else if (name_len == U_CONSTANT_SIZE("FCGI_MPXS_CONNS") && memcmp(ptr, U_CONSTANT_TO_PARAM("FCGI_MPXS_CONNS")) == 0) fcgi_mpxs_conns = value;
+
+      ptr += name_len + value_len;
+      }
+
+   connection->clearData();
+
+   U_RETURN(true);
+}
+
 // ---------------------------------------------------------------------------------------------------------------
 // END Fast CGI stuff
 // ---------------------------------------------------------------------------------------------------------------
@@ -148,6 +233,10 @@ U_CREAT_FUNC(server_plugin_fcgi, UFCGIPlugIn)
 
 bool          UFCGIPlugIn::fcgi_keep_conn;
 char          UFCGIPlugIn::environment_type;
+u_short       UFCGIPlugIn::request_id;
+uint32_t      UFCGIPlugIn::fcgi_max_reqs;
+uint32_t      UFCGIPlugIn::fcgi_max_conns;
+uint32_t      UFCGIPlugIn::fcgi_mpxs_conns;
 UClient_Base* UFCGIPlugIn::connection;
 
 UFCGIPlugIn::UFCGIPlugIn()
@@ -178,7 +267,9 @@ int UFCGIPlugIn::handlerConfig(UFileConfig& cfg)
    //
    // RES_TIMEOUT    timeout for response from server FCGI
    // FCGI_KEEP_CONN If not zero, the server FCGI does not close the connection after
-   //                responding to request; the plugin retains responsibility for the connection.
+   //                responding to request; the plugin retains responsibility for the connection
+   //                (every process keep its connection, it is disabled if the FCGI_MAX_CONNS of the
+   //                 application is less than the number of process)
    //
    // LOG_FILE       location for file log (use server log if exist)
    // ------------------------------------------------------------------------------------------
@@ -195,7 +286,10 @@ int UFCGIPlugIn::handlerConfig(UFileConfig& cfg)
 
       if (x) UHTTP::fcgi_uri_mask = U_NEW(UString(x));
 
-      fcgi_keep_conn = cfg.readBoolean(U_CONSTANT_TO_PARAM("CGI_KEEP_CONN"));
+      // NB: CGI_KEEP_CONN is the old name...
+
+      fcgi_keep_conn = cfg.readBoolean(U_CONSTANT_TO_PARAM("FCGI_KEEP_CONN")) ||
+                       cfg.readBoolean(U_CONSTANT_TO_PARAM("CGI_KEEP_CONN"));
 
       U_RETURN(U_PLUGIN_HANDLER_PROCESSED | U_PLUGIN_HANDLER_GO_ON);
       }
@@ -223,6 +317,28 @@ int UFCGIPlugIn::handlerInit()
          {
          U_SRV_LOG("connection to the fastcgi-backend %V accepted", connection->host_port.rep);
 
+         if (getValues())
+            {
+            U_SRV_LOG("fastcgi-backend %V: FCGI_MAX_CONNS = %u FCGI_MAX_REQS = %u FCGI_MPXS_CONNS = %u",
+                      connection->host_port.rep, fcgi_max_conns, fcgi_max_reqs, fcgi_mpxs_conns);
+
+            int nproc = (UServer_Base::preforked_num_kids > 1 ? UServer_Base::preforked_num_kids : 1);
+
+            if (fcgi_keep_conn &&
+                fcgi_max_conns &&
+                fcgi_max_conns < (uint32_t)nproc)
+               {
+               U_SRV_LOG("WARNING: fastcgi-backend %V accept only %u connections but we have %d process, FCGI_KEEP_CONN is disabled",
+                         connection->host_port.rep, fcgi_max_conns, nproc);
+
+               fcgi_keep_conn = false;
+               }
+            }
+
+         // NB: the connection is made by every process when needed, otherwise the socket is shared between the children after the fork...
+
+         connection->close();
+
          set_FCGIBeginRequest();
 
 #     ifndef U_ALIAS
@@ -257,10 +373,15 @@ int UFCGIPlugIn::handlerRequest()
    if (connection &&
        UHTTP::isFCGIRequest())
       {
+      // NB: the id must be unique only among the requests active on the connection...
+
+      if (++request_id == FCGI_NULL_REQUEST_ID) request_id = 1;
+
       fill_FCGIBeginRequest(FCGI_BEGIN_REQUEST, sizeof(FCGI_BeginRequestBody));
 
       FCGI_Header* h;
       char* equalPtr;
+      bool berror = true;
       char* envp[128];
       uint32_t clength, pos, size;
       unsigned char  headerBuff[8];
@@ -363,13 +484,16 @@ int UFCGIPlugIn::handlerRequest()
 
       // Send request and read fast cgi header+record
 
+      U_SRV_STAT_ADD(cnt_fcgi_request, 1);
+      U_SRV_STAT_ADD(cnt_fcgi_wait,    1); // NB: the sum on all the children is the depth of the queue of the fastcgi-backend...
+
       connection->prepareRequest(request);
 
       if (connection->sendRequestAndReadResponse() == false)
          {
          UHTTP::setInternalError();
 
-         U_RETURN(U_PLUGIN_HANDLER_PROCESSED | U_PLUGIN_HANDLER_GO_ON);
+         goto end;
          }
 
       if (fcgi_keep_conn == false)
@@ -400,8 +524,7 @@ int UFCGIPlugIn::handlerRequest()
 
          U_INTERNAL_DUMP("version = %C request_id = %u", h->version, ntohs(h->request_id))
 
-         U_INTERNAL_ASSERT_EQUALS(h->version,    FCGI_VERSION_1)
-         U_INTERNAL_ASSERT_EQUALS(h->request_id, htons((uint16_t)u_pid))
+         U_INTERNAL_ASSERT_EQUALS(h->version, FCGI_VERSION_1)
 
          h->content_length = ntohs(h->content_length);
 
@@ -426,45 +549,55 @@ int UFCGIPlugIn::handlerRequest()
 
          // Process this fcgi record
 
-         U_INTERNAL_DUMP("h->type = %C", h->type)
+         U_INTERNAL_DUMP("h->type = %C h->request_id = %u", h->type, ntohs(h->request_id))
 
-         switch (h->type)
-            {
-            case FCGI_STDOUT:
-               if (clength) (void) UClientImage_Base::wbuffer->append(connection->response.substr(pos, clength));
-            break;
-
-            case FCGI_STDERR:
-               (void) UFile::writeToTmp(connection->response.c_pointer(pos), clength, true, "server_plugin_fcgi.err", 0);
-            break;
+         // NB: we skip the management records (FCGI_NULL_REQUEST_ID) and the records of other requests...
 
-            case FCGI_END_REQUEST:
+         if (h->request_id == htons(request_id))
+            {
+            switch (h->type)
                {
-               FCGI_EndRequestBody* body = (FCGI_EndRequestBody*)connection->response.c_pointer(pos);
+               case FCGI_STDOUT:
+                  if (clength) (void) UClientImage_Base::wbuffer->append(connection->response.substr(pos, clength));
+               break;
 
-               U_INTERNAL_DUMP("protocol_status = %C app_status = %u", body->protocol_status, ntohl(body->app_status))
+               case FCGI_STDERR:
+                  (void) UFile::writeToTmp(connection->response.c_pointer(pos), clength, true, "server_plugin_fcgi.err", 0);
+               break;
 
-               if (body->protocol_status == FCGI_REQUEST_COMPLETE)
+               case FCGI_END_REQUEST:
                   {
-                  U_INTERNAL_ASSERT_EQUALS(pos + clength, connection->response.size())
+                  FCGI_EndRequestBody* body = (FCGI_EndRequestBody*)connection->response.c_pointer(pos);
 
-                  if (UHTTP::processCGIOutput(false, false)) UClientImage_Base::setRequestProcessed();
-                  else                                       UHTTP::setInternalError();
+                  U_INTERNAL_DUMP("protocol_status = %C app_status = %u", body->protocol_status, ntohl(body->app_status))
 
-                  goto end;
+                  if (body->protocol_status == FCGI_REQUEST_COMPLETE)
+                     {
+                     U_INTERNAL_ASSERT_EQUALS(pos + clength, connection->response.size())
+
+                     if (UHTTP::processCGIOutput(false, false) == false) UHTTP::setInternalError();
+                     else
+                        {
+                        berror = false;
+
+                        UClientImage_Base::setRequestProcessed();
+                        }
+
+                     goto end;
+                     }
                   }
-               }
-            // NB: lack of break is intentional...
+               // NB: lack of break is intentional...
 
-            // not implemented
+               // not implemented
 
-            case FCGI_UNKNOWN_TYPE:
-            case FCGI_GET_VALUES_RESULT:
-            default:
-               {
-               UHTTP::setInternalError();
+               case FCGI_UNKNOWN_TYPE:
+               case FCGI_GET_VALUES_RESULT:
+               default:
+                  {
+                  UHTTP::setInternalError();
 
-               goto end;
+                  goto end;
+                  }
                }
             }
 
@@ -480,6 +613,10 @@ int UFCGIPlugIn::handlerRequest()
          }
 
 end:
+      U_SRV_STAT_SUB(cnt_fcgi_wait, 1);
+
+      if (berror) U_SRV_STAT_ADD(cnt_fcgi_error, 1);
+
       connection->clearData();
 
       if (fcgi_keep_conn == false &&
@@ -499,7 +636,11 @@ end:
 #if defined(U_STDCPP_ENABLE) && defined(DEBUG)
 const char* UFCGIPlugIn::dump(bool reset) const
 {
-   *UObjectIO::os << "fcgi_keep_conn              " << fcgi_keep_conn         << '\n'
+   *UObjectIO::os << "request_id                  " << request_id             << '\n'
+                  << "fcgi_max_reqs               " << fcgi_max_reqs          << '\n'
+                  << "fcgi_keep_conn              " << fcgi_keep_conn         << '\n'
+                  << "fcgi_max_conns              " << fcgi_max_conns         << '\n'
+                  << "fcgi_mpxs_conns             " << fcgi_mpxs_conns        << '\n'
                   << "connection    (UClient_Base " << (void*)connection      << ')';
 
    if (reset)
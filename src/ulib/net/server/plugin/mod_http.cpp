@@ -74,12 +74,24 @@ int UHttpPlugIn::handlerConfig(UFileConfig& cfg)
    //
    // ENABLE_INOTIFY         enable automatic update of document root image with inotify
    // CACHE_FILE_MASK        mask (DOS regexp) of pathfile that content      be cached in memory (default: "*.css|*.js|*.*html|*.png|*.gif|*.jpg")
+   //                        (with the compressed variants gzip, brotli and zstd, these taken from the precompressed files <name>.br, <name>.zst if present)
    // CACHE_AVOID_MASK       mask (DOS regexp) of pathfile that presence NOT be cached in memory
    // NOCACHE_FILE_MASK      mask (DOS regexp) of pathfile that content  NOT be cached in memory
    // CACHE_FILE_STORE       pathfile of memory cache stored on filesystem
+   // CACHE_FILE_SHARED      flag to move the data of the memory cache in shared memory at startup (one copy for all the preforked children)
+   // CACHE_FILE_MEMORY      max size of the content of the files in the memory cache for process (0 => no limit), the less used are served from filesystem
+   //
+   // HTTP2_PUSH             flag to send with HTTP/2 (PUSH_PROMISE) the resources of the file cache linked from a page (css, javascript)
+   // HTTP2_PUSH_MANIFEST    pathfile of the list of the resources to push for a page (a line for page: <page> <resource> ...), instead of those linked from the content
+   //
+   // MICRO_CACHE_SIZE       size of the shared memory for the cache of the dynamic responses (USP/CGI) visible to all the preforked children (0 => disabled)
+   // MICRO_CACHE_RULE       vector of pair (mask (DOS regexp) of URI, time to live in seconds) of the dynamic responses to cache (ex: [ "/news*|/home" 5 /stat 1 ])
+   // MICRO_CACHE_STALE      seconds for which an expired response is still served while only one process regenerate it (stale-while-revalidate)
+   // MICRO_CACHE_VARY       list of comma separated request headers that are part of the key of the cache (ex: Accept-Language,Cookie)
    //
    // CGI_TIMEOUT            timeout for cgi execution
    // MOUNT_POINT            mount point application (to adjust var SCRIPT_NAME)
+   // STATUS_URI             URI where the statistics of the server are served (only to client with loopback or private address)
    // VIRTUAL_HOST           flag to activate practice of maintaining more than one server on one machine,
    //                        as differentiated by their apparent hostname
    // DIGEST_AUTHENTICATION  flag authentication method (yes = digest, no = basic)
@@ -98,6 +110,8 @@ int UHttpPlugIn::handlerConfig(UFileConfig& cfg)
    // This directive gives greater control over abnormal client request behavior, which may be useful for avoiding some forms of denial-of-service attacks
    // ----------------------------------------------------------------------------------------------------------------------------------------------------
    // LIMIT_REQUEST_BODY   restricts the total size of the HTTP request body sent from the client
+   // FORM_STREAM_MIN_SIZE min size of a multipart/form-data body that is parsed while it arrives, with the files written directly on disk (0 => disabled)
+   // FORM_FIELD_MAX_SIZE  max size of the fields (not file) kept in memory for a streamed multipart/form-data body (default 64k)
    // REQUEST_READ_TIMEOUT set timeout for receiving requests
    // ------------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -181,9 +195,12 @@ int UHttpPlugIn::handlerConfig(UFileConfig& cfg)
       UHTTP::cgi_timeout                     = cfg.readLong(U_CONSTANT_TO_PARAM("CGI_TIMEOUT"));
       UHTTP::limit_request_body              = cfg.readLong(U_CONSTANT_TO_PARAM("LIMIT_REQUEST_BODY"), U_STRING_MAX_SIZE);
       UHTTP::request_read_timeout            = cfg.readLong(U_CONSTANT_TO_PARAM("REQUEST_READ_TIMEOUT"));
+      UHTTP::form_stream_min_size            = cfg.readLong(U_CONSTANT_TO_PARAM("FORM_STREAM_MIN_SIZE"));
+      UHTTP::form_field_max_size             = cfg.readLong(U_CONSTANT_TO_PARAM("FORM_FIELD_MAX_SIZE"), 64 * 1024);
       UHTTP::enable_caching_by_proxy_servers = cfg.readBoolean(U_CONSTANT_TO_PARAM("ENABLE_CACHING_BY_PROXY_SERVERS"));
 
-      U_INTERNAL_DUMP("UHTTP::limit_request_body = %u", UHTTP::limit_request_body)
+      U_INTERNAL_DUMP("UHTTP::limit_request_body = %u UHTTP::form_stream_min_size = %u UHTTP::form_field_max_size = %u",
+                       UHTTP::limit_request_body,     UHTTP::form_stream_min_size,     UHTTP::form_field_max_size)
 
       // CACHE FILE
 
@@ -220,6 +237,58 @@ int UHttpPlugIn::handlerConfig(UFileConfig& cfg)
          UHTTP::nocache_file_mask = U_NEW(UString(x));
          }
 
+      UHTTP::cache_file_shared     = cfg.readBoolean(U_CONSTANT_TO_PARAM("CACHE_FILE_SHARED"));
+      UHTTP::cache_file_memory_max = cfg.readLong(U_CONSTANT_TO_PARAM("CACHE_FILE_MEMORY"));
+
+#  ifndef U_HTTP2_DISABLE
+      // HTTP2 PUSH
+
+      UHTTP2::push_enable = cfg.readBoolean(U_CONSTANT_TO_PARAM("HTTP2_PUSH"));
+
+      if (UHTTP2::push_enable)
+         {
+         x = cfg.at(U_CONSTANT_TO_PARAM("HTTP2_PUSH_MANIFEST"));
+
+         if (x) UHTTP2::loadPushManifest(x);
+         }
+#  endif
+
+      // MICRO CACHE
+
+      UHTTP::micro_cache_size = cfg.readLong(U_CONSTANT_TO_PARAM("MICRO_CACHE_SIZE"));
+
+      if (UHTTP::micro_cache_size)
+         {
+         x = cfg.at(U_CONSTANT_TO_PARAM("MICRO_CACHE_RULE"));
+
+         UVector<UString> vec(x);
+         uint32_t n = vec.size();
+
+         if (n < 2 ||
+             (n & 1) != 0)
+            {
+            U_ERROR("UHttpPlugIn::handlerConfig(): vector MICRO_CACHE_RULE malformed: %S", x.rep);
+            }
+
+         if (UHTTP::micro_cache_size < 64U * 1024U) UHTTP::micro_cache_size = 64U * 1024U;
+
+         U_INTERNAL_ASSERT_EQUALS(UHTTP::micro_cache_rule, 0)
+
+         UHTTP::micro_cache_rule  = U_NEW(UVector<UString>(vec, n));
+         UHTTP::micro_cache_stale = U_min(cfg.readLong(U_CONSTANT_TO_PARAM("MICRO_CACHE_STALE")), U_ONE_DAY_IN_SECOND);
+
+         x = cfg.at(U_CONSTANT_TO_PARAM("MICRO_CACHE_VARY"));
+
+         if (x)
+            {
+            U_INTERNAL_ASSERT_EQUALS(UHTTP::micro_cache_vary, 0)
+
+            if (x.findWhiteSpace() != U_NOT_FOUND) x = UStringExt::removeWhiteSpace(x);
+
+            UHTTP::micro_cache_vary = U_NEW(UVector<UString>(x, ','));
+            }
+         }
+
 #  ifdef U_STDCPP_ENABLE
       x = cfg.at(U_CONSTANT_TO_PARAM("CACHE_FILE_STORE"));
 
@@ -270,6 +339,17 @@ int UHttpPlugIn::handlerConfig(UFileConfig& cfg)
          }
 #  endif
 
+      // STATUS URI
+
+      x = cfg.at(U_CONSTANT_TO_PARAM("STATUS_URI"));
+
+      if (x)
+         {
+         U_INTERNAL_ASSERT_EQUALS(UHTTP::status_uri, 0)
+
+         UHTTP::status_uri = U_NEW(UString(x));
+         }
+
       // MOUNT POINT
 
       x = cfg.at(U_CONSTANT_TO_PARAM("MOUNT_POINT"));
@@ -458,6 +538,10 @@ int UHttpPlugIn::handlerInit()
 
    UHTTP::init();
 
+   if (UHTTP::cache_file_shared) UHTTP::setCacheFileShared();
+
+   if (UHTTP::micro_cache_size) UHTTP::micro_cache_ptr = UServer_Base::getOffsetToDataShare(UHTTP::micro_cache_size);
+
    U_RETURN(U_PLUGIN_HANDLER_PROCESSED | U_PLUGIN_HANDLER_GO_ON);
 }
 
@@ -475,6 +559,9 @@ int UHttpPlugIn::handlerRun() // NB: we use this method instead of handlerInit()
 #endif
    if (UServer_Base::handler_inotify) UHTTP::initDbNotFound();
 
+   if (UHTTP::cache_file_shared_ptr) UHTTP::initCacheFileShared();
+   if (UHTTP::micro_cache_ptr)       UHTTP::initMicroCache();
+
    if (UServer_Base::vplugin_name->last() == *UString::str_http)
       {
       UServer_Base::update_date  =
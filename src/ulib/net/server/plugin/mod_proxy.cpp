@@ -11,6 +11,7 @@
 //
 // ============================================================================
 
+#include <ulib/timer.h>
 #include <ulib/command.h>
 #include <ulib/mime/entity.h>
 #include <ulib/utility/escape.h>
@@ -70,6 +71,26 @@ int UProxyPlugIn::handlerInit()
 
    client_http = U_NEW(UHttpClient<UTCPSocket>((UFileConfig*)0));
 
+   UModProxyService::allocUpstreamData();
+
+   U_RETURN(U_PLUGIN_HANDLER_PROCESSED | U_PLUGIN_HANDLER_GO_ON);
+}
+
+int UProxyPlugIn::handlerRun()
+{
+   U_TRACE_NO_PARAM(0, "UProxyPlugIn::handlerRun()")
+
+   UModProxyService::mapUpstreamData();
+
+   U_RETURN(U_PLUGIN_HANDLER_PROCESSED | U_PLUGIN_HANDLER_GO_ON);
+}
+
+int UProxyPlugIn::handlerFork()
+{
+   U_TRACE_NO_PARAM(0, "UProxyPlugIn::handlerFork()")
+
+   UModProxyService::startHealthCheck();
+
    U_RETURN(U_PLUGIN_HANDLER_PROCESSED | U_PLUGIN_HANDLER_GO_ON);
 }
 
@@ -133,9 +154,32 @@ int UProxyPlugIn::handlerRequest()
 
       if (output_to_client == false)
          {
+         // NB: if possible we don't wait for the response of the server, it is relayed to the client as it arrive (see UProxyConnection)...
+
+         if (UHTTP::service->isAsync()                       &&
+             U_ClientImage_pipeline == false                 &&
+             U_http_version != '2'                           &&
+             UServer_Base::isParallelizationChild() == false &&
+             UProxyConnection::sendRequest(UHTTP::service, UServer_Base::pClientImage, (output_to_server ? *UClientImage_Base::wbuffer
+                                                                                                          : *UClientImage_Base::request),
+                                           U_http_method_type == HTTP_HEAD, U_ClientImage_close))
+            {
+            U_ClientImage_close = false; // NB: if needed the connection is closed at the end of the response...
+
+            UClientImage_Base::wbuffer->setEmpty();
+
+            UClientImage_Base::setRequestNoCache(); // NB: the response is not in the write buffer, we must not replay it...
+            UClientImage_Base::setRequestProcessed();
+
+            U_RETURN(U_PLUGIN_HANDLER_PROCESSED | U_PLUGIN_HANDLER_GO_ON);
+            }
+
          // before connect to server check if server and/or port to connect has changed...
 
-         if (client_http->setHostPort(UHTTP::service->getServer(), UHTTP::service->getPort()) &&
+         UProxyUpstream* peer = UHTTP::service->getUpstream();
+
+         if (client_http->setHostPort(peer ? peer->getServer() : UHTTP::service->getServer(),
+                                      peer ? peer->getPort()   : UHTTP::service->getPort()) &&
              client_http->UClient_Base::isConnected())
             {
             client_http->UClient_Base::close();
@@ -176,6 +220,12 @@ int UProxyPlugIn::handlerRequest()
 
          *UClientImage_Base::wbuffer = client_http->getResponse();
 
+         if (peer)
+            {
+            if (UClientImage_Base::wbuffer->empty()) peer->setFailure(); // NB: no response from the server...
+            else                                     peer->setSuccess();
+            }
+
          if (result)
             {
             UClientImage_Base::setNoHeaderForResponse();
@@ -232,12 +282,1128 @@ int UProxyPlugIn::handlerRequest()
    U_RETURN(U_PLUGIN_HANDLER_GO_ON);
 }
 
-// DEBUG
+UProxyConnection::UProxyConnection(UModProxyService* _service) : timer(this, _service->response_timeout)
+{
+   U_TRACE_REGISTER_OBJECT(0, UProxyConnection, "%p", _service)
+
+   service  = _service;
+   peer     = 0;
+   client   = 0;
+   next     = 0;
+   remain   = 0;
+   sent     =
+   nline    =
+   npipe    =
+   nretry   =
+   nrequest = 0;
+   state    = DONE;
+
+   pipefd[0] =
+   pipefd[1] = -1;
+
+   bhead = bclose = bkeep_alive = bchunk_ext = bresponse = bactive = btimeout = false;
+}
 
-#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
-const char* UProxyPlugIn::dump(bool reset) const
+UProxyConnection::~UProxyConnection()
 {
-   *UObjectIO::os << "client_http (UHttpClient<UTCPSocket> " << (void*)client_http << ')';
+   U_TRACE_UNREGISTER_OBJECT(0, UProxyConnection)
+
+   UTimer::erase(&timer);
+
+   if (socket.isOpen()) socket.close();
+
+   if (pipefd[0] != -1)
+      {
+      UFile::close(pipefd[0]);
+      UFile::close(pipefd[1]);
+      }
+}
+
+bool UProxyConnection::connect()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::connect()")
+
+   U_INTERNAL_ASSERT(socket.isClosed())
+   U_INTERNAL_ASSERT_POINTER(peer)
+
+   // NB: the name of the server is resolved only the first time...
+
+   if (peer->addr.getAddressFamily() == 0 &&
+       peer->addr.setHostName(peer->server) == false)
+      {
+      U_RETURN(false);
+      }
+
+   U_socket_IPv6(&socket) = (peer->addr.getAddressFamily() == AF_INET6);
+
+   socket._socket();
+
+   if (socket.isClosed()) U_RETURN(false);
+
+   socket.setNonBlocking();
+
+        if (socket.connectServer(peer->addr, peer->port)) state = REQUEST;
+   else if (errno == EINPROGRESS)                         state = CONNECT;
+   else
+      {
+      socket.close();
+
+      U_RETURN(false);
+      }
+
+   UEventFd::fd = socket.getFd();
+
+   nrequest = 0;
+
+   U_RETURN(true);
+}
+
+UProxyConnection* UProxyConnection::get(UModProxyService* _service)
+{
+   U_TRACE(0, "UProxyConnection::get(%p)", _service)
+
+   UProxyUpstream* _peer  = _service->getUpstream();
+   UProxyConnection* conn = _peer->idle;
+
+   if (conn)
+      {
+      _peer->idle = conn->next;
+
+      --_peer->nidle;
+
+      U_INTERNAL_ASSERT_EQUALS(conn->state, IDLE)
+      U_INTERNAL_ASSERT_EQUALS(conn->peer, _peer)
+
+      conn->state = REQUEST;
+      }
+   else
+      {
+      if ((conn = _service->unused)) _service->unused = conn->next;
+      else                           conn = U_NEW(UProxyConnection(_service));
+
+      conn->peer = _peer;
+
+      if (conn->connect() == false)
+         {
+         _peer->setFailure();
+
+         conn->next = _service->unused;
+                      _service->unused = conn;
+
+         U_RETURN_POINTER(0, UProxyConnection);
+         }
+      }
+
+   conn->next    = 0;
+   conn->bactive = true;
+
+   ++_peer->nactive;
+
+   U_RETURN_POINTER(conn, UProxyConnection);
+}
+
+bool UProxyConnection::sendRequest(UModProxyService* _service, UClientImage_Base* _client, const UString& _request, bool _bhead, bool _bclose, uint32_t _nretry)
+{
+   U_TRACE(0, "UProxyConnection::sendRequest(%p,%p,%V,%b,%b,%u)", _service, _client, _request.rep, _bhead, _bclose, _nretry)
+
+   U_INTERNAL_ASSERT(_request)
+   U_INTERNAL_ASSERT_POINTER(_client)
+
+   bool breused;
+   UProxyConnection* conn;
+
+   while ((conn = get(_service)))
+      {
+      breused = (conn->nrequest > 0);
+
+      conn->nretry = _nretry;
+
+      if (conn->start(_client, _request, _bhead, _bclose)) U_RETURN(true);
+
+      // NB: a connection kept alive can be closed by the server in the meanwhile, so we try with another one...
+
+      if (breused == false) break;
+      }
+
+   U_RETURN(false);
+}
+
+bool UProxyConnection::start(UClientImage_Base* _client, const UString& _request, bool _bhead, bool _bclose)
+{
+   U_TRACE(0, "UProxyConnection::start(%p,%V,%b,%b)", _client, _request.rep, _bhead, _bclose)
+
+   U_INTERNAL_ASSERT_EQUALS(client, 0)
+   U_INTERNAL_ASSERT(state == CONNECT || state == REQUEST)
+
+   bool bregistered = (nrequest > 0); // NB: the connection kept alive is already registered to the event manager...
+   uint32_t mask    = EPOLLOUT;
+
+   (void) request.replace(U_STRING_TO_PARAM(_request)); // NB: the request can be in the read buffer of the server, that is shared...
+
+   bhead       = _bhead;
+   bclose      = _bclose;
+   sent        = 0;
+   remain      = 0;
+   bkeep_alive = true;
+   bresponse   =
+   btimeout    =
+   bchunk_ext  = false;
+
+   if (header)  header.setEmpty();
+   if (pending) pending.setEmpty();
+
+   if (state == REQUEST)
+      {
+      int n = socket.send(request.data(), request.size());
+
+      if (n < 0)
+         {
+         if (errno != EAGAIN) goto fail;
+         }
+      else if ((sent = n) == request.size())
+         {
+         state = HEADER;
+         mask  = EPOLLIN | EPOLLRDHUP | EPOLLET;
+         }
+      }
+
+   if (bregistered == false)
+      {
+      UEventFd::op_mask = mask;
+
+      UNotifier::insert(this);
+      }
+   else if (UEventFd::op_mask != mask)
+      {
+      UEventFd::op_mask = mask;
+
+      UNotifier::modify(this);
+      }
+
+   client = _client;
+
+   client->setAsyncResponse(this);
+
+   if (service->response_timeout) UTimer::insert(&timer);
+
+   U_RETURN(true);
+
+fail:
+   if (bregistered) UNotifier::handlerDelete(this);
+   else                        handlerDelete();
+
+   U_RETURN(false);
+}
+
+int UProxyConnection::handlerWrite()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::handlerWrite()")
+
+   if (client == 0) U_RETURN(U_NOTIFIER_OK);
+
+   if (state > REQUEST)
+      {
+      // NB: it is the socket of the client that is become writable (see UClientImage_Base::handlerWrite()), or in a tunnel the socket of the server...
+
+      if (((pending || npipe) && flush()    == false) ||
+          (state == TUNNEL    && upstream() == false))
+         {
+         UNotifier::handlerDelete(this);
+         }
+
+      U_RETURN(U_NOTIFIER_OK);
+      }
+
+   if (state == CONNECT)
+      {
+      int err = 0;
+      uint32_t len = sizeof(int);
+
+      if (socket.getSockOpt(SOL_SOCKET, SO_ERROR, &err, len) == false ||
+          err != 0)
+         {
+         U_RETURN(U_NOTIFIER_DELETE);
+         }
+
+      state = REQUEST;
+      }
+
+   int n = socket.send(request.c_pointer(sent), request.size() - sent);
+
+   if (n < 0)
+      {
+      if (errno == EAGAIN) U_RETURN(U_NOTIFIER_OK);
+
+      U_RETURN(U_NOTIFIER_DELETE);
+      }
+
+   sent += n;
+
+   if (sent == request.size())
+      {
+      state = HEADER;
+
+      UEventFd::op_mask = EPOLLIN | EPOLLRDHUP | EPOLLET;
+
+      UNotifier::modify(this);
+      }
+
+   U_RETURN(U_NOTIFIER_OK);
+}
+
+int UProxyConnection::handlerRead()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::handlerRead()")
+
+#ifdef U_EPOLLET_POSTPONE_STRATEGY
+   // NB: we always read until EAGAIN (or we wait for the client), so the event manager don't need to call us again. We say it only when
+   //     we are called for the socket of the server, in a tunnel we are called also by the client that do it itself for its socket...
+
+   if (UNotifier::handler_event == this) U_ClientImage_state = U_PLUGIN_HANDLER_AGAIN;
+#endif
+
+   if (state == IDLE)
+      {
+      // NB: on a connection kept alive the server can only close it...
+
+      char c;
+
+      if (socket.recv(&c, 1) < 0 &&
+          errno == EAGAIN)
+         {
+         U_RETURN(U_NOTIFIER_OK);
+         }
+
+      U_RETURN(U_NOTIFIER_DELETE);
+      }
+
+   if (state < HEADER ||
+       client == 0)
+      {
+      U_RETURN(U_NOTIFIER_OK);
+      }
+
+   // NB: in a tunnel we are called also when the socket of the client is readable (see UClientImage_Base::handlerRead())...
+
+   if ((pending || npipe || relay()) &&
+       (state != TUNNEL  || upstream()))
+      {
+      U_RETURN(U_NOTIFIER_OK);
+      }
+
+   U_RETURN(U_NOTIFIER_DELETE);
+}
+
+int UProxyConnection::handlerTimeout()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::handlerTimeout()")
+
+   U_INTERNAL_DUMP("state = %d client = %p bresponse = %b nrequest = %u", state, client, bresponse, nrequest)
+
+   // NB: the server has not sent the header of the response in time, we don't try with another server because the request can be already processed...
+
+   btimeout = true;
+
+   U_RETURN(U_NOTIFIER_DELETE);
+}
+
+int UProxyTimeout::handlerTime()
+{
+   U_TRACE_NO_PARAM(0, "UProxyTimeout::handlerTime()")
+
+   U_INTERNAL_ASSERT_POINTER(conn)
+
+   if (conn->handlerTimeout() == U_NOTIFIER_DELETE) UNotifier::handlerDelete(conn);
+
+   // ---------------
+   // return value:
+   // ---------------
+   // -1 - normal
+   //  0 - monitoring
+   // ---------------
+
+   U_RETURN(-1);
+}
+
+void UProxyConnection::handlerDelete()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::handlerDelete()")
+
+   U_INTERNAL_DUMP("state = %d client = %p bresponse = %b btimeout = %b nrequest = %u", state, client, bresponse, btimeout, nrequest)
+
+   if (btimeout == false) UTimer::erase(&timer); // NB: with btimeout we are called by the timer, that is already out of the queue...
+
+   if (client)
+      {
+      if (client->isAsyncResponse(this) == false) // NB: the client is gone (see UClientImage_Base::handlerDelete())...
+         {
+         if (bresponse == false &&
+             state     != TUNNEL &&
+             client->socket->iState == USocket::TIMEOUT)
+            {
+            peer->setFailure(); // NB: the server has not responded in time...
+            }
+         }
+      else if (state == TUNNEL) client->endAsyncResponse(true);
+      else
+         {
+         // NB: a connection kept alive can be closed by the server in the meanwhile, this is not a failure of the server...
+
+         if (bresponse ||
+             btimeout  ||
+             nrequest == 0)
+            {
+            peer->setFailure();
+            }
+
+         if (btimeout ||
+             retry() == false)
+            {
+            U_SRV_LOG("WARNING: connection to server %v:%d failed%s, the response to client is %s", peer->server.rep, peer->port,
+                      (btimeout ? " (timeout)" : ""), (bresponse ? "truncated" : "502 Bad Gateway"));
+
+            abortResponse();
+            }
+         }
+
+      client = 0;
+      }
+
+   release();
+
+   if (socket.isOpen()) socket.close();
+
+   UEventFd::fd = -1;
+
+   if (state == IDLE)
+      {
+      UProxyConnection** ptr = &(peer->idle);
+
+      while (*ptr != this)
+         {
+         U_INTERNAL_ASSERT_POINTER(*ptr)
+
+         ptr = &((*ptr)->next);
+         }
+
+      *ptr = next;
+
+      --peer->nidle;
+      }
+
+   state = DONE;
+
+   if (pending) pending.setEmpty();
+
+   if (npipe)
+      {
+      // NB: the data in the pipe are no more useful...
+
+      UFile::close(pipefd[0]);
+      UFile::close(pipefd[1]);
+
+      pipefd[0] =
+      pipefd[1] = -1;
+
+      npipe = 0;
+      }
+
+   // NB: the object is not deallocated because it can be referenced by other event in the same loop of the event manager...
+
+   next = service->unused;
+          service->unused = this;
+}
+
+bool UProxyConnection::retry()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::retry()")
+
+   // NB: if nothing is sent to the client and the connection was kept alive, it is possible that the server has closed it in the meanwhile,
+   //     and if the connect() is failed (nothing is sent to the server) we can try with another server of the upstream group...
+
+   if (bresponse == false &&
+       (nrequest > 0 ||
+        (sent == 0 && nretry < service->vupstream.size())))
+      {
+      UClientImage_Base* _client = client;
+
+      _client->async_response = 0;
+                       client = 0;
+
+      if (sendRequest(service, _client, request, bhead, bclose, nretry + (nrequest == 0))) U_RETURN(true);
+
+      _client->async_response = this;
+                       client = _client;
+      }
+
+   U_RETURN(false);
+}
+
+void UProxyConnection::release()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::release()")
+
+   if (bactive)
+      {
+      bactive = false;
+
+      U_INTERNAL_ASSERT_MAJOR(peer->nactive, 0)
+
+      --peer->nactive;
+      }
+}
+
+void UProxyConnection::abortResponse()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::abortResponse()")
+
+   U_INTERNAL_ASSERT_POINTER(client)
+
+   if (bresponse == false) (void) client->socket->send(U_CONSTANT_TO_PARAM("HTTP/1.1 502 Bad Gateway\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"));
+
+   client->endAsyncResponse(true);
+}
+
+bool UProxyConnection::finish()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::finish()")
+
+   U_INTERNAL_ASSERT_EQUALS(state, DONE)
+
+   UClientImage_Base* _client = client;
+                                client = 0;
+
+   _client->endAsyncResponse(bclose);
+
+   release();
+
+   U_INTERNAL_DUMP("bkeep_alive = %b nidle = %u pool_size = %u", bkeep_alive, peer->nidle, service->pool_size)
+
+   if (bkeep_alive &&
+       peer->nidle < service->pool_size)
+      {
+      state = IDLE;
+
+      ++nrequest;
+
+      next = peer->idle;
+             peer->idle = this;
+
+      ++peer->nidle;
+
+      U_RETURN(true);
+      }
+
+   U_RETURN(false);
+}
+
+bool UProxyConnection::write(const char* ptr, uint32_t len)
+{
+   U_TRACE(0, "UProxyConnection::write(%.*S,%u)", len, ptr, len)
+
+   U_INTERNAL_ASSERT_POINTER(client)
+   U_INTERNAL_ASSERT(pending.empty())
+
+   int n = client->socket->send(ptr, len);
+
+   if (n < 0)
+      {
+      if (errno != EAGAIN) U_RETURN(false);
+
+      n = 0;
+      }
+
+   U_SRV_STAT_ADD(cnt_bytes_write, n);
+
+   client->setLastEvent();
+
+   if ((uint32_t)n < len)
+      {
+      // NB: the client is not writable, we stop to read from the server until it become writable again...
+
+      (void) pending.replace(ptr + n, len - n);
+
+      client->waitForAsyncResponse(true);
+      }
+
+   U_RETURN(true);
+}
+
+bool UProxyConnection::flush()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::flush()")
+
+   U_INTERNAL_ASSERT_POINTER(client)
+   U_INTERNAL_ASSERT(pending || npipe)
+
+#ifdef U_PROXY_SPLICE_SUPPORT
+   if (npipe)
+      {
+      if (drain() == false) U_RETURN(false);
+
+      if (npipe) U_RETURN(true);
+      }
+   else
+#endif
+   {
+   int n = client->socket->send(pending.data(), pending.size());
+
+   if (n < 0)
+      {
+      if (errno == EAGAIN) U_RETURN(true);
+
+      U_RETURN(false);
+      }
+
+   U_SRV_STAT_ADD(cnt_bytes_write, n);
+
+   client->setLastEvent();
+
+   if ((uint32_t)n < pending.size())
+      {
+      (void) pending.erase(0, n);
+
+      U_RETURN(true);
+      }
+
+   pending.setEmpty();
+   }
+
+   client->waitForAsyncResponse(false);
+
+   if (state == DONE) return finish();
+
+   return relay();
+}
+
+bool UProxyConnection::relay()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::relay()")
+
+   U_INTERNAL_ASSERT_POINTER(client)
+   U_INTERNAL_ASSERT(pending.empty())
+   U_INTERNAL_ASSERT_EQUALS(npipe, 0)
+
+#ifdef U_PROXY_SPLICE_SUPPORT
+   if (isSplice()) return splice();
+#endif
+
+   int n;
+   uint32_t len;
+   char buffer[16 * 1024];
+
+   while (true)
+      {
+      n = socket.recv(buffer, sizeof(buffer));
+
+      if (n <= 0)
+         {
+         if (n < 0 &&
+             errno == EAGAIN)
+            {
+            U_RETURN(true);
+            }
+
+         if (n == 0 &&
+             state == BODY_TO_CLOSE)
+            {
+            state       = DONE;
+            bkeep_alive = false;
+
+            (void) finish();
+            }
+
+         U_RETURN(false);
+         }
+
+      len = parseResponse(buffer, n);
+
+      if (len == U_NOT_FOUND) U_RETURN(false);
+
+      if (len < (uint32_t)n) bkeep_alive = false; // NB: the server has sent more data than the response...
+
+      bresponse = true;
+
+      if (write(buffer, len) == false) U_RETURN(false);
+
+      if (pending) U_RETURN(true);
+
+      if (state == DONE) return finish();
+
+#  ifdef U_PROXY_SPLICE_SUPPORT
+      if (isSplice()) return splice();
+#  endif
+      }
+}
+
+bool UProxyConnection::upstream()
+{
+   U_TRACE_NO_PARAM(0, "UProxyConnection::upstream()")
+
+   U_INTERNAL_ASSERT_POINTER(client)
+   U_INTERNAL_ASSERT_EQUALS(state, TUNNEL)
+
+   int n, m;
+   char buffer[16 * 1024];
+
+   if (request) // NB: in a tunnel the request buffer is used for the data of the client not yet written to the server...
+      {
+      n = socket.send(request.data(), request.size());
+
+      if (n < 0)
+         {
+         if (errno == EAGAIN) U_RETURN(true);
+
+         U_RETURN(false);
+         }
+
+      if ((uint32_t)n < request.size())
+         {
+         (void) request.erase(0, n);
+
+         U_RETURN(true);
+         }
+
+      request.setEmpty();
+
+      UEventFd::op_mask = EPOLLIN | EPOLLRDHUP | EPOLLET;
+
+      UNotifier::modify(this);
+      }
+
+   while (true)
+      {
+      n = client->socket->recv(buffer, sizeof(buffer));
+
+      if (n <= 0)
+         {
+         if (n < 0 &&
+             errno == EAGAIN)
+            {
+            U_RETURN(true);
+            }
+
+         U_RETURN(false);
+         }
+
+      U_SRV_STAT_ADD(cnt_bytes_read, n);
+
+      client->setLastEvent();
+
+      m = socket.send(buffer, n);
+
+      if (m < 0)
+         {
+         if (errno != EAGAIN) U_RETURN(false);
+
+         m = 0;
+         }
+
+      if (m < n)
+         {
+         // NB: the server is not writable, we stop to read from the client until it become writable again...
+
+         (void) request.replace(buffer + m, n - m);
+
+         UEventFd::op_mask = EPOLLOUT;
+
+         UNotifier::modify(this);
+
+         U_RETURN(true);
+         }
+      }
+}
+
+#ifdef U_PROXY_SPLICE_SUPPORT
+bool UProxyConnection::isSplice()
+{
+   U_TRACE_NO_PARAM(1, "UProxyConnection::isSplice()")
+
+   U_INTERNAL_DUMP("state = %d remain = %llu pipefd[0] = %d", state, remain, pipefd[0])
+
+   if ((state == TUNNEL        ||
+        state == BODY_TO_CLOSE ||
+        (state == BODY && remain >= U_PROXY_MIN_SIZE_FOR_SPLICE)) &&
+       client->socket->isSSLActive() == false) // NB: with SSL the data must be encrypted in user space...
+      {
+      if (pipefd[0] != -1) U_RETURN(true);
+
+#  ifndef HAVE_PIPE2
+      if (U_SYSCALL(pipe, "%p", pipefd) == 0)
+         {
+         (void) U_SYSCALL(fcntl, "%d,%d,%d", pipefd[0], F_SETFL, O_NONBLOCK | O_CLOEXEC);
+         (void) U_SYSCALL(fcntl, "%d,%d,%d", pipefd[1], F_SETFL, O_NONBLOCK | O_CLOEXEC);
+
+         U_RETURN(true);
+         }
+#  else
+      if (U_SYSCALL(pipe2, "%p,%d", pipefd, O_NONBLOCK | O_CLOEXEC) == 0) U_RETURN(true);
+#  endif
+
+      pipefd[0] =
+      pipefd[1] = -1;
+      }
+
+   U_RETURN(false);
+}
+
+bool UProxyConnection::splice()
+{
+   U_TRACE_NO_PARAM(1, "UProxyConnection::splice()")
+
+   U_INTERNAL_ASSERT_POINTER(client)
+   U_INTERNAL_ASSERT_EQUALS(npipe, 0)
+   U_INTERNAL_ASSERT_DIFFERS(pipefd[0], -1)
+
+   int n;
+   uint32_t len;
+
+   while (true)
+      {
+      len = (state == BODY && remain < U_PROXY_PIPE_SIZE ? (uint32_t)remain : U_PROXY_PIPE_SIZE);
+
+      n = U_SYSCALL(splice, "%d,%p,%d,%p,%u,%u", socket.getFd(), 0, pipefd[1], 0, len, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+      if (n <= 0)
+         {
+         if (n < 0 &&
+             errno == EAGAIN)
+            {
+            U_RETURN(true);
+            }
+
+         if (n == 0 &&
+             state == BODY_TO_CLOSE)
+            {
+            state       = DONE;
+            bkeep_alive = false;
+
+            (void) finish();
+            }
+
+         U_RETURN(false);
+         }
+
+      npipe     = n;
+      bresponse = true;
+
+      if (state == BODY &&
+          (remain -= n) == 0)
+         {
+         state = DONE;
+         }
+
+      if (drain() == false) U_RETURN(false);
+
+      if (npipe) U_RETURN(true);
+
+      if (state == DONE) return finish();
+      }
+}
+
+bool UProxyConnection::drain()
+{
+   U_TRACE_NO_PARAM(1, "UProxyConnection::drain()")
+
+   U_INTERNAL_ASSERT_MAJOR(npipe, 0)
+   U_INTERNAL_ASSERT_POINTER(client)
+
+   int n = U_SYSCALL(splice, "%d,%p,%d,%p,%u,%u", pipefd[0], 0, client->socket->getFd(), 0, npipe, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+   if (n < 0)
+      {
+      if (errno != EAGAIN) U_RETURN(false);
+
+      n = 0;
+      }
+
+   npipe -= n;
+
+   U_SRV_STAT_ADD(cnt_bytes_write,  n);
+   U_SRV_STAT_ADD(cnt_bytes_splice, n);
+
+   client->setLastEvent();
+
+   // NB: the client is not writable, we stop to read from the server until it become writable again...
+
+   if (npipe) client->waitForAsyncResponse(true);
+
+   U_RETURN(true);
+}
+#endif
+
+bool UProxyConnection::parseHeader(const char* ptr, uint32_t len)
+{
+   U_TRACE(0, "UProxyConnection::parseHeader(%.*S,%u)", len, ptr, len)
+
+   // NB: we need only to know where the response end (and if the connection can be kept alive)...
+
+   if (len < U_CONSTANT_SIZE("HTTP/1.1 200\r\n\r\n")  ||
+       memcmp(ptr, U_CONSTANT_TO_PARAM("HTTP/1.")) != 0 ||
+       u__isdigit(ptr[9])  == false                    ||
+       u__isdigit(ptr[10]) == false                    ||
+       u__isdigit(ptr[11]) == false)
+      {
+      U_RETURN(false);
+      }
+
+   int code = (ptr[9] - '0') * 100 + (ptr[10] - '0') * 10 + (ptr[11] - '0');
+
+   uint64_t content_length = 0;
+   const char* end = ptr + len;
+   bool bchunked = false, blength = false, keep_alive = (ptr[7] == '1'); // NB: HTTP/1.0 close the connection by default...
+
+   for (ptr = (const char*) memchr(ptr, '\n', len); ptr && ++ptr < end; ptr = (const char*) memchr(ptr, '\n', end - ptr))
+      {
+      len = end - ptr;
+
+      if (len > U_CONSTANT_SIZE("Content-Length:") &&
+          u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("Content-Length:")) == 0)
+         {
+         blength = true;
+
+         for (ptr += U_CONSTANT_SIZE("Content-Length:"); u__isblank(*ptr); ++ptr) {}
+
+         for (content_length = 0; u__isdigit(*ptr); ++ptr)
+            {
+            if ((content_length >> 59) != 0) U_RETURN(false); // NB: overflow...
+
+            content_length = (content_length * 10) + (*ptr - '0');
+            }
+         }
+      else if (len > U_CONSTANT_SIZE("Transfer-Encoding:") &&
+               u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("Transfer-Encoding:")) == 0)
+         {
+         const char* eol = (const char*) memchr(ptr, '\n', len);
+
+         bchunked = (eol && u_find(ptr, eol - ptr, U_CONSTANT_TO_PARAM("chunked")) != 0);
+         }
+      else if (len > U_CONSTANT_SIZE("Connection:") &&
+               u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("Connection:")) == 0)
+         {
+         for (ptr += U_CONSTANT_SIZE("Connection:"); u__isblank(*ptr); ++ptr) {}
+
+              if (u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("close"))      == 0) keep_alive = false;
+         else if (u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("keep-alive")) == 0) keep_alive = true;
+         }
+      }
+
+   U_INTERNAL_DUMP("code = %d content_length = %llu blength = %b bchunked = %b keep_alive = %b", code, content_length, blength, bchunked, keep_alive)
+
+   if (code  < 200 &&
+       code != 101)
+      {
+      state = HEADER; // NB: interim response (ex: 100 Continue), the final response follow...
+
+      U_RETURN(true);
+      }
+
+   bkeep_alive = keep_alive;
+
+   UTimer::erase(&timer); // NB: the server has responded in time...
+
+   peer->setSuccess();
+
+   if (code == 101)
+      {
+      state       = TUNNEL; // NB: the protocol is switched (ex: WebSocket), from now we relay the data in both directions...
+      bkeep_alive = false;
+
+      request.setEmpty(); // NB: from now it is used for the data of the client not yet written to the server (see upstream())...
+
+      client->setAsyncTunnel();
+      }
+   else if (bhead       ||
+       code == 204 ||
+       code == 304)
+      {
+      state = DONE;
+      }
+   else if (bchunked)
+      {
+      state      = CHUNK_SIZE;
+      remain     = 0;
+      bchunk_ext = false;
+      }
+   else if (blength)
+      {
+      state = ((remain = content_length) ? BODY : DONE);
+      }
+   else
+      {
+      state       = BODY_TO_CLOSE;
+      bkeep_alive = false;
+      }
+
+   if (bkeep_alive == false) bclose = true; // NB: the client has received the header of the server...
+
+   U_RETURN(true);
+}
+
+uint32_t UProxyConnection::parseResponse(const char* ptr, uint32_t len)
+{
+   U_TRACE(0, "UProxyConnection::parseResponse(%.*S,%u)", len, ptr, len)
+
+   char c;
+   uint32_t n, pos;
+   const char* start = ptr;
+   const char* end   = ptr + len;
+
+   while (ptr < end &&
+          state != DONE)
+      {
+      n = end - ptr;
+
+      switch (state)
+         {
+         case HEADER:
+            {
+            if (header.empty() &&
+                (pos = u_findEndHeader1(ptr, n)) != U_NOT_FOUND)
+               {
+               if (parseHeader(ptr, pos) == false) U_RETURN(U_NOT_FOUND);
+
+               ptr += pos;
+
+               break;
+               }
+
+            // NB: the header is splitted between more read...
+
+            uint32_t sz = header.size();
+
+            (void) header.append(ptr, n);
+
+            pos = u_findEndHeader1(U_STRING_TO_PARAM(header));
+
+            if (pos == U_NOT_FOUND)
+               {
+               if (header.size() > (64U * 1024U)) U_RETURN(U_NOT_FOUND);
+
+               ptr = end;
+
+               break;
+               }
+
+            if (parseHeader(header.data(), pos) == false) U_RETURN(U_NOT_FOUND);
+
+            ptr += pos - sz;
+
+            header.setEmpty();
+            }
+         break;
+
+         case BODY:
+         case CHUNK_DATA:
+            {
+            if (n > remain) n = remain;
+
+            ptr    += n;
+            remain -= n;
+
+            if (remain == 0) state = (state == BODY ? DONE : CHUNK_SIZE);
+            }
+         break;
+
+         case TUNNEL:
+         case BODY_TO_CLOSE: ptr = end; break;
+
+         case CHUNK_SIZE:
+            {
+            c = *ptr++;
+
+            if (c == '\n')
+               {
+               bchunk_ext = false;
+
+               if (remain)
+                  {
+                  remain += 2; // NB: the CRLF at the end of the data of the chunk...
+
+                  state = CHUNK_DATA;
+                  }
+               else
+                  {
+                  nline = 0;
+                  state = CHUNK_TRAILER;
+                  }
+               }
+            else if (bchunk_ext == false)
+               {
+               if (u__isxdigit(c) == false)
+                  {
+                  if (c != '\r') bchunk_ext = true; // NB: chunk extension (ex: ;name=value)...
+                  }
+               else
+                  {
+                  if ((remain >> 60) != 0) U_RETURN(U_NOT_FOUND); // NB: overflow...
+
+                  remain = (remain << 4) | u__hexc2int(c);
+                  }
+               }
+            }
+         break;
+
+         case CHUNK_TRAILER:
+            {
+            c = *ptr++;
+
+                 if (c  == '\n') { if (nline == 0) state = DONE; else nline = 0; }
+            else if (c  != '\r') ++nline;
+            }
+         break;
+
+         default: U_RETURN(U_NOT_FOUND);
+         }
+      }
+
+   U_RETURN(ptr - start);
+}
+
+// DEBUG
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+const char* UProxyPlugIn::dump(bool reset) const
+{
+   *UObjectIO::os << "client_http (UHttpClient<UTCPSocket> " << (void*)client_http << ')';
+
+   if (reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return 0;
+}
+
+const char* UProxyConnection::dump(bool reset) const
+{
+   *UObjectIO::os << "fd                                   " << fd                << '\n'
+                  << "sent                                 " << sent              << '\n'
+                  << "nline                                " << nline             << '\n'
+                  << "npipe                                " << npipe             << '\n'
+                  << "state                                " << state             << '\n'
+                  << "bhead                                " << bhead             << '\n'
+                  << "bclose                               " << bclose            << '\n'
+                  << "remain                               " << remain            << '\n'
+                  << "op_mask                              " << op_mask           << '\n'
+                  << "nretry                               " << nretry            << '\n'
+                  << "nrequest                             " << nrequest          << '\n'
+                  << "bactive                              " << bactive           << '\n'
+                  << "bresponse                            " << bresponse         << '\n'
+                  << "btimeout                             " << btimeout          << '\n'
+                  << "bchunk_ext                           " << bchunk_ext        << '\n'
+                  << "bkeep_alive                          " << bkeep_alive       << '\n'
+                  << "next              (UProxyConnection  " << (void*)next       << ")\n"
+                  << "peer              (UProxyUpstream    " << (void*)peer       << ")\n"
+                  << "client            (UClientImage_Base " << (void*)client     << ")\n"
+                  << "service           (UModProxyService  " << (void*)service    << ")\n"
+                  << "socket            (UTCPSocket        " << (void*)&socket    << ")\n"
+                  << "timer             (UProxyTimeout     " << (void*)&timer     << ")\n"
+                  << "header            (UString           " << (void*)&header    << ")\n"
+                  << "request           (UString           " << (void*)&request   << ")\n"
+                  << "pending           (UString           " << (void*)&pending   << ')';
 
    if (reset)
       {
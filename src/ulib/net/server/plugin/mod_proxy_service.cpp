@@ -12,14 +12,306 @@
 // ============================================================================
 
 #include <ulib/date.h>
+#include <ulib/timer.h>
 #include <ulib/command.h>
 #include <ulib/file_config.h>
 #include <ulib/utility/uhttp.h>
 #include <ulib/utility/services.h>
 #include <ulib/net/server/server.h>
 #include <ulib/utility/string_ext.h>
+#include <ulib/net/server/plugin/mod_proxy.h>
 #include <ulib/net/server/plugin/mod_proxy_service.h>
 
+void*    UModProxyService::upstream_data;
+uint32_t UModProxyService::nupstream;
+
+/**
+ * The active health check of a server of the upstream group: every HEALTH_CHECK_INTERVAL seconds we connect (not blocking) to the server
+ * and send GET HEALTH_CHECK_URI, the server is healthy if the status of the response is 2xx or 3xx. If the check is not terminated at the
+ * next interval the server is considered down. The timer (UProxyHealthCheck) start the probe (UProxyHealthProbe), that is managed by the
+ * event manager...
+ */
+
+class U_NO_EXPORT UProxyHealthProbe : public UEventFd {
+public:
+
+   // Check for memory error
+   U_MEMORY_TEST
+
+   // COSTRUTTORI
+
+   UProxyHealthProbe(UProxyUpstream* _peer)
+      {
+      U_TRACE_REGISTER_OBJECT(0, UProxyHealthProbe, "%p", _peer)
+
+      peer   = _peer;
+      bcheck = false;
+      }
+
+   virtual ~UProxyHealthProbe() U_DECL_FINAL
+      {
+      U_TRACE_UNREGISTER_OBJECT(0, UProxyHealthProbe)
+
+      if (socket.isOpen()) socket.close();
+      }
+
+   // SERVICES
+
+   void start()
+      {
+      U_TRACE_NO_PARAM(0, "UProxyHealthProbe::start()")
+
+      if (socket.isOpen()) UNotifier::handlerDelete(this); // NB: the previous check is not terminated (timeout)...
+
+      if (peer->addr.getAddressFamily() == 0 &&
+          peer->addr.setHostName(peer->server) == false)
+         {
+         peer->setHealth(false);
+
+         return;
+         }
+
+      U_socket_IPv6(&socket) = (peer->addr.getAddressFamily() == AF_INET6);
+
+      socket._socket();
+
+      if (socket.isOpen())
+         {
+         socket.setNonBlocking();
+
+         if (socket.connectServer(peer->addr, peer->port) == false &&
+             errno != EINPROGRESS)
+            {
+            socket.close();
+
+            peer->setHealth(false);
+            }
+         else
+            {
+            bcheck = true;
+
+            UEventFd::fd      = socket.getFd();
+            UEventFd::op_mask = EPOLLOUT;
+
+            UNotifier::insert(this);
+            }
+         }
+      }
+
+   // define method VIRTUAL of class UEventFd
+
+   virtual int handlerWrite() U_DECL_FINAL
+      {
+      U_TRACE_NO_PARAM(0, "UProxyHealthProbe::handlerWrite()")
+
+      int err = 0;
+      uint32_t len = sizeof(int);
+
+      if (socket.getSockOpt(SOL_SOCKET, SO_ERROR, &err, len) == false ||
+          err != 0)
+         {
+         U_RETURN(U_NOTIFIER_DELETE);
+         }
+
+      UString request(U_CAPACITY);
+
+      request.snprintf("GET %v HTTP/1.0\r\nHost: %v:%d\r\nConnection: close\r\n\r\n", peer->service->health_check_uri.rep, peer->server.rep, peer->port);
+
+      if (socket.send(request.data(), request.size()) != (int)request.size()) U_RETURN(U_NOTIFIER_DELETE);
+
+      UEventFd::op_mask = EPOLLIN | EPOLLRDHUP | EPOLLET;
+
+      UNotifier::modify(this);
+
+      U_RETURN(U_NOTIFIER_OK);
+      }
+
+   virtual int handlerRead() U_DECL_FINAL
+      {
+      U_TRACE_NO_PARAM(0, "UProxyHealthProbe::handlerRead()")
+
+      char buffer[64];
+
+      int n = socket.recv(buffer, sizeof(buffer));
+
+      if (n < 0 &&
+          errno == EAGAIN)
+         {
+         U_RETURN(U_NOTIFIER_OK);
+         }
+
+      bcheck = false;
+
+      peer->setHealth(n >= (int)U_CONSTANT_SIZE("HTTP/1.1 200")           &&
+                      memcmp(buffer, U_CONSTANT_TO_PARAM("HTTP/1.")) == 0 &&
+                      (buffer[9] == '2' || buffer[9] == '3'));
+
+      U_RETURN(U_NOTIFIER_DELETE);
+      }
+
+   virtual void handlerDelete() U_DECL_FINAL
+      {
+      U_TRACE_NO_PARAM(0, "UProxyHealthProbe::handlerDelete()")
+
+      if (bcheck) // NB: the check is failed (ex: connection refused) or not terminated in time...
+         {
+         bcheck = false;
+
+         peer->setHealth(false);
+         }
+
+      if (socket.isOpen()) socket.close();
+
+      UEventFd::fd = -1;
+      }
+
+#if defined(DEBUG) && defined(U_STDCPP_ENABLE)
+   const char* dump(bool _reset) const
+      {
+      *UObjectIO::os << "bcheck                               " << bcheck         << '\n'
+                     << "peer              (UProxyUpstream    " << (void*)peer    << ")\n"
+                     << "socket            (UTCPSocket        " << (void*)&socket << ')';
+
+      if (_reset)
+         {
+         UObjectIO::output();
+
+         return UObjectIO::buffer_output;
+         }
+
+      return 0;
+      }
+#endif
+
+protected:
+   UTCPSocket socket;
+   UProxyUpstream* peer;
+   bool bcheck; // NB: the check is in progress...
+
+private:
+   UProxyHealthProbe(const UProxyHealthProbe&) : UEventFd() {}
+   UProxyHealthProbe& operator=(const UProxyHealthProbe&)   { return *this; }
+};
+
+class U_NO_EXPORT UProxyHealthCheck : public UEventTime {
+public:
+
+   // COSTRUTTORI
+
+   UProxyHealthCheck(UProxyUpstream* _peer) : UEventTime(_peer->service->health_check_interval, 0L), probe(_peer)
+      {
+      U_TRACE_REGISTER_OBJECT(0, UProxyHealthCheck, "%p", _peer)
+      }
+
+   virtual ~UProxyHealthCheck() U_DECL_FINAL
+      {
+      U_TRACE_UNREGISTER_OBJECT(0, UProxyHealthCheck)
+      }
+
+   // define method VIRTUAL of class UEventTime
+
+   virtual int handlerTime() U_DECL_FINAL
+      {
+      U_TRACE_NO_PARAM(0, "UProxyHealthCheck::handlerTime()")
+
+      probe.start();
+
+      // ---------------
+      // return value:
+      // ---------------
+      // -1 - normal
+      //  0 - monitoring
+      // ---------------
+
+      U_RETURN(0);
+      }
+
+#if defined(DEBUG) && defined(U_STDCPP_ENABLE)
+   const char* dump(bool _reset) const { return UEventTime::dump(_reset); }
+#endif
+
+protected:
+   UProxyHealthProbe probe;
+
+private:
+   UProxyHealthCheck(const UProxyHealthCheck&) : UEventTime(), probe(0) {}
+   UProxyHealthCheck& operator=(const UProxyHealthCheck&)              { return *this; }
+};
+
+UProxyUpstream::UProxyUpstream(UModProxyService* _service, const UString& _server, int _port, uint32_t _weight) : server(_server)
+{
+   U_TRACE_REGISTER_OBJECT(0, UProxyUpstream, "%p,%V,%d,%u", _service, _server.rep, _port, _weight)
+
+   local.down_until = 0;
+   local.nfail      =
+   local.bdown      = 0;
+
+   service = _service;
+   idle    = 0;
+   data    = &local; // NB: it become the shared memory with mapUpstreamData()...
+   weight  = _weight;
+   port    = _port;
+
+   nidle          =
+   nactive        =
+   index          = 0;
+   current_weight = 0;
+}
+
+UProxyUpstream::~UProxyUpstream()
+{
+   U_TRACE_UNREGISTER_OBJECT(0, UProxyUpstream)
+
+   UProxyConnection* conn;
+
+   while ((conn = idle))
+      {
+      idle = conn->next;
+
+      delete conn;
+      }
+}
+
+void UProxyUpstream::setFailure()
+{
+   U_TRACE_NO_PARAM(0, "UProxyUpstream::setFailure()")
+
+#ifdef HAVE_GCC_ATOMICS
+   uint32_t n = __atomic_add_fetch(&(data->nfail), 1, __ATOMIC_RELAXED);
+#else
+   uint32_t n = ++(data->nfail);
+#endif
+
+   U_INTERNAL_DUMP("n = %u max_fails = %u", n, service->max_fails)
+
+   if (service->max_fails &&
+       n >= service->max_fails)
+      {
+      data->nfail      = 0;
+      data->down_until = u_now->tv_sec + service->fail_timeout;
+
+      U_SRV_LOG("WARNING: server %v:%d of the upstream group is ejected for %u seconds after %u consecutive failures", server.rep, port, service->fail_timeout, n);
+      }
+}
+
+void UProxyUpstream::setHealth(bool bup)
+{
+   U_TRACE(0, "UProxyUpstream::setHealth(%b)", bup)
+
+   if ((data->bdown == 0) != bup)
+      {
+      data->bdown = (bup == false);
+
+      U_SRV_LOG("%sserver %v:%d of the upstream group is %s (health check)", (bup ? "" : "WARNING: "), server.rep, port, (bup ? "up" : "down"));
+      }
+
+   if (bup &&
+       data->down_until)
+      {
+      data->down_until = 0; // NB: the server is back, we don't wait the end of the passive ejection...
+      }
+}
+
 UModProxyService::UModProxyService()
 {
    U_TRACE_REGISTER_OBJECT(0, UModProxyService, "")
@@ -27,7 +319,19 @@ UModProxyService::UModProxyService()
    command = 0;
    vremote_address = 0;
    port = method_mask = 0;
-   request_cert = follow_redirects = response_client = websocket = false;
+   request_cert = follow_redirects = response_client = websocket = async = false;
+
+   unused    = 0;
+   pool_size = 8;
+
+   vring                 = 0;
+   nring                 =
+   rr_index              = 0;
+   max_fails             = 1;
+   fail_timeout          = 10;
+   response_timeout      = 30;
+   health_check_interval = 5;
+   balance               = ROUND_ROBIN;
 }
 
 UModProxyService::~UModProxyService()
@@ -35,6 +339,17 @@ UModProxyService::~UModProxyService()
    U_TRACE_UNREGISTER_OBJECT(0, UModProxyService)
 
    if (vremote_address) delete vremote_address;
+
+   if (vring) UMemoryPool::_free(vring, nring, sizeof(uint64_t));
+
+   UProxyConnection* conn;
+
+   while ((conn = unused))
+      {
+      unused = conn->next;
+
+      delete conn;
+      }
 }
 
 bool UModProxyService::loadConfig(UFileConfig& cfg)
@@ -59,6 +374,16 @@ bool UModProxyService::loadConfig(UFileConfig& cfg)
    //
    // PORT                 port of server for connection
    // SERVER               name of server for connection
+   // POOL_SIZE            max number of idle (keep-alive) connections to server kept by each process (default 8, 0 => close after response)
+   //
+   // UPSTREAM             list of servers of the group that serve the request, as host[:port][=weight] (the default port is PORT, it replace SERVER)
+   // BALANCE              how to select the server of the group (round_robin (weighted, default) | least_conn | hash_uri | hash_cookie)
+   // HASH_COOKIE          name of the cookie for the consistent hash with BALANCE hash_cookie
+   // MAX_FAILS            number of consecutive failures (connect, error or timeout) after that a server is ejected (default 1, 0 => disable)
+   // FAIL_TIMEOUT         time (in seconds) for which a server is ejected (default 10)
+   // RESPONSE_TIMEOUT     time (in seconds) to wait for the header of the response of a server before to consider it failed (default 30, 0 => disable)
+   // HEALTH_CHECK_URI     uri for the active health check of the servers of the group (GET, status 2xx or 3xx is healthy)
+   // HEALTH_CHECK_INTERVAL time (in seconds) between two active health check (default 5)
    //
    // FOLLOW_REDIRECTS     yes if     manage to automatically follow redirects from server
    // USER                     if     manage to follow redirects, in response to a HTTP_UNAUTHORISED response from the HTTP server: user
@@ -98,6 +423,7 @@ bool UModProxyService::loadConfig(UFileConfig& cfg)
       {
       service = U_NEW(UModProxyService);
 
+      (void) cfg.loadVector(tmp,                        "UPSTREAM");
       (void) cfg.loadVector(service->vreplace_response, "REPLACE_RESPONSE");
 
       if (cfg.loadTable())
@@ -112,6 +438,62 @@ bool UModProxyService::loadConfig(UFileConfig& cfg)
          service->request_cert     = cfg.readBoolean(U_CONSTANT_TO_PARAM("CLIENT_CERTIFICATE"));
          service->response_client  = cfg.readBoolean(U_CONSTANT_TO_PARAM("RESPONSE_TYPE"));
          service->follow_redirects = cfg.readBoolean(U_CONSTANT_TO_PARAM("FOLLOW_REDIRECTS"));
+         service->pool_size        = cfg.readLong(   U_CONSTANT_TO_PARAM("POOL_SIZE"), 8);
+
+         // UPSTREAM GROUP
+
+         service->hash_cookie           = cfg.at(U_CONSTANT_TO_PARAM("HASH_COOKIE"));
+         service->health_check_uri      = cfg.at(U_CONSTANT_TO_PARAM("HEALTH_CHECK_URI"));
+         service->max_fails             = cfg.readLong(U_CONSTANT_TO_PARAM("MAX_FAILS"), 1);
+         service->fail_timeout          = cfg.readLong(U_CONSTANT_TO_PARAM("FAIL_TIMEOUT"), 10);
+         service->response_timeout      = cfg.readLong(U_CONSTANT_TO_PARAM("RESPONSE_TIMEOUT"), 30);
+         service->health_check_interval = cfg.readLong(U_CONSTANT_TO_PARAM("HEALTH_CHECK_INTERVAL"), 5);
+
+         x = cfg.at(U_CONSTANT_TO_PARAM("BALANCE"));
+
+         if (x)
+            {
+                 if (x.equal(U_CONSTANT_TO_PARAM("least_conn")))  service->balance = LEAST_CONN;
+            else if (x.equal(U_CONSTANT_TO_PARAM("hash_uri")))    service->balance = HASH_URI;
+            else if (x.equal(U_CONSTANT_TO_PARAM("hash_cookie"))) service->balance = HASH_COOKIE;
+            }
+
+         if (tmp.empty() == false)
+            {
+            for (uint32_t i = 0, n = tmp.size(); i < n; ++i)
+               {
+               if (service->addUpstream(tmp[i]) == false) U_SRV_LOG("WARNING: invalid server of the upstream group: %V", tmp[i].rep);
+               }
+
+            tmp.clear();
+            }
+         else if (service->server                     &&
+                  service->server.first_char() != '~' &&
+                  u_get_unalignedp16(service->server.data()) != U_MULTICHAR_CONSTANT16('$','<'))
+            {
+            // NB: a group with only the server to connect, that don't change at runtime...
+
+            UProxyUpstream* elem = U_NEW(UProxyUpstream(service, service->server, service->port, 1));
+
+            elem->index = nupstream++;
+
+            service->vupstream.push_back(elem);
+            }
+
+         if (service->balance >= HASH_URI &&
+             service->vupstream.size() > 1)
+            {
+            service->buildRing();
+            }
+
+         // NB: the response is relayed to the client as it arrives (see UProxyConnection), this is not possible
+         //     if we must follow redirects or modify the response, or if the server to connect change at runtime...
+
+         service->async = (service->websocket        == false &&
+                           service->follow_redirects == false &&
+                           service->isAuthorization() == false &&
+                           service->vupstream.empty() == false &&
+                           service->vreplace_response.empty());
 
          x = cfg.at(U_CONSTANT_TO_PARAM("URI"));
 
@@ -189,12 +571,12 @@ loop:       switch (u_get_unalignedp32(msk))
 
          UHTTP::vservice->push_back(service);
 
-         cfg.clear();
+         cfg.table.clear();
          }
-
-      U_RETURN(true);
       }
 
+   if (UHTTP::vservice->empty() == false) U_RETURN(true);
+
    U_RETURN(false);
 }
 
@@ -243,6 +625,295 @@ __pure UModProxyService* UModProxyService::findService(const char* host, uint32_
    U_RETURN_POINTER(0, UModProxyService);
 }
 
+bool UModProxyService::addUpstream(const UString& x)
+{
+   U_TRACE(0, "UModProxyService::addUpstream(%V)", x.rep)
+
+   // NB: host[:port][=weight]...
+
+   int _port = port;
+   uint32_t _weight = 1;
+   const char* ptr = x.data();
+   const char* end = ptr + x.size();
+   const char* sep = (const char*) memchr(ptr, '=', x.size());
+
+   if (sep)
+      {
+      _weight = u_strtoul(sep+1, end);
+
+      if (_weight ==   0) U_RETURN(false);
+      if (_weight  > 100) _weight = 100;
+
+      end = sep;
+      }
+
+   for (sep = end; --sep > ptr; )
+      {
+      if (*sep == ':')
+         {
+         _port = u_strtoul(sep+1, end);
+
+         end = sep;
+
+         break;
+         }
+      }
+
+   if (end == ptr ||
+       _port <= 0 ||
+       _port > 0xFFFF)
+      {
+      U_RETURN(false);
+      }
+
+   UProxyUpstream* elem = U_NEW(UProxyUpstream(this, UString((void*)ptr, end - ptr), _port, _weight)); // NB: we need a copy, the config buffer is released...
+
+   elem->index = nupstream++;
+
+   vupstream.push_back(elem);
+
+   U_RETURN(true);
+}
+
+// NB: we don't use u_hash(), it have a random seed (the ring must be the same after a restart and for all the proxies) or it is
+//     the crc32, that is linear: the points of the servers (and the keys) differ only in few chars and they are not spread on the
+//     ring without the avalanche of the bits (we use the finalizer of MurmurHash3)...
+
+static inline uint32_t hashRing(const char* key, uint32_t key_len)
+{
+   uint32_t h = u_cdb_hash((unsigned char*)key, key_len, 0);
+
+   h ^= h >> 16;
+   h *= 0x85ebca6b;
+   h ^= h >> 13;
+   h *= 0xc2b2ae35;
+   h ^= h >> 16;
+
+   return h;
+}
+
+static int compareRing(const void* a, const void* b)
+{
+   U_TRACE(0, "compareRing(%p,%p)", a, b)
+
+   uint64_t x = *(const uint64_t*)a,
+            y = *(const uint64_t*)b;
+
+   U_RETURN(x < y ? -1 : x > y);
+}
+
+void UModProxyService::buildRing()
+{
+   U_TRACE_NO_PARAM(0, "UModProxyService::buildRing()")
+
+   // NB: every server have 100 points (for unit of weight) on the ring, so if a server is removed only its keys change server...
+
+   char buffer[512];
+   UProxyUpstream* elem;
+   uint32_t i, j, k, len, n = vupstream.size();
+
+   for (i = nring = 0; i < n; ++i) nring += vupstream[i]->weight * 100;
+
+   vring = (uint64_t*) UMemoryPool::_malloc(nring, sizeof(uint64_t));
+
+   for (i = k = 0; i < n; ++i)
+      {
+      elem = vupstream[i];
+
+      for (j = 0; j < elem->weight * 100; ++j)
+         {
+         len = u__snprintf(buffer, sizeof(buffer), "%v:%d-%u", elem->server.rep, elem->port, j);
+
+         vring[k++] = ((uint64_t)hashRing(buffer, len) << 32) | i;
+         }
+      }
+
+   U_INTERNAL_ASSERT_EQUALS(k, nring)
+
+   qsort(vring, nring, sizeof(uint64_t), compareRing);
+}
+
+__pure UProxyUpstream* UModProxyService::getUpstreamByHash(const char* key, uint32_t key_len)
+{
+   U_TRACE(0, "UModProxyService::getUpstreamByHash(%.*S,%u)", key_len, key, key_len)
+
+   U_INTERNAL_ASSERT_MAJOR(nring, 0)
+
+   UProxyUpstream* elem;
+   uint32_t i, mid, low = 0, high = nring, h = hashRing(key, key_len);
+
+   // NB: we search the first point of the ring with hash >= h...
+
+   while (low < high)
+      {
+      mid = (low + high) / 2;
+
+      if ((uint32_t)(vring[mid] >> 32) < h) low  = mid + 1;
+      else                                  high = mid;
+      }
+
+   // NB: if the server is not available we take the next one on the ring...
+
+   for (i = 0; i < nring; ++i)
+      {
+      elem = vupstream[(uint32_t)vring[(low + i) % nring]];
+
+      if (elem->isAvailable()) U_RETURN_POINTER(elem, UProxyUpstream);
+      }
+
+   U_RETURN_POINTER(0, UProxyUpstream);
+}
+
+UProxyUpstream* UModProxyService::getUpstream()
+{
+   U_TRACE_NO_PARAM(0, "UModProxyService::getUpstream()")
+
+   uint32_t i, n = vupstream.size();
+
+   if (n == 0) U_RETURN_POINTER(0,            UProxyUpstream);
+   if (n == 1) U_RETURN_POINTER(vupstream[0], UProxyUpstream);
+
+   UProxyUpstream* elem;
+   UProxyUpstream* best = 0;
+
+   if (balance >= HASH_URI)
+      {
+      uint32_t len = 0;
+      const char* key;
+
+      if (balance == HASH_URI) key = UClientImage_Base::getRequestUri(len);
+      else
+         {
+         // NB: we search the value of the cookie in the header Cookie (name1=value1; name2=value2; ...)...
+
+         uint32_t sz = hash_cookie.size();
+         const char* end = u_clientimage_info.http_info.cookie + u_clientimage_info.http_info.cookie_len;
+
+         for (key = u_clientimage_info.http_info.cookie; key && sz && key < end; key = (const char*) memchr(key, ';', end - key))
+            {
+            while (key < end && (*key == ';' || u__isblank(*key))) ++key;
+
+            if ((uint32_t)(end - key) > sz          &&
+                key[sz] == '='                      &&
+                memcmp(key, hash_cookie.data(), sz) == 0)
+               {
+               key += sz + 1;
+
+               const char* eov = (const char*) memchr(key, ';', end - key);
+
+               len = (eov ? eov : end) - key;
+
+               break;
+               }
+            }
+         }
+
+      if (len &&
+          (best = getUpstreamByHash(key, len)))
+         {
+         U_RETURN_POINTER(best, UProxyUpstream);
+         }
+      }
+
+   if (balance == LEAST_CONN)
+      {
+      // NB: we start from a different server every time, so with the same number of connections in use the requests are distributed...
+
+      for (i = 0, ++rr_index; i < n; ++i)
+         {
+         elem = vupstream[(rr_index + i) % n];
+
+         if (elem->isAvailable() &&
+             (best == 0 ||
+              (uint64_t)elem->nactive * best->weight < (uint64_t)best->nactive * elem->weight))
+            {
+            best = elem;
+            }
+         }
+      }
+   else
+      {
+      // NB: smooth weighted round-robin, the servers with more weight are selected more often but not consecutively...
+
+      int total = 0;
+
+      for (i = 0; i < n; ++i)
+         {
+         elem = vupstream[i];
+
+         if (elem->isAvailable())
+            {
+            elem->current_weight += elem->weight;
+            total                += elem->weight;
+
+            if (best == 0 ||
+                elem->current_weight > best->current_weight)
+               {
+               best = elem;
+               }
+            }
+         }
+
+      if (best) best->current_weight -= total;
+      }
+
+   if (best == 0) best = vupstream[rr_index++ % n]; // NB: all the servers are down, we try anyway...
+
+   U_RETURN_POINTER(best, UProxyUpstream);
+}
+
+void UModProxyService::allocUpstreamData()
+{
+   U_TRACE_NO_PARAM(0, "UModProxyService::allocUpstreamData()")
+
+   U_INTERNAL_DUMP("nupstream = %u", nupstream)
+
+   // NB: two step shared memory acquisition - here we get the offset (see mapUpstreamData())...
+
+   if (nupstream) upstream_data = UServer_Base::getOffsetToDataShare(sizeof(UProxyUpstream::upstream_data) * nupstream);
+}
+
+void UModProxyService::mapUpstreamData()
+{
+   U_TRACE_NO_PARAM(0, "UModProxyService::mapUpstreamData()")
+
+   if (nupstream)
+      {
+      UModProxyService* service;
+      UProxyUpstream::upstream_data* ptr = (UProxyUpstream::upstream_data*) UServer_Base::getPointerToDataShare(upstream_data);
+
+      for (uint32_t i = 0, n = UHTTP::vservice->size(); i < n; ++i)
+         {
+         service = (*UHTTP::vservice)[i];
+
+         for (uint32_t j = 0, m = service->vupstream.size(); j < m; ++j) service->vupstream[j]->data = ptr + service->vupstream[j]->index;
+         }
+      }
+}
+
+void UModProxyService::startHealthCheck()
+{
+   U_TRACE_NO_PARAM(0, "UModProxyService::startHealthCheck()")
+
+   // NB: the state of the servers is shared, so only the first process make the active health check...
+
+   if (UServer_Base::child_index == 0)
+      {
+      UModProxyService* service;
+
+      for (uint32_t i = 0, n = UHTTP::vservice->size(); i < n; ++i)
+         {
+         service = (*UHTTP::vservice)[i];
+
+         if (service->health_check_uri &&
+             service->health_check_interval)
+            {
+            for (uint32_t j = 0, m = service->vupstream.size(); j < m; ++j) UTimer::insert(U_NEW(UProxyHealthCheck(service->vupstream[j])));
+            }
+         }
+      }
+}
+
 #define U_SRV_ADDR_FMT "%v/%.*s:%u.srv"
 
 bool UModProxyService::setServerAddress(const UString& dir, const char* address, uint32_t address_len)
@@ -355,6 +1026,16 @@ const char* UModProxyService::dump(bool reset) const
                   << "request_cert                         " << request_cert              << '\n'
                   << "response_client                      " << response_client           << '\n'
                   << "follow_redirects                     " << follow_redirects          << '\n'
+                  << "async                                " << async                     << '\n'
+                  << "nring                                " << nring                     << '\n'
+                  << "balance                              " << balance                   << '\n'
+                  << "rr_index                             " << rr_index                  << '\n'
+                  << "max_fails                            " << max_fails                 << '\n'
+                  << "pool_size                            " << pool_size                 << '\n'
+                  << "fail_timeout                         " << fail_timeout              << '\n'
+                  << "response_timeout                     " << response_timeout          << '\n'
+                  << "health_check_interval                " << health_check_interval     << '\n'
+                  << "unused            (UProxyConnection  " << (void*)unused             << ")\n"
 #              ifdef USE_LIBPCRE
                   << "uri_mask          (UPCRE             " << (void*)&uri_mask          << ")\n"
 #              else
@@ -365,6 +1046,9 @@ const char* UModProxyService::dump(bool reset) const
                   << "host_mask         (UString           " << (void*)&host_mask         << ")\n"
                   << "password          (UString           " << (void*)&password          << ")\n"
                   << "environment       (UString           " << (void*)&environment       << ")\n"
+                  << "hash_cookie       (UString           " << (void*)&hash_cookie       << ")\n"
+                  << "health_check_uri  (UString           " << (void*)&health_check_uri  << ")\n"
+                  << "vupstream         (UVector           " << (void*)&vupstream         << ")\n"
                   << "vremote_address   (UVector<UIPAllow> " << (void*)vremote_address    << ")\n"
                   << "vreplace_response (UVector<UString>  " << (void*)&vreplace_response << ')';
 
@@ -378,3 +1062,29 @@ const char* UModProxyService::dump(bool reset) const
    return 0;
 }
 #endif
+
+#if defined(U_STDCPP_ENABLE) && defined(DEBUG)
+const char* UProxyUpstream::dump(bool reset) const
+{
+   *UObjectIO::os << "port                                 " << port              << '\n'
+                  << "index                                " << index             << '\n'
+                  << "nidle                                " << nidle             << '\n'
+                  << "weight                               " << weight            << '\n'
+                  << "nactive                              " << nactive           << '\n'
+                  << "current_weight                       " << current_weight    << '\n'
+                  << "data                                 " << (void*)data       << '\n'
+                  << "idle              (UProxyConnection  " << (void*)idle       << ")\n"
+                  << "service           (UModProxyService  " << (void*)service    << ")\n"
+                  << "addr              (UIPAddress        " << (void*)&addr      << ")\n"
+                  << "server            (UString           " << (void*)&server    << ')';
+
+   if (reset)
+      {
+      UObjectIO::output();
+
+      return UObjectIO::buffer_output;
+      }
+
+   return 0;
+}
+#endif
@@ -93,6 +93,7 @@ bool          UServer_Base::public_address;
 bool          UServer_Base::monitoring_process;
 bool          UServer_Base::set_tcp_keep_alive;
 bool          UServer_Base::set_realtime_priority;
+bool          UServer_Base::set_tcp_reuseport_bpf;
 bool          UServer_Base::update_date;
 bool          UServer_Base::update_date1;
 bool          UServer_Base::update_date2;
@@ -106,6 +107,7 @@ ULock*        UServer_Base::lock_user1;
 ULock*        UServer_Base::lock_user2;
 time_t        UServer_Base::last_event;
 uint32_t      UServer_Base::map_size;
+uint32_t      UServer_Base::child_index;
 uint32_t      UServer_Base::vplugin_size;
 uint32_t      UServer_Base::nClientIndex;
 uint32_t      UServer_Base::shared_data_add;
@@ -113,6 +115,7 @@ uint32_t      UServer_Base::client_address_len;
 uint32_t      UServer_Base::document_root_size;
 uint32_t      UServer_Base::num_client_threshold;
 uint32_t      UServer_Base::min_size_for_sendfile;
+uint32_t      UServer_Base::min_size_for_zerocopy;
 uint32_t      UServer_Base::num_client_for_parallelization;
 sigset_t      UServer_Base::mask;
 UString*      UServer_Base::host;
@@ -130,12 +133,16 @@ UString*      UServer_Base::cenvironment;
 UString*      UServer_Base::senvironment;
 UString*      UServer_Base::document_root;
 UString*      UServer_Base::str_preforked_num_kids;
+UString*      UServer_Base::statistics_file;
 USocket*      UServer_Base::socket;
 USocket*      UServer_Base::csocket;
 UProcess*     UServer_Base::proc;
 UEventFd*     UServer_Base::handler_other;
 UEventFd*     UServer_Base::handler_inotify;
 UEventTime*   UServer_Base::ptime;
+#if defined(ENABLE_THREAD) && !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
+UClientQueue* UServer_Base::client_queue;
+#endif
 const char*   UServer_Base::document_root_ptr;
 unsigned int  UServer_Base::port;
 UFileConfig*  UServer_Base::cfg;
@@ -148,6 +155,7 @@ UClientImage_Base*                UServer_Base::pClientImage;
 UClientImage_Base*                UServer_Base::eClientImage;
 UVector<UServerPlugIn*>*          UServer_Base::vplugin;
 UServer_Base::shared_data*        UServer_Base::ptr_shared_data;
+UServer_Base::shared_data_child*  UServer_Base::ptr_shared_child;
 UVector<UServer_Base::file_LOG*>* UServer_Base::vlog;
 
 #ifdef U_WELCOME_SUPPORT
@@ -296,7 +304,7 @@ public:
 
       U_INTERNAL_DUMP("UNotifier::num_connection = %u UNotifier::min_connection = %u", UNotifier::num_connection, UNotifier::min_connection)
 
-      if (UNotifier::num_connection > UNotifier::min_connection) UNotifier::callForAllEntryDynamic(UServer_Base::handlerTimeoutConnection);
+      if (UNotifier::num_connection > UNotifier::min_connection) UServer_Base::handlerTimeoutIdleConnection();
 
 #  ifdef U_LOG_ENABLE
       if (U_SRV_CNT_PARALLELIZATION)
@@ -866,11 +874,108 @@ public:
       {
       U_TRACE_NO_PARAM(0, "UClientThread::run()")
 
-      U_INTERNAL_ASSERT_EQUALS(UServer_Base::ptime, 0)
+      U_SRV_LOG("UClientThread event loop activated (tid %u)", u_gettid());
+
+      while (UServer_Base::flag_loop) UServer_Base::waitForEvent();
+      }
+};
+
+#  if !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
+/**
+ * With the thread approach (PREFORK_CHILD == -1) the main thread only accept the new connections and the event manager is owned by UClientThread:
+ * the accepted client images are passed by a single-producer/single-consumer queue and the read end of a pipe (written only when the queue was
+ * empty) wake up the event loop, so that UNotifier and the list of idle connections are never touched by two threads at the same time...
+ */
+
+class UClientQueue : public UEventFd {
+public:
+
+   UClientQueue(uint32_t n)
+      {
+      U_TRACE(1, "UClientQueue::UClientQueue(%u)", n)
+
+      size   = n;
+      head   =
+      tail   = 0;
+      vqueue = (UClientImage_Base**) UMemoryPool::_malloc(n, sizeof(UClientImage_Base*));
+
+#  ifndef HAVE_PIPE2
+      (void) U_SYSCALL(pipe, "%p",     fds);
+
+      (void) U_SYSCALL(fcntl, "%d,%d,%d", fds[0], F_SETFL, O_NONBLOCK | O_CLOEXEC);
+      (void) U_SYSCALL(fcntl, "%d,%d,%d", fds[1], F_SETFL, O_NONBLOCK | O_CLOEXEC);
+#  else
+      (void) U_SYSCALL(pipe2, "%p,%d", fds, O_NONBLOCK | O_CLOEXEC);
+#  endif
+
+      UEventFd::fd = fds[0];
+      }
+
+   virtual ~UClientQueue()
+      {
+      U_TRACE_NO_PARAM(1, "UClientQueue::~UClientQueue()")
+
+      UMemoryPool::_free(vqueue, size, sizeof(UClientImage_Base*));
+
+      (void) U_SYSCALL(close, "%d", fds[0]);
+      (void) U_SYSCALL(close, "%d", fds[1]);
+      }
+
+   // NB: called by the main thread (producer)...
+
+   void push(UClientImage_Base* ptr)
+      {
+      U_TRACE(1, "UClientQueue::push(%p)", ptr)
+
+      uint32_t t = tail;
+
+      U_INTERNAL_ASSERT_MINOR(t - __atomic_load_n(&head, __ATOMIC_SEQ_CST), size)
+
+      vqueue[t % size] = ptr;
+
+      __atomic_store_n(&tail, t + 1, __ATOMIC_SEQ_CST);
+
+      // NB: if the consumer has already emptied the queue it can sleep on the event manager, so we must wake it up...
+
+      if (__atomic_load_n(&head, __ATOMIC_SEQ_CST) == t) (void) U_SYSCALL(write, "%d,%p,%u", fds[1], "", 1);
+      }
+
+   // NB: called by the event loop thread (consumer)...
+
+   virtual int handlerRead() U_DECL_FINAL
+      {
+      U_TRACE_NO_PARAM(1, "UClientQueue::handlerRead()")
+
+      char buffer[64];
+
+      while (U_SYSCALL(read, "%d,%p,%u", fds[0], buffer, sizeof(buffer)) == (ssize_t)sizeof(buffer)) {}
 
-      while (UServer_Base::flag_loop) UNotifier::waitForEvent();
+      uint32_t h = head;
+
+      while (h != __atomic_load_n(&tail, __ATOMIC_SEQ_CST))
+         {
+         UServer_Base::handlerNewClient(vqueue[h % size]);
+
+         __atomic_store_n(&head, ++h, __ATOMIC_SEQ_CST);
+         }
+
+      U_RETURN(U_NOTIFIER_OK);
       }
+
+protected:
+   UClientImage_Base** vqueue;
+   uint32_t size, head, tail;
+   int fds[2];
+
+#ifdef U_COMPILER_DELETE_MEMBERS
+   UClientQueue(const UClientQueue&) = delete;
+   UClientQueue& operator=(const UClientQueue&) = delete;
+#else
+   UClientQueue(const UClientQueue&) : UEventFd() {}
+   UClientQueue& operator=(const UClientQueue&)   { return *this; }
+#endif
 };
+#  endif
 
 #  ifdef U_LINUX
 class UTimeThread : public UThread {
@@ -1357,14 +1462,18 @@ void UServer_Base::loadConfigParam()
    // ALLOWED_IP_PRIVATE    list of comma separated client private address for IP-based access control (IPADDR[/MASK]) for public server
    // ENABLE_RFC1918_FILTER reject request from private IP to public server address
    // MIN_SIZE_FOR_SENDFILE for major size it is better to use sendfile() to serve static content
+   // MIN_SIZE_FOR_ZEROCOPY for major size the body of the response is sent with MSG_ZEROCOPY (0 => disabled, default)
    //
    // LISTEN_BACKLOG        max number of ready to be delivered connections to accept()
    // SET_REALTIME_PRIORITY flag indicating that the preforked processes will be scheduled under the real-time policies SCHED_FIFO
+   // TCP_REUSEPORT_BPF     flag indicating to steer (SO_REUSEPORT) new connection to the preforked process of the cpu that received it
+   // USE_IO_URING          flag indicating to use io_uring (if available) instead of epoll for the event notification
    //
    // CLIENT_THRESHOLD           min number of clients to active polling
    // CLIENT_FOR_PARALLELIZATION min number of clients to active parallelization
    //
    // PID_FILE      write pid on file indicated
+   // STATISTICS_FILE map the per-child statistics on file indicated (it can be dumped with the command 'userver -s <file>')
    // WELCOME_MSG   message of welcome to send initially to client
    // RUN_AS_USER   downgrade the security to that of user account
    // DOCUMENT_ROOT The directory out of which you will serve your documents
@@ -1393,7 +1502,7 @@ void UServer_Base::loadConfigParam()
    // VERIFY_MODE   mode of verification (SSL_VERIFY_NONE=0, SSL_VERIFY_PEER=1, SSL_VERIFY_FAIL_IF_NO_PEER_CERT=2, SSL_VERIFY_CLIENT_ONCE=4)
    // CIPHER_SUITE  cipher suite model (Intermediate=0, Modern=1, Old=2)
    //
-   // PREFORK_CHILD number of child server processes created at startup: -1 - thread approach (experimental)
+   // PREFORK_CHILD number of child server processes created at startup: -1 - thread approach (accept and event loop thread)
    //                                                                     0 - serialize, no forking
    //                                                                     1 - classic, forking after client accept
    //                                                                    >1 - pool of serialized processes plus monitoring process
@@ -1435,6 +1544,14 @@ void UServer_Base::loadConfigParam()
    set_tcp_keep_alive    = cfg->readBoolean(U_CONSTANT_TO_PARAM("TCP_KEEP_ALIVE"));
    set_realtime_priority = cfg->readBoolean(U_CONSTANT_TO_PARAM("SET_REALTIME_PRIORITY"), true);
 
+#ifdef U_LINUX
+   set_tcp_reuseport_bpf = cfg->readBoolean(U_CONSTANT_TO_PARAM("TCP_REUSEPORT_BPF"));
+#endif
+
+#ifdef U_IO_URING_SUPPORT
+   UNotifier::bio_uring = cfg->readBoolean(U_CONSTANT_TO_PARAM("USE_IO_URING"));
+#endif
+
    tcp_linger_set                 = cfg->readLong(U_CONSTANT_TO_PARAM("TCP_LINGER_SET"), -2);
    USocket::iBackLog              = cfg->readLong(U_CONSTANT_TO_PARAM("LISTEN_BACKLOG"), SOMAXCONN);
    UNotifier::max_connection      = cfg->readLong(U_CONSTANT_TO_PARAM("MAX_KEEP_ALIVE"));
@@ -1447,6 +1564,10 @@ void UServer_Base::loadConfigParam()
 
    if (x) str_preforked_num_kids = U_NEW(UString(x));
 
+   x = cfg->at(U_CONSTANT_TO_PARAM("STATISTICS_FILE"));
+
+   if (x) statistics_file = U_NEW(UString(x));
+
 #ifdef U_WELCOME_SUPPORT
    x = cfg->at(U_CONSTANT_TO_PARAM("WELCOME_MSG"));
 
@@ -1457,6 +1578,13 @@ void UServer_Base::loadConfigParam()
 
    if (min_size_for_sendfile == 0) min_size_for_sendfile = 500 * 1024; // 500k: for major size we assume is better to use sendfile()
 
+   min_size_for_zerocopy = cfg->readLong(U_CONSTANT_TO_PARAM("MIN_SIZE_FOR_ZEROCOPY"));
+
+#ifdef U_ZEROCOPY_SUPPORT
+   if (min_size_for_zerocopy == 0)
+#endif
+   min_size_for_zerocopy = U_NOT_FOUND; // NB: 0 => disabled (for small size the copy cost less than the page pinning and the completion notification)...
+
 #ifdef USE_LIBSSL
    *password   = cfg->at(U_CONSTANT_TO_PARAM("PASSWORD"));
    *ca_file    = cfg->at(U_CONSTANT_TO_PARAM("CA_FILE"));
@@ -1467,10 +1595,10 @@ void UServer_Base::loadConfigParam()
    *dh_file    = cfg->at(U_CONSTANT_TO_PARAM("DH_FILE"));
    verify_mode = cfg->at(U_CONSTANT_TO_PARAM("VERIFY_MODE"));
 
-   if (bssl) min_size_for_sendfile = U_NOT_FOUND; // NB: we can't use sendfile with SSL...
+   if (bssl) min_size_for_sendfile = min_size_for_zerocopy = U_NOT_FOUND; // NB: we can't use sendfile (and MSG_ZEROCOPY) with SSL...
 #endif
 
-   U_INTERNAL_DUMP("min_size_for_sendfile = %u", min_size_for_sendfile)
+   U_INTERNAL_DUMP("min_size_for_sendfile = %u min_size_for_zerocopy = %u", min_size_for_sendfile, min_size_for_zerocopy)
 
    // Instructs server to accept connections from the IP address IPADDR. A CIDR mask length can be
    // supplied optionally after a trailing slash, e.g. 192.168.0.0/24, in which case addresses that
@@ -2254,6 +2382,18 @@ void UServer_Base::init()
 
    if (preforked_num_kids > 1) monitoring_process = true;
 
+#ifdef U_IO_URING_SUPPORT
+   // NB: we can't give the ring to the process forked for every connection...
+
+   if (UNotifier::bio_uring &&
+       isClassic())
+      {
+      U_WARNING("Sorry, I can't use io_uring with PREFORK_CHILD == 1, I must use epoll");
+
+      UNotifier::bio_uring = false;
+      }
+#endif
+
    UTimer::init(UTimer::NOSIGNAL);
 
    UClientImage_Base::init();
@@ -2284,6 +2424,42 @@ void UServer_Base::init()
    U_INTERNAL_DUMP("log_rotate_size = %u", log_rotate_size)
 #endif
 
+   // NB: one slot for every preforked process, must run after the setting for shared log (the gzip buffer follow the shared_data struct)...
+
+   bool bstatistics_on_file = false;
+   uint32_t child_size = sizeof(shared_data_child) * (preforked_num_kids > 1 ? preforked_num_kids : 1);
+
+   if (statistics_file)
+      {
+      // NB: the per-child statistics are mapped on file so that they can be read by an external tool (userver -s <file>)...
+
+      UFile stat_file(*statistics_file);
+
+      if (stat_file.creat() &&
+          stat_file.ftruncate(child_size))
+         {
+         ptr_shared_child = (shared_data_child*) UFile::mmap(&child_size, stat_file.getFd(), PROT_READ | PROT_WRITE, MAP_SHARED, 0);
+
+         bstatistics_on_file = (ptr_shared_child != (shared_data_child*)MAP_FAILED);
+         }
+
+      stat_file.close();
+
+      if (bstatistics_on_file == false) U_WARNING("Mapping of statistics on file %V failed", statistics_file->rep);
+
+      delete statistics_file;
+             statistics_file = 0;
+      }
+
+   if (bstatistics_on_file == false)
+      {
+      // NB: the slots must be aligned to the cache line to avoid false sharing between the preforked processes...
+
+      shared_data_add = ((sizeof(shared_data) + shared_data_add + U_STAT_CACHE_LINE - 1) & ~(U_STAT_CACHE_LINE - 1)) - sizeof(shared_data);
+
+      ptr_shared_child = (shared_data_child*) getOffsetToDataShare(child_size);
+      }
+
    // init plugin modules, must run after the setting for shared log
 
    if (pluginsHandlerInit() != U_PLUGIN_HANDLER_FINISHED) U_ERROR("Plugins stage init failed");
@@ -2300,6 +2476,8 @@ void UServer_Base::init()
    U_INTERNAL_ASSERT_POINTER(ptr_shared_data)
    U_INTERNAL_ASSERT_DIFFERS(ptr_shared_data, MAP_FAILED)
 
+   if (bstatistics_on_file == false) ptr_shared_child = (shared_data_child*) getPointerToDataShare(ptr_shared_child);
+
 #if defined(U_LINUX) && defined(ENABLE_THREAD)
    bool bpthread_time = (preforked_num_kids >= 4); // intuitive heuristic...
 #else
@@ -2395,7 +2573,18 @@ void UServer_Base::init()
    socket_flags |= O_RDWR | O_CLOEXEC;
 
 #if defined(ENABLE_THREAD) && !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
-   if (preforked_num_kids != -1)
+   if (preforked_num_kids == -1)
+      {
+      // NB: the main thread block on accept() and the event loop thread is notified of the new connection by the queue (UClientQueue)...
+
+      UNotifier::min_connection = 1;
+
+      if (timeoutMS > 0) ptime = U_NEW(UTimeoutConnection);
+
+      if (handler_other)   UNotifier::min_connection++;
+      if (handler_inotify) UNotifier::min_connection++;
+      }
+   else
 #endif
       {
       // ---------------------------------------------------------------------------------------------------------
@@ -2567,6 +2756,8 @@ RETSIGTYPE UServer_Base::handlerForSigHUP(int signo)
       {
       logMemUsage("SIGHUP");
 
+      ULog::log("SIGHUP (Interrupt): %v", getAcceptStats().rep);
+
       log->reopen();
       }
 #endif
@@ -2741,13 +2932,13 @@ int UServer_Base::handlerRead() // This method is called to accept a new connect
 
    // This loops until the accept() fails, trying to start new connections as fast as possible so we don't overrun the listen queue
 
-   pClientImage = vClientImage + nClientIndex;
-
 #if defined(ENABLE_THREAD) && !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
    USocket* psocket;
    char* lclient_address;
    uint32_t lclient_address_len;
-   UClientImage_Base* lClientIndex = pClientImage;
+   UClientImage_Base* lClientIndex = vClientImage + nClientIndex; // NB: with PREFORK_CHILD == -1 pClientImage belong to the event loop thread...
+#else
+   pClientImage = vClientImage + nClientIndex;
 #endif
    int cround = 0;
 #ifdef DEBUG
@@ -2770,6 +2961,33 @@ loop:
    U_INTERNAL_DUMP("vClientImage[%d].socket->iSockDesc = %d",    (CLIENT_INDEX - vClientImage), CSOCKET->iSockDesc)
    U_INTERNAL_DUMP("----------------------------------------", 0)
 
+#if defined(ENABLE_THREAD) && !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
+   if (preforked_num_kids == -1)
+      {
+      // NB: the client image is released by the event loop thread only at the end of UClientImage_Base::handlerDelete() (UEventFd::fd = -1)...
+
+      if (__atomic_load_n(&(lClientIndex->UEventFd::fd), __ATOMIC_ACQUIRE) != -1 ||
+          CSOCKET->isOpen())
+         {
+         if (++CLIENT_INDEX >= eClientImage)
+            {
+            CLIENT_INDEX = vClientImage;
+
+            if (++cround >= 2) // NB: all the client image are busy, we wait that the event loop thread release someone...
+               {
+               cround = 0;
+
+               (void) U_SYSCALL_NO_PARAM(sched_yield);
+               }
+            }
+
+         goto loop;
+         }
+
+      goto try_accept;
+      }
+#endif
+
    if (CSOCKET->isOpen()) // busy
       {
       if (cround >= 2) // polling mode
@@ -2885,6 +3103,13 @@ try_accept:
          }
 #  endif
 
+      if (flag_loop                 &&
+          CSOCKET->iState != -EINTR &&
+          CSOCKET->iState != -EAGAIN)
+         {
+         U_SRV_STAT_ADD(cnt_error_accept, 1);
+         }
+
 #  if defined(U_EPOLLET_POSTPONE_STRATEGY)
       if (CSOCKET->iState == -EAGAIN) U_ClientImage_state = U_PLUGIN_HANDLER_AGAIN;
 #  endif
@@ -2967,6 +3192,16 @@ try_accept:
       }
 #endif
 
+   U_SRV_CNT_ACCEPT++;
+
+   U_SRV_STAT_ADD(cnt_active, 1);
+
+   U_INTERNAL_DUMP("child_index = %u U_SRV_CNT_ACCEPT = %u", child_index, U_SRV_CNT_ACCEPT)
+
+#if defined(ENABLE_THREAD) && !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
+   if (preforked_num_kids != -1) // NB: with PREFORK_CHILD == -1 these are updated by the event loop thread (handlerNewClient())...
+#endif
+   {
 #ifdef U_LOG_ENABLE
    U_SRV_TOT_CONNECTION++;
 
@@ -2974,6 +3209,7 @@ try_accept:
 #endif
 
    ++UNotifier::num_connection;
+   }
 
 #ifdef DEBUG
    ++stats_connections;
@@ -2990,7 +3226,7 @@ try_accept:
    /**
     * PREFORK_CHILD number of child server processes created at startup:
     *
-    * -1 - thread approach (experimental)
+    * -1 - thread approach (accept and event loop thread)
     *  0 - serialize, no forking
     *  1 - classic, forking after accept client
     * >1 - pool of process serialize plus monitoring process
@@ -3061,14 +3297,25 @@ retry:   pid = UProcess::waitpid(-1, &status, WNOHANG); // NB: to avoid too much
       {
       CSOCKET->abortive_close();
 
+#  if defined(ENABLE_THREAD) && !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
+      if (preforked_num_kids != -1) // NB: with PREFORK_CHILD == -1 it is not yet known by the event loop thread...
+#  endif
       CLIENT_INDEX->UClientImage_Base::handlerDelete();
+#  if defined(ENABLE_THREAD) && !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
+      else U_SRV_STAT_SUB(cnt_active, 1);
+#  endif
 
       goto next;
       }
 #endif
 
 #if defined(ENABLE_THREAD) && !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
-   if (preforked_num_kids == -1) lClientIndex->UEventFd::fd = psocket->iSockDesc;
+   if (preforked_num_kids == -1)
+      {
+      U_INTERNAL_ASSERT(CSOCKET->isOpen())
+
+      client_queue->push(lClientIndex); // NB: the event loop thread insert it in the event manager...
+      }
    else
 #endif
    {
@@ -3093,16 +3340,18 @@ retry:   pid = UProcess::waitpid(-1, &status, WNOHANG); // NB: to avoid too much
 #endif
 
    if (CLIENT_IMAGE_HANDLER_READ == false) goto next;
-   }
 
    U_INTERNAL_ASSERT(CSOCKET->isOpen())
    U_INTERNAL_ASSERT_DIFFERS(U_ClientImage_parallelization, U_PARALLELIZATION_CHILD)
 
+   CLIENT_INDEX->setLastEvent();
+
 #if defined(HAVE_EPOLL_CTL_BATCH) && !defined(USE_LIBEVENT)
    UNotifier::batch((UEventFd*)CLIENT_INDEX);
 #else
    UNotifier::insert((UEventFd*)CLIENT_INDEX);
 #endif
+   }
 
    if (++CLIENT_INDEX >= eClientImage) CLIENT_INDEX = vClientImage;
 
@@ -3182,6 +3431,138 @@ uint32_t UServer_Base::getNumConnection(char* ptr)
 }
 #endif
 
+UString UServer_Base::getAcceptStats()
+{
+   U_TRACE_NO_PARAM(0, "UServer_Base::getAcceptStats()")
+
+   U_INTERNAL_ASSERT_POINTER(ptr_shared_child)
+
+   uint32_t n = (preforked_num_kids > 1 ? preforked_num_kids : 1);
+
+   UString x(32U + n * 32U);
+
+   (void) x.append(U_CONSTANT_TO_PARAM("connections accepted per child:"));
+
+   for (uint32_t i = 0; i < n; ++i) x.snprintf_add(" [%u] %u (pid %d)", i, U_SRV_CHILD(i).cnt_accept, U_SRV_CHILD(i).pid);
+
+   U_RETURN_STRING(x);
+}
+
+UString UServer_Base::getStatistics()
+{
+   U_TRACE_NO_PARAM(0, "UServer_Base::getStatistics()")
+
+   U_INTERNAL_ASSERT_POINTER(ptr_shared_child)
+
+   return getStatistics(ptr_shared_child, (preforked_num_kids > 1 ? preforked_num_kids : 1));
+}
+
+UString UServer_Base::getStatistics(const shared_data_child* vchild, uint32_t n)
+{
+   U_TRACE(0, "UServer_Base::getStatistics(%p,%u)", vchild, n)
+
+   U_INTERNAL_ASSERT_POINTER(vchild)
+
+   // NB: the slots are updated concurrently by the children, we read every counter with a relaxed atomic load (no lock)...
+
+   uint32_t i, j, k;
+   uint64_t value, count, cumulative;
+   uint64_t status[6], histogram[STAT_NUM_PHASE][U_STAT_NUM_BUCKET];
+   uint64_t cnt_accept = 0, cnt_active = 0, cnt_error_accept = 0, cnt_error_read = 0, cnt_error_write = 0, cnt_request = 0, cnt_bytes_read = 0, cnt_bytes_write = 0;
+   uint64_t cnt_bytes_splice = 0, cnt_fcgi_request = 0, cnt_fcgi_wait = 0, cnt_fcgi_error = 0;
+   uint64_t cnt_micro_hit = 0, cnt_micro_stale = 0, cnt_micro_miss = 0, cnt_bytes_saved[3] = { 0, 0, 0 }, cnt_file_hit = 0, cnt_file_miss = 0, cnt_file_evict = 0;
+
+   static const char* phase_name[STAT_NUM_PHASE] = { "read", "process", "write", "total" };
+   static const double quantile[4] = { 0.50, 0.90, 0.99, 0.999 };
+
+   (void) U_SYSCALL(memset, "%p,%d,%u",    status, 0, sizeof(status));
+   (void) U_SYSCALL(memset, "%p,%d,%u", histogram, 0, sizeof(histogram));
+
+   UString x(U_CAPACITY);
+
+   for (i = 0; i < n; ++i)
+      {
+      const shared_data_child* ptr = vchild+i;
+
+      cnt_accept       += U_SRV_STAT_GET(ptr->cnt_accept);
+      cnt_active       += U_SRV_STAT_GET(ptr->cnt_active);
+      cnt_error_accept += U_SRV_STAT_GET(ptr->cnt_error_accept);
+      cnt_error_read   += U_SRV_STAT_GET(ptr->cnt_error_read);
+      cnt_error_write  += U_SRV_STAT_GET(ptr->cnt_error_write);
+      cnt_request      += U_SRV_STAT_GET(ptr->cnt_request);
+      cnt_bytes_read   += U_SRV_STAT_GET(ptr->cnt_bytes_read);
+      cnt_bytes_write  += U_SRV_STAT_GET(ptr->cnt_bytes_write);
+      cnt_bytes_splice += U_SRV_STAT_GET(ptr->cnt_bytes_splice);
+      cnt_fcgi_request += U_SRV_STAT_GET(ptr->cnt_fcgi_request);
+      cnt_fcgi_wait    += U_SRV_STAT_GET(ptr->cnt_fcgi_wait);
+      cnt_fcgi_error   += U_SRV_STAT_GET(ptr->cnt_fcgi_error);
+      cnt_micro_hit    += U_SRV_STAT_GET(ptr->cnt_micro_hit);
+      cnt_micro_stale  += U_SRV_STAT_GET(ptr->cnt_micro_stale);
+      cnt_micro_miss   += U_SRV_STAT_GET(ptr->cnt_micro_miss);
+      cnt_file_hit     += U_SRV_STAT_GET(ptr->cnt_file_hit);
+      cnt_file_miss    += U_SRV_STAT_GET(ptr->cnt_file_miss);
+      cnt_file_evict   += U_SRV_STAT_GET(ptr->cnt_file_evict);
+
+      for (j = 0; j < 3; ++j) cnt_bytes_saved[j] += U_SRV_STAT_GET(ptr->cnt_bytes_saved[j]);
+
+      for (j = 0; j < 6; ++j) status[j] += U_SRV_STAT_GET(ptr->cnt_status[j]);
+
+      for (j = 0; j < STAT_NUM_PHASE; ++j)
+         {
+         for (k = 0; k < U_STAT_NUM_BUCKET; ++k) histogram[j][k] += U_SRV_STAT_GET(ptr->histogram[j][k]);
+         }
+
+      x.snprintf_add("child %u: pid %d accepted %u active %u requests %llu\n", i, U_SRV_STAT_GET(ptr->pid), U_SRV_STAT_GET(ptr->cnt_accept),
+                                                                                  U_SRV_STAT_GET(ptr->cnt_active), U_SRV_STAT_GET(ptr->cnt_request));
+      }
+
+   x.snprintf_add("connections: accepted %llu active %llu\n"
+                  "requests: %llu (1xx %llu 2xx %llu 3xx %llu 4xx %llu 5xx %llu other %llu)\n"
+                  "bytes: read %llu written %llu spliced %llu\n"
+                  "errors: accept %llu read %llu write %llu\n"
+                  "fastcgi: requests %llu in flight %llu errors %llu\n"
+                  "micro cache: hits %llu stale %llu misses %llu\n"
+                  "compression: bytes saved gzip %llu brotli %llu zstd %llu\n"
+                  "file cache: hits %llu misses %llu evictions %llu\n"
+                  "latency (usec):  count  p50  p90  p99  p99.9  max\n",
+                  cnt_accept, cnt_active,
+                  cnt_request, status[0], status[1], status[2], status[3], status[4], status[5],
+                  cnt_bytes_read, cnt_bytes_write, cnt_bytes_splice,
+                  cnt_error_accept, cnt_error_read, cnt_error_write,
+                  cnt_fcgi_request, cnt_fcgi_wait, cnt_fcgi_error,
+                  cnt_micro_hit, cnt_micro_stale, cnt_micro_miss,
+                  cnt_bytes_saved[0], cnt_bytes_saved[1], cnt_bytes_saved[2],
+                  cnt_file_hit, cnt_file_miss, cnt_file_evict);
+
+   for (j = 0; j < STAT_NUM_PHASE; ++j)
+      {
+      for (k = 0, count = 0; k < U_STAT_NUM_BUCKET; ++k) count += histogram[j][k];
+
+      x.snprintf_add("%s: %llu", phase_name[j], count);
+
+      // NB: the quantile is the lower bound of the bucket where the cumulative count reach it...
+
+      for (i = k = 0, cumulative = histogram[j][0]; i < 4; ++i)
+         {
+         value = (uint64_t)(quantile[i] * count);
+
+         while (cumulative <= value &&
+                k < (U_STAT_NUM_BUCKET-1))
+            {
+            cumulative += histogram[j][++k];
+            }
+
+         x.snprintf_add(" %llu", (count ? getStatBucketValue(k) : 0));
+         }
+
+      for (k = U_STAT_NUM_BUCKET-1; k > 0 && histogram[j][k] == 0; --k) {}
+
+      x.snprintf_add(" %llu\n", (count ? getStatBucketValue(k) : 0));
+      }
+
+   U_RETURN_STRING(x);
+}
+
 bool UServer_Base::handlerTimeoutConnection(void* cimg)
 {
    U_TRACE(0, "UServer_Base::handlerTimeoutConnection(%p)", cimg)
@@ -3238,12 +3619,105 @@ bool UServer_Base::handlerTimeoutConnection(void* cimg)
    U_RETURN(false);
 }
 
+void UServer_Base::handlerTimeoutIdleConnection()
+{
+   U_TRACE_NO_PARAM(0, "UServer_Base::handlerTimeoutIdleConnection()")
+
+   U_INTERNAL_ASSERT_POINTER(ptime)
+
+   // NB: the list of connections is ordered by last_event, so we stop at the first connection that is not expired...
+
+   UClientImage_Base* item;
+   uint32_t n = UNotifier::num_connection - UNotifier::min_connection;
+
+   while ((item = UClientImage_Base::first_idle) &&
+          (u_now->tv_sec - item->last_event) >= ptime->UTimeVal::tv_sec)
+      {
+      U_INTERNAL_DUMP("n = %u item = %p item->last_event = %#3D", n, item, item->last_event)
+
+      if (handlerTimeoutConnection(item)) UNotifier::handlerDelete((UEventFd*)item);
+      else                                item->setLastEvent(); // NB: we move it at the end of the list...
+
+      if (n-- == 0) break; // NB: each connection is checked at most once...
+      }
+}
+
+#if defined(ENABLE_THREAD) && !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
+void UServer_Base::handlerNewClient(UClientImage_Base* ptr)
+{
+   U_TRACE(0, "UServer_Base::handlerNewClient(%p)", ptr)
+
+   U_INTERNAL_ASSERT_POINTER(ptr)
+   U_INTERNAL_ASSERT(ptr->socket->isOpen())
+   U_INTERNAL_ASSERT_EQUALS(ptr->UEventFd::fd, -1)
+
+#ifdef U_LOG_ENABLE
+   U_SRV_TOT_CONNECTION++;
+
+   U_INTERNAL_DUMP("U_SRV_TOT_CONNECTION = %u", U_SRV_TOT_CONNECTION)
+#endif
+
+   ++UNotifier::num_connection;
+
+   ptr->UEventFd::fd = ptr->socket->iSockDesc;
+
+   ptr->setLastEvent();
+
+   UNotifier::insert((UEventFd*)ptr);
+}
+#endif
+
+void UServer_Base::waitForEvent()
+{
+   U_TRACE_NO_PARAM(0, "UServer_Base::waitForEvent()")
+
+   U_INTERNAL_ASSERT_MAJOR(UNotifier::min_connection, 0)
+
+   if (ptime == 0) UNotifier::waitForEvent();
+   else
+      {
+      bool some_client = (UNotifier::num_connection > UNotifier::min_connection);
+
+      if (some_client) // NB: we must feel the possibly timeout for request from the client...
+         {
+         UTimer::insert(ptime);
+
+         last_event = u_now->tv_sec;
+         }
+
+      UNotifier::waitForEvent();
+
+      if (some_client &&
+          UNotifier::nfd_ready > 0)
+         {
+         UTimer::erase(ptime);
+
+         // NB: with a busy server the timer never expire, so we check (in O(1)) if the less recent connection is idle...
+
+         if (UClientImage_Base::first_idle &&
+             (u_now->tv_sec - UClientImage_Base::first_idle->last_event) >= ptime->UTimeVal::tv_sec &&
+             UNotifier::num_connection > UNotifier::min_connection)
+            {
+#        if defined(U_LOG_ENABLE) || (!defined(USE_LIBEVENT) && defined(HAVE_EPOLL_WAIT) && defined(DEBUG))
+            called_from_handlerTime = false;
+#        endif
+
+            handlerTimeoutIdleConnection();
+            }
+         }
+      }
+
+   U_ASSERT_EQUALS(UNotifier::empty(), false)
+}
+
 void UServer_Base::runLoop(const char* user)
 {
    U_TRACE(0, "UServer_Base::runLoop(%S)", user)
 
    socket->reusePort(socket_flags);
 
+   if (USocket::reuseport_prog != -1) U_SRV_LOG("SO_ATTACH_REUSEPORT_EBPF status is: %susing (child %u of %u)", (USocket::breuseport_bpf ? "" : "NOT "), child_index, USocket::reuseport_group);
+
 #ifdef U_LINUX
    if (bipc == false)
       {
@@ -3309,6 +3783,17 @@ void UServer_Base::runLoop(const char* user)
 
    U_INTERNAL_DUMP("UNotifier::min_connection = %d", UNotifier::min_connection)
 
+#if defined(ENABLE_THREAD) && !defined(USE_LIBEVENT) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
+   if (preforked_num_kids == -1)
+      {
+      U_INTERNAL_ASSERT_EQUALS(client_queue, 0)
+
+      client_queue = U_NEW(UClientQueue(UNotifier::max_connection));
+
+      UNotifier::insert(client_queue); // NB: we ask to be notified for new connection accepted by the main thread
+      }
+#endif
+
    if (UNotifier::min_connection)
       {
       if (binsert)         UNotifier::insert(pthis,           EPOLLEXCLUSIVE | EPOLLROUNDROBIN); // NB: we ask to be notified for request of connection (=> accept)
@@ -3327,10 +3812,6 @@ void UServer_Base::runLoop(const char* user)
 
       UNotifier::pthread = U_NEW(UClientThread);
 
-#  ifdef _MSWINDOWS_
-      InitializeCriticalSection(&UNotifier::mutex);
-#  endif
-
       UNotifier::pthread->start(50);
 
       proc->_pid = UNotifier::pthread->id;
@@ -3362,28 +3843,7 @@ void UServer_Base::runLoop(const char* user)
       {
       if (UNotifier::min_connection) // NB: we need to notify someone for something...
          {
-         if (ptime == 0) UNotifier::waitForEvent();
-         else
-            {
-            bool some_client = (UNotifier::num_connection > UNotifier::min_connection);
-
-            if (some_client) // NB: we must feel the possibly timeout for request from the client...
-               {
-               UTimer::insert(ptime);
-
-               last_event = u_now->tv_sec;
-               }
-
-            UNotifier::waitForEvent();
-
-            if (some_client &&
-                UNotifier::nfd_ready > 0)
-               {
-               UTimer::erase(ptime);
-               }
-            }
-
-         U_ASSERT_EQUALS(UNotifier::empty(), false)
+         waitForEvent();
 
          continue;
          }
@@ -3415,7 +3875,7 @@ void UServer_Base::run()
    /**
     * PREFORK_CHILD number of child server processes created at startup:
     *
-    * -1 - thread approach (experimental)
+    * -1 - thread approach (accept and event loop thread)
     *  0 - serialize, no forking
     *  1 - classic, forking after accept client
     * >1 - pool of process serialize plus monitoring process
@@ -3459,17 +3919,40 @@ no_monitoring_process:
 
       U_INTERNAL_DUMP("nkids = %u", nkids)
 
+#  if defined(U_LINUX) && !defined(U_SERVER_CAPTIVE_PORTAL)
+      if (set_tcp_reuseport_bpf &&
+          preforked_num_kids > 1)
+         {
+         u_need_root(false);
+
+         if (USocket::createReusePortBPF(preforked_num_kids, (baffinity ? u_num_cpu : 0)) == false)
+            {
+            U_SRV_LOG("WARNING: SO_ATTACH_REUSEPORT_EBPF not available %R, the cpu steering relies on SO_INCOMING_CPU", 0); // NB: the last argument (0) is necessary...
+            }
+         }
+#  endif
+
       while (flag_loop)
          {
          u_need_root(false);
 
          while (rkids < nkids)
             {
+            // NB: the new child take the first free slot of ptr_shared_child (a restarted child reuse the slot of the child that exited)...
+
+            for (child_index = 0; U_SRV_CHILD(child_index).pid; ++child_index) {}
+
+            U_INTERNAL_ASSERT_MINOR(child_index, (uint32_t)nkids)
+
+            U_SRV_CHILD(child_index).cnt_active = 0; // NB: the connections of the child that exited are gone...
+
             if (proc->fork() &&
                 proc->parent())
                {
                ++rkids;
 
+               U_SRV_CHILD(child_index).pid = proc->_pid;
+
                if (preforked_num_kids <= 0) pid_to_wait = proc->_pid;
 
                U_SRV_LOG("Started new child (pid %d), up to %u children", proc->_pid, rkids);
@@ -3486,7 +3969,7 @@ no_monitoring_process:
                   {
                   CPU_ZERO(&cpuset);
 
-                  u_bind2cpu(&cpuset, rkids % u_num_cpu); // Pin the process to a particular cpu...
+                  u_bind2cpu(&cpuset, child_index % u_num_cpu); // Pin the process to a particular cpu (NB: a restarted child takes the cpu of the child that exited)...
 
 #              if !defined(U_LOG_DISABLE) || defined(HAVE_SCHED_GETCPU)
                   char buffer[64];
@@ -3495,7 +3978,7 @@ no_monitoring_process:
 #              endif
 
 #              ifdef SO_INCOMING_CPU
-                  USocket::incoming_cpu = rkids % u_num_cpu;
+                  USocket::incoming_cpu = child_index % u_num_cpu;
 #              endif
 
 #              ifdef HAVE_SCHED_GETCPU
@@ -3514,7 +3997,7 @@ no_monitoring_process:
                   {
                   struct bitmask* bmask = (struct bitmask*) U_SYSCALL(numa_bitmask_alloc, "%u", 16);
 
-                  (void) U_SYSCALL(numa_bitmask_setbit, "%p,%u", bmask, rkids % 2);
+                  (void) U_SYSCALL(numa_bitmask_setbit, "%p,%u", bmask, child_index % 2);
 
                   U_SYSCALL_VOID(numa_set_membind,  "%p", bmask);
                   U_SYSCALL_VOID(numa_bitmask_free, "%p", bmask);
@@ -3541,6 +4024,8 @@ no_monitoring_process:
 
                UInterrupt::setHandlerForSignal(SIGHUP, (sighandler_t)SIG_IGN); // NB: we can't use UInterrupt::erase() because it restore the old action (UInterrupt::init)...
 
+               USocket::reuseport_slot = child_index; // NB: the program attached to the group select the listening socket of the child by its slot...
+
                if (pluginsHandlerFork() != U_PLUGIN_HANDLER_FINISHED) U_ERROR("Plugins stage fork failed");
 
                runLoop(user);
@@ -3576,6 +4061,8 @@ no_monitoring_process:
 
          if (rkids == 0)  // NB: check for SIGHUP event...
             {
+            for (int i = 0; i < nkids; ++i) U_SRV_CHILD(i).pid = 0;
+
             manageSigHUP();
 
             continue;
@@ -3588,7 +4075,15 @@ no_monitoring_process:
 
             --rkids;
 
-            baffinity = false;
+            for (int i = 0; i < nkids; ++i)
+               {
+               if (U_SRV_CHILD(i).pid == pid)
+                  {
+                  U_SRV_CHILD(i).pid = 0;
+
+                  break;
+                  }
+               }
 
             U_INTERNAL_DUMP("down to %u children", rkids)
 
@@ -3794,6 +4289,8 @@ const char* UServer_Base::dump(bool reset) const
                   << "verify_mode               " << verify_mode                << '\n'
                   << "shared_data_add           " << shared_data_add            << '\n'
                   << "ptr_shared_data           " << (void*)ptr_shared_data     << '\n'
+                  << "ptr_shared_child          " << (void*)ptr_shared_child    << '\n'
+                  << "child_index               " << child_index                << '\n'
                   << "preforked_num_kids        " << preforked_num_kids         << '\n'
                   << "log           (ULog       " << (void*)log                 << ")\n"
                   << "socket        (USocket    " << (void*)socket              << ")\n"
@@ -23,6 +23,10 @@
 #  include <ws2tcpip.h>
 #else
 #  include <ulib/net/unixsocket.h>
+#  ifdef U_LINUX
+#     include <linux/bpf.h>
+#     include <sys/syscall.h>
+#  endif
 #  ifndef __clang__
 U_DUMP_KERNEL_VERSION(LINUX_VERSION_CODE)
 #  endif
@@ -44,6 +48,11 @@ int            USocket::iBackLog = SOMAXCONN;
 int            USocket::accept4_flags;  // If flags is 0, then accept4() is the same as accept()
 bool           USocket::tcp_reuseport;
 bool           USocket::bincoming_cpu;
+bool           USocket::breuseport_bpf;
+int            USocket::reuseport_map = -1;
+int            USocket::reuseport_prog = -1;
+uint32_t       USocket::reuseport_slot;
+uint32_t       USocket::reuseport_group;
 SocketAddress* USocket::cLocal;
 
 #include "socket_address.cpp"
@@ -368,6 +377,143 @@ void USocket::setReusePort()
 #endif
 }
 
+#if !defined(U_SERVER_CAPTIVE_PORTAL) && defined(U_LINUX) && defined(__NR_bpf) && defined(BPF_PSEUDO_MAP_FD)
+#  define U_REUSEPORT_BPF
+
+static inline int u_bpf(int cmd, union bpf_attr* attr)
+{
+   U_TRACE(1, "u_bpf(%d,%p)", cmd, attr)
+
+   int result = U_SYSCALL(syscall, "%d,%d,%p,%u", __NR_bpf, cmd, attr, sizeof(union bpf_attr));
+
+   U_RETURN(result);
+}
+#endif
+
+bool USocket::createReusePortBPF(uint32_t group, uint32_t ncpu)
+{
+   U_TRACE(0, "USocket::createReusePortBPF(%u,%u)", group, ncpu)
+
+   /**
+    * With SO_REUSEPORT the kernel select the listening socket of the group by a hash of the 4-tuple, so a connection
+    * can be accepted by a process that run on a cpu different from the one that has received the packet. We can't steer
+    * by the index of the socket in the group because it is not stable: when a preforked process exit the kernel move the
+    * last socket of the group in the hole, the restarted process is appended at the end (and the listening socket of the
+    * parent is also part of the group). So we use a socket array (BPF_MAP_TYPE_REUSEPORT_SOCKARRAY) indexed by the slot of
+    * the preforked process, where every process store its listening socket when it start (the kernel remove the entry when
+    * the socket is closed), and a program (SO_ATTACH_REUSEPORT_EBPF) that select the entry of the cpu that received the packet:
+    *
+    * slot = cpu                                  (group == ncpu)
+    * slot = cpu + ncpu * (hash % (group / ncpu)) (group multiple of ncpu, the process of slot n is bound to the cpu n % ncpu)
+    * slot = cpu % group                          (otherwise)
+    *
+    * If the entry is empty (ex. the process is restarting) the kernel fallback to the hash selection. NB: must be called by
+    * the parent before the fork, with the privilege to load the program (CAP_BPF)...
+    */
+
+#ifdef U_REUSEPORT_BPF
+   U_INTERNAL_ASSERT_MAJOR(group, 1)
+   U_INTERNAL_ASSERT_EQUALS(reuseport_map, -1)
+
+   union bpf_attr attr;
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", &attr, 0, sizeof(attr));
+
+   attr.map_type    = BPF_MAP_TYPE_REUSEPORT_SOCKARRAY;
+   attr.key_size    = sizeof(uint32_t);
+   attr.value_size  = sizeof(uint64_t);
+   attr.max_entries = group;
+
+   if ((reuseport_map = u_bpf(BPF_MAP_CREATE, &attr)) == -1) U_RETURN(false);
+
+   uint32_t n = 0, per_cpu = (ncpu && (group % ncpu) == 0 ? group / ncpu : 0);
+   struct bpf_insn code[32];
+
+#  define U_BPF_INSN(c,dst,src,o,i) (code[n].code = (c), code[n].dst_reg = (dst), code[n].src_reg = (src), code[n].off = (o), code[n].imm = (i), ++n)
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", code, 0, sizeof(code));
+
+   U_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_6, BPF_REG_1, 0, 0);                                                      // r6 = ctx
+   U_BPF_INSN(BPF_JMP   | BPF_CALL,        0,         0,         0, BPF_FUNC_get_smp_processor_id);                          // r0 = cpu
+
+   if (per_cpu == 0) U_BPF_INSN(BPF_ALU | BPF_MOD | BPF_K, BPF_REG_0, 0, 0, (int32_t)group);                                 // r0 %= group
+   else if (per_cpu > 1)
+      {
+      U_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_X, BPF_REG_7, BPF_REG_0, 0, 0);                                                   // r7 = cpu
+      U_BPF_INSN(BPF_LDX   | BPF_MEM | BPF_W, BPF_REG_0, BPF_REG_6, offsetof(struct sk_reuseport_md, hash), 0);              // r0 = ctx->hash
+      U_BPF_INSN(BPF_ALU   | BPF_MOD | BPF_K, BPF_REG_0, 0,         0, (int32_t)per_cpu);                                    // r0 %= per_cpu
+      U_BPF_INSN(BPF_ALU   | BPF_MUL | BPF_K, BPF_REG_0, 0,         0, (int32_t)ncpu);                                       // r0 *= ncpu
+      U_BPF_INSN(BPF_ALU   | BPF_ADD | BPF_X, BPF_REG_0, BPF_REG_7, 0, 0);                                                   // r0 += cpu
+      }
+
+   U_BPF_INSN(BPF_STX   | BPF_MEM | BPF_W,   BPF_REG_10, BPF_REG_0, -4, 0);                                                  // key = r0
+   U_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_X,   BPF_REG_1,  BPF_REG_6,  0, 0);                                                  // r1 = ctx
+   U_BPF_INSN(BPF_LD    | BPF_DW  | BPF_IMM, BPF_REG_2,  BPF_PSEUDO_MAP_FD, 0, reuseport_map);                              // r2 = map
+   U_BPF_INSN(0, 0, 0, 0, 0);
+   U_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_X,   BPF_REG_3,  BPF_REG_10, 0, 0);                                                  // r3 = &key
+   U_BPF_INSN(BPF_ALU64 | BPF_ADD | BPF_K,   BPF_REG_3,  0,          0, -4);
+   U_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_K,   BPF_REG_4,  0,          0, 0);                                                  // r4 = flags
+   U_BPF_INSN(BPF_JMP   | BPF_CALL,          0,          0,          0, BPF_FUNC_sk_select_reuseport);
+   U_BPF_INSN(BPF_ALU64 | BPF_MOV | BPF_K,   BPF_REG_0,  0,          0, SK_PASS);                                            // return SK_PASS
+   U_BPF_INSN(BPF_JMP   | BPF_EXIT,          0,          0,          0, 0);
+
+#  undef U_BPF_INSN
+
+   U_INTERNAL_ASSERT_MINOR(n, sizeof(code) / sizeof(code[0]))
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", &attr, 0, sizeof(attr));
+
+   attr.prog_type = BPF_PROG_TYPE_SK_REUSEPORT;
+   attr.insn_cnt  = n;
+   attr.insns     = (uint64_t)(uintptr_t)code;
+   attr.license   = (uint64_t)(uintptr_t)"GPL";
+
+   if ((reuseport_prog = u_bpf(BPF_PROG_LOAD, &attr)) == -1)
+      {
+      (void) U_SYSCALL(close, "%d", reuseport_map);
+
+      reuseport_map = -1;
+
+      U_RETURN(false);
+      }
+
+   reuseport_group = group;
+
+   U_RETURN(true);
+#else
+   U_RETURN(false);
+#endif
+}
+
+void USocket::setReusePortBPF()
+{
+   U_TRACE_NO_PARAM(0, "USocket::setReusePortBPF()")
+
+   U_INTERNAL_DUMP("reuseport_slot = %u reuseport_group = %u reuseport_map = %d reuseport_prog = %d", reuseport_slot, reuseport_group, reuseport_map, reuseport_prog)
+
+#ifdef U_REUSEPORT_BPF
+   U_INTERNAL_ASSERT_MINOR(reuseport_slot, reuseport_group)
+   U_INTERNAL_ASSERT_DIFFERS(reuseport_map, -1)
+
+   // NB: the entry of the slot is replaced (a restarted process take the slot of the process that exited)...
+
+   union bpf_attr attr;
+   uint64_t value = (uint64_t)iSockDesc;
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", &attr, 0, sizeof(attr));
+
+   attr.map_fd = reuseport_map;
+   attr.key    = (uint64_t)(uintptr_t)&reuseport_slot;
+   attr.value  = (uint64_t)(uintptr_t)&value;
+   attr.flags  = BPF_ANY;
+
+   breuseport_bpf = (u_bpf(BPF_MAP_UPDATE_ELEM, &attr) == 0 &&
+                     setSockOpt(SOL_SOCKET, SO_ATTACH_REUSEPORT_EBPF, (const void*)&reuseport_prog, sizeof(int)));
+
+   U_INTERNAL_DUMP("breuseport_bpf = %b", breuseport_bpf)
+#endif
+}
+
 void USocket::setReuseAddress()
 {
    U_TRACE_NO_PARAM(0, "USocket::setReuseAddress()")
@@ -596,6 +742,8 @@ void USocket::reusePort(int _flags)
       if (incoming_cpu != -1) bincoming_cpu = setSockOpt(SOL_SOCKET, SO_INCOMING_CPU, (void*)&incoming_cpu);
 #  endif
 
+      if (reuseport_prog != -1) setReusePortBPF();
+
       (void) U_SYSCALL(close, "%d", old);
       }
 #endif
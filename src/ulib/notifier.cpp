@@ -21,6 +21,10 @@
 #ifdef HAVE_KQUEUE
 #  include <sys/event.h>
 #endif
+#ifdef U_IO_URING_SUPPORT
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#endif
 
 #ifndef HAVE_POLL_H
 UEventTime* UNotifier::time_obj;
@@ -70,11 +74,6 @@ uint32_t UNotifier::max_nfd_ready;
 
 #if defined(ENABLE_THREAD) && defined(U_SERVER_THREAD_APPROACH_SUPPORT)
 UThread* UNotifier::pthread;
-#  ifdef _MSWINDOWS_
-CRITICAL_SECTION UNotifier::mutex;
-#  else
-pthread_mutex_t UNotifier::mutex = PTHREAD_MUTEX_INITIALIZER;
-#  endif
 #endif
 
 #ifdef USE_LIBEVENT
@@ -117,6 +116,302 @@ void UNotifier::batch((UEventFd* item)
    if (++ctl_cmd_cnt >= U_EPOLL_CTL_CMD_SIZE) insertBatch();
 }
 #  endif
+#  ifdef U_IO_URING_SUPPORT
+bool                 UNotifier::bio_uring;
+int                  UNotifier::ring_fd;
+void*                UNotifier::ring_ptr[2];
+size_t               UNotifier::ring_sz[2];
+uint32_t             UNotifier::sq_mask;
+uint32_t             UNotifier::cq_mask;
+uint32_t             UNotifier::sq_tail_local;
+uint32_t             UNotifier::sq_to_submit;
+uint32_t*            UNotifier::sq_head;
+uint32_t*            UNotifier::sq_tail;
+uint32_t*            UNotifier::sq_array;
+uint32_t*            UNotifier::cq_head;
+uint32_t*            UNotifier::cq_tail;
+struct io_uring_sqe* UNotifier::sqes;
+struct io_uring_cqe* UNotifier::cqes;
+
+bool UNotifier::ringInit()
+{
+   U_TRACE_NO_PARAM(1, "UNotifier::ringInit()")
+
+   U_INTERNAL_ASSERT_EQUALS(ring_fd, 0)
+
+   char* ptr;
+   struct io_uring_params p;
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", &p, 0, sizeof(p));
+
+   p.flags      = IORING_SETUP_CQSIZE;
+   p.cq_entries = U_max(max_connection, U_IO_URING_SQ_SIZE) * 2; // NB: multishot poll can post many completion for the same request...
+
+   ring_fd = U_SYSCALL(syscall, "%d,%u,%p", __NR_io_uring_setup, U_IO_URING_SQ_SIZE, &p);
+
+   if (ring_fd == -1)
+      {
+      ring_fd = 0;
+
+      U_RETURN(false);
+      }
+
+   U_INTERNAL_DUMP("p.sq_entries = %u p.cq_entries = %u p.features = %B", p.sq_entries, p.cq_entries, p.features)
+
+   // NB: we need the submission and completion ring in a single mmap, no drop of completion and the timeout as argument of io_uring_enter()...
+
+   if ((p.features & IORING_FEAT_NODROP)      == 0 ||
+       (p.features & IORING_FEAT_EXT_ARG)     == 0 ||
+       (p.features & IORING_FEAT_SINGLE_MMAP) == 0)
+      {
+      (void) U_SYSCALL(close, "%d", ring_fd);
+
+      ring_fd = 0;
+
+      U_RETURN(false);
+      }
+
+   ring_sz[0] = U_max(p.sq_off.array + p.sq_entries * sizeof(uint32_t),
+                      p.cq_off.cqes  + p.cq_entries * sizeof(struct io_uring_cqe));
+   ring_sz[1] =                        p.sq_entries * sizeof(struct io_uring_sqe);
+
+   ring_ptr[0] = U_SYSCALL(mmap, "%d,%u,%d,%d,%d,%u", 0, ring_sz[0], PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+   ring_ptr[1] = U_SYSCALL(mmap, "%d,%u,%d,%d,%d,%u", 0, ring_sz[1], PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+
+   if (ring_ptr[0] == MAP_FAILED ||
+       ring_ptr[1] == MAP_FAILED)
+      {
+      if (ring_ptr[0] == MAP_FAILED) ring_ptr[0] = 0;
+      if (ring_ptr[1] == MAP_FAILED) ring_ptr[1] = 0;
+
+      ringClose();
+
+      U_RETURN(false);
+      }
+
+   ptr = (char*)ring_ptr[0];
+
+   sq_head  =  (uint32_t*)(ptr + p.sq_off.head);
+   sq_tail  =  (uint32_t*)(ptr + p.sq_off.tail);
+   sq_mask  = *(uint32_t*)(ptr + p.sq_off.ring_mask);
+   sq_array =  (uint32_t*)(ptr + p.sq_off.array);
+   cq_head  =  (uint32_t*)(ptr + p.cq_off.head);
+   cq_tail  =  (uint32_t*)(ptr + p.cq_off.tail);
+   cq_mask  = *(uint32_t*)(ptr + p.cq_off.ring_mask);
+   cqes     =  (struct io_uring_cqe*)(ptr + p.cq_off.cqes);
+   sqes     =  (struct io_uring_sqe*)ring_ptr[1];
+
+   sq_tail_local = *sq_tail;
+   sq_to_submit  = 0;
+
+   U_RETURN(true);
+}
+
+void UNotifier::ringClose()
+{
+   U_TRACE_NO_PARAM(1, "UNotifier::ringClose()")
+
+   U_INTERNAL_ASSERT_MAJOR(ring_fd, 0)
+
+   // NB: after fork() the ring is shared with the parent, so we must only unmap it...
+
+   if (ring_ptr[1]) (void) U_SYSCALL(munmap, "%p,%u", ring_ptr[1], ring_sz[1]);
+   if (ring_ptr[0]) (void) U_SYSCALL(munmap, "%p,%u", ring_ptr[0], ring_sz[0]);
+
+   (void) U_SYSCALL(close, "%d", ring_fd);
+
+   ring_fd     = 0;
+   ring_ptr[0] =
+   ring_ptr[1] = 0;
+}
+
+void UNotifier::ringSubmit()
+{
+   U_TRACE_NO_PARAM(1, "UNotifier::ringSubmit()")
+
+   U_INTERNAL_DUMP("sq_to_submit = %u", sq_to_submit)
+
+   if (sq_to_submit)
+      {
+      (void) U_SYSCALL(syscall, "%d,%d,%u,%u,%u,%p,%u", __NR_io_uring_enter, ring_fd, sq_to_submit, 0, 0, 0, 0);
+
+      sq_to_submit = 0;
+      }
+}
+
+struct io_uring_sqe* UNotifier::ringGetSqe()
+{
+   U_TRACE_NO_PARAM(0, "UNotifier::ringGetSqe()")
+
+   U_INTERNAL_ASSERT_MAJOR(ring_fd, 0)
+
+   // NB: if the submission ring is full we must submit the pending requests...
+
+   if ((sq_tail_local - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE)) > sq_mask) ringSubmit();
+
+   uint32_t idx = sq_tail_local & sq_mask;
+
+   struct io_uring_sqe* sqe = sqes + idx;
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", sqe, 0, sizeof(struct io_uring_sqe));
+
+   sq_array[idx] = idx;
+
+   __atomic_store_n(sq_tail, ++sq_tail_local, __ATOMIC_RELEASE);
+
+   ++sq_to_submit;
+
+   U_RETURN_POINTER(sqe, struct io_uring_sqe);
+}
+
+void UNotifier::ringPollAdd(UEventFd* item)
+{
+   U_TRACE(0, "UNotifier::ringPollAdd(%p)", item)
+
+   U_INTERNAL_ASSERT_POINTER(item)
+
+   U_INTERNAL_DUMP("item->fd = %d item->op_mask = %B", item->fd, item->op_mask)
+
+   struct io_uring_sqe* sqe = ringGetSqe();
+
+   sqe->opcode        = IORING_OP_POLL_ADD;
+   sqe->fd            = item->fd;
+   sqe->poll32_events = item->op_mask; // NB: the same mask of epoll (EPOLLET included)
+   sqe->user_data     = (uint64_t)(long)item;
+
+   // NB: the multishot poll is edge-triggered, for the fd without EPOLLET we need the level-triggered behaviour of epoll, so we use a
+   //     single shot poll (it check the readiness when it is armed) that is armed again after the call of the handler...
+
+   if ((item->op_mask & EPOLLET) != 0) sqe->len = IORING_POLL_ADD_MULTI;
+}
+
+void UNotifier::ringPollRemove(UEventFd* item)
+{
+   U_TRACE(0, "UNotifier::ringPollRemove(%p)", item)
+
+   U_INTERNAL_ASSERT_POINTER(item)
+
+   struct io_uring_sqe* sqe = ringGetSqe();
+
+   sqe->opcode    = IORING_OP_POLL_REMOVE;
+   sqe->fd        = -1;
+   sqe->addr      = (uint64_t)(long)item;
+   sqe->user_data = 0; // NB: we are not interested to the completion of this request...
+}
+
+void UNotifier::ringWaitForEvent(UEventTime* ptimeout)
+{
+   U_TRACE(1, "UNotifier::ringWaitForEvent(%p)", ptimeout)
+
+   U_INTERNAL_ASSERT_MAJOR(ring_fd, 0)
+
+   int i;
+   uint32_t res, head;
+   struct io_uring_cqe* cqe;
+
+loop:
+   head = *cq_head;
+
+   U_INTERNAL_DUMP("sq_to_submit = %u head = %u", sq_to_submit, head)
+
+   if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+      {
+      // NB: we submit the pending requests (registration of new fd) and wait for events with a single syscall...
+
+      struct io_uring_getevents_arg arg;
+
+      arg.sigmask    = 0;
+      arg.sigmask_sz = 0;
+      arg.pad        = 0;
+      arg.ts         = (uint64_t)(long)UEventTime::getTimeSpec(ptimeout);
+
+      nfd_ready = U_SYSCALL(syscall, "%d,%d,%u,%u,%u,%p,%u", __NR_io_uring_enter, ring_fd, sq_to_submit, 1,
+                                                             IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+
+      sq_to_submit = 0;
+
+      if (nfd_ready == -1)
+         {
+         if (errno == ETIME) nfd_ready = 0; // timeout
+
+         return;
+         }
+      }
+   else
+      {
+      ringSubmit();
+      }
+
+   i = 0;
+
+   // NB: the completion entry must be consumed before to call the handler (it can submit new requests)...
+
+   while (head != __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+      {
+      cqe = cqes + (head & cq_mask);
+
+      handler_event = (UEventFd*)(long)cqe->user_data;
+
+      res = cqe->res;
+
+      bool bmore = ((cqe->flags & IORING_CQE_F_MORE) != 0);
+
+      __atomic_store_n(cq_head, ++head, __ATOMIC_RELEASE);
+
+      U_INTERNAL_DUMP("handler_event = %p res = %d bmore = %b", handler_event, (int)res, bmore)
+
+      // NB: user_data == 0 is the completion of a poll remove and a negative result is a cancelled (or failed) poll request...
+
+      if (handler_event == 0 ||
+          (int)res < 0       ||
+          handler_event->fd == -1)
+         {
+         continue;
+         }
+
+      if ((res & (handler_event->op_mask | EPOLLERR | EPOLLHUP)) == 0)
+         {
+         if (bmore == false) ringPollAdd(handler_event);
+
+         continue;
+         }
+
+      ++i;
+
+      U_INTERNAL_DUMP("i = %d handler_event->fd = %d res = %B", i, handler_event->fd, res)
+
+      int fd         = handler_event->fd;
+      uint32_t mask  = handler_event->op_mask;
+      UEventFd* item = handler_event;
+
+      if ((UNLIKELY((res & (EPOLLERR | EPOLLHUP)) != 0) && isEventError(res)) ||
+          ((res & (EPOLLIN | EPOLLRDHUP | EPOLLOUT)) != 0 &&
+           (LIKELY((res & (EPOLLIN | EPOLLRDHUP)) != 0) ? handler_event->handlerRead()
+                                                        : handler_event->handlerWrite()) == U_NOTIFIER_DELETE))
+         {
+         handlerDelete(handler_event);
+         }
+      else if (bmore == false && // NB: single shot poll or the kernel has terminated the multishot poll request (ex: overflow of the completion ring)...
+               item->fd      == fd &&
+               item->op_mask == mask) // NB: otherwise the handler has already armed a new poll request (with modify() or insert())...
+         {
+         ringPollAdd(item);
+         }
+      }
+
+   // NB: nfd_ready == 0 mean timeout for the caller, so if we have consumed only completion without events we must wait again...
+
+   if (i == 0) goto loop;
+
+   nfd_ready = i;
+
+#ifdef DEBUG
+   if (max_nfd_ready < (uint32_t)nfd_ready) max_nfd_ready = nfd_ready;
+
+   U_INTERNAL_DUMP("max_nfd_ready = %u", max_nfd_ready)
+#endif
+}
+#  endif
 # elif defined(HAVE_KQUEUE)
 int            UNotifier::kq;
 int            UNotifier::nkqevents;
@@ -151,6 +446,41 @@ void UNotifier::init(bool bacquisition)
 {
    U_TRACE(0, "UNotifier::init(%b)", bacquisition)
 
+#ifdef U_IO_URING_SUPPORT
+   U_INTERNAL_DUMP("bio_uring = %b ring_fd = %d", bio_uring, ring_fd)
+
+   if (bio_uring)
+      {
+      if (ring_fd) ringClose(); // NB: after fork() we need a new ring...
+
+      if (ringInit())
+         {
+         if (lo_map_fd == 0) createMapFd();
+         else if (bacquisition &&
+                  num_connection)
+            {
+            // NB: reinitialized all after fork()...
+
+            for (int fd = 1; fd < (int32_t)max_connection; ++fd)
+               {
+               if ((handler_event = lo_map_fd[fd])) ringPollAdd(handler_event);
+               }
+
+            if (hi_map_fd->first())
+               {
+               do { ringPollAdd(hi_map_fd->elem()); } while (hi_map_fd->next());
+               }
+            }
+
+         return;
+         }
+
+      bio_uring = false;
+
+      U_WARNING("io_uring is not available, I must use epoll...");
+      }
+#endif
+
 #ifdef HAVE_EPOLL_WAIT
    int old = epollfd;
 
@@ -314,6 +644,15 @@ void UNotifier::resume(UEventFd* item)
    U_INTERNAL_ASSERT_POINTER(item)
    U_INTERNAL_ASSERT_EQUALS(item->op_mask, EPOLLOUT)
 
+#ifdef U_IO_URING_SUPPORT
+   if (ring_fd)
+      {
+      ringPollAdd(item);
+
+      return;
+      }
+#endif
+
 #ifdef HAVE_EPOLL_WAIT
    struct epoll_event _events = { EPOLLOUT, { item } };
 
@@ -346,6 +685,15 @@ void UNotifier::suspend(UEventFd* item)
    U_INTERNAL_ASSERT_POINTER(item)
    U_INTERNAL_ASSERT_EQUALS(item->op_mask, EPOLLOUT)
 
+#ifdef U_IO_URING_SUPPORT
+   if (ring_fd)
+      {
+      ringPollRemove(item);
+
+      return;
+      }
+#endif
+
 #ifdef HAVE_EPOLL_WAIT
    (void) U_SYSCALL(epoll_ctl, "%d,%d,%d,%p", epollfd, EPOLL_CTL_DEL, item->fd, (struct epoll_event*)1);
 #elif defined(HAVE_KQUEUE)
@@ -435,6 +783,15 @@ loop:
    nkqevents = 0;
 #else
 loop:
+# ifdef U_IO_URING_SUPPORT
+   if (ring_fd)
+      {
+      ringWaitForEvent(ptimeout);
+
+      if (nfd_ready != -1) return;
+      }
+   else
+# endif
    nfd_ready = U_SYSCALL(epoll_wait, "%d,%p,%u,%d", epollfd, events, max_connection, UEventTime::getMilliSecond(ptimeout));
 #endif
 
@@ -541,9 +898,10 @@ loop0:
           *  EPOLLIN  EPOLLRDHUP
           */
 
-         if (UNLIKELY((pevents->events & (EPOLLERR | EPOLLHUP))  != 0) ||
+         if ((UNLIKELY((pevents->events & (EPOLLERR | EPOLLHUP)) != 0) && isEventError(pevents->events)) ||
+             ((pevents->events & (EPOLLIN | EPOLLRDHUP | EPOLLOUT)) != 0 &&
               (LIKELY((pevents->events & (EPOLLIN | EPOLLRDHUP)) != 0) ? handler_event->handlerRead()
-                                                                       : handler_event->handlerWrite()) == U_NOTIFIER_DELETE)
+                                                                       : handler_event->handlerWrite()) == U_NOTIFIER_DELETE))
             {
             handlerDelete(handler_event);
 
@@ -596,9 +954,8 @@ loop2:         if (pevents->events)
 
                   U_INTERNAL_DUMP("i = %d handler_event->fd = %d ", i, handler_event->fd)
 
-                  U_INTERNAL_ASSERT_DIFFERS(handler_event->fd, -1)
-
-                  if (handler_event->handlerRead() == U_NOTIFIER_DELETE)
+                  if (handler_event->fd == -1) pevents->events = 0; // NB: it can be deleted by the handler of another event...
+                  else if (handler_event->handlerRead() == U_NOTIFIER_DELETE)
                      {
                      handlerDelete(handler_event);
 
@@ -704,11 +1061,7 @@ bool UNotifier::isHandler(int fd)
       if (fd < (int32_t)max_connection) result = (lo_map_fd[fd] != 0);
       else
          {
-         lock();
-
          result = hi_map_fd->find(fd);
-
-         unlock();
          }
       }
 
@@ -735,15 +1088,7 @@ bool UNotifier::setHandler(int fd)
          }
       }
 
-   bool result;
-
-   lock();
-
-   result = hi_map_fd->find(fd);
-
-   unlock();
-
-   if (result)
+   if (hi_map_fd->find(fd))
       {
       handler_event = hi_map_fd->elem();
 
@@ -768,14 +1113,7 @@ void UNotifier::insert(UEventFd* item, int op)
    U_INTERNAL_ASSERT_DIFFERS(fd, -1)
 
    if (fd < (int32_t)max_connection) lo_map_fd[fd] = item;
-   else
-      {
-      lock();
-
-      hi_map_fd->insert(fd, item);
-
-      unlock();
-      }
+   else                              hi_map_fd->insert(fd, item);
 
 #ifdef USE_LIBEVENT
    U_INTERNAL_ASSERT_POINTER(u_ev_base)
@@ -788,6 +1126,15 @@ void UNotifier::insert(UEventFd* item, int op)
 
    (void) UDispatcher::add(*(item->pevent));
 #elif defined(HAVE_EPOLL_WAIT)
+#  ifdef U_IO_URING_SUPPORT
+   if (ring_fd)
+      {
+      ringPollAdd(item); // NB: it is submitted with the next wait for event...
+
+      return;
+      }
+#  endif
+
    U_INTERNAL_ASSERT_MAJOR(epollfd, 0)
 
    struct epoll_event _events = { item->op_mask, { item } };
@@ -859,6 +1206,16 @@ void UNotifier::modify(UEventFd* item)
 
    (void) UDispatcher::add(*(item->pevent));
 #elif defined(HAVE_EPOLL_WAIT)
+#  ifdef U_IO_URING_SUPPORT
+   if (ring_fd)
+      {
+      ringPollRemove(item);
+      ringPollAdd(item);
+
+      return;
+      }
+#  endif
+
    U_INTERNAL_ASSERT_MAJOR(epollfd, 0)
 
    struct epoll_event _events = { item->op_mask, { item } };
@@ -935,15 +1292,21 @@ void UNotifier::handlerDelete(int fd, int mask)
 
    U_INTERNAL_ASSERT_MAJOR(fd, 0)
 
-   if (fd < (int32_t)max_connection) lo_map_fd[fd] = 0;
-   else
+#ifdef U_IO_URING_SUPPORT
+   // NB: the poll request hold a reference to the file, so we must cancel it (otherwise close() don't release the socket)...
+
+   if (ring_fd)
       {
-      lock();
+      UEventFd* item = handler_event; // NB: we can be called inside the handler of another event...
 
-      (void) hi_map_fd->erase(fd);
+      if (setHandler(fd)) ringPollRemove(handler_event);
 
-      unlock();
+      handler_event = item;
       }
+#endif
+
+   if (fd < (int32_t)max_connection) lo_map_fd[fd] = 0;
+   else                              (void) hi_map_fd->erase(fd);
 
 #if !defined(USE_LIBEVENT) && !defined(HAVE_EPOLL_WAIT) && !defined(HAVE_KQUEUE)
    if ((mask & (EPOLLIN | EPOLLRDHUP)) != 0)
@@ -1074,6 +1437,12 @@ void UNotifier::clear()
 
 #ifndef USE_LIBEVENT
 # ifdef HAVE_EPOLL_WAIT
+#  ifdef U_IO_URING_SUPPORT
+   if (ring_fd) ringClose();
+
+   if (events == 0) return;
+#  endif
+
    U_INTERNAL_ASSERT_POINTER(events)
 
    UMemoryPool::_free(events, max_connection + 1, sizeof(struct epoll_event));
@@ -57,6 +57,16 @@
 #else
 #  define LIBZOPFLI_ENABLE   "no"
 #endif
+#ifdef USE_LIBBROTLI
+#  define LIBBROTLI_ENABLE   "yes ( " _LIBBROTLI_VERSION " )"
+#else
+#  define LIBBROTLI_ENABLE   "no"
+#endif
+#ifdef USE_LIBZSTD
+#  define LIBZSTD_ENABLE     "yes ( " _LIBZSTD_VERSION " )"
+#else
+#  define LIBZSTD_ENABLE     "no"
+#endif
 #ifdef USE_LIBTDB
 #  define LIBTDB_ENABLE      "yes ( " _LIBTDB_VERSION " )"
 #else
@@ -707,6 +717,8 @@ uint32_t UOptions::getopt(int argc, char** argv, int* poptind)
 
                "LIBZ support.........:%W " LIBZ_ENABLE "%W\n"
                "LIBZOPFLI support....:%W " LIBZOPFLI_ENABLE "%W\n"
+               "LIBBROTLI support....:%W " LIBBROTLI_ENABLE "%W\n"
+               "LIBZSTD support......:%W " LIBZSTD_ENABLE "%W\n"
                "LIBTDB support.......:%W " LIBTDB_ENABLE "%W\n"
                "PCRE support.........:%W " LIBPCRE_ENABLE "%W\n"
                "SSL support..........:%W " LIBSSL_ENABLE "%W\n"
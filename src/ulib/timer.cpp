@@ -13,9 +13,12 @@
 
 #include <ulib/timer.h>
 
-int     UTimer::mode;
-UTimer* UTimer::pool;
-UTimer* UTimer::first;
+int      UTimer::mode;
+UTimer*  UTimer::pool;
+UTimer*  UTimer::first;
+UTimer*  UTimer::wheel[U_TIMER_WHEEL_SIZE];
+uint64_t UTimer::horizon;
+uint32_t UTimer::num_timer;
 
 void UTimer::init(Type _mode)
 {
@@ -40,32 +43,136 @@ U_NO_EXPORT void UTimer::insertEntry()
 
    U_CHECK_MEMORY
 
-   if (first == 0) // The list is empty
+   uint64_t tick = getTick();
+
+   U_INTERNAL_DUMP("tick = %llu horizon = %llu", tick, horizon)
+
+   if (tick > horizon) // it expire after the horizon: O(1) insert in the slot of the wheel
       {
-      next  = 0;
-      first = this;
+      link(wheel + (tick & U_TIMER_WHEEL_MASK));
+
+      return;
       }
-   else
+
+   UTimer** ptr = &first;
+
+   if (tick < horizon)
       {
-      UTimer** ptr = &first;
+      // NB: it expire before the horizon, so we move back the horizon to its tick and put back
+      //     in the wheel the timers (at the end of the active list) that expire after the new one...
+
+      horizon = tick;
 
-      do {
-         if (*this < **ptr) break;
+      while (*ptr)
+         {
+         if ((*ptr)->getTick() > tick)
+            {
+            UTimer* item;
+
+            do {
+               item = *ptr;
+
+               item->unlink();
+               item->link(wheel + (item->getTick() & U_TIMER_WHEEL_MASK));
+               }
+            while (*ptr);
+
+            break;
+            }
 
          ptr = &(*ptr)->next;
          }
-      while (*ptr);
 
-      next = *ptr;
-      *ptr = this;
+      ptr = &first;
       }
 
+   // add it in to the active list, sorted correctly
+
+   while (*ptr)
+      {
+      if (*this < **ptr) break;
+
+      ptr = &(*ptr)->next;
+      }
+
+   link(ptr);
+
    U_ASSERT(invariant())
 }
 
+U_NO_EXPORT void UTimer::advance()
+{
+   U_TRACE_NO_PARAM(0, "UTimer::advance()")
+
+   U_INTERNAL_ASSERT_EQUALS(first, 0)
+   U_INTERNAL_ASSERT_MAJOR(num_timer, 0)
+
+   // move the horizon to the next tick of the wheel that have timers and put them in the active list
+
+   UTimer** ptr;
+   UTimer* item;
+   UTimer* item_next;
+   uint64_t tick;
+   uint32_t i, n = U_TIMER_WHEEL_SIZE;
+
+loop:
+   while (n--)
+      {
+      ++horizon;
+
+      for (item = wheel[horizon & U_TIMER_WHEEL_MASK]; item; item = item_next)
+         {
+         item_next = item->next;
+
+         if (item->getTick() == horizon)
+            {
+            // NB: we don't call insertEntry(), the other timers of the slot that expire at the horizon are not yet moved (see invariant())...
+
+            item->unlink();
+
+            for (ptr = &first; *ptr; ptr = &(*ptr)->next)
+               {
+               if (*item < **ptr) break;
+               }
+
+            item->link(ptr);
+            }
+         }
+
+      if (first)
+         {
+         U_INTERNAL_DUMP("horizon = %llu", horizon)
+
+         U_ASSERT(invariant())
+
+         return;
+         }
+      }
+
+   // a full revolution of the wheel without timers: we jump directly before the nearest one
+
+   tick = (uint64_t)-1;
+
+   for (i = 0; i < U_TIMER_WHEEL_SIZE; ++i)
+      {
+      for (item = wheel[i]; item; item = item->next)
+         {
+         if (item->getTick() < tick) tick = item->getTick();
+         }
+      }
+
+   U_INTERNAL_ASSERT_MAJOR(tick, horizon)
+
+   horizon = tick - 1;
+
+   n = 1;
+
+   goto loop;
+}
+
 void UTimer::insert(UEventTime* a)
 {
-   U_TRACE(0, "UTimer::insert(%p,%b)", a)
+   U_TRACE(0, "UTimer::insert(%p)", a)
 
    // set an alarm to more than 2 month is very suspect...
 
@@ -80,10 +187,12 @@ void UTimer::insert(UEventTime* a)
       pool = pool->next;
       }
 
-   // add it in to its new list, sorted correctly
+   ++num_timer;
 
    (item->alarm = a)->setTimeToExpire();
 
+   a->ptimer = item;
+
    item->insertEntry();
 }
 
@@ -94,9 +203,11 @@ void UTimer::callHandlerTimeout()
    U_INTERNAL_ASSERT_POINTER(first)
 
    UTimer* item = first;
-                  first = first->next; // remove it from its active list
+                  item->unlink(); // remove it from its active list
 
-   U_INTERNAL_DUMP("UEventTime::timeout1 = %#19D (next alarm expire) = %#19D", UEventTime::timeout1.tv_sec, item->next ? item->next->alarm->expire() : 0L)
+   --num_timer;
+
+   U_INTERNAL_DUMP("UEventTime::timeout1 = %#19D (next alarm expire) = %#19D", UEventTime::timeout1.tv_sec, first ? first->alarm->expire() : 0L)
 
    int result = item->alarm->handlerTime();
 
@@ -110,15 +221,13 @@ void UTimer::callHandlerTimeout()
 
       item->alarm->updateTimeToExpire();
 
+      ++num_timer;
+
       item->insertEntry();
       }
    else
       {
-      // put it on the free list
-
-      item->alarm = 0;
-      item->next  = pool;
-            pool  = item;
+      item->freeEntry();
       }
 }
 
@@ -128,28 +237,23 @@ void UTimer::run()
 
    (void) U_SYSCALL(gettimeofday, "%p,%p", &UEventTime::timeout1, 0);
 
-   U_INTERNAL_DUMP("UEventTime::timeout1 = { %ld %6ld } first = %p", UEventTime::timeout1.tv_sec, UEventTime::timeout1.tv_usec, first)
+   U_INTERNAL_DUMP("UEventTime::timeout1 = { %ld %6ld } first = %p num_timer = %u", UEventTime::timeout1.tv_sec, UEventTime::timeout1.tv_usec, first, num_timer)
 
-   UTimer* item = first;
    bool bnosignal = (mode == NOSIGNAL);
 
-loop:
-#ifdef DEBUG
-   U_INTERNAL_DUMP("item = %p item->next = %p", item, item->next)
-
-   U_INTERNAL_ASSERT_POINTER(item)
+   while (num_timer)
+      {
+      if (first == 0) advance();
 
-   if (item->next) U_INTERNAL_ASSERT(*item <= *(item->next))
-#endif
+      U_INTERNAL_ASSERT_POINTER(first)
 
-   if (bnosignal ? item->alarm->isExpired()
-                 : item->alarm->isExpiredWithTolerance())
-      {
-      item = item->next;
+      if (bnosignal ? first->alarm->isExpired() == false
+                    : first->alarm->isExpiredWithTolerance() == false)
+         {
+         break;
+         }
 
       callHandlerTimeout();
-
-      if (item) goto loop;
       }
 
    U_INTERNAL_DUMP("first = %p", first)
@@ -186,26 +290,40 @@ void UTimer::erase(UEventTime* a)
 {
    U_TRACE(0, "UTimer::erase(%p)", a)
 
-   U_INTERNAL_ASSERT_POINTER(first)
+   UTimer* item = a->ptimer;
 
-   UTimer* item;
-
-   for (UTimer** ptr = &first; (item = *ptr); ptr = &(*ptr)->next)
+   if (item)
       {
-      if (item->alarm == a)
-         {
-         *ptr = item->next; // remove it from its active list
+      U_INTERNAL_ASSERT_EQUALS(item->alarm, a)
 
-         U_ASSERT(invariant())
+      item->unlink(); // remove it from its list (active or wheel)
 
-         // and we put it on the free list
+      --num_timer;
 
-         item->alarm = 0;
-         item->next  = pool;
-                pool = item;
+      U_ASSERT(invariant())
 
-         break;
-         }
+      item->freeEntry();
+      }
+}
+
+U_NO_EXPORT void UTimer::deleteList(UTimer* item)
+{
+   U_TRACE(0, "UTimer::deleteList(%p)", item)
+
+   // NB: we don't use the recursive destructor because the list can be very long...
+
+   UTimer* item_next;
+
+   for (; item; item = item_next)
+      {
+      item_next = item->next;
+
+      if (item->alarm) item->alarm->ptimer = 0;
+
+      item->next  = 0;
+      item->alarm = 0;
+
+      delete item;
       }
 }
 
@@ -213,7 +331,7 @@ void UTimer::clear()
 {
    U_TRACE_NO_PARAM(1, "UTimer::clear()")
 
-   U_INTERNAL_DUMP("mode = %d first = %p pool = %p", mode, first, pool)
+   U_INTERNAL_DUMP("mode = %d first = %p pool = %p num_timer = %u", mode, first, pool, num_timer)
 
    if (mode != NOSIGNAL)
       {
@@ -223,25 +341,25 @@ void UTimer::clear()
       (void) U_SYSCALL(setitimer, "%d,%p,%p", ITIMER_REAL, &UInterrupt::timerval, 0);
       }
 
-   UTimer* item = first;
-
-   if (first)
-      {
-      do { item->alarm = 0; } while ((item = item->next));
-
-      delete first;
-             first = 0;
-      }
-
-   if (pool)
+   if (num_timer)
       {
-      item = pool;
+      deleteList(first);
+                 first = 0;
 
-      do { item->alarm = 0; } while ((item = item->next));
+      for (uint32_t i = 0; i < U_TIMER_WHEEL_SIZE; ++i)
+         {
+         if (wheel[i])
+            {
+            deleteList(wheel[i]);
+                       wheel[i] = 0;
+            }
+         }
 
-      delete pool;
-             pool = 0;
+      num_timer = 0;
       }
+
+   deleteList(pool);
+              pool = 0;
 }
 
 #ifdef DEBUG
@@ -249,14 +367,27 @@ bool UTimer::invariant()
 {
    U_TRACE_NO_PARAM(0, "UTimer::invariant()")
 
-   if (first)
+   UTimer* item;
+   uint32_t n = 0;
+
+   for (item = first; item; item = item->next, ++n)
       {
-      for (UTimer* item = first; item->next; item = item->next)
+      U_INTERNAL_ASSERT(item->getTick() <= horizon)
+
+      if (item->next) U_INTERNAL_ASSERT(*item <= *(item->next))
+      }
+
+   for (uint32_t i = 0; i < U_TIMER_WHEEL_SIZE; ++i)
+      {
+      for (item = wheel[i]; item; item = item->next, ++n)
          {
-         if (item->next) U_INTERNAL_ASSERT(*item <= *(item->next))
+         U_INTERNAL_ASSERT(item->getTick() > horizon)
+         U_INTERNAL_ASSERT_EQUALS(item->getTick() & U_TIMER_WHEEL_MASK, i)
          }
       }
 
+   U_INTERNAL_ASSERT_EQUALS(n, num_timer)
+
    U_RETURN(true);
 }
 #endif
@@ -298,6 +429,8 @@ void UTimer::printInfo(ostream& os)
    if (first) os << *first;
    else       os << (void*)first;
 
+   os << "\nnum_timer = " << num_timer << " horizon = " << horizon;
+
    os << "\npool  = ";
 
    if (pool) os << *pool;
@@ -315,6 +448,9 @@ const char* UTimer::dump(bool reset) const
                                                                  << " } }\n"
                   << "pool         (UTimer     " << (void*)pool  << ")\n"
                   << "first        (UTimer     " << (void*)first << ")\n"
+                  << "horizon                  " << horizon      << '\n'
+                  << "num_timer                " << num_timer    << '\n'
+                  << "prev         (UTimer     " << (void*)prev  << ")\n"
                   << "next         (UTimer     " << (void*)next  << ")\n"
                   << "alarm        (UEventTime " << (void*)alarm << ")";
 
@@ -21,10 +21,24 @@
 #define HTTP2_HEADER_TABLE_OFFSET 62
 
 int                           UHTTP2::nerror;
+int                           UHTTP2::data_iovcnt;
+char                          UHTTP2::data_frame_header[8*9];
+uint32_t                      UHTTP2::data_iovlen;
+struct iovec                  UHTTP2::data_iov[16];
 bool                          UHTTP2::settings_ack;
 uint32_t                      UHTTP2::hash_static_table[61];
 const char*                   UHTTP2::upgrade_settings;
 UHTTP2::Stream*               UHTTP2::pStream;
+UHTTP2::Stream*               UHTTP2::pool_chunk;
+bool                          UHTTP2::ext_from_cache;
+UHashMap<UString>*            UHTTP2::hpack_cache;
+bool                          UHTTP2::push_enable;
+UHashMap<UString>*            UHTTP2::push_manifest;
+UString*                      UHTTP2::push_list;
+UString*                      UHTTP2::push_frames;
+UVector<UString>*             UHTTP2::push_body;
+UHashMap<UString>*            UHTTP2::push_cache;
+UHTTP2::Stream*               UHTTP2::pool_stream;
 UVector<UString>*             UHTTP2::vext;
 UHTTP2::FrameHeader           UHTTP2::frame;
 UHTTP2::Connection*           UHTTP2::vConnection;
@@ -98,10 +112,14 @@ UHTTP2::Connection::Connection() : itable(53, setIndexStaticTable)
 
    state  = CONN_STATE_IDLE;
 
+   hpack_encoder = 0;
+
    max_open_stream_id      =
    max_processed_stream_id = 0;
 
-   (void) memset(&streams, 0, sizeof(Stream) * 100);
+   (void) memset(&streams, 0, sizeof(Stream) * HTTP2_INLINE_STREAMS);
+
+   for (uint32_t i = 0; i < (HTTP2_INLINE_STREAMS-1); ++i) streams[i].next = streams+i+1;
 }
 
 void UHTTP2::ctor()
@@ -239,6 +257,54 @@ void UHTTP2::ctor()
     hash_static_table[60]       = UString::str_www_authenticate->hash();
 
    vext = U_NEW(UVector<UString>(10));
+
+   hpack_cache = U_NEW(UHashMap<UString>(U_GET_NEXT_PRIME_NUMBER(HTTP2_HPACK_CACHE_MAX)));
+
+   if (push_enable)
+      {
+      push_list   = U_NEW(UString);
+      push_frames = U_NEW(UString(U_CAPACITY));
+      push_body   = U_NEW(UVector<UString>(HTTP2_PUSH_MAX));
+      push_cache  = U_NEW(UHashMap<UString>(U_GET_NEXT_PRIME_NUMBER(HTTP2_PUSH_CACHE_MAX)));
+      }
+}
+
+void UHTTP2::loadPushManifest(const UString& pathname)
+{
+   U_TRACE(0, "UHTTP2::loadPushManifest(%V)", pathname.rep)
+
+   // NB: a line for page, the path of the page followed by the path of the resources to push (ex: /index.html /css/site.css /js/site.js)
+
+   UString page, list, content = UFile::contentOf(pathname);
+   UVector<UString> vline, vword;
+
+   if (push_manifest == 0) push_manifest = U_NEW(UHashMap<UString>);
+
+   for (uint32_t i = 0, n = vline.split(content, '\n'); i < n; ++i)
+      {
+      if (vline[i].first_char() != '#' &&
+          vword.split(vline[i]) > 1)
+         {
+         page = vword[0];
+         list = UString(U_CAPACITY);
+
+         if (page.first_char() == '/') page = page.substr(1U);
+
+         for (uint32_t j = 1, m = vword.size(); j < m; ++j)
+            {
+            if (vword[j].first_char() == '/') (void) list.append(vword[j].data()+1, vword[j].size()-1);
+            else                              (void) list.append(vword[j]);
+
+            list.push_back('\n');
+            }
+
+         push_manifest->insert(page, list);
+         }
+
+      vword.clear();
+      }
+
+   U_SRV_LOG("HTTP2 push: loaded the resources to push for %u pages from %V", push_manifest->size(), pathname.rep);
 }
 
 void UHTTP2::dtor()
@@ -246,7 +312,27 @@ void UHTTP2::dtor()
    U_TRACE_NO_PARAM(0, "UHTTP2::dtor()")
 
    delete   vext;
+   delete   hpack_cache;
+
+   if (push_list)
+      {
+      delete push_list;
+      delete push_frames;
+      delete push_body;
+      delete push_cache;
+      }
+
+   if (push_manifest) delete push_manifest;
    delete[] vConnection;
+
+   while (pool_chunk)
+      {
+      Stream* chunk = pool_chunk;
+
+      pool_chunk = chunk->next;
+
+      UMemoryPool::_free(chunk, HTTP2_POOL_STREAMS, sizeof(Stream));
+      }
 }
 
 bool UHTTP2::updateSetting(unsigned char* ptr, uint32_t len)
@@ -261,11 +347,68 @@ bool UHTTP2::updateSetting(unsigned char* ptr, uint32_t len)
 
       switch (ntohs(*(uint16_t*)ptr))
          {
-         case HEADER_TABLE_SIZE:      pConnection->peer_settings.header_table_size      = value; break;
+         case HEADER_TABLE_SIZE:
+            {
+            pConnection->peer_settings.header_table_size = value;
+
+            if (pConnection->hpack_encoder)
+               {
+               // NB: the change must be signaled at the beginning of the next header block (RFC 7541 4.2)...
+
+               pConnection->hpack_encoder->max_size     = U_min(value, HTTP2_HPACK_MAX_SIZE);
+               pConnection->hpack_encoder->bsize_update = true;
+               }
+            }
+         break;
+
          case ENABLE_PUSH:            pConnection->peer_settings.enable_push            = value; break;
          case MAX_CONCURRENT_STREAMS: pConnection->peer_settings.max_concurrent_streams = value; break;
-         case INITIAL_WINDOW_SIZE:    pConnection->peer_settings.initial_window_size    = value; break;
-         case MAX_FRAME_SIZE:         pConnection->peer_settings.max_frame_size         = value; break;
+         case INITIAL_WINDOW_SIZE:
+            {
+            if (value > 0x7fffffff)
+               {
+               nerror = FLOW_CONTROL_ERROR;
+
+               U_RETURN(false);
+               }
+
+            // NB: a change of SETTINGS_INITIAL_WINDOW_SIZE adjusts the size of the send window of all the streams (6.9.2)...
+
+            int32_t delta = (int32_t)value - (int32_t)pConnection->peer_settings.initial_window_size;
+
+            for (Stream* pStreamTmp = pConnection->streams; pStreamTmp; pStreamTmp = pStreamTmp->next)
+               {
+               if (pStreamTmp->id)
+                  {
+                  if ((int64_t)pStreamTmp->out_window + delta > 0x7fffffff)
+                     {
+                     nerror = FLOW_CONTROL_ERROR;
+
+                     U_RETURN(false);
+                     }
+
+                  pStreamTmp->out_window += delta;
+                  }
+               }
+
+            pConnection->peer_settings.initial_window_size = value;
+            }
+         break;
+
+         case MAX_FRAME_SIZE:
+            {
+            if (value < 16384 ||
+                value > 16777215)
+               {
+               nerror = PROTOCOL_ERROR;
+
+               U_RETURN(false);
+               }
+
+            pConnection->peer_settings.max_frame_size = value;
+            }
+         break;
+
          case MAX_HEADER_LIST_SIZE:   pConnection->peer_settings.max_header_list_size   = value; break;
 
          default: break; // ignore unknown (5.5)
@@ -285,14 +428,16 @@ unsigned char* UHTTP2::hpackEncodeInt(unsigned char* dst, uint32_t value, uint8_
 {
    U_TRACE(0, "UHTTP2::hpackEncodeInt(%p,%u,%u)", dst, value, prefix_max)
 
-   if (value <= prefix_max) *dst++ |= value;
+   if (value < prefix_max) *dst++ |= value;
    else
       {
       value -= prefix_max;
 
       U_INTERNAL_ASSERT(value <= 0x0fffffff)
 
-      for (*dst++ |= prefix_max; value >= 256; value >>= 8) *dst++ = 0x80 | value;
+      // NB: the rest of the value is encoded in groups of 7 bits, the least significant first (RFC 7541 5.1)...
+
+      for (*dst++ |= prefix_max; value >= 128; value >>= 7) *dst++ = 0x80 | (value & 0x7f);
 
       *dst++ = value;
       }
@@ -334,85 +479,188 @@ unsigned char* UHTTP2::hpackEncodeString(unsigned char* dst, const char* src, ui
 {
    U_TRACE(0+256, "UHTTP2::hpackEncodeString(%p,%.*S,%u)", dst, len, src, len)
 
-   U_INTERNAL_ASSERT_MAJOR(len, 0)
+   // NB: we use the huffman encoding only if it is shorter than the string as-is (RFC 7541 5.2), so we compute first its length...
+
+   uint32_t i, nbits = 0;
+
+   for (i = 0; i < len; ++i) nbits += huff_sym_table[(unsigned char)src[i]].nbits;
+
+   uint32_t hlen = (nbits + 7) / 8;
+
+   U_INTERNAL_DUMP("hlen = %u", hlen)
 
-   if (len < 29)
+   if (hlen >= len)
       {
       // encode as-is
 
-asis: *dst = '\0';
+      *dst = '\0';
        dst = hpackEncodeInt(dst, len, (1<<7)-1);
 
-      u__memcpy(dst, src, len, __PRETTY_FUNCTION__);
+      if (len) u__memcpy(dst, src, len, __PRETTY_FUNCTION__);
+
+      return dst+len;
       }
-   else
+
+   *dst = '\x80';
+    dst = hpackEncodeInt(dst, hlen, (1<<7)-1);
+
+   uint64_t bits = 0;
+   int bits_left = 40;
+   const char* src_end = src + len;
+
+#ifdef DEBUG
+   unsigned char* dst_start = dst;
+#endif
+
+   do {
+      const HuffSym* sym = huff_sym_table + *(unsigned char*)src++;
+
+      bits |= (uint64_t)sym->code << (bits_left - sym->nbits);
+
+      bits_left -= sym->nbits;
+
+      while (bits_left <= 32)
+         {
+         *dst++ = bits >> 32;
+
+         bits <<= 8;
+         bits_left += 8;
+         }
+      }
+   while (src < src_end);
+
+   if (bits_left != 40) // NB: the padding is the most significant bits of the EOS symbol (all ones)...
       {
-      uint64_t bits = 0;
-      int bits_left = 40;
-      const char* src_end = src + len;
+      bits |= (1UL << bits_left) - 1;
 
-      UString buffer(len + 1024U);
+      *dst++ = bits >> 32;
+      }
 
-      unsigned char* _dst       = (unsigned char*)buffer.data();
-      unsigned char* _dst_end   = _dst + len;
-      unsigned char* _dst_start = _dst;
+   U_INTERNAL_ASSERT_EQUALS((uint32_t)(dst-dst_start), hlen)
 
-      // try to encode in huffman
+   return dst;
+}
 
-      do {
-         const HuffSym* sym = huff_sym_table + *(unsigned char*)src++;
+unsigned char* UHTTP2::hpackEncodeSizeUpdate(unsigned char* dst)
+{
+   U_TRACE(0, "UHTTP2::hpackEncodeSizeUpdate(%p)", dst)
 
-      // U_INTERNAL_DUMP("sym->nbits = %u sym->code = %u bits_left = %d", sym->nbits, sym->code, bits_left)
+   U_INTERNAL_ASSERT_POINTER(pConnection)
 
-         bits |= (uint64_t)sym->code << (bits_left - sym->nbits);
+   HpackDynamicTable* table = pConnection->hpack_encoder;
 
-         bits_left -= sym->nbits;
+   if (table == 0)
+      {
+      pConnection->hpack_encoder = table = new HpackDynamicTable;
 
-      // U_INTERNAL_DUMP("bits = %llu bits_left = %d", bits, bits_left)
+      table->num_entries  =
+      table->entry_start  =
+      table->size         = 0;
+      table->max_size     = U_min(pConnection->peer_settings.header_table_size, HTTP2_HPACK_MAX_SIZE);
+      table->bsize_update = (table->max_size < 4096); // NB: 4096 is the initial size of the table for the decoder of the peer...
+      }
 
-         while (bits_left <= 32)
-            {
-            *_dst++ = bits >> 32;
+   U_INTERNAL_DUMP("table->max_size = %u table->bsize_update = %b", table->max_size, table->bsize_update)
 
-         // U_INTERNAL_DUMP("_dst = %u bits >> 32 = %u", _dst[-1], bits >> 32)
+   if (table->bsize_update)
+      {
+      table->bsize_update = false;
+
+      while (table->size > table->max_size)
+         {
+         uint32_t pos = (table->entry_start + --table->num_entries) % HTTP2_HPACK_ENTRIES;
 
-            bits <<= 8;
-            bits_left += 8;
+         table->size -= 32 + table->name[pos].size() + table->value[pos].size();
 
-            U_INTERNAL_ASSERT_MINOR(_dst, _dst_end)
-            }
+         table->name[pos].clear();
+         table->value[pos].clear();
          }
-      while (src < src_end);
 
-   // U_INTERNAL_DUMP("bits = %llu bits_left = %d", bits, bits_left)
+      *dst = 0x20;
+       dst = hpackEncodeInt(dst, table->max_size, (1<<5)-1);
+      }
+
+   return dst;
+}
+
+unsigned char* UHTTP2::hpackEncodeHeader(unsigned char* dst, uint32_t index, const char* name, uint32_t name_len, const char* value, uint32_t value_len, bool bindex)
+{
+   U_TRACE(0, "UHTTP2::hpackEncodeHeader(%p,%u,%.*S,%u,%.*S,%u,%b)", dst, index, name_len, name, name_len, value_len, value, value_len, bindex)
+
+   U_INTERNAL_ASSERT_POINTER(pConnection)
+
+   HpackDynamicTable* table = pConnection->hpack_encoder;
+
+   if (bindex &&
+       table)
+      {
+      uint32_t i, pos, esize, name_index = 0;
 
-      if (bits_left != 40)
+      for (i = 0; i < table->num_entries; ++i)
          {
-         bits |= (1UL << bits_left) - 1;
+         pos = (table->entry_start + i) % HTTP2_HPACK_ENTRIES;
+
+         if (table->name[pos].equal(name, name_len))
+            {
+            if (table->value[pos].equal(value, value_len)) // indexed header field representation
+               {
+               *dst = 0x80;
 
-         *_dst++ = bits >> 32;
+               return hpackEncodeInt(dst, HTTP2_HEADER_TABLE_OFFSET + i, (1<<7)-1);
+               }
 
-      // U_INTERNAL_DUMP("_dst = %u bits >> 32 = %u", _dst[-1], bits >> 32)
+            if (name_index == 0) name_index = HTTP2_HEADER_TABLE_OFFSET + i;
+            }
          }
 
-#  ifdef DEBUG
-      int32_t u_printf_string_max_length_save = u_printf_string_max_length;
-                                                u_printf_string_max_length = buffer.distance((const char*)_dst) * 3;
+      if (index == 0) index = name_index;
 
-      U_INTERNAL_DUMP("_dst_end = %p _dst = %p %#.*S", _dst_end, _dst, buffer.distance((const char*)_dst), _dst_start)
+      esize = 32 + name_len + value_len;
 
-      u_printf_string_max_length = u_printf_string_max_length_save;
-#  endif
+      U_INTERNAL_DUMP("esize = %u table->size = %u table->max_size = %u table->num_entries = %u", esize, table->size, table->max_size, table->num_entries)
+
+      if (esize <= table->max_size &&
+          (table->num_entries < HTTP2_HPACK_ENTRIES ||
+           table->size + esize > table->max_size))
+         {
+         // literal header field with incremental indexing: we evict the oldest entries as the decoder of the peer will do (RFC 7541 4.4)...
+
+         while (table->size + esize > table->max_size)
+            {
+            pos = (table->entry_start + --table->num_entries) % HTTP2_HPACK_ENTRIES;
+
+            table->size -= 32 + table->name[pos].size() + table->value[pos].size();
+
+            table->name[pos].clear();
+            table->value[pos].clear();
+            }
+
+         pos = table->entry_start = (table->entry_start + HTTP2_HPACK_ENTRIES - 1) % HTTP2_HPACK_ENTRIES;
+
+         (void) table->name[pos].replace(name, name_len);
+         (void) table->value[pos].replace(value, value_len);
+
+         table->size += esize;
 
-      if (_dst > _dst_end) goto asis; // encode as-is
+         ++table->num_entries;
 
-      *dst = '\x80';
-       dst = hpackEncodeInt(dst, (len = _dst-_dst_start), (1<<7)-1);
+         *dst = 0x40;
+
+         if (index) dst = hpackEncodeInt(     dst, index, (1<<6)-1);
+         else       dst = hpackEncodeString(++dst, name, name_len);
 
-      u__memcpy(dst, _dst_start, len, __PRETTY_FUNCTION__);
+         return hpackEncodeString(dst, value, value_len);
+         }
       }
 
-   return dst+len;
+   // literal header field without indexing
+
+   *dst = 0x00;
+
+   if (index) dst = hpackEncodeInt(     dst, index, (1<<4)-1);
+   else       dst = hpackEncodeString(++dst, name, name_len);
+
+   return hpackEncodeString(dst, value, value_len);
 }
 
 unsigned char* UHTTP2::hpackDecodeString(unsigned char* src, unsigned char* src_end, UString* pvalue)
@@ -484,6 +732,11 @@ void UHTTP2::decodeHeaders(unsigned char* ptr, unsigned char* endptr)
    bool value_is_indexed, continue100 = false;
    UHashMap<UString>* ptable = &(pConnection->itable);
 
+   (void) U_SYSCALL(memset, "%p,%d,%u", UHTTP::accept_encoding, 0, sizeof(UHTTP::accept_encoding));
+
+   U_http_info.if_match_len      =
+   U_http_info.if_none_match_len = 0;
+
    while (ptr < endptr)
       {
       value_is_indexed = ((c = *ptr) >= 128);
@@ -539,6 +792,8 @@ void UHTTP2::decodeHeaders(unsigned char* ptr, unsigned char* endptr)
 
                if (value)
                   {
+                  if (name.equal(U_CONSTANT_TO_PARAM("priority"))) setPriority(pStream, U_STRING_TO_PARAM(value)); // RFC 9218 5
+
                   // add the decoded header to the header table
 
                   ptable->hash = name.hash();
@@ -597,9 +852,9 @@ error:   nerror = COMPRESSION_ERROR;
          0,/* 36 expires */
          0,/* 37 from */
          (int)((char*)&&case_38-(char*)&&cdefault), /* 38 host */
-         0,/* 39 if-match */
+         (int)((char*)&&case_39-(char*)&&cdefault), /* 39 if-match */
          (int)((char*)&&case_40-(char*)&&cdefault), /* 40 if-modified-since */
-         0,/* 41 if-none-match */
+         (int)((char*)&&case_41-(char*)&&cdefault), /* 41 if-none-match */
          0,/* 42 if-range */
          0,/* 43 if-unmodified-since */
          0,/* 44 last-modified */
@@ -757,13 +1012,15 @@ case_16: // accept-encoding: gzip, deflate
 
       name = *UString::str_accept_encoding;
 
-      U_INTERNAL_ASSERT(value_is_indexed)
-
-      value = *UString::str_accept_encoding_value;
+      if (value_is_indexed) value = *UString::str_accept_encoding_value;
+      else
+         {
+         ptr = hpackDecodeString(ptr, endptr, &value); // ex: gzip, deflate, br, zstd
 
-      U_http_is_accept_gzip = '1';
+         if (value.empty()) goto error;
+         }
 
-      U_INTERNAL_DUMP("U_http_is_accept_gzip = %C", U_http_is_accept_gzip)
+      UHTTP::setAcceptEncoding(U_STRING_TO_PARAM(value));
 
       ptable->hash = hash_static_table[15]; // accept_encoding
 
@@ -890,6 +1147,25 @@ case_35: // expect
 
       continue;
 
+case_39: // if-match
+
+      name = *UString::str_if_match;
+
+      U_INTERNAL_ASSERT_EQUALS(value_is_indexed, false)
+
+      ptr = hpackDecodeString(ptr, endptr, &value);
+
+      if (value.empty()) goto error;
+
+      U_http_info.if_match     = value.data();
+      U_http_info.if_match_len = U_min(value.size(), 0xffff);
+
+      U_INTERNAL_DUMP("If-Match = %.*S", U_http_info.if_match_len, U_http_info.if_match)
+
+      ptable->hash = hash_static_table[38]; // if_match
+
+      goto insert;
+
 case_40: // if-modified-since
 
       name = *UString::str_if_modified_since;
@@ -908,6 +1184,25 @@ case_40: // if-modified-since
 
       goto insert;
 
+case_41: // if-none-match
+
+      name = *UString::str_if_none_match;
+
+      U_INTERNAL_ASSERT_EQUALS(value_is_indexed, false)
+
+      ptr = hpackDecodeString(ptr, endptr, &value);
+
+      if (value.empty()) goto error;
+
+      U_http_info.if_none_match     = value.data();
+      U_http_info.if_none_match_len = U_min(value.size(), 0xffff);
+
+      U_INTERNAL_DUMP("If-None-Match = %.*S", U_http_info.if_none_match_len, U_http_info.if_none_match)
+
+      ptable->hash = hash_static_table[40]; // if_none_match
+
+      goto insert;
+
 case_50: // range 
 
       name = *UString::str_range;
@@ -1033,18 +1328,124 @@ insert:
       }
 }
 
-void UHTTP2::openStream()
+UHTTP2::Stream* UHTTP2::allocStream()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::allocStream()")
+
+   U_INTERNAL_ASSERT_POINTER(pConnection)
+
+   if (pool_stream == 0)
+      {
+      // NB: the first stream of the chunk is not used, it links the chunks allocated (to be freed by dtor())...
+
+      Stream* chunk = (Stream*) UMemoryPool::_malloc(HTTP2_POOL_STREAMS, sizeof(Stream), true);
+
+      chunk->next = pool_chunk;
+                    pool_chunk = chunk;
+
+      for (uint32_t i = 1; i < HTTP2_POOL_STREAMS; ++i)
+         {
+         chunk[i].next = pool_stream;
+                         pool_stream = chunk+i;
+         }
+      }
+
+   Stream* pStreamLast = pConnection->streams + (HTTP2_INLINE_STREAMS-1);
+   Stream* pStreamNew  = pool_stream;
+
+   pool_stream = pStreamNew->next;
+
+   pStreamNew->next  = pStreamLast->next;
+   pStreamLast->next = pStreamNew;
+
+   U_RETURN_POINTER(pStreamNew, Stream);
+}
+
+void UHTTP2::releaseStreams()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::releaseStreams()")
+
+   U_INTERNAL_ASSERT_POINTER(pConnection)
+
+   Stream* pStreamTmp  = pConnection->streams;
+   Stream* pStreamLast = pStreamTmp + (HTTP2_INLINE_STREAMS-1);
+
+   for (; pStreamTmp <= pStreamLast; ++pStreamTmp)
+      {
+      pStreamTmp->id       =
+      pStreamTmp->state    = 0;
+      pStreamTmp->data_len =
+      pStreamTmp->count    = 0;
+      pStreamTmp->bpart    = false;
+      }
+
+   // NB: the streams taken from the pool come back to the free list...
+
+   while ((pStreamTmp = pStreamLast->next))
+      {
+      pStreamLast->next = pStreamTmp->next;
+
+      pStreamTmp->id       =
+      pStreamTmp->state    = 0;
+      pStreamTmp->data_len =
+      pStreamTmp->count    = 0;
+      pStreamTmp->bpart    = false;
+
+      pStreamTmp->next = pool_stream;
+                         pool_stream = pStreamTmp;
+      }
+}
+
+bool UHTTP2::openStream()
 {
    U_TRACE_NO_PARAM(0, "UHTTP2::openStream()")
 
-   U_INTERNAL_ASSERT_POINTER(pStream)
+   U_INTERNAL_ASSERT_POINTER(pConnection)
    U_INTERNAL_ASSERT(pConnection->max_open_stream_id <= frame.stream_id)
 
-//     pStream->out_window =
-// pConnection->out_window =                   settings.initial_window_size; //   sender flow control window
+   // NB: we reuse a stream of the connection that is idle (or closed with nothing to send), otherwise we take one from the pool...
+
+   uint32_t nopen = 0;
+   Stream* pStreamFree = 0;
+
+   for (Stream* pStreamTmp = pConnection->streams; pStreamTmp; pStreamTmp = pStreamTmp->next)
+      {
+      if (pStreamTmp->state == STREAM_STATE_OPEN ||
+          pStreamTmp->state == STREAM_STATE_HALF_CLOSED)
+         {
+         ++nopen;
+         }
+      else if (pStreamFree == 0         &&
+               pStreamTmp->data_len == 0 &&
+               pStreamTmp->count    == 0)
+         {
+         pStreamFree = pStreamTmp;
+         }
+      }
+
+   U_INTERNAL_DUMP("nopen = %u pStreamFree = %p", nopen, pStreamFree)
+
+   if (nopen >= settings.max_concurrent_streams)
+      {
+      nerror = REFUSED_STREAM;
+
+      U_RETURN(false);
+      }
+
+   pStream = (pStreamFree ? pStreamFree : allocStream());
+
+       pStream->out_window = pConnection->peer_settings.initial_window_size; //   sender flow control window
 //     pStream->inp_window =
    pConnection->inp_window = pConnection->peer_settings.initial_window_size; // receiver flow control window
 
+   pStream->data_len =
+   pStream->count    = 0;
+   pStream->bpart    = false;
+
+   pStream->urgency         = HTTP2_DEFAULT_URGENCY;
+   pStream->incremental     = false;
+   pStream->priority_signal = PRIORITY_NONE;
+
    pStream->id                     =
    pConnection->max_open_stream_id = frame.stream_id;
 
@@ -1053,6 +1454,8 @@ void UHTTP2::openStream()
    pStream->state = ((frame.flags & FLAG_END_STREAM) != 0 ? STREAM_STATE_HALF_CLOSED : STREAM_STATE_OPEN);
 
    U_INTERNAL_DUMP("pStream->id = %d pStream->state = %d", pStream->id, pStream->state)
+
+   U_RETURN(true);
 }
 
 void UHTTP2::readFrame()
@@ -1080,7 +1483,10 @@ loop:
          {
          U_DEBUG("HTTP2 upgrade: User-Agent = %.*S", U_HTTP_USER_AGENT_TO_TRACE);
 
-         openStream();
+         // NB: the stream 1 is already open (the request is the HTTP/1.1 one sent prior to upgrade)...
+
+         pConnection->inp_window         = pConnection->peer_settings.initial_window_size;
+         pConnection->hpack_max_capacity = settings.header_table_size;
 
          return;
          }
@@ -1102,8 +1508,11 @@ loop:
 
    U_INTERNAL_DUMP("ptr = %#.4S", ptr) // "\000\000\f\004" (big endian: 0x11223344)
 
+   frame.type = ptr[3];
+
 #ifdef DEBUG
-   if ((frame.type = ptr[3]) > CONTINUATION)
+   if (frame.type > CONTINUATION &&
+       frame.type != PRIORITY_UPDATE)
       {
       nerror = PROTOCOL_ERROR;
 
@@ -1150,22 +1559,7 @@ loop:
 
    if (frame.type == WINDOW_UPDATE)
       {
-      uint32_t window_size_increment = ntohl(*(uint32_t*)frame.payload) & 0x7fffffff;
-
-      U_INTERNAL_DUMP("window_size_increment = %u", window_size_increment)
-
-#  ifdef DEBUG
-      if (frame.length != 4 ||
-          window_size_increment == 0)
-         {
-         nerror = PROTOCOL_ERROR;
-
-         goto err;
-         }
-#  endif
-
-   // if (frame.stream_id)     pStream->out_window += window_size_increment;
-   // else                 pConnection->out_window += window_size_increment;
+      if (updateWindow() == false) goto err;
 
       goto loop;
       }
@@ -1194,7 +1588,7 @@ loop:
             if (updateSetting(frame.payload, frame.length) == false ||
                 USocketExt::write(UServer_Base::csocket, U_CONSTANT_TO_PARAM(HTTP2_SETTINGS_ACK), UServer_Base::timeoutMS) != U_CONSTANT_SIZE(HTTP2_SETTINGS_ACK))
                {
-               nerror = PROTOCOL_ERROR;
+               if (nerror == NO_ERROR) nerror = PROTOCOL_ERROR;
 
                goto err;
                }
@@ -1202,19 +1596,34 @@ loop:
 
          goto loop;
          }
+
+      if (frame.type == PRIORITY_UPDATE)
+         {
+         updatePriority();
+
+         goto loop;
+         }
       }
    else
       {
       if (frame.type == PRIORITY)
          {
-         // TODO
+         Stream* pStreamTmp;
+
+         // NB: the dependency and the exclusive flag are ignored (RFC 9113 5.3.2), only the weight is used as hint for the urgency...
+
+         if (frame.length == 5 &&
+             (pStreamTmp = findStream(frame.stream_id)))
+            {
+            setPriority(pStreamTmp, (uint32_t)frame.payload[4] + 1);
+            }
 
          goto loop;
          }
 
       if (frame.type == HEADERS)
          {
-         openStream();
+         if (openStream() == false) goto err;
 
          manageHeaders();
 
@@ -1229,12 +1638,14 @@ loop:
          {
          U_INTERNAL_DUMP("pConnection->max_open_stream_id = %d", pConnection->max_open_stream_id)
 
-         if (frame.stream_id <= pConnection->max_open_stream_id)
+         Stream* pStreamTmp;
+
+         if (frame.stream_id <= pConnection->max_open_stream_id &&
+             (pStreamTmp = findStream(frame.stream_id)))
             {
-            for (Stream* pStreamEnd = (pStream = pConnection->streams) + 100; pStream < pStreamEnd; ++pStream)
-               {
-               if (pStream->id == frame.stream_id) goto next;
-               }
+            pStream = pStreamTmp;
+
+            goto next;
             }
 
          nerror = FLOW_CONTROL_ERROR;
@@ -1300,13 +1711,7 @@ void UHTTP2::manageHeaders()
       endptr -= padlen;
       }
 
-   if ((frame.flags & FLAG_PRIORITY) == 0)
-      {
-   // pStream->priority_exclusive  = false;
-   // pStream->priority_dependency = 0;
-   // pStream->priority_weight     = 0;
-      }
-   else
+   if ((frame.flags & FLAG_PRIORITY) != 0)
       {
 #  ifdef DEBUG
       if ((frame.length - padlen) < 5)
@@ -1317,12 +1722,11 @@ void UHTTP2::manageHeaders()
          }
 #  endif
 
-   // uint32_t u4 = ntohl(*(uint32_t*)ptr);
-                                      ptr += 4;
+      // NB: the stream dependency and the exclusive flag are ignored (RFC 9113 5.3.2)...
+
+      ptr += 4;
 
-   // pStream->priority_exclusive  = (u4 >> 31) != 0;
-   // pStream->priority_dependency =  u4 & 0x7fffffff;
-   // pStream->priority_weight     = (uint16_t)*ptr++ + 1;
+      setPriority(pStream, (uint32_t)*ptr++ + 1);
       }
 
    if ((frame.flags & FLAG_END_HEADERS) != 0) decodeHeaders(ptr, endptr); // parse header block fragment
@@ -1491,27 +1895,186 @@ void UHTTP2::sendError()
       }
 }
 
-void UHTTP2::handlerResponse()
+unsigned char* UHTTP2::hpackEncodeHeaders(unsigned char* dst, const UString& ext, bool bindex)
 {
-   U_TRACE_NO_PARAM(0, "UHTTP2::handlerResponse()")
+   U_TRACE(0, "UHTTP2::hpackEncodeHeaders(%p,%V,%b)", dst, ext.rep, bindex)
 
-   U_INTERNAL_DUMP("ext(%u) = %#V", UHTTP::ext->size(), UHTTP::ext->rep)
+   char name[128];
+   const char* keyp;
+   UString key, value, row;
+   uint32_t pos, index, name_len;
+   bool bindex_header; // NB: the headers with a value that changes from a response to another are not inserted in the dynamic table...
 
-   uint32_t sz  = HTTP2_FRAME_HEADER_SIZE+1,
-            sz1 = UHTTP::set_cookie->size(),
+   for (uint32_t i = 0, n = vext->split(ext, U_CRLF); i < n; ++i)
+      {
+      row = (*vext)[i];
+      pos = row.find_first_of(':');
+
+      key   = row.substr(0U, pos);
+      value = row.substr(pos+2);
+
+      U_INTERNAL_DUMP("key(%u) = %#V", key.size(), key.rep)
+      U_INTERNAL_DUMP("value(%u) = %#V", value.size(), value.rep)
+
+      U_INTERNAL_ASSERT_EQUALS(u_isBinary((unsigned char*)U_STRING_TO_PARAM(value)), false)
+
+      bindex_header = bindex;
+
+      index = U_NOT_FOUND;
+       keyp = key.data();
+
+      switch (u_get_unalignedp32(keyp))
+         {
+         case U_MULTICHAR_CONSTANT32('C','o','n','t'):
+            {
+            keyp += 7;
+
+            switch (u_get_unalignedp32(keyp))
+               {
+               case U_MULTICHAR_CONSTANT32('-','D','i','s'): index = 25; bindex_header = false; break; // content-disposition
+               case U_MULTICHAR_CONSTANT32('-','E','n','c'): index = 26; break; // content-encoding
+               case U_MULTICHAR_CONSTANT32('-','L','a','n'): index = 27; break; // content-language
+               case U_MULTICHAR_CONSTANT32('-','L','o','c'): index = 29; bindex_header = false; break; // content-location
+               case U_MULTICHAR_CONSTANT32('-','R','a','n'): index = 30; bindex_header = false; break; // content-range
+               case U_MULTICHAR_CONSTANT32('-','T','y','p'): index = 31; break; // content-type 
+
+               default:
+                  {
+                  U_INTERNAL_ASSERT_EQUALS(key, U_STRING_FROM_CONSTANT("Content-Length"))
+
+                  continue;
+                  }
+               }
+            }
+         break;
+
+         case U_MULTICHAR_CONSTANT32('A','c','c','e'):
+            {
+            keyp += 6;
+
+            if (u_get_unalignedp32(keyp) == U_MULTICHAR_CONSTANT32('-','R','a','n')) index = 18; // accept-ranges
+            else
+               {
+               U_INTERNAL_ASSERT_EQUALS(key, U_STRING_FROM_CONSTANT("Access-Control-Allow-Origin"))
+
+               index = 20; // access-control-allow-origin
+               }
+            }
+         break;
+
+         case U_MULTICHAR_CONSTANT32('C','a','c','h'): index = 24; break; // cache-control
+         case U_MULTICHAR_CONSTANT32('E','t','a','g'): index = 34; bindex_header = false; break; // etag
+         case U_MULTICHAR_CONSTANT32('E','x','p','i'): index = 36; bindex_header = false; break; // expires
+         case U_MULTICHAR_CONSTANT32('L','a','s','t'): index = 44; bindex_header = false; break; // last-modified
+         case U_MULTICHAR_CONSTANT32('L','i','n','k'): index = 45; break; // link
+         case U_MULTICHAR_CONSTANT32('L','o','c','a'): index = 46; bindex_header = false; break; // location
+         case U_MULTICHAR_CONSTANT32('P','r','o','x'): index = 48; bindex_header = false; break; // proxy-authenticate
+         case U_MULTICHAR_CONSTANT32('R','e','f','r'): index = 52; bindex_header = false; break; // refresh
+         case U_MULTICHAR_CONSTANT32('R','e','t','r'): index = 53; bindex_header = false; break; // retry-after
+         case U_MULTICHAR_CONSTANT32('S','t','r','i'): index = 56; break; // strict-transport-security
+         case U_MULTICHAR_CONSTANT32('V','a','r','y'): index = 59; break; // vary 
+         case U_MULTICHAR_CONSTANT32('W','W','W','-'): index = 61; bindex_header = false; break; // www-authenticate 
+
+         default:
+            {
+                 if (key.equalnocase(U_CONSTANT_TO_PARAM("Via"))) index = 60; // via
+            else if (key.equalnocase(U_CONSTANT_TO_PARAM("Age"))) { index = 21; bindex_header = false; } // age
+            }
+         break;
+         }
+
+      if (index != U_NOT_FOUND)
+         {
+         keyp     = hpack_static_table[index-1].name->data();
+         name_len = hpack_static_table[index-1].name->size();
+         }
+      else
+         {
+         // NB: with HTTP/2 the names of the headers must be lowercase (RFC 7540 8.1.2)...
+
+         index    = 0;
+         keyp     = name;
+         name_len = key.size();
+
+         if (name_len > sizeof(name)) continue;
+
+         for (uint32_t j = 0; j < name_len; ++j) name[j] = u__tolower(key.c_char(j));
+         }
+
+      dst = hpackEncodeHeader(dst, index, keyp, name_len, U_STRING_TO_PARAM(value), bindex_header);
+      }
+
+   vext->clear();
+
+   return dst;
+}
+
+unsigned char* UHTTP2::hpackEncodeHeadersFromCache(unsigned char* dst, const UString& ext)
+{
+   U_TRACE(0, "UHTTP2::hpackEncodeHeadersFromCache(%p,%V)", dst, ext.rep)
+
+   // NB: the header block of an entry of the file cache is encoded only once, without reference to the dynamic table, so that it can be used by any connection...
+
+   UString block = (*hpack_cache)[ext.rep];
+
+   U_INTERNAL_DUMP("block(%u) = %#V", block.size(), block.rep)
+
+   if (block)
+      {
+      u__memcpy(dst, block.data(), block.size(), __PRETTY_FUNCTION__);
+
+      return dst + block.size();
+      }
+
+   unsigned char* start = dst;
+
+   dst = hpackEncodeHeaders(dst, ext, false);
+
+   if (hpack_cache->size() >= HTTP2_HPACK_CACHE_MAX) hpack_cache->clear();
+
+   hpack_cache->insert(ext, UString((const char*)start, dst-start));
+
+   return dst;
+}
+
+void UHTTP2::handlerResponse()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::handlerResponse()")
+
+   U_INTERNAL_DUMP("ext(%u) = %#V", UHTTP::ext->size(), UHTTP::ext->rep)
+
+   bool bcache = ext_from_cache;
+                 ext_from_cache = false;
+
+   if (bcache)
+      {
+      if (pStream->priority_signal == PRIORITY_NONE) setPriority(pStream, UHTTP::file_data->mime_index);
+
+      if (push_enable                                 &&
+          U_http_method_type == HTTP_GET             &&
+          U_http_info.nResponseCode == HTTP_OK       &&
+          u_is_html(UHTTP::file_data->mime_index)    &&
+          pConnection->peer_settings.enable_push)
+         {
+         checkPush(); // NB: it can add a cookie to the response (so before we look at set_cookie)...
+         }
+      }
+
+   uint32_t sz,
+            sz1 = UHTTP::set_cookie->size(),
             sz2 = UHTTP::ext->size();
 
    UClientImage_Base::wbuffer->setBuffer(200U + sz1 + sz2);
 
             char* ptr = UClientImage_Base::wbuffer->data();
-   unsigned char* dst = (unsigned char*)ptr+HTTP2_FRAME_HEADER_SIZE+1;
+   unsigned char* dst = hpackEncodeSizeUpdate((unsigned char*)ptr+HTTP2_FRAME_HEADER_SIZE);
 
    if (U_http_info.nResponseCode == HTTP_NOT_IMPLEMENTED ||
        U_http_info.nResponseCode == HTTP_OPTIONS_RESPONSE)
       {
       UClientImage_Base::setCloseConnection();
 
-      ptr[HTTP2_FRAME_HEADER_SIZE] = 0x80 | 8;
+      *dst++ = 0x80 | 8;
 
       *dst = 0x40;
        dst = hpackEncodeInt(dst, 22, (1<<6)-1);
@@ -1523,55 +2086,49 @@ void UHTTP2::handlerResponse()
                                    "MERGE, REPORT, CHECKOUT, MKACTIVITY, "       // subversion
                                    "NOTIFY, MSEARCH, SUBSCRIBE, UNSUBSCRIBE"));  // upnp
      
-      U_INTERNAL_DUMP("allow(%u) = %#169S", dst-(unsigned char*)ptr-HTTP2_FRAME_HEADER_SIZE+1, ptr+HTTP2_FRAME_HEADER_SIZE+1)
+      U_INTERNAL_DUMP("allow(%u) = %#169S", dst-(unsigned char*)ptr-HTTP2_FRAME_HEADER_SIZE, ptr+HTTP2_FRAME_HEADER_SIZE)
       }
    else
       {
       if (sz2 == 0 &&
           U_http_info.nResponseCode == HTTP_OK)
          {
-         ptr[HTTP2_FRAME_HEADER_SIZE] = 0x80 | 9; // HTTP_NO_CONTENT
+         *dst++ = 0x80 | 9; // HTTP_NO_CONTENT
          }
       else
          {
          switch (U_http_info.nResponseCode)
             {
-            case HTTP_OK:             ptr[HTTP2_FRAME_HEADER_SIZE] = 0x80 |  8; break;
-            case HTTP_NO_CONTENT:     ptr[HTTP2_FRAME_HEADER_SIZE] = 0x80 |  9; break;
-            case HTTP_PARTIAL:        ptr[HTTP2_FRAME_HEADER_SIZE] = 0x80 | 10; break;
-            case HTTP_NOT_MODIFIED:   ptr[HTTP2_FRAME_HEADER_SIZE] = 0x80 | 11; break;
-            case HTTP_BAD_REQUEST:    ptr[HTTP2_FRAME_HEADER_SIZE] = 0x80 | 12; break;
-            case HTTP_NOT_FOUND:      ptr[HTTP2_FRAME_HEADER_SIZE] = 0x80 | 13; break;
-            case HTTP_INTERNAL_ERROR: ptr[HTTP2_FRAME_HEADER_SIZE] = 0x80 | 14; break;
+            case HTTP_OK:             *dst++ = 0x80 |  8; break;
+            case HTTP_NO_CONTENT:     *dst++ = 0x80 |  9; break;
+            case HTTP_PARTIAL:        *dst++ = 0x80 | 10; break;
+            case HTTP_NOT_MODIFIED:   *dst++ = 0x80 | 11; break;
+            case HTTP_BAD_REQUEST:    *dst++ = 0x80 | 12; break;
+            case HTTP_NOT_FOUND:      *dst++ = 0x80 | 13; break;
+            case HTTP_INTERNAL_ERROR: *dst++ = 0x80 | 14; break;
 
             default: // use literal header field without indexing - indexed name
                {
-               u_put_unalignedp32(ptr+HTTP2_FRAME_HEADER_SIZE,  U_MULTICHAR_CONSTANT32('\010','\003','0'+(U_http_info.nResponseCode / 100),'\0'));
-                      U_NUM2STR16(ptr+HTTP2_FRAME_HEADER_SIZE+3,                                          U_http_info.nResponseCode % 100);
+               u_put_unalignedp32(dst,  U_MULTICHAR_CONSTANT32('\010','\003','0'+(U_http_info.nResponseCode / 100),'\0'));
+                      U_NUM2STR16(dst+3,                                          U_http_info.nResponseCode % 100);
 
-                sz += 4;
-               dst += 4;
+               dst += 5;
                }
             }
          }
       }
 
    /**
-    * -------------------------------------------------
-    * literal header field with indexing (indexed name)
-    * -------------------------------------------------
-    * server: ULib
-    * date: Wed, 20 Jun 2012 11:43:17 GMT
-    * -------------------------------------------------
-    * *dst = 0x40;
-    *  dst = hpackEncodeInt(dst, 54, (1<<6)-1);
-    *  dst = hpackEncodeString(dst, U_CONSTANT_TO_PARAM("ULib"));
-    * *dst = 0x40;
-    *  dst = hpackEncodeInt(dst, 33, (1<<6)-1);
-    * -------------------------------------------------
+    * ----------------------------------------------------------
+    * server: ULib (literal header field with incremental indexing, so the next responses of the connection use only one byte)
+    * date: Wed, 20 Jun 2012 11:43:17 GMT (literal header field without indexing - indexed name)
+    * ----------------------------------------------------------
+    * *dst = 0x00;
+    *  dst = hpackEncodeInt(dst, 33, (1<<4)-1);
+    * ----------------------------------------------------------
     */
 
-   u_put_unalignedp64(dst, U_MULTICHAR_CONSTANT64('v','\004','U','L','i','b','a','\0'));
+   dst = hpackEncodeHeader(dst, 54, U_CONSTANT_TO_PARAM("server"), U_CONSTANT_TO_PARAM("ULib"), true);
 
 #if defined(U_LINUX) && defined(ENABLE_THREAD) && !defined(U_LOG_ENABLE) && !defined(USE_LIBZ)
    U_INTERNAL_ASSERT_POINTER(u_pthread_time)
@@ -1582,127 +2139,63 @@ void UHTTP2::handlerResponse()
    ULog::updateDate3();
 #endif
 
-   dst = hpackEncodeString(dst+7, ((char*)UClientImage_Base::iov_vec[1].iov_base)+6, 29); // Date: Wed, 20 Jun 2012 11:43:17 GMT\r\nServer: ULib\r\nConnection: close\r\n
+   u_put_unalignedp16(dst, U_MULTICHAR_CONSTANT16('\017','\022'));
+
+   dst = hpackEncodeString(dst+2, ((char*)UClientImage_Base::iov_vec[1].iov_base)+6, 29); // Date: Wed, 20 Jun 2012 11:43:17 GMT\r\nServer: ULib\r\nConnection: close\r\n
 
    if (sz1)
       {
       UClientImage_Base::setRequestNoCache();
 
-     *dst = 0x40;
-      dst = hpackEncodeInt(dst, 55, (1<<6)-1);
-      dst = hpackEncodeString(dst, UHTTP::set_cookie->data(), sz1);
-
-      UHTTP::set_cookie->setEmpty();
-      }
+      // NB: set_cookie has the format of HTTP/1.1 (one or more "Set-Cookie: ...\r\n"), we send a header field for each cookie as literal never indexed (the value can be sensitive)...
 
-   if (sz2)
-      {
-      const char* keyp;
-      uint32_t pos, index;
-      UString key, value, row;
+      const char* ptr1 = UHTTP::set_cookie->data();
+      const char* end1 = ptr1 + sz1;
+      const char* ptr2;
 
-      for (uint32_t i = 0, n = vext->split(*UHTTP::ext, U_CRLF); i < n; ++i)
+      while (ptr1 < end1)
          {
-         row = (*vext)[i];
-         pos = row.find_first_of(':');
-
-         key   = row.substr(0U, pos);
-         value = row.substr(pos+2);
-
-         U_INTERNAL_DUMP("key(%u) = %#V", key.size(), key.rep)
-         U_INTERNAL_DUMP("value(%u) = %#V", value.size(), value.rep)
+         ptr2 = (const char*) memchr(ptr1, '\r', end1-ptr1);
 
-         U_INTERNAL_ASSERT_EQUALS(u_isBinary((unsigned char*)U_STRING_TO_PARAM(value)), false)
+         if (ptr2 == 0) ptr2 = end1;
 
-         index = U_NOT_FOUND;
-          keyp = key.data();
-
-         switch (u_get_unalignedp32(keyp))
+         if ((ptr2-ptr1) > (ptrdiff_t)U_CONSTANT_SIZE("Set-Cookie: ") &&
+             u__strncasecmp(ptr1, U_CONSTANT_TO_PARAM("Set-Cookie: ")) == 0)
             {
-            case U_MULTICHAR_CONSTANT32('C','o','n','t'):
-               {
-               keyp += 7;
-
-               switch (u_get_unalignedp32(keyp))
-                  {
-                  case U_MULTICHAR_CONSTANT32('-','D','i','s'): index = 25; break; // content-disposition
-                  case U_MULTICHAR_CONSTANT32('-','E','n','c'): index = 26; break; // content-encoding
-                  case U_MULTICHAR_CONSTANT32('-','L','a','n'): index = 27; break; // content-language
-                  case U_MULTICHAR_CONSTANT32('-','L','o','c'): index = 29; break; // content-location
-                  case U_MULTICHAR_CONSTANT32('-','R','a','n'): index = 30; break; // content-range
-                  case U_MULTICHAR_CONSTANT32('-','T','y','p'): index = 31; break; // content-type 
-
-                  default:
-                     {
-                     U_INTERNAL_ASSERT_EQUALS(key, U_STRING_FROM_CONSTANT("Content-Length"))
-
-                     continue;
-                     }
-                  }
-               }
-            break;
-
-            case U_MULTICHAR_CONSTANT32('A','c','c','e'):
-               {
-               keyp += 6;
-
-               if (u_get_unalignedp32(keyp) == U_MULTICHAR_CONSTANT32('-','R','a','n')) index = 18; // accept-ranges
-               else
-                  {
-                  U_INTERNAL_ASSERT_EQUALS(key, U_STRING_FROM_CONSTANT("Access-Control-Allow-Origin"))
-
-                  index = 20; // access-control-allow-origin
-                  }
-               }
-            break;
-
-            case U_MULTICHAR_CONSTANT32('C','a','c','h'): index = 24; break; // cache-control
-            case U_MULTICHAR_CONSTANT32('E','t','a','g'): index = 34; break; // etag
-            case U_MULTICHAR_CONSTANT32('E','x','p','i'): index = 36; break; // expires
-            case U_MULTICHAR_CONSTANT32('L','a','s','t'): index = 44; break; // last-modified
-            case U_MULTICHAR_CONSTANT32('L','i','n','k'): index = 45; break; // link
-            case U_MULTICHAR_CONSTANT32('L','o','c','a'): index = 46; break; // location
-            case U_MULTICHAR_CONSTANT32('P','r','o','x'): index = 48; break; // proxy-authenticate
-            case U_MULTICHAR_CONSTANT32('R','e','f','r'): index = 52; break; // refresh
-            case U_MULTICHAR_CONSTANT32('R','e','t','r'): index = 53; break; // retry-after
-            case U_MULTICHAR_CONSTANT32('S','t','r','i'): index = 56; break; // strict-transport-security
-            case U_MULTICHAR_CONSTANT32('V','a','r','y'): index = 59; break; // vary 
-            case U_MULTICHAR_CONSTANT32('W','W','W','-'): index = 61; break; // www-authenticate 
-
-            default:
-               {
-                    if (key.equalnocase(U_CONSTANT_TO_PARAM("Via"))) index = 60; // via
-               else if (key.equalnocase(U_CONSTANT_TO_PARAM("Age"))) index = 21; // age
-               }
-            break;
+            ptr1 += U_CONSTANT_SIZE("Set-Cookie: ");
             }
 
-         *dst = 0x40;
-
-         if (index != U_NOT_FOUND) dst = hpackEncodeInt(     dst, index, (1<<6)-1);
-         else                      dst = hpackEncodeString(++dst, U_STRING_TO_PARAM(key));
+        *dst = 0x10;
+         dst = hpackEncodeInt(dst, 55, (1<<4)-1);
+         dst = hpackEncodeString(dst, ptr1, ptr2-ptr1);
 
-         dst = hpackEncodeString(dst, U_STRING_TO_PARAM(value));
+         ptr1 = ptr2 + U_CONSTANT_SIZE(U_CRLF);
          }
 
-      vext->clear();
+      UHTTP::set_cookie->setEmpty();
+      }
+
+   if (sz2)
+      {
+      dst = (bcache ? hpackEncodeHeadersFromCache(dst, *UHTTP::ext)
+                    : hpackEncodeHeaders(         dst, *UHTTP::ext, true));
       }
    else
       {
       /**
        * -------------------------------------------------
-       * literal header field with indexing (indexed name)
+       * literal header field without indexing (indexed name)
        * -------------------------------------------------
        * content-length: 0
        * -------------------------------------------------
-       * *dst = 0x40;
-       *  dst = hpackEncodeInt(dst, 28, (1<<6)-1);
+       * *dst = 0x00;
+       *  dst = hpackEncodeInt(dst, 28, (1<<4)-1);
        *  dst = hpackEncodeString(dst, U_CONSTANT_TO_PARAM("0"));
        * -------------------------------------------------
        */
 
-      u_put_unalignedp32(dst, U_MULTICHAR_CONSTANT32('\\','\001','0','\0'));
-                         dst += 3;
+      u_put_unalignedp32(dst, U_MULTICHAR_CONSTANT32('\017','\015','\001','0'));
+                         dst += 4;
       }
 
    sz  = dst-(unsigned char*)ptr;
@@ -1744,20 +2237,7 @@ void UHTTP2::handlerResponse()
    U_DUMP("frame header response { length = %d stream_id = %d type = (%d, %s) flags = %d } = %#.*S", ntohl(*(uint32_t*)ptr & 0x00ffffff) >> 8,
            ntohl(*(uint32_t*)(ptr+5) & 0x7fffffff), ptr[3], getFrameTypeDescription(ptr[3]), ptr[4], ntohl(*(uint32_t*)ptr & 0x00ffffff) >> 8, ptr + HTTP2_FRAME_HEADER_SIZE)
 
-   sz2 = UClientImage_Base::body->size();
-
-   if (sz2)
-      {
-      *(uint32_t*) dst    = htonl(sz2 << 8);
-                   dst[3] = DATA;
-                   dst[4] = FLAG_END_STREAM;
-      *(uint32_t*)(dst+5) = htonl(pStream->id);
-
-      U_DUMP("frame data response { length = %d stream_id = %d type = (%d, %s) flags = %d }", ntohl(*(uint32_t*)dst & 0x00ffffff) >> 8,
-                  ntohl(*(uint32_t*)(dst+5) & 0x7fffffff), dst[3], getFrameTypeDescription(dst[3]), dst[4])
-
-      sz += HTTP2_FRAME_HEADER_SIZE;
-      }
+   // NB: the body is sent in DATA frames by writeResponse(), within the flow control windows of the peer...
 
    UClientImage_Base::wbuffer->size_adjust(sz);
 
@@ -1778,14 +2258,28 @@ int UHTTP2::handlerRequest()
 
    pStream = (pConnection = (vConnection + sz))->streams;
 
-   pConnection->state =   CONN_STATE_OPEN;
-       pStream->state = STREAM_STATE_IDLE;
+   pConnection->state = CONN_STATE_OPEN;
+
+   releaseStreams();
+
+   if (pConnection->hpack_encoder)
+      {
+      // NB: a new connection starts with an empty dynamic table for the decoder of the peer...
+
+      delete pConnection->hpack_encoder;
+             pConnection->hpack_encoder = 0;
+      }
+
+   nerror = NO_ERROR;
 
    pConnection->max_open_stream_id      =
    pConnection->max_processed_stream_id = 0;
 
    pConnection->peer_settings                     = settings;
    pConnection->peer_settings.initial_window_size = 65535; // initial flow-control window size
+   pConnection->peer_settings.max_frame_size      = 16384; // initial value of SETTINGS_MAX_FRAME_SIZE
+
+   pConnection->out_window = 65535; // NB: the connection window can be changed only by WINDOW_UPDATE (6.9.2)...
 
    U_INTERNAL_DUMP("HTTP2-Settings(%u): = %.*S U_http_method_type = %d %B", U_http2_settings_len, U_http2_settings_len, upgrade_settings, U_http_method_type, U_http_method_type)
 
@@ -1869,7 +2363,15 @@ int UHTTP2::handlerRequest()
       pStream->id                     = 
       pConnection->max_open_stream_id = 1;
 
-      pStream->state = STREAM_STATE_HALF_CLOSED;
+      pStream->state      = STREAM_STATE_HALF_CLOSED;
+      pStream->out_window = pConnection->peer_settings.initial_window_size;
+      pStream->data_len   =
+      pStream->count      = 0;
+      pStream->bpart      = false;
+
+      pStream->urgency         = HTTP2_DEFAULT_URGENCY;
+      pStream->incremental     = false;
+      pStream->priority_signal = PRIORITY_NONE;
       }
    else if (USocketExt::write(UServer_Base::csocket, U_CONSTANT_TO_PARAM(HTTP2_SETTINGS_BIN), UServer_Base::timeoutMS) !=
                                                          U_CONSTANT_SIZE(HTTP2_SETTINGS_BIN))
@@ -1935,6 +2437,1043 @@ bool UHTTP2::readBodyRequest()
    U_RETURN(true);
 }
 
+bool UHTTP2::updateWindow()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::updateWindow()")
+
+   U_INTERNAL_ASSERT_POINTER(pConnection)
+   U_INTERNAL_ASSERT_EQUALS(frame.type, WINDOW_UPDATE)
+
+   if (frame.length != 4)
+      {
+      nerror = FRAME_SIZE_ERROR;
+
+      U_RETURN(false);
+      }
+
+   int32_t* pwindow;
+   uint32_t window_size_increment = ntohl(*(uint32_t*)frame.payload) & 0x7fffffff;
+
+   U_INTERNAL_DUMP("window_size_increment = %u", window_size_increment)
+
+   if (window_size_increment == 0)
+      {
+      nerror = PROTOCOL_ERROR;
+
+      U_RETURN(false);
+      }
+
+   if (frame.stream_id == 0) pwindow = &(pConnection->out_window);
+   else
+      {
+      Stream* pStreamTmp = findStream(frame.stream_id);
+
+      if (pStreamTmp == 0) U_RETURN(true); // NB: WINDOW_UPDATE can be received for a closed stream...
+
+      pwindow = &(pStreamTmp->out_window);
+      }
+
+   U_INTERNAL_DUMP("*pwindow = %d", *pwindow)
+
+   if ((int64_t)*pwindow + window_size_increment > 0x7fffffff) // A sender MUST NOT allow a flow-control window to exceed 2^31-1 octets (6.9.1)
+      {
+      nerror = FLOW_CONTROL_ERROR;
+
+      U_RETURN(false);
+      }
+
+   *pwindow += window_size_increment;
+
+   U_RETURN(true);
+}
+
+bool UHTTP2::readControlFrame()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::readControlFrame()")
+
+   U_INTERNAL_ASSERT_POINTER(pConnection)
+
+   // NB: the send windows are exhausted, we read the frames of the peer waiting for WINDOW_UPDATE...
+
+   const char* ptr;
+   uint32_t sz, len = HTTP2_FRAME_HEADER_SIZE;
+
+read:
+   sz = UClientImage_Base::rbuffer->size() - UClientImage_Base::rstart;
+
+   U_INTERNAL_DUMP("sz = %u len = %u", sz, len)
+
+   if (sz < len)
+      {
+      if (UClientImage_Base::rstart)
+         {
+         if (sz) UClientImage_Base::rbuffer->moveToBeginDataInBuffer(UClientImage_Base::rstart);
+         else    UClientImage_Base::rbuffer->setEmpty();
+
+         UClientImage_Base::rstart = 0;
+         }
+
+      if (USocketExt::read(UServer_Base::csocket, *UClientImage_Base::rbuffer, len-sz, UServer_Base::timeoutMS, UHTTP::request_read_timeout) == false ||
+          UClientImage_Base::rbuffer->size() < len)
+         {
+         nerror = ERROR_INCOMPLETE;
+
+         U_RETURN(false);
+         }
+      }
+
+   ptr = UClientImage_Base::rbuffer->c_pointer(UClientImage_Base::rstart);
+
+   if (len == HTTP2_FRAME_HEADER_SIZE)
+      {
+      frame.length    = ntohl(*(uint32_t*)ptr & 0x00ffffff) >> 8;
+      frame.type      = ptr[3];
+      frame.flags     = ptr[4];
+      frame.stream_id = ntohl(*(uint32_t*)(ptr+5) & 0x7fffffff);
+
+      if (frame.length)
+         {
+         len += frame.length;
+
+         goto read;
+         }
+      }
+
+   frame.payload = (unsigned char*)ptr + HTTP2_FRAME_HEADER_SIZE;
+
+   UClientImage_Base::rstart += len;
+
+   U_DUMP("frame { length = %d stream_id = %d type = (%d, %s) flags = %d } = %#.*S", frame.length,
+             frame.stream_id, frame.type, getFrameTypeDescription(frame.type), frame.flags, frame.length, frame.payload)
+
+   switch (frame.type)
+      {
+      case WINDOW_UPDATE:
+         {
+         if (updateWindow() == false) U_RETURN(false);
+         }
+      break;
+
+      case SETTINGS:
+         {
+         if ((frame.flags & FLAG_ACK) != 0) settings_ack = true;
+         else if (updateSetting(frame.payload, frame.length) == false ||
+                  USocketExt::write(UServer_Base::csocket, U_CONSTANT_TO_PARAM(HTTP2_SETTINGS_ACK), UServer_Base::timeoutMS) != U_CONSTANT_SIZE(HTTP2_SETTINGS_ACK))
+            {
+            if (nerror == NO_ERROR) nerror = PROTOCOL_ERROR;
+
+            U_RETURN(false);
+            }
+         }
+      break;
+
+      case PING:
+         {
+         if ((frame.flags & FLAG_ACK) == 0)
+            {
+            if (frame.length != 8)
+               {
+               nerror = FRAME_SIZE_ERROR;
+
+               U_RETURN(false);
+               }
+
+            char buffer[HTTP2_FRAME_HEADER_SIZE+8] = { 0, 0, 8,    // frame size
+                                                       PING,       // header frame
+                                                       FLAG_ACK,   // flags
+                                                       0, 0, 0, 0, // stream id
+                                                       0, 0, 0, 0,
+                                                       0, 0, 0, 0 };
+
+            U_MEMCPY(buffer+HTTP2_FRAME_HEADER_SIZE, frame.payload, 8);
+
+            if (USocketExt::write(UServer_Base::csocket, buffer, HTTP2_FRAME_HEADER_SIZE+8, UServer_Base::timeoutMS) != HTTP2_FRAME_HEADER_SIZE+8)
+               {
+               nerror = INTERNAL_ERROR;
+
+               U_RETURN(false);
+               }
+            }
+         }
+      break;
+
+      case RST_STREAM:
+         {
+         Stream* pStreamTmp = findStream(frame.stream_id);
+
+         if (pStreamTmp)
+            {
+            // NB: the peer cancels the stream, we discard the output not yet sent...
+
+            pStreamTmp->state    = STREAM_STATE_CLOSED;
+            pStreamTmp->data_len =
+            pStreamTmp->count    = 0;
+            pStreamTmp->bpart    = false;
+            }
+         }
+      break;
+
+      case HEADERS:
+         {
+         // NB: we serve one request for connection, so a new stream opened while we are sending the response is refused...
+
+         if (frame.stream_id > pConnection->max_open_stream_id)
+            {
+            char buffer[HTTP2_FRAME_HEADER_SIZE+4] = { 0, 0, 4,       // frame size
+                                                       RST_STREAM,    // header frame
+                                                       FLAG_NONE,     // flags
+                                                       0, 0, 0, 0,    // stream id
+                                                       0, 0, 0, REFUSED_STREAM };
+
+            *(uint32_t*)(buffer+5) = htonl(frame.stream_id);
+
+            if (USocketExt::write(UServer_Base::csocket, buffer, HTTP2_FRAME_HEADER_SIZE+4, UServer_Base::timeoutMS) != HTTP2_FRAME_HEADER_SIZE+4)
+               {
+               nerror = INTERNAL_ERROR;
+
+               U_RETURN(false);
+               }
+            }
+         }
+      break;
+
+      case PRIORITY:
+         {
+         Stream* pStreamTmp;
+
+         // NB: the priority can change while we are sending the response, the scheduler picks it up at the next DATA frame...
+
+         if (frame.length == 5 &&
+             (pStreamTmp = findStream(frame.stream_id)))
+            {
+            setPriority(pStreamTmp, (uint32_t)frame.payload[4] + 1);
+            }
+         }
+      break;
+
+      case PRIORITY_UPDATE: updatePriority();                          break;
+      case GOAWAY:          pConnection->state = CONN_STATE_IS_CLOSING; break;
+
+      default: break; // DATA, CONTINUATION, PUSH_PROMISE: ignored while we are sending the response...
+      }
+
+   U_RETURN(true);
+}
+
+void UHTTP2::setPriority(Stream* pStreamTmp, uint32_t weight)
+{
+   U_TRACE(0, "UHTTP2::setPriority(%p,%u)", pStreamTmp, weight)
+
+   U_INTERNAL_ASSERT_RANGE(1, weight, 256)
+
+   // NB: the signal of RFC 9218 takes precedence over the weight of RFC 7540...
+
+   if (pStreamTmp->priority_signal != PRIORITY_FIELD)
+      {
+      // weight: 256 => 0, 220 => 1, 183 => 2, 147 => 3, 110 => 4, ..., 1 => 7 (the weights used by the browsers for document/css, script, image, ...)
+
+      pStreamTmp->urgency         = (256 - weight + 18) / 37;
+      pStreamTmp->incremental     = false;
+      pStreamTmp->priority_signal = PRIORITY_WEIGHT;
+
+      U_INTERNAL_DUMP("pStreamTmp->id = %d pStreamTmp->urgency = %u", pStreamTmp->id, pStreamTmp->urgency)
+      }
+}
+
+void UHTTP2::setPriority(Stream* pStreamTmp, const char* ptr, uint32_t len)
+{
+   U_TRACE(0, "UHTTP2::setPriority(%p,%.*S,%u)", pStreamTmp, len, ptr, len)
+
+   // RFC 9218 4: the value is a structured field dictionary (ex: "u=1, i"), the members that are unknown or not valid are ignored...
+
+   char key;
+   uint8_t urgency = HTTP2_DEFAULT_URGENCY;
+   bool incremental = false;
+   const char* end = ptr + len;
+
+   while (ptr < end)
+      {
+      while (u__isspace(*ptr)) if (++ptr >= end) goto next;
+
+      key = *ptr++;
+
+      if (ptr >= end ||
+          *ptr == ',' ||
+          *ptr == ';' ||
+          u__isspace(*ptr))
+         {
+         if (key == 'i') incremental = true; // NB: boolean true without value...
+         }
+      else if (*ptr == '=' &&
+               ++ptr < end)
+         {
+         if (key == 'u')
+            {
+            if (*ptr >= '0' &&
+                *ptr <= '7' &&
+                (ptr+1 == end || u__isdigit(ptr[1]) == false))
+               {
+               urgency = *ptr - '0';
+               }
+            }
+         else if (key == 'i' &&
+                  *ptr == '?' &&
+                  ++ptr < end)
+            {
+            incremental = (*ptr == '1');
+            }
+         }
+
+      while (ptr < end && *ptr != ',') ++ptr;
+
+      ++ptr;
+      }
+
+next:
+   pStreamTmp->urgency         = urgency;
+   pStreamTmp->incremental     = incremental;
+   pStreamTmp->priority_signal = PRIORITY_FIELD;
+
+   U_INTERNAL_DUMP("pStreamTmp->id = %d pStreamTmp->urgency = %u pStreamTmp->incremental = %b", pStreamTmp->id, pStreamTmp->urgency, pStreamTmp->incremental)
+}
+
+void UHTTP2::setPriority(Stream* pStreamTmp, int mime_index)
+{
+   U_TRACE(0, "UHTTP2::setPriority(%p,%C)", pStreamTmp, mime_index)
+
+   U_INTERNAL_ASSERT_EQUALS(pStreamTmp->priority_signal, PRIORITY_NONE)
+
+   // NB: without a signal from the client we give precedence to what blocks the rendering of the page (html, css, javascript),
+   //     while the images (that are rendered progressively) go after the other resources and are interleaved between them...
+
+   if (u_is_css(mime_index) ||
+       u_is_js(mime_index)  ||
+       u_is_html(mime_index))
+      {
+      pStreamTmp->urgency = 1;
+      }
+   else if (u_is_img(mime_index))
+      {
+      pStreamTmp->urgency     = 5;
+      pStreamTmp->incremental = true;
+      }
+}
+
+void UHTTP2::updatePriority()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::updatePriority()")
+
+   // RFC 9218 7.1: the id of the prioritized stream followed by the priority field value
+
+   if (frame.length >= 4)
+      {
+      int32_t id = ntohl(*(uint32_t*)frame.payload) & 0x7fffffff;
+
+      Stream* pStreamTmp = findStream(id);
+
+      // NB: we don't keep the priority of a stream not yet opened, it will be signalled again by the priority header...
+
+      if (pStreamTmp) setPriority(pStreamTmp, (const char*)frame.payload+4, frame.length-4);
+      }
+}
+
+void UHTTP2::addData(const char* ptr, uint32_t len)
+{
+   U_TRACE(0, "UHTTP2::addData(%p,%u)", ptr, len)
+
+   U_INTERNAL_ASSERT_MINOR(data_iovcnt, 16)
+
+   data_iov[data_iovcnt].iov_base = (caddr_t)ptr;
+   data_iov[data_iovcnt].iov_len  = len;
+
+   ++data_iovcnt;
+
+   data_iovlen += len;
+}
+
+bool UHTTP2::flushData()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::flushData()")
+
+   U_INTERNAL_DUMP("data_iovcnt = %d data_iovlen = %u", data_iovcnt, data_iovlen)
+
+   if (data_iovcnt == 0) U_RETURN(true);
+
+   int iBytesWrite = USocketExt::writev(UServer_Base::csocket, data_iov, data_iovcnt, data_iovlen, UServer_Base::timeoutMS);
+
+   if (iBytesWrite > 0) U_SRV_STAT_ADD(cnt_bytes_write, iBytesWrite);
+
+   bool result = (iBytesWrite == (int)data_iovlen);
+
+   data_iovcnt = 0;
+   data_iovlen = 0;
+
+   U_RETURN(result);
+}
+
+bool UHTTP2::sendData(Stream* pStreamData, uint32_t n)
+{
+   U_TRACE(0, "UHTTP2::sendData(%p,%u)", pStreamData, n)
+
+   U_INTERNAL_ASSERT_MAJOR(n, 0)
+   U_INTERNAL_ASSERT(pStreamData->data_len || pStreamData->count)
+
+   U_INTERNAL_DUMP("pStreamData->id = %d pStreamData->data_len = %u pStreamData->start = %u pStreamData->count = %u pStreamData->bpart = %b",
+                    pStreamData->id,     pStreamData->data_len,     pStreamData->start,     pStreamData->count,     pStreamData->bpart)
+
+   // NB: every DATA frame takes two entries of data_iov (the frame header and the data)...
+
+   if (data_iovcnt > 14 &&
+       flushData() == false)
+      {
+      U_RETURN(false);
+      }
+
+   bool bend;
+   uint32_t len;
+   char* ptr = data_frame_header + (data_iovcnt / 2) * HTTP2_FRAME_HEADER_SIZE;
+
+   if (pStreamData->data_len)
+      {
+      len  = U_min(n, pStreamData->data_len);
+      bend = (len == pStreamData->data_len && pStreamData->count == 0 && pStreamData->bpart == false);
+      }
+   else
+      {
+      len  = U_min(n, pStreamData->count);
+      bend = (len == pStreamData->count && pStreamData->bpart == false);
+      }
+
+   *(uint32_t*) ptr    = htonl(len << 8);
+                ptr[3] = DATA;
+                ptr[4] = (bend ? FLAG_END_STREAM : FLAG_NONE);
+   *(uint32_t*)(ptr+5) = htonl(pStreamData->id);
+
+   U_DUMP("frame data response { length = %d stream_id = %d type = (%d, %s) flags = %d }", ntohl(*(uint32_t*)ptr & 0x00ffffff) >> 8,
+               ntohl(*(uint32_t*)(ptr+5) & 0x7fffffff), ptr[3], getFrameTypeDescription(ptr[3]), ptr[4])
+
+   addData(ptr, HTTP2_FRAME_HEADER_SIZE);
+
+   if (pStreamData->data_len)
+      {
+      addData(pStreamData->data, len);
+
+      pStreamData->data     += len;
+      pStreamData->data_len -= len;
+      }
+   else
+      {
+      // NB: the frame header must precede the range of the file (with TCP_CORK they leave in the same segment)...
+
+      if (flushData() == false) U_RETURN(false);
+
+      off_t offset    = pStreamData->start;
+      int iBytesWrite = USocketExt::sendfile(UServer_Base::csocket, pStreamData->sfd, &offset, len, UServer_Base::timeoutMS);
+
+      if (iBytesWrite > 0) U_SRV_STAT_ADD(cnt_bytes_write, iBytesWrite);
+
+      if (iBytesWrite != (int)len) U_RETURN(false);
+
+      pStreamData->start += len;
+      pStreamData->count -= len;
+
+      if (pStreamData->count == 0 &&
+          pStreamData->bpart)
+         {
+         // NB: multipart/byteranges, we continue with the delimiter and the next range of the file...
+
+         UClientImage_Base* pClientImage = UServer_Base::pClientImage;
+
+         pStreamData->data  = pClientImage->nextSendfilePart(&(pStreamData->data_len));
+         pStreamData->start = pClientImage->start;
+         pStreamData->count = pClientImage->count;
+
+         if (pStreamData->count == 0) pStreamData->bpart = false; // NB: close delimiter...
+         }
+      }
+
+   pStreamData->out_window -= len;
+   pConnection->out_window -= len;
+
+   if (bend) pStreamData->state = STREAM_STATE_CLOSED;
+
+   U_RETURN(true);
+}
+
+// SERVER PUSH
+
+static const char* findAttribute(const char* ptr, const char* end, const char* name, uint32_t name_len, uint32_t* plen)
+{
+   U_TRACE(0, "findAttribute(%p,%p,%.*S,%u,%p)", ptr, end, name_len, name, name_len, plen)
+
+   char quote;
+   const char* value;
+   const char* result = 0;
+
+   for (; (ptr + name_len + 1) < end; ++ptr)
+      {
+      if (u__isspace(*ptr) &&
+          u__strncasecmp(ptr+1, name, name_len) == 0)
+         {
+         value = ptr + 1 + name_len;
+
+         while (value < end && u__isspace(*value)) ++value;
+
+         if (value >= end ||
+             *value != '=')
+            {
+            continue;
+            }
+
+         do { ++value; } while (value < end && u__isspace(*value));
+
+         if (value >= end) break;
+
+         quote = *value;
+
+         if (quote == '"' ||
+             quote == '\'')
+            {
+            ++value;
+
+            ptr = (const char*) memchr(value, quote, end - value);
+
+            if (ptr == 0) break;
+            }
+         else
+            {
+            for (ptr = value; ptr < end && u__isspace(*ptr) == false; ++ptr) {}
+            }
+
+         *plen  = ptr - value;
+          result = value;
+
+         break;
+         }
+      }
+
+   U_RETURN(result);
+}
+
+UString UHTTP2::getLinkedResources(const char* path, uint32_t len, const UString& content)
+{
+   U_TRACE(0, "UHTTP2::getLinkedResources(%.*S,%u,%V)", len, path, len, content.rep)
+
+   // NB: we look only for the resources that block the rendering of the page: <link rel="stylesheet|preload" href="..."> and <script src="...">,
+   //     with a local path (absolute or relative to the directory of the page) that we can look for in the file cache...
+
+   bool bscript;
+   UString list(U_CAPACITY);
+   uint32_t n = 0, dir_len = len, value_len, rel_len;
+   const char* ptr = content.data();
+   const char* end = ptr + content.size();
+   const char* tag_end;
+   const char* value;
+   const char* rel;
+
+   while (dir_len && path[dir_len-1] != '/') --dir_len;
+
+   while (n < HTTP2_PUSH_MAX &&
+          (ptr = (const char*) memchr(ptr, '<', end - ptr)) &&
+          (end - ++ptr) > 6)
+      {
+           if (u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("script")) == 0 && u__isspace(ptr[6])) bscript = true;
+      else if (u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("link"))   == 0 && u__isspace(ptr[4])) bscript = false;
+      else continue;
+
+      if ((tag_end = (const char*) memchr(ptr, '>', end - ptr)) == 0) break;
+
+      if (bscript)
+         {
+         value = findAttribute(ptr, tag_end, U_CONSTANT_TO_PARAM("src"), &value_len);
+         }
+      else
+         {
+         rel   = findAttribute(ptr, tag_end, U_CONSTANT_TO_PARAM("rel"), &rel_len);
+         value = (rel &&
+                  (u_find(rel, rel_len, U_CONSTANT_TO_PARAM("stylesheet")) ||
+                   u_find(rel, rel_len, U_CONSTANT_TO_PARAM("preload")))
+                     ? findAttribute(ptr, tag_end, U_CONSTANT_TO_PARAM("href"), &value_len)
+                     : 0);
+         }
+
+      ptr = tag_end;
+
+      if (value == 0 ||
+          value_len == 0)
+         {
+         continue;
+         }
+
+      // NB: we strip the query and the fragment, and we skip the external resources (ex: //cdn..., http://..., data:...) and the paths with '..'
+
+      for (uint32_t i = 0; i < value_len; ++i)
+         {
+         if (value[i] == '?' ||
+             value[i] == '#')
+            {
+            value_len = i;
+
+            break;
+            }
+         }
+
+      if (value_len == 0                                      ||
+          (value_len > 1 && u_get_unalignedp16(value) == U_MULTICHAR_CONSTANT16('/','/')) ||
+          memchr(value, ':', value_len)                        ||
+          u_find(value, value_len, U_CONSTANT_TO_PARAM("..")))
+         {
+         continue;
+         }
+
+      if (*value == '/') (void) list.append(value+1, value_len-1);
+      else
+         {
+         (void) list.append(path, dir_len);
+         (void) list.append(value, value_len);
+         }
+
+      list.push_back('\n');
+
+      ++n;
+      }
+
+   U_RETURN_STRING(list);
+}
+
+void UHTTP2::checkPush()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::checkPush()")
+
+   U_INTERNAL_ASSERT_POINTER(push_list)
+   U_INTERNAL_ASSERT_POINTER(UHTTP::file_data)
+
+   UString list, page(U_FILE_TO_PARAM(*UHTTP::file));
+
+   if (push_manifest) list = (*push_manifest)[page];
+
+   if (list.empty())
+      {
+      // NB: the resources linked from the content of the page are discovered only once for each version (mtime) of the page...
+
+      UString key(U_CAPACITY);
+
+      key.snprintf("%v@%u", page.rep, (uint32_t)UHTTP::file_data->mtime);
+
+      list = (*push_cache)[key];
+
+      if (list.empty())
+         {
+         list = getLinkedResources(U_STRING_TO_PARAM(page), UHTTP::getBodyFromCache());
+
+         if (list.empty()) list = U_STRING_FROM_CONSTANT("\n"); // NB: nothing to push, so we don't look again...
+
+         if (push_cache->size() >= HTTP2_PUSH_CACHE_MAX) push_cache->clear();
+
+         push_cache->insert(key, list);
+         }
+      }
+
+   U_INTERNAL_DUMP("list(%u) = %V", list.size(), list.rep)
+
+   if (list.size() <= 1) return;
+
+   // NB: a cookie with the digest of the list tells us that the client has already received these resources (and presumably has them in its cache)...
+
+   char cookie[32];
+   uint32_t cookie_len = u__snprintf(cookie, sizeof(cookie), "ULib.push=%08x", list.hash());
+
+   if (U_http_info.cookie_len &&
+       u_find(U_http_info.cookie, U_http_info.cookie_len, cookie, cookie_len))
+      {
+      U_INTERNAL_DUMP("the client has already the resources linked from the page")
+
+      return;
+      }
+
+   *push_list = list;
+
+   (void) UHTTP::set_cookie->reserve(100U);
+
+   UHTTP::set_cookie->snprintf_add("Set-Cookie: %.*s; path=/; max-age=%ld\r\n", cookie_len, cookie, 30 * U_ONE_DAY_IN_SECOND);
+}
+
+void UHTTP2::pushResources()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::pushResources()")
+
+   U_INTERNAL_ASSERT(*push_list)
+   U_INTERNAL_ASSERT(push_frames->empty())
+   U_INTERNAL_ASSERT_POINTER(pConnection)
+
+   int encoding;
+   Stream* pStreamPush;
+   UString body, header;
+   UVector<UString> vpush;
+   unsigned char* dst;
+   char* ptr;
+   char* ptr1;
+   char uri[1024];
+   int32_t promised_id = 0;
+   uint32_t len, max = U_min(pConnection->peer_settings.max_concurrent_streams, HTTP2_PUSH_MAX);
+   UHTTP::UFileCacheData* file_data_save = UHTTP::file_data;
+
+   for (uint32_t i = 0, n = vpush.split(*push_list, '\n'); i < n && push_body->size() < max; ++i)
+      {
+      len = vpush[i].size();
+
+      if (len >= sizeof(uri)) continue;
+
+      // NB: we push only what is in the file cache with the content in memory...
+
+      UHTTP::file_data = UHTTP::getFileInCache(vpush[i].data(), len);
+
+      if (UHTTP::file_data == 0           ||
+          UHTTP::file_data->array == 0    ||
+          UHTTP::file_data->size  == 0    ||
+          S_ISDIR(UHTTP::file_data->mode) ||
+          UHTTP::file_data->evicted)
+         {
+         continue;
+         }
+
+      encoding = UHTTP::getAcceptEncodingFromCache();
+
+      body   = (encoding ? UHTTP::getBodyCompressFromCache(encoding)   : UHTTP::getBodyFromCache());
+      header = (encoding ? UHTTP::getHeaderCompressFromCache(encoding) : UHTTP::getHeaderFromCache());
+
+      if (body.empty()) continue;
+
+      if (encoding) UHTTP::addBytesSavedFromCache(encoding);
+
+      uri[0] = '/';
+
+      u__memcpy(uri+1, vpush[i].data(), len, __PRETTY_FUNCTION__);
+
+      (void) push_frames->reserve(HTTP2_FRAME_HEADER_SIZE * 2 + 4 + 32 + U_http_host_len + len + header.size());
+
+      /**
+       * PUSH_PROMISE on the stream of the request: the promised stream id followed by the header block of the request that we promise
+       * (:method GET, :scheme, :authority, :path). NB: these header blocks are encoded without reference to the dynamic table because
+       * the decoder of the peer sees them after the one of the response of the page...
+       */
+
+      ptr = push_frames->c_pointer(push_frames->size());
+      dst = (unsigned char*)ptr + HTTP2_FRAME_HEADER_SIZE + 4;
+
+      *dst++ = 0x82; // :method: GET
+      *dst++ = (UServer_Base::csocket->isSSLActive() ? 0x87 : 0x86); // :scheme: https|http
+
+      if (U_http_host_len) dst = hpackEncodeHeader(dst, 1, U_CONSTANT_TO_PARAM(":authority"), U_HTTP_HOST_TO_PARAM, false);
+                           dst = hpackEncodeHeader(dst, 4, U_CONSTANT_TO_PARAM(":path"),      uri, len+1,           false);
+
+      promised_id += 2;
+
+      *(uint32_t*) ptr                            = htonl(((char*)dst-ptr-HTTP2_FRAME_HEADER_SIZE) << 8);
+                   ptr[3]                         = PUSH_PROMISE;
+                   ptr[4]                         = FLAG_END_HEADERS;
+      *(uint32_t*)(ptr+5)                         = htonl(pStream->id);
+      *(uint32_t*)(ptr+HTTP2_FRAME_HEADER_SIZE)   = htonl(promised_id);
+
+      // the HEADERS of the pushed response (the header block of the entry of the file cache)...
+
+      ptr1 = (char*)dst;
+      dst += HTTP2_FRAME_HEADER_SIZE;
+
+      *dst++ = 0x88; // :status: 200
+
+      dst = hpackEncodeHeadersFromCache(dst, header);
+
+      *(uint32_t*) ptr1    = htonl(((char*)dst-ptr1-HTTP2_FRAME_HEADER_SIZE) << 8);
+                   ptr1[3] = HEADERS;
+                   ptr1[4] = FLAG_END_HEADERS;
+      *(uint32_t*)(ptr1+5) = htonl(promised_id);
+
+      push_frames->size_adjust((char*)dst - push_frames->data());
+
+      // the stream of the pushed response (reserved by us and then half closed from the client with the HEADERS)...
+
+      for (pStreamPush = pConnection->streams; pStreamPush; pStreamPush = pStreamPush->next)
+         {
+         if (pStreamPush != pStream                      &&
+             (pStreamPush->state == STREAM_STATE_IDLE ||
+              pStreamPush->state == STREAM_STATE_CLOSED) &&
+             pStreamPush->data_len == 0                  &&
+             pStreamPush->count    == 0)
+            {
+            break;
+            }
+         }
+
+      if (pStreamPush == 0) pStreamPush = allocStream();
+
+      pStreamPush->id              = promised_id;
+      pStreamPush->state           = STREAM_STATE_HALF_CLOSED;
+      pStreamPush->out_window      = pConnection->peer_settings.initial_window_size;
+      pStreamPush->data            = body.data();
+      pStreamPush->data_len        = body.size();
+      pStreamPush->count           = 0;
+      pStreamPush->bpart           = false;
+      pStreamPush->urgency         = HTTP2_DEFAULT_URGENCY;
+      pStreamPush->incremental     = false;
+      pStreamPush->priority_signal = PRIORITY_NONE;
+
+      setPriority(pStreamPush, UHTTP::file_data->mime_index);
+
+      push_body->push_back(body);
+
+      U_SRV_LOG("HTTP2 push: %.*S (stream %d) with the page %.*S", len+1, uri, promised_id, U_FILE_TO_TRACE(*UHTTP::file));
+      }
+
+   UHTTP::file_data = file_data_save;
+}
+
+bool UHTTP2::writeResponse()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP2::writeResponse()")
+
+   U_INTERNAL_ASSERT_POINTER(pStream)
+   U_INTERNAL_ASSERT_POINTER(pConnection)
+   U_INTERNAL_ASSERT(*UClientImage_Base::wbuffer)
+   U_INTERNAL_ASSERT_EQUALS(data_iovcnt, 0)
+
+   // NB: the HEADERS (and CONTINUATION) frames are built by handlerResponse(), what follows them in wbuffer (ex: the FLV header) is part of the body...
+
+   bool bend_headers, bcork = false, result = true;
+   UClientImage_Base* pClientImage = UServer_Base::pClientImage;
+   char* ptr = UClientImage_Base::wbuffer->data();
+   uint32_t sz = UClientImage_Base::wbuffer->size(), hsz = 0;
+
+   do {
+      U_INTERNAL_ASSERT_MINOR(hsz, sz)
+
+      bend_headers = ((ptr[hsz+4] & FLAG_END_HEADERS) != 0);
+      hsz         += HTTP2_FRAME_HEADER_SIZE + (ntohl(*(uint32_t*)(ptr+hsz) & 0x00ffffff) >> 8);
+      }
+   while (bend_headers == false);
+
+   U_INTERNAL_DUMP("sz = %u hsz = %u U_http_method_type = %d", sz, hsz, U_http_method_type)
+
+   pStream->data_len =
+   pStream->count    = 0;
+   pStream->bpart    = false;
+
+   if (U_http_method_type != HTTP_HEAD)
+      {
+      if (sz > hsz &&
+          *UClientImage_Base::body)
+         {
+         (void) UClientImage_Base::wbuffer->append(*UClientImage_Base::body);
+
+         ptr = UClientImage_Base::wbuffer->data();
+         sz  = UClientImage_Base::wbuffer->size();
+         }
+
+      if (sz > hsz)
+         {
+         pStream->data     = ptr+hsz;
+         pStream->data_len = sz -hsz;
+         }
+      else
+         {
+         pStream->data     = UClientImage_Base::body->data();
+         pStream->data_len = UClientImage_Base::body->size();
+         }
+
+      if (pClientImage->count)
+         {
+         pStream->sfd   = pClientImage->sfd;
+         pStream->start = pClientImage->start;
+         pStream->count = pClientImage->count;
+         pStream->bpart = (pClientImage->sendfile_part.empty() == false);
+         }
+      }
+
+   if (pStream->data_len == 0 &&
+       pStream->count    == 0)
+      {
+      ptr[4] |= FLAG_END_STREAM; // NB: response without body...
+
+      pStream->state = STREAM_STATE_CLOSED;
+      }
+
+   addData(ptr, hsz);
+
+   if (push_list &&
+       *push_list)
+      {
+      // NB: the PUSH_PROMISE frames must precede the DATA frames of the page that refer to the resources...
+
+      if (pStream->data_len ||
+          pStream->count)
+         {
+         pushResources();
+
+         if (*push_frames) addData(push_frames->data(), push_frames->size());
+         }
+
+      push_list->clear();
+      }
+
+   if (pStream->count)
+      {
+      bcork = true;
+
+      USocket::setTcpCork(UServer_Base::csocket, 1U);
+      }
+
+   /**
+    * The scheduler (RFC 9218): for each pass we select the most urgent level with pending output. At that level a non incremental
+    * stream is served alone (the lowest id first), the incremental streams get instead one DATA frame each (round robin). The size
+    * of the frame is limited by SETTINGS_MAX_FRAME_SIZE and by the send windows of the stream and of the connection. If the selected
+    * streams are blocked by their window we go on with the other streams that can proceed, and if no stream can proceed we read the
+    * frames of the peer (waiting for WINDOW_UPDATE)...
+    */
+
+   for (;;)
+      {
+      uint32_t n;
+      bool bprogress = false;
+      Stream* pStreamData;
+      Stream* pStreamFirst = 0; // the stream that leads the most urgent level
+
+      for (pStreamData = pConnection->streams; pStreamData; pStreamData = pStreamData->next)
+         {
+         if ((pStreamData->data_len ||
+              pStreamData->count) &&
+             (pStreamFirst == 0 ||
+              isMoreUrgent(pStreamData, pStreamFirst)))
+            {
+            pStreamFirst = pStreamData;
+            }
+         }
+
+      if (pStreamFirst == 0) break;
+
+      U_INTERNAL_DUMP("pStreamFirst->id = %d pStreamFirst->urgency = %u pStreamFirst->incremental = %b pConnection->out_window = %d",
+                       pStreamFirst->id,     pStreamFirst->urgency,     pStreamFirst->incremental,     pConnection->out_window)
+
+      if (pStreamFirst->incremental == false)
+         {
+         if ((n = getSendWindow(pStreamFirst)))
+            {
+            if (sendData(pStreamFirst, n) == false)
+               {
+               result = false;
+
+               goto end;
+               }
+
+            bprogress = true;
+            }
+         }
+      else
+         {
+         for (pStreamData = pConnection->streams; pStreamData; pStreamData = pStreamData->next)
+            {
+            if ((pStreamData->data_len ||
+                 pStreamData->count)                          &&
+                pStreamData->incremental                       &&
+                pStreamData->urgency == pStreamFirst->urgency &&
+                (n = getSendWindow(pStreamData)))
+               {
+               if (sendData(pStreamData, n) == false)
+                  {
+                  result = false;
+
+                  goto end;
+                  }
+
+               bprogress = true;
+               }
+            }
+         }
+
+      if (bprogress == false)
+         {
+         // NB: the most urgent streams are blocked by their send window, we don't leave unused the window of the connection...
+
+         for (pStreamData = pConnection->streams; pStreamData; pStreamData = pStreamData->next)
+            {
+            if ((pStreamData->data_len ||
+                 pStreamData->count) &&
+                (n = getSendWindow(pStreamData)))
+               {
+               if (sendData(pStreamData, n) == false)
+                  {
+                  result = false;
+
+                  goto end;
+                  }
+
+               bprogress = true;
+
+               break;
+               }
+            }
+         }
+
+      U_INTERNAL_DUMP("bprogress = %b", bprogress)
+
+      if (bprogress == false &&
+          (flushData() == false || readControlFrame() == false))
+         {
+         result = false;
+
+         goto end;
+         }
+      }
+
+   result = flushData();
+
+end:
+   if (bcork) USocket::setTcpCork(UServer_Base::csocket, 0U);
+
+   // NB: we serve one request for connection, so with the response sent (or failed) the streams taken from the pool can come back to it (and the dynamic table of the encoder is not needed anymore)...
+
+   releaseStreams();
+
+   if (pConnection->hpack_encoder)
+      {
+      delete pConnection->hpack_encoder;
+             pConnection->hpack_encoder = 0;
+      }
+
+   if (push_list &&
+       push_body->empty() == false)
+      {
+      push_frames->setEmpty();
+      push_body->clear();
+      }
+
+   if (result == false)
+      {
+      data_iovcnt = 0;
+      data_iovlen = 0;
+
+      if (nerror != NO_ERROR &&
+          UServer_Base::csocket->isOpen())
+         {
+         sendError();
+         }
+      }
+
+   if (pClientImage->count)
+      {
+      if ((U_ClientImage_pclose(pClientImage) & U_CLOSE) != 0) UFile::close(pClientImage->sfd);
+
+      pClientImage->start =
+      pClientImage->count =  0;
+      pClientImage->sfd   = -1;
+
+      if (pClientImage->sendfile_part) pClientImage->sendfile_part.clear();
+
+      if ((U_ClientImage_pclose(pClientImage) & U_YES) != 0) result = false;
+      }
+
+   U_RETURN(result);
+}
+
 #ifdef DEBUG
 #ifdef ENTRY
 #undef ENTRY
@@ -1959,6 +3498,7 @@ const char* UHTTP2::getFrameTypeDescription(char type)
       case ENTRY(GOAWAY);
       case ENTRY(WINDOW_UPDATE);
       case ENTRY(CONTINUATION);
+      case ENTRY(PRIORITY_UPDATE);
 
       default: descr = "Frame type unknown";
       }
@@ -1970,7 +3510,7 @@ const char* UHTTP2::getFrameTypeDescription(char type)
 U_EXPORT const char* UHTTP2::Connection::dump(bool reset) const
 {
    *UObjectIO::os << "state                     " << state                   << '\n'
-               // << "out_window                " << out_window              << '\n'
+                  << "out_window                " << out_window              << '\n'
                   << "inp_window                " << inp_window              << '\n'
                   << "hpack_max_capacity        " << hpack_max_capacity      << '\n'
                   << "max_open_stream_id        " << max_open_stream_id      << '\n'
@@ -109,6 +109,8 @@ error:   U_INTERNAL_DUMP("errno = %d", errno)
 
          if (errno != EAGAIN)
             {
+            if (sk == UServer_Base::csocket) U_SRV_STAT_ADD(cnt_error_read, 1);
+
             if (U_ClientImage_parallelization != U_PARALLELIZATION_CHILD)
                {
                if (errno != ECONNRESET &&
@@ -559,6 +561,72 @@ error:   U_INTERNAL_DUMP("errno = %d", errno)
    U_RETURN(byte_written);
 }
 
+#ifdef U_ZEROCOPY_SUPPORT
+int USocketExt::writev_zerocopy(USocket* sk, struct iovec* iov, int iovcnt, uint32_t count, bool& bzerocopy)
+{
+   U_TRACE(1, "USocketExt::writev_zerocopy(%p,%p,%d,%u,%p)", sk, iov, iovcnt, count, &bzerocopy)
+
+   U_INTERNAL_ASSERT_POINTER(sk)
+   U_INTERNAL_ASSERT_MAJOR(iovcnt, 0)
+   U_INTERNAL_ASSERT(sk->isConnected())
+   U_INTERNAL_ASSERT_EQUALS(sk->isSSLActive(), false)
+
+   ssize_t value;
+   struct msghdr msg;
+   struct iovec* pbody = iov + iovcnt - 1;
+   uint32_t sz = count - pbody->iov_len;
+
+   U_INTERNAL_ASSERT_MAJOR(pbody->iov_len, 0)
+
+   bzerocopy = false;
+
+   (void) U_SYSCALL(memset, "%p,%d,%u", &msg, 0, sizeof(struct msghdr));
+
+   if (sz)
+      {
+      msg.msg_iov    = iov;
+      msg.msg_iovlen = iovcnt - 1;
+
+      value = U_SYSCALL(sendmsg, "%d,%p,%d", sk->iSockDesc, &msg, MSG_MORE);
+
+      if (value != (ssize_t)sz) // NB: the headers are not sent entirely, the copy path manage the error or the partial write...
+         {
+         if (value <= 0) U_RETURN(_writev(sk, iov, iovcnt, count, 0));
+
+         iov_resize(iov, iovcnt, value);
+
+         value += _writev(sk, iov, iovcnt, count - value, 0);
+
+         U_RETURN(value);
+         }
+
+      iov_resize(iov, iovcnt, sz);
+      }
+
+   msg.msg_iov    = pbody;
+   msg.msg_iovlen = 1;
+
+   value = U_SYSCALL(sendmsg, "%d,%p,%d", sk->iSockDesc, &msg, MSG_ZEROCOPY);
+
+   if (value <= 0) // NB: with ENOBUFS (the limit of optmem is exceeded) we fall back to the copy path...
+      {
+      U_INTERNAL_DUMP("errno = %d", errno)
+
+      value = sz + _writev(sk, pbody, 1, pbody->iov_len, 0);
+
+      U_RETURN(value);
+      }
+
+   bzerocopy = true;
+
+   if (value < (ssize_t)pbody->iov_len) iov_resize(pbody, 1, value);
+
+   value += sz;
+
+   U_RETURN(value);
+}
+#endif
+
 int USocketExt::writev(USocket* sk, struct iovec* iov, int iovcnt, uint32_t count, int timeoutMS)
 {
    U_TRACE(0, "USocketExt::writev(%p,%p,%d,%u,%d)", sk, iov, iovcnt, count, timeoutMS)
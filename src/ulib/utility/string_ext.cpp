@@ -28,6 +28,12 @@
 #ifdef USE_LIBZOPFLI
 #  include <zopfli.h>
 #endif
+#ifdef USE_LIBBROTLI
+#  include <brotli/encode.h>
+#endif
+#ifdef USE_LIBZSTD
+#  include <zstd.h>
+#endif
 #ifdef USE_LIBEXPAT
 #  include <ulib/xml/expat/xml2txt.h>
 #endif
@@ -1424,13 +1430,17 @@ UString UStringExt::deflate(const char* s, uint32_t len, int type) // .gz compre
          }
 #  endif
 
+      char* ptr = UFile::pfree;
+
       sz = UFile::getSizeAligned(len);
 
-      UString result(len, sz, UFile::pfree);
+      // NB: we must reserve the space before the allocation of the UStringRep object (the memory pool can grow the stack from UFile::pfree)...
 
       UFile::pfree += sz;
       UFile::nfree -= sz;
 
+      UString result(len, sz, ptr);
+
       U_RETURN_STRING(result);
       }
 
@@ -1493,6 +1503,56 @@ UString UStringExt::gunzip(const char* ptr, uint32_t sz, uint32_t space) // .gz
 #endif
 }
 
+UString UStringExt::brotli(const char* s, uint32_t len, int quality) // .br compress
+{
+   U_TRACE(1, "UStringExt::brotli(%.*S,%u,%d)", len, s, len, quality)
+
+#ifdef USE_LIBBROTLI
+   size_t sz = U_SYSCALL(BrotliEncoderMaxCompressedSize, "%u", (size_t)len);
+
+   if (sz)
+      {
+      UString r((uint32_t)sz);
+
+      if (U_SYSCALL(BrotliEncoderCompress, "%d,%d,%d,%u,%p,%p,%p", quality, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                                                                (size_t)len, (const uint8_t*)s, &sz, (uint8_t*)r.rep->data()) == BROTLI_TRUE)
+         {
+         r.rep->_length = sz;
+
+         U_INTERNAL_DUMP("BrotliEncoderCompress(%u) = %u", len, sz)
+
+         U_RETURN_STRING(r);
+         }
+      }
+#endif
+
+   return UString::getStringNull();
+}
+
+UString UStringExt::zstd(const char* s, uint32_t len, int level) // .zst compress
+{
+   U_TRACE(1, "UStringExt::zstd(%.*S,%u,%d)", len, s, len, level)
+
+#ifdef USE_LIBZSTD
+   size_t sz = U_SYSCALL(ZSTD_compressBound, "%u", (size_t)len);
+
+   UString r((uint32_t)sz);
+
+   sz = U_SYSCALL(ZSTD_compress, "%p,%u,%p,%u,%d", r.rep->data(), sz, s, (size_t)len, level);
+
+   if (ZSTD_isError(sz) == 0)
+      {
+      r.rep->_length = sz;
+
+      U_INTERNAL_DUMP("ZSTD_compress(%u) = %u", len, sz)
+
+      U_RETURN_STRING(r);
+      }
+#endif
+
+   return UString::getStringNull();
+}
+
 // convert letter to upper or lower case
 
 UString UStringExt::tolower(const char* s, uint32_t n)
@@ -15,6 +15,7 @@
 
 #include <ulib/url.h>
 #include <ulib/date.h>
+#include <ulib/cache.h>
 #include <ulib/db/rdb.h>
 #include <ulib/tokenizer.h>
 #include <ulib/mime/entity.h>
@@ -64,6 +65,12 @@
 
 #define U_FLV_HEAD        "FLV\x1\x1\0\0\0\x9\0\0\0\x9"
 #define U_TIME_FOR_EXPIRE (u_now->tv_sec + (365 * U_ONE_DAY_IN_SECOND))
+#define U_MICRO_CACHE_UPDATING_TIME 10 // max time (in seconds) to regenerate a stale response, after that another process can try it
+#define U_MICRO_CACHE_WAIT_TIME    500 // max time (in ms) that a process wait for a response in-flight (cold miss) before to generate it
+#define U_MICRO_CACHE_WAIT_STEP     10 // interval (in ms) to check for a response in-flight
+#define U_SKETCH_ROWS 4 // rows of the frequency sketch of the file cache (CACHE_FILE_MEMORY)
+#define U_ETAG_MAX_LEN 64 // strong ETag of the file cache: "size-hash[-coding]"
+#define U_HTTP_MAX_RANGE 64 // max number of ranges (after coalescing) of a multipart/byteranges response
 
 int         UHTTP::mime_index;
 int         UHTTP::cgi_timeout;
@@ -78,14 +85,17 @@ UString*    UHTTP::etag;
 UString*    UHTTP::geoip;
 UString*    UHTTP::suffix;
 UString*    UHTTP::tmpdir;
+UString*    UHTTP::form_stream_buffer;
 UString*    UHTTP::request;
 UString*    UHTTP::htpasswd;
 UString*    UHTTP::htdigest;
 UString*    UHTTP::qcontent;
+UString*    UHTTP::sendfile_part;
 UString*    UHTTP::pathname;
 UString*    UHTTP::rpathname;
 UString*    UHTTP::set_cookie;
 UString*    UHTTP::mount_point;
+UString*    UHTTP::status_uri;
 UString*    UHTTP::fcgi_uri_mask;
 UString*    UHTTP::scgi_uri_mask;
 UString*    UHTTP::cache_file_mask;
@@ -105,7 +115,32 @@ uint32_t    UHTTP::sid_counter_cur;
 uint32_t    UHTTP::usp_page_key_len;
 uint32_t    UHTTP::limit_request_body = U_STRING_MAX_SIZE;
 uint32_t    UHTTP::request_read_timeout;
+uint32_t    UHTTP::form_stream_min_size;
+uint32_t    UHTTP::form_field_max_size = 64 * 1024;
+uint32_t    UHTTP::micro_cache_ttl;
+uint32_t    UHTTP::micro_cache_size;
+uint32_t    UHTTP::micro_cache_stale;
+UCache*     UHTTP::micro_cache;
+ULock*      UHTTP::micro_cache_lock;
+UString*    UHTTP::micro_cache_key;
+void*       UHTTP::micro_cache_ptr;
+bool        UHTTP::form_stream;
+bool        UHTTP::cache_file_shared;
+int         UHTTP::cache_file_shared_idx = -1;
+void*       UHTTP::cache_file_shared_ptr;
+uint32_t    UHTTP::cache_file_shared_num;
+uint32_t    UHTTP::cache_file_shared_size;
+bool        UHTTP::cache_file_admit;
+uint8_t*    UHTTP::cache_file_sketch;
+uint32_t    UHTTP::cache_file_memory;
+uint32_t    UHTTP::cache_file_memory_max;
+uint32_t    UHTTP::cache_file_lru_memory[2];
+uint32_t    UHTTP::cache_file_sketch_bits;
+uint32_t    UHTTP::cache_file_sketch_count;
+uint32_t    UHTTP::header_line_num;
+uhttpline   UHTTP::header_line[U_HTTP_MAX_HEADER_LINE];
 const char* UHTTP::usp_page_key;
+uint16_t    UHTTP::accept_encoding[U_ENCODING_NUM];
 
 UCommand*                         UHTTP::pcmd;
 UDataSession*                     UHTTP::data_session;
@@ -113,10 +148,15 @@ UDataSession*                     UHTTP::data_storage;
 UMimeMultipart*                   UHTTP::formMulti;
 UModProxyService*                 UHTTP::service;
 UVector<UString>*                 UHTTP::vmsg_error;
+UVector<UString>*                 UHTTP::micro_cache_vary;
+UVector<UString>*                 UHTTP::micro_cache_rule;
 UVector<UString>*                 UHTTP::form_name_value;
 UHTTP::UServletPage*              UHTTP::usp_page_ptr;
 UVector<UModProxyService*>*       UHTTP::vservice;
 URDBObjectHandler<UDataStorage*>* UHTTP::db_session;
+UHTTP::file_cache_shared_info*    UHTTP::cache_file_shared_info;
+UHTTP::UFileCacheData*            UHTTP::cache_file_lru_head[2];
+UHTTP::UFileCacheData*            UHTTP::cache_file_lru_tail[2];
 
          UHTTP::UFileCacheData*   UHTTP::file_data;
          UHTTP::UFileCacheData*   UHTTP::file_not_in_cache_data;
@@ -285,13 +325,20 @@ UHTTP::UFileCacheData::UFileCacheData()
    U_TRACE_REGISTER_OBJECT(0, UFileCacheData, "")
 
    ptr = array = 0;
+   prev = next = 0;
    size        = 0;
    mode        = 0;
+   hash        = 0;
+   etag        = 0;
    mtime       = 0;
+   nbytes      = 0;
+   segment     = 0;
    link        = false;
+   evicted     = false;
    expire      = U_TIME_FOR_EXPIRE;
+   generation  = 0;
    mime_index  = U_unknow;
-   wd = fd     = -1;
+   wd = fd     = shared = -1;
 }
 
 UHTTP::UFileCacheData::UFileCacheData(const UHTTP::UFileCacheData& elem)
@@ -300,11 +347,19 @@ UHTTP::UFileCacheData::UFileCacheData(const UHTTP::UFileCacheData& elem)
 
    fd         = wd = -1;
    mode       = 0;
+   hash       = 0;
+   nbytes     = 0;
+   segment    = 0;
+   prev       = next = 0;
+   evicted    = false;
    ptr        = elem.ptr;        // data
    link       = elem.link;       // true => ptr point to another entry
-   array      = elem.array;      // content, header, gzip(content, header)
+   array      = elem.array;      // content, header, gzip(content, header), brotli(content, header), zstd(content, header)
    size       = elem.size;       // size content
+   etag       = elem.etag;       // hash of the content (strong ETag)
    mtime      = elem.mtime;      // time of last modification
+   shared     = elem.shared;     // index of the entry in the shared file cache
+   generation = elem.generation; // generation of the shared entry that the array point to
    mime_index = elem.mime_index; // index file mime type
 
    // check expire time of the entry
@@ -330,6 +385,8 @@ UHTTP::UFileCacheData::~UFileCacheData()
       else delete (UString*)ptr;
       }
 
+   if (nbytes) UHTTP::removeFileDataFromLRU(this);
+
    if (array) delete array;
 
 #if defined(HAVE_SYS_INOTIFY_H) && defined(U_HTTP_INOTIFY_SUPPORT) && !defined(U_SERVER_CAPTIVE_PORTAL)
@@ -799,6 +856,7 @@ void UHTTP::init()
    tmpdir                = U_NEW(UString(U_PATH_MAX));
    request               = U_NEW(UString);
    qcontent              = U_NEW(UString);
+   sendfile_part         = U_NEW(UString);
    pathname              = U_NEW(UString(U_CAPACITY));
    rpathname             = U_NEW(UString);
    formMulti             = U_NEW(UMimeMultipart);
@@ -1367,6 +1425,7 @@ void UHTTP::dtor()
    if (scgi_uri_mask)         delete scgi_uri_mask;
    if (cache_file_store)      delete cache_file_store;
    if (string_HTTP_Variables) delete string_HTTP_Variables;
+   if (form_stream_buffer)    delete form_stream_buffer;
 
    if (file)
       {
@@ -1379,6 +1438,7 @@ void UHTTP::dtor()
       delete tmpdir;
       delete request;
       delete qcontent;
+      delete sendfile_part;
       delete pathname;
       delete rpathname;
       delete formMulti;
@@ -1392,8 +1452,19 @@ void UHTTP::dtor()
       if (htpasswd)          delete htpasswd;
       if (htdigest)          delete htdigest;
       if (mount_point)       delete mount_point;
+      if (status_uri)        delete status_uri;
       if (nocache_file_mask) delete nocache_file_mask;
 
+      if (micro_cache)
+         {
+         delete micro_cache;
+         delete micro_cache_key;
+         delete micro_cache_lock;
+         }
+
+      if (micro_cache_vary) delete micro_cache_vary;
+      if (micro_cache_rule) delete micro_cache_rule;
+
 #  ifdef U_ALIAS
                                  delete  alias;
       if (valias)                delete valias;
@@ -1431,6 +1502,8 @@ void UHTTP::dtor()
 
       delete cache_file;
 
+      if (cache_file_sketch) UMemoryPool::_free(cache_file_sketch, U_SKETCH_ROWS << cache_file_sketch_bits);
+
       if (db_session) clearSession();
 
       if (db_not_found)
@@ -1925,6 +1998,8 @@ U_NO_EXPORT bool UHTTP::readHeaderRequest()
 
    U_INTERNAL_DUMP("sz = %u", sz)
 
+   header_line_num = 0;
+
    if ( sz < 18 && // 18 -> "GET / HTTP/1.0\r\n\r\n"
        (sz <  4 || u_get_unalignedp32(ptr+sz-4) != U_MULTICHAR_CONSTANT32('\r','\n','\r','\n')))
       {
@@ -1947,7 +2022,11 @@ U_NO_EXPORT bool UHTTP::readHeaderRequest()
 
    if (u_get_unalignedp32(ptr) == U_MULTICHAR_CONSTANT32('\r','\n','\r','\n')) U_RETURN(true);
 
-   sz = u_findEndHeader1(ptr+2, sz-U_http_info.startHeader-2);
+   // NB: in one pass we find the end of header and the position of the U_CRLF and of the ':' of every line (see checkRequestForHeader())...
+
+   sz = u_scanHeader(ptr+2, sz-U_http_info.startHeader-2, header_line, U_HTTP_MAX_HEADER_LINE, &header_line_num);
+
+   U_INTERNAL_DUMP("header_line_num = %u", header_line_num)
 
    if (sz != U_NOT_FOUND) sz += U_http_info.startHeader-2;
    else
@@ -2266,6 +2345,20 @@ parallelization: // parent
          U_RETURN(false);
          }
 
+      // NB: a big upload is parsed while it arrives, without to keep the whole body in memory...
+
+      if (form_stream_min_size                           &&
+          U_http_version == '1'                          &&
+          U_http_info.clength >= form_stream_min_size    &&
+          U_HTTP_CTYPE_MEMEQ("multipart/form-data"))
+         {
+         if (readFormStream(body_byte_read) == false) U_RETURN(false);
+
+         UClientImage_Base::setRequestNoCache();
+
+         U_RETURN(true);
+         }
+
       // NB: wait for other data to complete the read of the request...
 
       if (USocketExt::read(UServer_Base::csocket, *UClientImage_Base::request, U_http_info.clength - body_byte_read, U_SSL_TIMEOUT_MS, request_read_timeout) == false)
@@ -2332,6 +2425,366 @@ parallelization: // parent
    U_RETURN(true);
 }
 
+/**
+ * Streaming of a multipart/form-data body: the parts are delimited by CRLF "--" boundary, so we put a CRLF before the
+ * read data to find also the first delimiter. The data of a part is passed on (to file or to memory) as soon as we know
+ * that it cannot be the start of a delimiter, and the read buffer keeps only the tail that must be examined again...
+ */
+
+#define U_FORM_STREAM_CHUNK      (64U * 1024U)
+#define U_FORM_STREAM_HEADER_MAX ( 8U * 1024U)
+
+U_NO_EXPORT bool UHTTP::readFormStream(uint32_t body_byte_read)
+{
+   U_TRACE(0, "UHTTP::readFormStream(%u)", body_byte_read)
+
+   U_ASSERT(tmpdir->empty())
+   U_ASSERT(form_name_value->empty())
+   U_INTERNAL_ASSERT_EQUALS(form_stream, false)
+   U_INTERNAL_ASSERT_MAJOR(U_http_info.clength, body_byte_read)
+
+   enum { PREAMBLE, BOUNDARY, HEADER, BODY, EPILOGUE };
+
+   char delimiter[4+70];
+   long timeout = 0;
+   ssize_t value;
+   const char* ptr;
+   const char* end;
+   const char* found;
+   UString name, field, filename, basename, content_disposition;
+   int fd = -1, state = PREAMBLE, code = HTTP_BAD_REQUEST;
+   uint32_t n, dlen, part_size = 0, memory = 0, remain = U_http_info.clength - body_byte_read;
+   UString content_type(U_HTTP_CTYPE_TO_PARAM), boundary = UMimeHeader::getBoundary(content_type); // NB: the boundary is a substring of content_type...
+
+   if (boundary.isQuoted()) boundary.rep->unQuote();
+
+   n = boundary.size();
+
+   U_INTERNAL_DUMP("boundary(%u) = %V", n, boundary.rep)
+
+   if (n == 0 ||
+       n > 70) // RFC 2046
+      {
+      U_RETURN(false);
+      }
+
+   u_put_unalignedp32(delimiter, U_MULTICHAR_CONSTANT32('\r','\n','-','-'));
+
+   U_MEMCPY(delimiter+4, boundary.data(), n);
+
+   dlen = 4 + n;
+
+   if (form_stream_buffer == 0) form_stream_buffer = U_NEW(UString(U_FORM_STREAM_CHUNK * 2));
+
+   form_stream_buffer->setBuffer(U_FORM_STREAM_CHUNK * 2);
+
+   (void) form_stream_buffer->append(U_CONSTANT_TO_PARAM(U_CRLF));
+   (void) form_stream_buffer->append(UClientImage_Base::request->c_pointer(U_http_info.endHeader), body_byte_read);
+
+   while (true)
+      {
+      ptr = form_stream_buffer->data();
+      end = ptr + form_stream_buffer->size();
+
+      while (ptr < end)
+         {
+         U_INTERNAL_DUMP("state = %d part_size = %u remain = %u", state, part_size, remain)
+
+         if (state == EPILOGUE)
+            {
+            ptr = end; // NB: the data after the close delimiter is ignored...
+
+            break;
+            }
+
+         if (state == BOUNDARY)
+            {
+            // NB: after the delimiter we have "--" (close delimiter) or optional white space until the end of line...
+
+            if ((end - ptr) < 2) break;
+
+            if (ptr[0] == '-' &&
+                ptr[1] == '-')
+               {
+               state = EPILOGUE;
+
+               continue;
+               }
+
+            found = (const char*) memchr(ptr, '\n', end - ptr);
+
+            if (found == 0)
+               {
+               if ((end - ptr) > 256) goto error;
+
+               break;
+               }
+
+            ptr   = found + 1;
+            state = HEADER;
+
+            continue;
+            }
+
+         if (state == HEADER)
+            {
+            if ((end - ptr) < 2) break;
+
+            if (u_get_unalignedp16(ptr) == U_MULTICHAR_CONSTANT16('\r','\n')) found = ptr; // part without headers
+            else
+               {
+               found = (const char*) u_find(ptr, end - ptr, U_CONSTANT_TO_PARAM(U_CRLF2));
+
+               if (found == 0)
+                  {
+                  if ((end - ptr) > (ptrdiff_t)U_FORM_STREAM_HEADER_MAX) goto error;
+
+                  break;
+                  }
+
+               found += 2;
+
+               // Content-Disposition: form-data; name="input_file"; filename="/tmp/4dcd39e8-2a84-4242-b7bc-ca74922d26e1"
+
+               for (const char* line = ptr; line < found; line = (const char*) memchr(line, '\n', found - line) + 1)
+                  {
+                  if ((found - line) > (ptrdiff_t)U_CONSTANT_SIZE("Content-Disposition:") &&
+                      u__strncasecmp(line, U_CONSTANT_TO_PARAM("Content-Disposition:")) == 0)
+                     {
+                     const char* cdisposition = line + U_CONSTANT_SIZE("Content-Disposition:");
+
+                     while (u__isblank(*cdisposition)) ++cdisposition;
+
+                     (void) content_disposition.replace(cdisposition, (const char*) memchr(cdisposition, '\r', found - cdisposition) - cdisposition);
+
+                     break;
+                     }
+                  }
+               }
+
+            ptr   = found + 2;
+            state = BODY;
+
+            part_size = 0;
+
+            if (content_disposition &&
+                UMimeHeader::getNames(content_disposition, name, filename))
+               {
+               // NB: we can't reuse the same string (filename) to avoid DEAD OF SOURCE STRING WITH CHILD ALIVE...
+
+               basename = UStringExt::basename(filename);
+
+               if (basename) // NB: a file input left empty is sent with filename="", there is no file to write...
+                  {
+                  // create temporary directory with files uploaded...
+
+                  if (tmpdir->empty())
+                     {
+                     tmpdir->snprintf("%s/formXXXXXX", u_tmpdir);
+
+                     if (UFile::mkdtemp(*tmpdir) == false)
+                        {
+                        tmpdir->setEmpty();
+
+                        code = HTTP_INTERNAL_ERROR;
+
+                        goto error;
+                        }
+
+                     U_SRV_LOG("temporary directory created: %V", tmpdir->rep);
+                     }
+
+                  pathname->setBuffer(tmpdir->size() + 1 + basename.size());
+
+                  pathname->snprintf("%v/%v", tmpdir->rep, basename.rep);
+
+                  fd = UFile::creat(pathname->data(), O_TRUNC | O_WRONLY, PERM_FILE);
+
+                  if (fd == -1)
+                     {
+                     code = HTTP_INTERNAL_ERROR;
+
+                     goto error;
+                     }
+
+                  // NB: with a big file we reserve the space on disk for the rest of the body (the excess is given back at the end of the part)...
+
+                  if (remain >= U_FORM_STREAM_CHUNK) (void) UFile::fallocate(fd, remain + (end - ptr));
+
+                  field = *pathname;
+                  }
+
+#           ifdef DEBUG
+               basename.clear();
+               filename.clear();
+#           endif
+               }
+
+            memory += name.size();
+
+            content_disposition.clear();
+
+            continue;
+            }
+
+         // state == PREAMBLE || state == BODY
+
+         U_INTERNAL_ASSERT(state == PREAMBLE || state == BODY)
+
+         found = (const char*) u_find(ptr, end - ptr, delimiter, dlen);
+
+         n = (found ? found - ptr
+                    : (end - ptr) > (ptrdiff_t)dlen ? (end - ptr) - dlen : 0); // NB: the tail can be the start of a delimiter...
+
+         if (n &&
+             state == BODY)
+            {
+            if (fd != -1)
+               {
+               if (UFile::write(fd, ptr, n) == false)
+                  {
+                  code = HTTP_INTERNAL_ERROR;
+
+                  goto error;
+                  }
+               }
+            else
+               {
+               if ((memory += n) > form_field_max_size)
+                  {
+                  code = HTTP_ENTITY_TOO_LARGE;
+
+                  goto error;
+                  }
+
+               (void) field.append(ptr, n);
+               }
+
+            part_size += n;
+            }
+
+         ptr += n;
+
+         if (found == 0) break;
+
+         if (state == BODY)
+            {
+            if (fd != -1)
+               {
+               (void) U_SYSCALL(ftruncate, "%d,%u", fd, part_size);
+
+               UFile::close(fd);
+                            fd = -1;
+               }
+
+            form_name_value->push_back(name);
+            form_name_value->push_back(field);
+
+            name.clear();
+            field.clear();
+            }
+
+         ptr  += dlen;
+         state = BOUNDARY;
+         }
+
+      if (remain == 0) break;
+
+      // NB: we keep only the data not yet examined...
+
+      n = form_stream_buffer->distance(ptr);
+
+      if (n == form_stream_buffer->size()) form_stream_buffer->size_adjust(0U);
+      else if (n)                          form_stream_buffer->moveToBeginDataInBuffer(n);
+
+      U_INTERNAL_ASSERT(form_stream_buffer->space() >= U_FORM_STREAM_CHUNK)
+
+      n = U_min(remain, form_stream_buffer->space());
+
+      // NB: we don't read over the end of the body (we don't want a pipeline after the upload)...
+
+read:
+      if (UServer_Base::csocket->isBlocking() &&
+          UNotifier::waitForRead(UServer_Base::csocket->iSockDesc, U_SSL_TIMEOUT_MS) != 1)
+         {
+         goto timeout;
+         }
+
+      value = UServer_Base::csocket->recv(form_stream_buffer->c_pointer(form_stream_buffer->size()), n);
+
+      if (value <= 0)
+         {
+         if (value == -1 &&
+             errno == EAGAIN)
+            {
+            if (UNotifier::waitForRead(UServer_Base::csocket->iSockDesc, U_SSL_TIMEOUT_MS) == 1) goto read;
+
+            goto timeout;
+            }
+
+         U_SRV_STAT_ADD(cnt_error_read, 1);
+
+         if (U_ClientImage_parallelization != U_PARALLELIZATION_CHILD) UServer_Base::csocket->abortive_close();
+
+         goto end;
+         }
+
+      form_stream_buffer->size_adjust(form_stream_buffer->size() + value);
+
+      remain -= value;
+
+      if (request_read_timeout &&
+          UServer_Base::csocket->checkTime(request_read_timeout, timeout) == false) // NB: may be is attacked by a "slow loris"...
+         {
+         goto timeout;
+         }
+      }
+
+   U_INTERNAL_DUMP("state = %d form_name_value->size() = %u", state, form_name_value->size())
+
+   if (state == EPILOGUE)
+      {
+      form_stream = true;
+
+      form_stream_buffer->setEmpty();
+
+      U_RETURN(true);
+      }
+
+   goto error;
+
+timeout:
+   code = HTTP_CLIENT_TIMEOUT;
+
+error:
+   U_SRV_LOG("WARNING: streaming of the multipart/form-data body failed (state = %d, code = %d, remain = %u)", state, code, remain);
+
+   UClientImage_Base::setCloseConnection();
+
+   if (code != HTTP_BAD_REQUEST) // NB: manageRequest() answer with setBadRequest() if we don't have a response...
+      {
+      U_http_info.nResponseCode = code;
+
+      setResponse(0, 0);
+      }
+
+end:
+   if (fd != -1) UFile::close(fd);
+
+   form_name_value->clear();
+
+   if (tmpdir->empty() == false)
+      {
+      (void) UFile::rmdir(*tmpdir, true);
+
+      tmpdir->setEmpty();
+      }
+
+   form_stream_buffer->setEmpty();
+
+   U_RETURN(false);
+}
+
 bool UHTTP::readBodyResponse(USocket* sk, UString* pbuffer, UString& body)
 {
    U_TRACE(0, "UHTTP::readBodyResponse(%p,%V,%V)", sk, pbuffer->rep, body.rep)
@@ -2401,7 +2854,9 @@ U_NO_EXPORT void UHTTP::checkRequestForHeader()
    // --------------------------------
 
    const char* pend;
-   const char* ptr = UClientImage_Base::request->data();
+   const uhttpline* line;
+   const char* ptr  = UClientImage_Base::request->data();
+   const char* base = ptr + U_http_info.startHeader;
    
    if (U_http_info.endHeader)
       {
@@ -2414,15 +2869,28 @@ U_NO_EXPORT void UHTTP::checkRequestForHeader()
       U_ClientImage_data_missing = true;
 
       *(char*)(pend = ptr + UClientImage_Base::request->size()) = '\r';
+
+      header_line_num = 0;
       }
 
-   for (const char* pn = ptr + U_http_info.startHeader; pn < pend; pn += U_CONSTANT_SIZE(U_CRLF))
+   U_INTERNAL_DUMP("header_line_num = %u", header_line_num)
+
+   // NB: if readHeaderRequest() has indexed the lines of the header (header_line_num > 0) we jump directly to the ':' and the U_CRLF of every line...
+
+   uint32_t k = 0;
+
+   for (const char* pn = base; pn < pend; pn += U_CONSTANT_SIZE(U_CRLF), ++k)
       {
       U_INTERNAL_DUMP("u__isheader(%C) = %b pn = %.20S", *pn, u__isheader(*pn), pn)
 
+      line = (k < header_line_num ? header_line+k : 0);
+
+      U_INTERNAL_ASSERT(line == 0 || base+line->end >= pn)
+
       if (u__isheader(*pn) == false)
          {
-         while (*pn != '\r') ++pn;
+         if (line) pn = base + line->end;
+         else      while (*pn != '\r') ++pn;
 
          if (UNLIKELY(pn >= pend)) return; // NB: we can have too much advanced...
          }
@@ -2433,6 +2901,20 @@ U_NO_EXPORT void UHTTP::checkRequestForHeader()
          uint32_t pos1, pos2;
          unsigned char c = *(p = pn), c1;
 
+         if (line)
+            {
+            if (line->colon == U_NOT_FOUND)
+               {
+               pn = base + line->end;
+
+               goto next;
+               }
+
+            pn = base + line->colon;
+
+            goto advance;
+            }
+
               if (pn[ 4] == ':') pn +=  4; // "Host:"
          else if (pn[ 5] == ':') pn +=  5; // "Range:"
          else if (pn[ 6] == ':') pn +=  6; // "Cookie|Accept:"
@@ -2468,7 +2950,8 @@ advance: U_INTERNAL_ASSERT_EQUALS(*pn, ':')
 
          pos1 = pn-ptr;
 
-         while (*pn != '\r') ++pn;
+         if (line) pn = base + line->end;
+         else      while (*pn != '\r') ++pn;
 
          if (UNLIKELY(pn >= pend)) return; // NB: we can have too much advanced...
 
@@ -2566,7 +3049,13 @@ advance: U_INTERNAL_ASSERT_EQUALS(*pn, ':')
             case U_MULTICHAR_CONSTANT32('U','s','e','r'): goto set_user_agent;
             case U_MULTICHAR_CONSTANT32('u','p','g','r'):
             case U_MULTICHAR_CONSTANT32('U','p','g','r'): goto set_upgrade;
-            case U_MULTICHAR_CONSTANT32('I','f','-','M'): goto set_if_mod_since;
+            case U_MULTICHAR_CONSTANT32('I','f','-','M'):
+               {
+               if (p[8] == ':') goto set_if_match; // "If-Match:"
+
+               goto set_if_mod_since;
+               }
+            case U_MULTICHAR_CONSTANT32('I','f','-','N'): goto set_if_none_match;
 #        ifdef U_LOG_ENABLE
             case U_MULTICHAR_CONSTANT32('R','e','f','e'): goto set_referer;
             case U_MULTICHAR_CONSTANT32('X','-','F','o'): goto set_x_forwarded_for;
@@ -2658,21 +3147,7 @@ set_cookie:
                      if (c1 == 'E' &&
                          memcmp(p1, U_CONSTANT_TO_PARAM("ncoding")) == 0)
                         {
-set_accept_encoding:    p1 = ptr+pos1;
-
-                        U_INTERNAL_DUMP("Accept-Encoding: = %.*S", pos2-pos1, p1)
-
-                        const char* p2 = (u_get_unalignedp32(p1) == U_MULTICHAR_CONSTANT32('g','z','i','p')
-                                       ?                     p1
-                                       : (const char*)u_find(p1, 30, U_CONSTANT_TO_PARAM("gzip")));
-
-                        if (                   p2 &&
-                            u_get_unalignedp32(p2) != U_MULTICHAR_CONSTANT32(';','q','=','0'))
-                           {
-                           U_http_is_accept_gzip = '1';
-
-                           U_INTERNAL_DUMP("U_http_is_accept_gzip = %C", U_http_is_accept_gzip)
-                           }
+set_accept_encoding:    setAcceptEncoding(ptr+pos1, pos2-pos1);
                         }
                      else if (c1 == 'L' &&
                               memcmp(p1, U_CONSTANT_TO_PARAM("anguage")) == 0)
@@ -2735,7 +3210,7 @@ set_upgrade:      p1 = ptr+pos1;
                }
             break;
 
-            case 'I': // If-Modified-Since
+            case 'I': // If-Modified-Since, If-None-Match, If-Match
                {
                if (u__toupper(p[2])  == 'M'                           &&
                    u__toupper(p[11]) == 'S'                           &&
@@ -2747,6 +3222,26 @@ set_if_mod_since: U_http_info.if_modified_since = UTimeDate::getSecondFromTime(p
 
                   U_INTERNAL_DUMP("If-Modified-Since = %u", U_http_info.if_modified_since)
                   }
+               else if (u__toupper(p[2]) == 'N'                         &&
+                        u__toupper(p[7]) == 'M'                         &&
+                        memcmp(p,   U_CONSTANT_TO_PARAM("f-"))     == 0 &&
+                        memcmp(p+3, U_CONSTANT_TO_PARAM("one-"))   == 0 &&
+                        memcmp(p+8, U_CONSTANT_TO_PARAM("atch:"))  == 0)
+                  {
+set_if_none_match: U_http_info.if_none_match     = ptr+pos1;
+                   U_http_info.if_none_match_len = U_min(pos2-pos1, 0xffff);
+
+                  U_INTERNAL_DUMP("If-None-Match = %.*S", U_http_info.if_none_match_len, U_http_info.if_none_match)
+                  }
+               else if (u__toupper(p[2]) == 'M'                         &&
+                        memcmp(p,   U_CONSTANT_TO_PARAM("f-"))     == 0 &&
+                        memcmp(p+3, U_CONSTANT_TO_PARAM("atch:"))  == 0)
+                  {
+set_if_match:     U_http_info.if_match     = ptr+pos1;
+                  U_http_info.if_match_len = U_min(pos2-pos1, 0xffff);
+
+                  U_INTERNAL_DUMP("If-Match = %.*S", U_http_info.if_match_len, U_http_info.if_match)
+                  }
                }
             break;
 
@@ -3378,6 +3873,8 @@ int UHTTP::handlerREAD()
    // ------------------------------
    U_HTTP_INFO_RESET(0);
 
+   (void) U_SYSCALL(memset, "%p,%d,%u", accept_encoding, 0, sizeof(accept_encoding));
+
    if (readHeaderRequest() == false)
       {
       if (U_ClientImage_data_missing) U_RETURN(U_PLUGIN_HANDLER_FINISHED);
@@ -3511,7 +4008,11 @@ int UHTTP::manageRequest()
 #  ifndef U_HTTP2_DISABLE
       if (U_http_version != '2')
 #  endif
-      UClientImage_Base::size_request += U_http_info.clength;
+      {
+      // NB: with the streaming of the upload in the read buffer there is only the start of the body...
+
+      UClientImage_Base::size_request += (form_stream ? UClientImage_Base::request->size() - U_http_info.endHeader : U_http_info.clength);
+      }
       }
 #endif
 
@@ -3636,14 +4137,38 @@ set_uri: U_http_info.uri     = alias->data();
 
    // ...process the HTTP message
 
-#ifdef U_THROTTLING_SUPPORT
-   if (UServer_Base::checkThrottling() == false)
+   if (status_uri &&
+       U_HTTP_URI_EQUAL(*status_uri))
       {
-      setServiceUnavailable();
+      // NB: the statistics of the server are served only to client with loopback or private address...
 
-      U_RETURN(U_PLUGIN_HANDLER_FINISHED);
-      }
-#endif
+      if (UServer_Base::csocket->remoteIPAddress().isLoopback() == false &&
+          UServer_Base::csocket->remoteIPAddress().isPrivate()  == false)
+         {
+         setForbidden();
+
+         U_SRV_LOG("STATUS_URI: request %.*S denied by client address", U_HTTP_URI_TO_TRACE);
+
+         U_RETURN(U_PLUGIN_HANDLER_FINISHED);
+         }
+
+      UString body = UServer_Base::getStatistics();
+
+      U_http_info.nResponseCode = HTTP_OK;
+
+      setResponse(UString::str_ctype_txt, &body);
+
+      U_RETURN(U_PLUGIN_HANDLER_FINISHED);
+      }
+
+#ifdef U_THROTTLING_SUPPORT
+   if (UServer_Base::checkThrottling() == false)
+      {
+      setServiceUnavailable();
+
+      U_RETURN(U_PLUGIN_HANDLER_FINISHED);
+      }
+#endif
 
    U_http_info.nResponseCode = HTTP_OK;
 
@@ -3775,11 +4300,24 @@ file_in_cache:
          U_INTERNAL_ASSERT_POINTER(usp_page)
          U_INTERNAL_ASSERT_POINTER(usp_page->runDynamicPage)
 
+         if (micro_cache &&
+             checkMicroCache())
+            {
+            U_RETURN(U_PLUGIN_HANDLER_FINISHED);
+            }
+
          U_SET_MODULE_NAME(usp);
 
          usp_page->runDynamicPage(0);
 
-         if (U_ClientImage_parallelization != U_PARALLELIZATION_PARENT) setDynamicResponse();
+         if (U_ClientImage_parallelization != U_PARALLELIZATION_PARENT)
+            {
+            setDynamicResponse();
+
+            if (micro_cache_ttl) releaseMicroCache(); // NB: the servlet have not set the response (putMicroCache() is not called)...
+            }
+
+         micro_cache_ttl = 0;
 
          U_RESET_MODULE_NAME;
 
@@ -3801,9 +4339,15 @@ file_in_cache:
 
             if (u_is_cgi(mime_index))
                {
-               (void) runCGI(true);
+               if (micro_cache == 0 ||
+                   checkMicroCache() == false)
+                  {
+                  (void) runCGI(true);
+
+                  if (micro_cache_ttl) releaseMicroCache();
 
-               UClientImage_Base::environment->setEmpty();
+                  UClientImage_Base::environment->setEmpty(); // NB: the response from the micro cache don't set the environment...
+                  }
 
                U_RETURN(U_PLUGIN_HANDLER_FINISHED);
                }
@@ -3827,6 +4371,12 @@ file_in_cache:
 
       U_INTERNAL_DUMP("file_data->link = %b file_data->ptr = %p", file_data->link, file_data->ptr)
 
+      if (cache_file_memory_max &&
+          file_data->link == false)
+         {
+         checkFileDataForMemoryBudget();
+         }
+
       if (file_data->link)
          {
          file_data = (UHTTP::UFileCacheData*)file_data->ptr;
@@ -3977,7 +4527,7 @@ int UHTTP::processRequest()
     * If the browser has to validate a component, it uses the If-None-Match header to pass the ETag back to
     * the origin server. If the ETags match, a 304 status code is returned reducing the response...
     *
-    * For me it's enough Last-Modified: ...
+    * NB: for the file in cache the strong ETag (hash of the content) is checked by processFileCache(), for the other it's enough Last-Modified: ...
     */
 
 // *etag = file->etag();
@@ -4045,17 +4595,17 @@ int UHTTP::processRequest()
 
             if (isDataFromCache()) // NB: check if we have the content of the index file in cache...
                {
+               int encoding = getAcceptEncodingFromCache();
+
                U_http_info.nResponseCode = HTTP_OK;
 
-#           ifdef USE_LIBZ
-               if (U_http_is_accept_gzip &&
-                   isDataCompressFromCache())
+               if (encoding)
                   {
-                  U_http_is_accept_gzip = '2';
+                  addBytesSavedFromCache(encoding);
 
-                  *ext = getHeaderCompressFromCache();
+                  *ext = getHeaderCompressFromCache(encoding);
 
-                  *UClientImage_Base::body = getBodyCompressFromCache();
+                  *UClientImage_Base::body = getBodyCompressFromCache(encoding);
                   }
                else
                   {
@@ -4065,7 +4615,6 @@ int UHTTP::processRequest()
                   }
 
                handlerResponse();
-#           endif
 
                U_RETURN(U_PLUGIN_HANDLER_FINISHED);
                }
@@ -4212,7 +4761,10 @@ void UHTTP::setEndRequestProcessing()
 
    // if any clear form data
 
-   if (form_name_value->size())
+   form_stream = false;
+
+   if (form_name_value->size() ||
+       tmpdir->empty() == false)
       {
       form_name_value->clear();
 
@@ -4494,6 +5046,274 @@ void UHTTP::initDbNotFound()
       }
 }
 
+// MICRO CACHE
+
+void UHTTP::initMicroCache()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP::initMicroCache()")
+
+   U_INTERNAL_ASSERT_EQUALS(micro_cache, 0)
+   U_INTERNAL_ASSERT_POINTER(micro_cache_ptr)
+   U_INTERNAL_ASSERT_POINTER(micro_cache_rule)
+
+   micro_cache      = U_NEW(UCache);
+   micro_cache_lock = U_NEW(ULock);
+   micro_cache_key  = U_NEW(UString(U_CAPACITY));
+
+   micro_cache->setMemory((char*)UServer_Base::getPointerToDataShare(micro_cache_ptr), micro_cache_size);
+
+   micro_cache_lock->init(U_SRV_LOCK_MICRO_CACHE, U_SRV_SPINLOCK_MICRO_CACHE);
+
+   U_SRV_LOG("Mapped %u bytes (%u KB) of shared memory for the micro cache of dynamic responses", micro_cache_size, micro_cache_size / 1024);
+}
+
+U_NO_EXPORT bool UHTTP::checkMicroCache()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP::checkMicroCache()")
+
+   U_INTERNAL_ASSERT_POINTER(micro_cache)
+   U_INTERNAL_ASSERT_EQUALS(micro_cache_ttl, 0)
+
+   if (isGET() == false) U_RETURN(false);
+
+   const char* value;
+   uint32_t i, n, sz, ttl = 0;
+   const char* ptr = UClientImage_Base::getRequestUri(sz);
+
+   for (i = 0, n = micro_cache_rule->size(); i < n; i += 2)
+      {
+      if (UServices::dosMatchWithOR(ptr, sz, U_STRING_TO_PARAM((*micro_cache_rule)[i]), 0))
+         {
+         ttl = U_min((*micro_cache_rule)[i+1].strtol(), U_ONE_DAY_IN_SECOND);
+
+         break;
+         }
+      }
+
+   U_INTERNAL_DUMP("ttl = %u", ttl)
+
+   if (ttl == 0) U_RETURN(false);
+
+   // NB: the key is: method + host + uri (with query) + the client accept gzip (the body can be compressed) + the values of the headers MICRO_CACHE_VARY...
+
+   micro_cache_key->setBuffer(U_CAPACITY);
+
+   micro_cache_key->snprintf("GET %.*s%.*s %c", U_HTTP_HOST_TO_TRACE, U_HTTP_URI_QUERY_TO_TRACE, (U_http_is_accept_gzip ? 'z' : '-'));
+
+   if (micro_cache_vary)
+      {
+#  ifndef U_HTTP2_DISABLE
+      if (U_http_version == '2') U_RETURN(false); // NB: the headers of the HTTP/2 request are not in the request buffer...
+#  endif
+
+      for (i = 0, n = micro_cache_vary->size(); i < n; ++i)
+         {
+         UStringRep* name = micro_cache_vary->UVector<UStringRep*>::at(i);
+
+         value = getHeaderValuePtr(name->data(), name->size(), true);
+
+         for (sz = 0; value && value[sz] != '\r' && value[sz] != '\n'; ++sz) {}
+
+         micro_cache_key->snprintf_add("\n%V: %.*s", name, sz, value);
+         }
+      }
+
+   U_INTERNAL_DUMP("micro_cache_key = %V", micro_cache_key->rep)
+
+   if (micro_cache_key->size() > U_MAX_KEYLEN) U_RETURN(false);
+
+   char* pdata;
+   micro_cache_entry e;
+   uint32_t wait = 0;
+
+loop:
+   U_gettimeofday; // NB: optimization if it is enough a time resolution of one second...
+
+   micro_cache_lock->lock();
+
+   UString data = micro_cache->get(U_STRING_TO_PARAM(*micro_cache_key));
+
+   if (data)
+      {
+      pdata = (char*)data.data();
+
+      U_MEMCPY(&e, pdata, sizeof(micro_cache_entry));
+
+      U_INTERNAL_DUMP("e.expire = %#3D e.updating = %#3D e.code = %u e.ext_len = %u", e.expire, e.updating, e.code, e.ext_len)
+
+      if (e.code == 0 && // NB: marker of a response in-flight...
+          u_now->tv_sec < e.expire)
+         {
+         // NB: the last response generated was not cacheable, until expire we don't coalesce the requests (no wait)...
+
+         micro_cache_lock->unlock();
+
+         U_RETURN(false);
+         }
+
+      if (u_now->tv_sec < e.expire) U_SRV_STAT_ADD(cnt_micro_hit, 1);
+      else
+         {
+         // NB: the response is stale (but inside the window of MICRO_CACHE_STALE) or it is in-flight (cold miss), only one process
+         //     regenerate it and the others serve it stale or wait for it...
+
+         if (u_now->tv_sec >= e.updating)
+            {
+            e.updating = u_now->tv_sec + U_MICRO_CACHE_UPDATING_TIME;
+
+            U_MEMCPY(pdata, &e, sizeof(micro_cache_entry));
+
+            micro_cache_lock->unlock();
+
+            goto miss;
+            }
+
+         if (e.code == 0)
+            {
+            micro_cache_lock->unlock();
+
+            // NB: the wait block this process, so it is bounded: after that we generate the response without to wait more...
+
+            if (wait < U_MICRO_CACHE_WAIT_TIME)
+               {
+               UTimeVal::nanosleep(U_MICRO_CACHE_WAIT_STEP);
+
+               wait += U_MICRO_CACHE_WAIT_STEP;
+
+               goto loop;
+               }
+
+            goto miss;
+            }
+
+         U_SRV_STAT_ADD(cnt_micro_stale, 1);
+         }
+
+      U_http_info.nResponseCode = e.code;
+
+      (void) ext->replace(pdata + sizeof(micro_cache_entry), e.ext_len);
+
+      (void) UClientImage_Base::body->replace(pdata + sizeof(micro_cache_entry) + e.ext_len, data.size() - sizeof(micro_cache_entry) - e.ext_len);
+
+      micro_cache_lock->unlock();
+
+      handlerResponse();
+
+      U_RETURN(true);
+      }
+
+   // NB: cold miss (or the entry is evicted), we put a marker of the response in-flight so the others processes wait for it
+   //     instead of generating it at the same time (thundering herd)...
+
+   e.expire   = 0;
+   e.updating = u_now->tv_sec + U_MICRO_CACHE_UPDATING_TIME;
+   e.code     =
+   e.ext_len  = 0;
+
+   micro_cache->add(*micro_cache_key, UString((const char*)&e, sizeof(micro_cache_entry)), U_MICRO_CACHE_UPDATING_TIME);
+
+   micro_cache_lock->unlock();
+
+miss:
+   U_SRV_STAT_ADD(cnt_micro_miss, 1);
+
+   micro_cache_ttl = ttl; // NB: putMicroCache() is called by setDynamicResponse()...
+
+   U_RETURN(false);
+}
+
+U_NO_EXPORT void UHTTP::releaseMicroCache()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP::releaseMicroCache()")
+
+   U_INTERNAL_ASSERT_POINTER(micro_cache)
+
+   micro_cache_ttl = 0;
+
+   // NB: the response is not cached, if there is our marker of the response in-flight we release it so the others processes
+   //     don't wait for it, and until MICRO_CACHE_UPDATING_TIME they generate the response without to coalesce the requests...
+
+   micro_cache_lock->lock();
+
+   UString data = micro_cache->get(U_STRING_TO_PARAM(*micro_cache_key));
+
+   if (data)
+      {
+      micro_cache_entry e;
+      char* pdata = (char*)data.data();
+
+      U_MEMCPY(&e, pdata, sizeof(micro_cache_entry));
+
+      if (e.code == 0)
+         {
+         U_gettimeofday; // NB: optimization if it is enough a time resolution of one second...
+
+         e.expire   = u_now->tv_sec + U_MICRO_CACHE_UPDATING_TIME;
+         e.updating = 0;
+
+         U_MEMCPY(pdata, &e, sizeof(micro_cache_entry));
+         }
+      }
+
+   micro_cache_lock->unlock();
+}
+
+U_NO_EXPORT void UHTTP::putMicroCache()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP::putMicroCache()")
+
+   U_INTERNAL_ASSERT_POINTER(micro_cache)
+   U_INTERNAL_ASSERT_MAJOR(micro_cache_ttl, 0)
+
+   uint32_t ttl = micro_cache_ttl;
+                  micro_cache_ttl = 0;
+
+   U_INTERNAL_DUMP("U_http_info.nResponseCode = %d set_cookie = %V ext = %V", U_http_info.nResponseCode, set_cookie->rep, ext->rep)
+
+   // NB: we don't cache the response if it is not ok or if it is specific for the client (cookie, private, no-store)...
+
+   if (U_http_info.nResponseCode != HTTP_OK                                            ||
+       set_cookie->empty() == false                                                    ||
+       u_find(U_STRING_TO_PARAM(*ext), U_CONSTANT_TO_PARAM("Set-Cookie"))              ||
+       u_find(U_STRING_TO_PARAM(*ext), U_CONSTANT_TO_PARAM("no-store"))                ||
+       u_find(U_STRING_TO_PARAM(*ext), U_CONSTANT_TO_PARAM("private")))
+      {
+      releaseMicroCache();
+
+      return;
+      }
+
+   uint32_t sz = sizeof(micro_cache_entry) + ext->size() + UClientImage_Base::body->size();
+
+   if (sz > U_MAX_DATALEN ||
+       sz > (micro_cache_size / 4)) // NB: a response must not evict all the cache...
+      {
+      releaseMicroCache();
+
+      return;
+      }
+
+   micro_cache_entry e;
+   UString data(sz);
+
+   U_gettimeofday; // NB: optimization if it is enough a time resolution of one second...
+
+   e.expire   = u_now->tv_sec + ttl;
+   e.updating = 0;
+   e.code     = U_http_info.nResponseCode;
+   e.ext_len  = ext->size();
+
+   (void) data.append((const char*)&e, sizeof(micro_cache_entry));
+   (void) data.append(*ext);
+   (void) data.append(*UClientImage_Base::body);
+
+   micro_cache_lock->lock();
+
+   micro_cache->add(*micro_cache_key, data, ttl + micro_cache_stale);
+
+   micro_cache_lock->unlock();
+}
+
 // HTTP session
 
 void UHTTP::initSession()
@@ -5285,6 +6105,15 @@ uint32_t UHTTP::processForm()
 {
    U_TRACE_NO_PARAM(0, "UHTTP::processForm()")
 
+   U_INTERNAL_DUMP("form_stream = %b", form_stream)
+
+   if (form_stream) // NB: the multipart/form-data body is already parsed by readFormStream()...
+      {
+      uint32_t len = form_name_value->size();
+
+      U_RETURN(len);
+      }
+
    U_ASSERT(tmpdir->empty())
    U_ASSERT(qcontent->empty())
    U_ASSERT(formMulti->isEmpty())
@@ -5526,12 +6355,15 @@ void UHTTP::handlerResponse()
    U_INTERNAL_ASSERT_MAJOR(U_http_info.nResponseCode, 0)
 
 #ifdef DEBUG // NB: All 1xx (informational), 204 (no content), and 304 (not modified) responses MUST not include a body...
-   if ((U_http_info.nResponseCode >= 100  &&
-        U_http_info.nResponseCode <  200) ||
-        U_http_info.nResponseCode == 304)
+   if (U_http_info.nResponseCode >= 100 &&
+       U_http_info.nResponseCode <  200)
       {
       U_ASSERT(ext->empty())
       }
+   else if (U_http_info.nResponseCode == 304)
+      {
+      U_ASSERT(UClientImage_Base::body->empty())
+      }
 #endif
 
    UClientImage_Base::setRequestProcessed();
@@ -6124,6 +6956,8 @@ end:
 
    ext->size_adjust(ptr1);
 
+   if (micro_cache_ttl) putMicroCache();
+
    handlerResponse();
 }
 
@@ -6869,13 +7703,36 @@ U_NO_EXPORT void UHTTP::putDataInCache(const UString& fmt, UString& content)
    int ratio = 100;
    bool gzip = false;
    const char* motivation = 0;
-   UString header(U_CAPACITY);
+   UString header(U_CAPACITY), plain;
+
+   if (cache_file_shared_idx != -1 &&
+       getCacheFileSharedEntry(cache_file_shared_idx)->hash == u_hash((unsigned char*)pathname->data(), pathname->size()))
+      {
+      file_data->shared = cache_file_shared_idx;
 
-   U_NEW_DBG(UVector<UString>, file_data->array, UVector<UString>(4U));
+      // NB: check if another process has already published this version of the entry...
+
+      if (getFileDataFromCacheShared(pathname->rep))
+         {
+         U_SRV_LOG("File cached: %V - %u bytes - attached to the shared generation %u", pathname->rep, file_data->size, file_data->generation);
+
+         return;
+         }
+      }
+
+   U_NEW_DBG(UVector<UString>, file_data->array, UVector<UString>(U_ENCODING_NUM * 2));
 
    file_data->array->push_back(content);
 
-   header.snprintf(fmt.data(), file_data->size);
+   // NB: the strong ETag is the hash of the content (for mod_ssi the content is processed for each request)...
+
+   file_data->etag = (u_is_ssi(mime_index) ? 0 : u_hash((unsigned char*)content.data(), content.size()));
+
+   U_INTERNAL_DUMP("file_data->etag = %u", file_data->etag)
+
+   addETagToHeader(header, U_ENCODING_IDENTITY);
+
+   header.snprintf_add(fmt.data(), file_data->size);
 
    (void) header.shrink();
 
@@ -6948,7 +7805,7 @@ next1:
 
         if (file_data->size >= UServer_Base::min_size_for_sendfile) motivation = " (size exceeded)";  // NB: for major size we assume is better to use sendfile()
    else if (file_data->size <= U_MIN_SIZE_FOR_DEFLATE)              motivation = " (size too small)";
-#ifdef USE_LIBZ
+   else if (cache_file_admit) motivation = " (readmitted)"; // NB: a file evicted by the memory budget come back in memory without the compressed variants, we don't want to compress it on every readmission...
    else if (u_is_ssi(mime_index) == false &&
             u_is_gz( mime_index) == false)
       {
@@ -6979,10 +7836,13 @@ next1:
        * Sending raw DEFLATE data is just not a good idea. As Mark says "[it's] simply more reliable to only use GZIP"
        */
 
+      plain = content; // NB: it is the source also for the other codings (brotli, zstd)...
+
+#  ifdef USE_LIBZ
       gzip    = true;
       content = UStringExt::deflate(content, 2); // zopfli...
+#  endif
       }
-#endif
 
 next2:
    size = content.size();
@@ -7003,7 +7863,10 @@ next2:
          header.setBuffer(U_CAPACITY);
 
          if (gzip) (void) header.assign(U_CONSTANT_TO_PARAM("Content-Encoding: gzip\r\n"));
-                          header.snprintf_add(fmt.data(), size);
+
+         addETagToHeader(header, (gzip ? U_ENCODING_GZIP : U_ENCODING_IDENTITY));
+
+         header.snprintf_add(fmt.data(), size);
 
          (void) header.shrink();
 
@@ -7011,53 +7874,295 @@ next2:
          }
       }
 
+   // NB: the brotli and zstd variants are taken from the precompressed files (.br, .zst) if present, else we generate them from the content...
+
+   for (int encoding = U_ENCODING_BROTLI; encoding < U_ENCODING_NUM; ++encoding)
+      {
+      struct stat st;
+      char buffer[U_PATH_MAX];
+
+      (void) u__snprintf(buffer, sizeof(buffer), "%.*s%s", U_FILE_TO_TRACE(*file), (encoding == U_ENCODING_BROTLI ? ".br" : ".zst"));
+
+      if (U_SYSCALL(stat, "%S,%p", buffer, &st) == 0)
+         {
+         if (st.st_mtime >= file_data->mtime)
+            {
+            if (putDataCompressInCache(encoding, fmt, UFile::contentOf(buffer), " (precompressed)")) continue;
+            }
+         else
+            {
+            U_SRV_LOG("WARNING: found precompressed file older than the original: %S", buffer);
+            }
+         }
+
+      if (plain &&
+          motivation == 0)
+         {
+         (void) putDataCompressInCache(encoding, fmt, (encoding == U_ENCODING_BROTLI ? UStringExt::brotli(plain) : UStringExt::zstd(plain)), 0);
+         }
+      }
+
 end:
    U_SRV_LOG("File cached: %V - %u bytes - (%d%%) compression ratio%s", pathname->rep, file_data->size, 100 - ratio, (motivation ? motivation : ""));
 }
 
-bool UHTTP::callInitForAllUSP(UStringRep* key, void* value)
-{
-   U_TRACE(0, "UHTTP::callInitForAllUSP(%V,%p)", key, value)
-
-   U_INTERNAL_ASSERT_POINTER(value)
+// NB: the ETag of a compressed variant must differ from the one of the identity content (RFC 7232 2.3.3), so we add a suffix with the coding...
 
-   UHTTP::UFileCacheData* cptr = (UHTTP::UFileCacheData*)value;
+U_NO_EXPORT uint32_t UHTTP::getETagFromCache(char* buffer, int encoding)
+{
+   U_TRACE(0, "UHTTP::getETagFromCache(%p,%d)", buffer, encoding)
 
-   if (cptr->ptr           &&
-       cptr->link == false &&
-       cptr->mime_index == U_usp)
-      {
-      UServletPage* usp_page = (UServletPage*)cptr->ptr;
+   U_INTERNAL_ASSERT_POINTER(file_data)
+   U_INTERNAL_ASSERT_MAJOR(file_data->etag, 0)
+   U_INTERNAL_ASSERT_RANGE(U_ENCODING_IDENTITY,encoding,U_ENCODING_NUM-1)
 
-      U_INTERNAL_DUMP("usp_page->runDynamicPage = %p", usp_page->runDynamicPage)
+   static const char* suffix[U_ENCODING_NUM] = { "", "-gzip", "-br", "-zstd" };
 
-#  ifdef DEBUG
-      if (usp_page->runDynamicPage)
-#  endif
-      usp_page->runDynamicPage(U_DPAGE_INIT);
-      }
+   uint32_t len = u__snprintf(buffer, U_ETAG_MAX_LEN, "\"%x-%x%s\"", file_data->size, file_data->etag, suffix[encoding]);
 
-   U_RETURN(true);
+   U_RETURN(len);
 }
 
-bool UHTTP::callEndForAllUSP(UStringRep* key, void* value)
+U_NO_EXPORT void UHTTP::addETagToHeader(UString& header, int encoding)
 {
-   U_TRACE(0, "UHTTP::callEndForAllUSP(%V,%p)", key, value)
-
-   U_INTERNAL_ASSERT_POINTER(value)
-   U_INTERNAL_ASSERT(bcallInitForAllUSP)
+   U_TRACE(0, "UHTTP::addETagToHeader(%V,%d)", header.rep, encoding)
 
-   UHTTP::UFileCacheData* cptr = (UHTTP::UFileCacheData*)value;
+   U_INTERNAL_ASSERT_POINTER(file_data)
 
-   if (cptr->ptr           &&
-       cptr->link == false &&
-       cptr->mime_index == U_usp)
+   if (file_data->etag)
       {
-      UServletPage* usp_page = (UServletPage*)cptr->ptr;
+      char buffer[U_ETAG_MAX_LEN];
 
-      U_INTERNAL_DUMP("usp_page->runDynamicPage = %p", usp_page->runDynamicPage)
+      header.snprintf_add("Etag: %.*s\r\n", getETagFromCache(buffer, encoding), buffer);
+      }
+}
 
-#  ifdef DEBUG
+U_NO_EXPORT bool UHTTP::putDataCompressInCache(int encoding, const UString& fmt, const UString& content, const char* motivation)
+{
+   U_TRACE(0, "UHTTP::putDataCompressInCache(%d,%V,%V,%S)", encoding, fmt.rep, content.rep, motivation)
+
+   U_INTERNAL_ASSERT_POINTER(file_data)
+   U_INTERNAL_ASSERT_POINTER(file_data->array)
+   U_INTERNAL_ASSERT_RANGE(U_ENCODING_BROTLI,encoding,U_ENCODING_NUM-1)
+
+   uint32_t size = content.size();
+
+   if (size == 0) U_RETURN(false);
+
+   int ratio = (size * 100U) / file_data->size;
+
+   U_INTERNAL_DUMP("ratio = %d (%d%%)", ratio, 100 - ratio)
+
+   // NB: a precompressed file is accepted if it is smaller than the original, for the generated one we want the same gain required for gzip...
+
+   if (ratio >= (motivation ? 100 : 85)) U_RETURN(false);
+
+   static const char* name[U_ENCODING_NUM] = { 0, "gzip", "br", "zstd" };
+
+   UString header(U_CAPACITY);
+
+   header.snprintf("Content-Encoding: %s\r\n", name[encoding]);
+
+   addETagToHeader(header, encoding);
+
+   header.snprintf_add(fmt.data(), size);
+
+   (void) header.shrink();
+
+   // NB: the position in the array is fixed (2 * coding), we fill with null string the slot of the missing variants...
+
+   while (file_data->array->size() < (uint32_t)(encoding * 2)) file_data->array->push_back(UString::getStringNull());
+
+   file_data->array->push_back(content);
+   file_data->array->push_back(header);
+
+   U_SRV_LOG("File cached: %V - %s variant %u bytes - (%d%%) compression ratio%s", pathname->rep, name[encoding], size, 100 - ratio, (motivation ? motivation : ""));
+
+   U_RETURN(true);
+}
+
+U_NO_EXPORT int UHTTP::getAcceptEncodingFromCache()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP::getAcceptEncodingFromCache()")
+
+   U_INTERNAL_ASSERT_POINTER(file_data)
+   U_INTERNAL_ASSERT_POINTER(file_data->array)
+
+   U_INTERNAL_DUMP("accept_encoding = { %u %u %u }", accept_encoding[U_ENCODING_GZIP], accept_encoding[U_ENCODING_BROTLI], accept_encoding[U_ENCODING_ZSTD])
+
+   // NB: we choose the variant with the highest q-value, with the same q-value we prefer (by compression ratio) brotli, zstd and then gzip...
+
+   static const int preference[U_ENCODING_NUM-1] = { U_ENCODING_BROTLI, U_ENCODING_ZSTD, U_ENCODING_GZIP };
+
+   int encoding, result = U_ENCODING_IDENTITY;
+   uint32_t qvalue = 0;
+
+   for (int i = 0; i < U_ENCODING_NUM-1; ++i)
+      {
+      encoding = preference[i];
+
+      if (accept_encoding[encoding] > qvalue &&
+          isDataCompressFromCache(encoding))
+         {
+         result = encoding;
+         qvalue = accept_encoding[encoding];
+         }
+      }
+
+   if (result)
+      {
+      if (result == U_ENCODING_GZIP)
+         {
+         U_http_is_accept_gzip = '2';
+
+         U_RETURN(result);
+         }
+      }
+   else if (file_data->array->size() <= 2) U_RETURN(result);
+
+   // NB: the request cache check only the gzip coding of the client, so we avoid to replay this response to a client with different codings...
+
+   UClientImage_Base::setRequestNoCache();
+
+   U_RETURN(result);
+}
+
+U_NO_EXPORT void UHTTP::addBytesSavedFromCache(int encoding)
+{
+   U_TRACE(0, "UHTTP::addBytesSavedFromCache(%d)", encoding)
+
+   U_INTERNAL_ASSERT_POINTER(file_data)
+   U_INTERNAL_ASSERT_RANGE(U_ENCODING_GZIP,encoding,U_ENCODING_NUM-1)
+
+   // NB: we count only when the compressed variant is sent (or when the client is told that its copy is still valid with 304)...
+
+   U_SRV_STAT_ADD(cnt_bytes_saved[encoding-1], file_data->size - file_data->array->getStringRep(encoding * 2)->size());
+}
+
+void UHTTP::setAcceptEncoding(const char* ptr, uint32_t len)
+{
+   U_TRACE(0, "UHTTP::setAcceptEncoding(%.*S,%u)", len, ptr, len)
+
+   // -------------------------------------------------------------
+   // Accept-Encoding: gzip;q=0.5, br, zstd;q=0.8, *;q=0
+   // -------------------------------------------------------------
+   // a coding without q-value has q=1, a coding with q=0 is not acceptable and the "*" apply to every coding not listed...
+
+   int encoding;
+   uint32_t qvalue;
+   const char* token;
+   const char* end = ptr + len;
+   int32_t wildcard = -1;
+   bool listed[U_ENCODING_NUM] = { false, false, false, false };
+
+   while (ptr < end)
+      {
+      while (ptr < end && (*ptr == ',' || u__isspace(*ptr))) ++ptr;
+
+      token = ptr;
+
+      while (ptr < end && *ptr != ',' && *ptr != ';' && u__isspace(*ptr) == false) ++ptr;
+
+      len    = ptr - token;
+      qvalue = 1000;
+
+      while (ptr < end && *ptr != ',') // parameters
+         {
+         if ((*ptr == 'q' || *ptr == 'Q') &&
+             (ptr[-1] == ';' || u__isspace(ptr[-1])) &&
+             (ptr+1) < end && ptr[1] == '=')
+            {
+            ptr += 2;
+
+            qvalue = (ptr < end && *ptr == '1' ? 1000 : 0);
+
+            if (qvalue == 0 && ptr < end && *ptr == '0' && (ptr+1) < end && ptr[1] == '.')
+               {
+               ptr += 2;
+
+               for (uint32_t mul = 100; mul && ptr < end && u__isdigit(*ptr); mul /= 10) qvalue += (*ptr++ - '0') * mul;
+               }
+
+            continue;
+            }
+
+         ++ptr;
+         }
+
+      U_INTERNAL_DUMP("coding = %.*S qvalue = %u", len, token, qvalue)
+
+           if (len == 1 && *token == '*')                                         { wildcard = qvalue; continue; }
+           if (len == 2 && u__strncasecmp(token,   "br", 2) == 0)                   encoding = U_ENCODING_BROTLI;
+      else if (len == 4 && u__strncasecmp(token, "zstd", 4) == 0)                   encoding = U_ENCODING_ZSTD;
+      else if ((len == 4 && u__strncasecmp(token,   "gzip", 4) == 0) ||
+               (len == 6 && u__strncasecmp(token, "x-gzip", 6) == 0))               encoding = U_ENCODING_GZIP;
+      else continue;
+
+      listed[encoding]          = true;
+      accept_encoding[encoding] = qvalue;
+      }
+
+   if (wildcard > 0)
+      {
+      for (encoding = U_ENCODING_GZIP; encoding < U_ENCODING_NUM; ++encoding)
+         {
+         if (listed[encoding] == false) accept_encoding[encoding] = wildcard;
+         }
+      }
+
+#ifdef USE_LIBZ
+   if (accept_encoding[U_ENCODING_GZIP])
+      {
+      U_http_is_accept_gzip = '1';
+
+      U_INTERNAL_DUMP("U_http_is_accept_gzip = %C", U_http_is_accept_gzip)
+      }
+#endif
+}
+
+bool UHTTP::callInitForAllUSP(UStringRep* key, void* value)
+{
+   U_TRACE(0, "UHTTP::callInitForAllUSP(%V,%p)", key, value)
+
+   U_INTERNAL_ASSERT_POINTER(value)
+
+   UHTTP::UFileCacheData* cptr = (UHTTP::UFileCacheData*)value;
+
+   if (cptr->ptr           &&
+       cptr->link == false &&
+       cptr->mime_index == U_usp)
+      {
+      UServletPage* usp_page = (UServletPage*)cptr->ptr;
+
+      U_INTERNAL_DUMP("usp_page->runDynamicPage = %p", usp_page->runDynamicPage)
+
+#  ifdef DEBUG
+      if (usp_page->runDynamicPage)
+#  endif
+      usp_page->runDynamicPage(U_DPAGE_INIT);
+      }
+
+   U_RETURN(true);
+}
+
+bool UHTTP::callEndForAllUSP(UStringRep* key, void* value)
+{
+   U_TRACE(0, "UHTTP::callEndForAllUSP(%V,%p)", key, value)
+
+   U_INTERNAL_ASSERT_POINTER(value)
+   U_INTERNAL_ASSERT(bcallInitForAllUSP)
+
+   UHTTP::UFileCacheData* cptr = (UHTTP::UFileCacheData*)value;
+
+   if (cptr->ptr           &&
+       cptr->link == false &&
+       cptr->mime_index == U_usp)
+      {
+      UServletPage* usp_page = (UServletPage*)cptr->ptr;
+
+      U_INTERNAL_DUMP("usp_page->runDynamicPage = %p", usp_page->runDynamicPage)
+
+#  ifdef DEBUG
       if (usp_page->runDynamicPage)
 #  endif
       usp_page->runDynamicPage(U_DPAGE_DESTROY);
@@ -7392,6 +8497,8 @@ U_NO_EXPORT void UHTTP::manageDataForCache()
             file_data->mime_index = mime_index;
 
             putDataInCache(getHeaderMimeType(content.data(), 0, ctype, U_TIME_FOR_EXPIRE), content);
+
+            if (cache_file_memory_max) admitFileDataInCache();
             }
          }
 
@@ -7615,62 +8722,543 @@ void UHTTP::checkFileInCache(const char* path, uint32_t len)
       }
 }
 
-void UHTTP::renewFileDataInCache()
+void UHTTP::renewFileDataInCache()
+{
+   U_TRACE(0, "UHTTP::renewFileDataInCache()")
+
+   U_ASSERT_EQUALS(file_data, cache_file->elem())
+
+   // NB: we need to do this before call eraseAfterFind()...
+
+   int fd                = file_data->fd;
+   const UStringRep* key = cache_file->key();
+
+   if (fd != -1) UFile::close(fd);
+
+   U_INTERNAL_DUMP("file_data->fd = %d cache_file->key = %V", file_data->fd, key)
+
+   pathname->setBuffer(key->size());
+
+   pathname->snprintf("%v", key);
+
+   U_DEBUG("renewFileDataInCache() called for file: %V - inotify %s enabled, expired=%b", pathname->rep, UServer_Base::handler_inotify ? "is" : "NOT", (u_now->tv_sec > file_data->expire));
+
+   cache_file_shared_idx = file_data->shared; // NB: the new entry take the same place in the shared file cache...
+
+   cache_file->eraseAfterFind();
+
+   checkFileForCache();
+
+   if (file->st_ino) // stat() ok...
+      {
+      if (fd != -1 &&
+          file->open())
+         {
+         file_data->fd = file->fd;
+         }
+
+      // NB: if we have rebuilt the entry we publish it in the shared file cache, so that the other processes can attach it...
+
+      if (file_data->array      &&
+          file_data->shared != -1 &&
+          file_data->generation == 0)
+         {
+         putFileDataInCacheShared(pathname->rep);
+         }
+      }
+
+   cache_file_shared_idx = -1;
+
+   U_INTERNAL_DUMP("file_data->array = %p", file_data->array)
+}
+
+UString UHTTP::getDataFromCache(int idx)
+{
+   U_TRACE(0, "UHTTP::getDataFromCache(%d)", idx)
+
+   U_INTERNAL_ASSERT_POINTER(file_data)
+
+   U_INTERNAL_DUMP("u_now->tv_sec     = %#3D", u_now->tv_sec)
+   U_INTERNAL_DUMP("file_data->expire = %#3D", file_data->expire)
+
+   UString result;
+
+   if (u_now->tv_sec > file_data->expire ||
+       isCacheFileSharedChanged()) // NB: another process has published a new version of the entry...
+      {
+      renewFileDataInCache();
+      }
+
+   U_INTERNAL_ASSERT_MINOR(idx, U_ENCODING_NUM * 2)
+
+   if (file_data->array &&
+       file_data->array->size() > (uint32_t)idx) // NB: the entry can be renewed without the compressed variant...
+      {
+      if (file_data->generation == 0) result = file_data->array->operator[](idx);
+      else
+         {
+         // NB: we don't touch the reference count of the string of the shared entry (it would be a write on a page shared with the other processes)...
+
+         UStringRep* r = file_data->array->getStringRep(idx);
+
+         if (r->size()) result = UString(r->data(), r->size());
+         }
+      }
+
+   U_RETURN_STRING(result);
+}
+
+// MEMORY BUDGET OF THE FILE CACHE
+
+/**
+ * TinyLFU (https://arxiv.org/abs/1512.00727): we keep an approximate frequency of the requests in a count-min sketch (4 rows of 4 bit counters,
+ * halved every 10 * width increments so that the old history fades) and a new entry is admitted in memory only if its frequency is greater than
+ * the one of the entry that should be evicted. The entries in memory are kept in a segmented LRU: a new entry is inserted in the probation segment
+ * and it is promoted to the protected segment (80% of the budget) when it is requested again, so that a scan of cold files don't flush the hot ones
+ */
+
+static const uint32_t sketch_seed[U_SKETCH_ROWS] = { 0x9e3779b1, 0x85ebca77, 0xc2b2ae3d, 0x27d4eb2f };
+
+U_NO_EXPORT uint32_t UHTTP::getFrequencyFromSketch(uint32_t hash)
+{
+   U_TRACE(0, "UHTTP::getFrequencyFromSketch(%u)", hash)
+
+   U_INTERNAL_ASSERT_POINTER(cache_file_sketch)
+
+   uint32_t i, freq = 15;
+
+   for (i = 0; i < U_SKETCH_ROWS; ++i)
+      {
+      uint8_t c = cache_file_sketch[(i << cache_file_sketch_bits) + ((hash * sketch_seed[i]) >> (32 - cache_file_sketch_bits))];
+
+      if (c < freq) freq = c;
+      }
+
+   U_RETURN(freq);
+}
+
+U_NO_EXPORT void UHTTP::incrementFrequencyInSketch(uint32_t hash)
+{
+   U_TRACE(0, "UHTTP::incrementFrequencyInSketch(%u)", hash)
+
+   U_INTERNAL_ASSERT_POINTER(cache_file_sketch)
+
+   uint32_t i, n;
+
+   for (i = 0; i < U_SKETCH_ROWS; ++i)
+      {
+      uint8_t* c = cache_file_sketch + (i << cache_file_sketch_bits) + ((hash * sketch_seed[i]) >> (32 - cache_file_sketch_bits));
+
+      if (*c < 15) ++(*c);
+      }
+
+   if (++cache_file_sketch_count >= (10U << cache_file_sketch_bits)) // NB: aging...
+      {
+      for (i = 0, n = (U_SKETCH_ROWS << cache_file_sketch_bits); i < n; ++i) cache_file_sketch[i] >>= 1;
+
+      cache_file_sketch_count /= 2;
+      }
+}
+
+U_NO_EXPORT void UHTTP::insertFileDataInLRU(UFileCacheData* ptr, int segment)
+{
+   U_TRACE(0, "UHTTP::insertFileDataInLRU(%p,%d)", ptr, segment)
+
+   U_INTERNAL_ASSERT_POINTER(ptr)
+   U_INTERNAL_ASSERT_MAJOR(ptr->nbytes, 0)
+   U_INTERNAL_ASSERT_EQUALS(ptr->prev, 0)
+   U_INTERNAL_ASSERT_EQUALS(ptr->next, 0)
+
+   ptr->segment = segment;
+   ptr->next    = cache_file_lru_head[segment];
+
+   if (ptr->next) ptr->next->prev = ptr;
+   else           cache_file_lru_tail[segment] = ptr;
+
+   cache_file_lru_head[segment] = ptr;
+
+   cache_file_memory               += ptr->nbytes;
+   cache_file_lru_memory[segment] += ptr->nbytes;
+
+   U_INTERNAL_DUMP("cache_file_memory = %u cache_file_lru_memory = { %u %u }", cache_file_memory, cache_file_lru_memory[0], cache_file_lru_memory[1])
+}
+
+U_NO_EXPORT void UHTTP::removeFileDataFromLRU(UFileCacheData* ptr)
+{
+   U_TRACE(0, "UHTTP::removeFileDataFromLRU(%p)", ptr)
+
+   U_INTERNAL_ASSERT_POINTER(ptr)
+   U_INTERNAL_ASSERT_MAJOR(ptr->nbytes, 0)
+
+   int segment = ptr->segment;
+
+   if (ptr->prev) ptr->prev->next = ptr->next;
+   else           cache_file_lru_head[segment] = ptr->next;
+
+   if (ptr->next) ptr->next->prev = ptr->prev;
+   else           cache_file_lru_tail[segment] = ptr->prev;
+
+   ptr->prev = ptr->next = 0;
+
+   cache_file_memory               -= ptr->nbytes;
+   cache_file_lru_memory[segment] -= ptr->nbytes;
+}
+
+U_NO_EXPORT void UHTTP::evictFileDataFromCache(UFileCacheData* ptr)
+{
+   U_TRACE(0, "UHTTP::evictFileDataFromCache(%p)", ptr)
+
+   U_INTERNAL_ASSERT_POINTER(ptr)
+   U_INTERNAL_ASSERT_POINTER(ptr->array)
+
+   if (ptr->nbytes)
+      {
+      removeFileDataFromLRU(ptr);
+
+      ptr->nbytes = 0;
+
+      if (UServer_Base::ptr_shared_data) U_SRV_STAT_ADD(cnt_file_evict, 1);
+      }
+
+   delete ptr->array;
+
+   ptr->array   = 0;
+   ptr->evicted = true; // NB: from now the file is served with sendfile() (or read())...
+}
+
+U_NO_EXPORT void UHTTP::admitFileDataInCache()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP::admitFileDataInCache()")
+
+   U_INTERNAL_ASSERT_POINTER(file_data)
+   U_INTERNAL_ASSERT_MAJOR(cache_file_memory_max, 0)
+
+   if (file_data->array == 0             ||
+       file_data->generation             || // NB: the data in shared memory are not part of the memory budget...
+       file_data->array->size() < 2      ||
+       u_is_ssi(file_data->mime_index))     // NB: mod_ssi need the content in memory...
+      {
+      return;
+      }
+
+   if (cache_file_sketch == 0)
+      {
+      uint32_t n = U_max(cache_file->capacity(), 512U);
+
+      for (cache_file_sketch_bits = 10; cache_file_sketch_bits < 20 && (1U << cache_file_sketch_bits) < (n * 2); ++cache_file_sketch_bits) {}
+
+      cache_file_sketch = (uint8_t*) UMemoryPool::_malloc(U_SKETCH_ROWS << cache_file_sketch_bits, 1, true);
+      }
+
+   UFileCacheData* victim;
+   uint32_t i, n = file_data->array->size(), nbytes = 0;
+
+   for (i = 0; i < n; ++i) nbytes += file_data->array->getStringRep(i)->size();
+
+   file_data->hash = u_hash((unsigned char*)pathname->data(), pathname->size());
+
+   U_INTERNAL_DUMP("nbytes = %u cache_file_memory = %u cache_file_memory_max = %u cache_file_admit = %b", nbytes, cache_file_memory, cache_file_memory_max, cache_file_admit)
+
+   while ((cache_file_memory + nbytes) > cache_file_memory_max)
+      {
+      victim = (cache_file_lru_tail[0] ? cache_file_lru_tail[0] : cache_file_lru_tail[1]);
+
+      if (victim == 0                       ||
+          nbytes > cache_file_memory_max    ||
+          (cache_file_admit == false        &&
+           getFrequencyFromSketch(file_data->hash) <= getFrequencyFromSketch(victim->hash)))
+         {
+         U_SRV_LOG("File not cached: %V - %u bytes - memory budget of the cache (%u bytes) exceeded", pathname->rep, nbytes, cache_file_memory_max);
+
+         evictFileDataFromCache(file_data);
+
+         return;
+         }
+
+      evictFileDataFromCache(victim);
+      }
+
+   file_data->nbytes = nbytes;
+
+   insertFileDataInLRU(file_data, 0);
+}
+
+void UHTTP::checkFileDataForMemoryBudget()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP::checkFileDataForMemoryBudget()")
+
+   U_INTERNAL_ASSERT_POINTER(file_data)
+   U_INTERNAL_ASSERT_MAJOR(cache_file_memory_max, 0)
+
+   U_INTERNAL_DUMP("file_data->nbytes = %u file_data->evicted = %b", file_data->nbytes, file_data->evicted)
+
+   if (file_data->nbytes)
+      {
+      U_SRV_STAT_ADD(cnt_file_hit, 1);
+
+      incrementFrequencyInSketch(file_data->hash);
+
+      // NB: the entry is moved at the head of the protected segment, and the least recently used of this go back in probation...
+
+      removeFileDataFromLRU(file_data);
+      insertFileDataInLRU(file_data, 1);
+
+      while (cache_file_lru_memory[1] > (cache_file_memory_max / 5) * 4 &&
+             cache_file_lru_tail[1] != file_data)
+         {
+         UFileCacheData* ptr = cache_file_lru_tail[1];
+
+         removeFileDataFromLRU(ptr);
+         insertFileDataInLRU(ptr, 0);
+         }
+      }
+   else if (file_data->evicted)
+      {
+      U_SRV_STAT_ADD(cnt_file_miss, 1);
+
+      incrementFrequencyInSketch(file_data->hash);
+
+      UFileCacheData* victim = (cache_file_lru_tail[0] ? cache_file_lru_tail[0] : cache_file_lru_tail[1]);
+
+      if ((cache_file_memory + file_data->size) <= cache_file_memory_max ||
+          (victim &&
+           getFrequencyFromSketch(file_data->hash) > getFrequencyFromSketch(victim->hash)))
+         {
+         // NB: the file come back in memory (the entry is rebuilt, the victims are evicted by admitFileDataInCache())...
+
+         cache_file_admit = true;
+
+         renewFileDataInCache();
+
+         cache_file_admit = false;
+         }
+      }
+}
+
+// SHARED FILE CACHE
+
+void UHTTP::setCacheFileShared()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP::setCacheFileShared()")
+
+   U_INTERNAL_ASSERT(cache_file_shared)
+   U_INTERNAL_ASSERT_POINTER(cache_file)
+   U_INTERNAL_ASSERT_EQUALS(cache_file_shared_ptr, 0)
+
+   cache_file_shared_num  =
+   cache_file_shared_size = 0;
+
+   cache_file->callForAllEntry(countFileDataForCacheShared);
+
+   U_INTERNAL_DUMP("cache_file_shared_num = %u cache_file_shared_size = %u", cache_file_shared_num, cache_file_shared_size)
+
+   if (cache_file_shared_num)
+      {
+      // NB: the data area is append only, so we reserve some space for the entries renewed at runtime (inotify)...
+
+      if (UServer_Base::handler_inotify) cache_file_shared_size += U_max(cache_file_shared_size / 4, 1024U * 1024U);
+
+      cache_file_shared_ptr = UServer_Base::getOffsetToDataShare(sizeof(file_cache_shared_info) + (cache_file_shared_num * sizeof(file_cache_shared_entry)) + cache_file_shared_size);
+      }
+}
+
+void UHTTP::initCacheFileShared()
+{
+   U_TRACE_NO_PARAM(0, "UHTTP::initCacheFileShared()")
+
+   U_INTERNAL_ASSERT_POINTER(cache_file)
+   U_INTERNAL_ASSERT_POINTER(cache_file_shared_ptr)
+   U_INTERNAL_ASSERT_EQUALS(cache_file_shared_info, 0)
+
+   cache_file_shared_info = (file_cache_shared_info*) UServer_Base::getPointerToDataShare(cache_file_shared_ptr);
+
+   cache_file_shared_info->num_entry = cache_file_shared_num;
+   cache_file_shared_info->size      = cache_file_shared_size;
+   cache_file_shared_info->used      = 0;
+
+   cache_file_shared_num = 0; // NB: now it is the index of the next entry...
+
+   cache_file->callForAllEntry(moveFileDataInCacheShared);
+
+   file_data = 0;
+
+   U_SRV_LOG("Moved %u entries of the file cache in shared memory: %u bytes (%u KB) of data, %u bytes available for the renewed entries",
+               cache_file_shared_num, cache_file_shared_info->used, cache_file_shared_info->used / 1024, cache_file_shared_size - cache_file_shared_info->used);
+}
+
+U_NO_EXPORT bool UHTTP::countFileDataForCacheShared(UStringRep* key, void* value)
+{
+   U_TRACE(0, "UHTTP::countFileDataForCacheShared(%V,%p)", key, value)
+
+   U_INTERNAL_ASSERT_POINTER(value)
+
+   UHTTP::UFileCacheData* cptr = (UHTTP::UFileCacheData*)value;
+
+   if (cptr->array              &&
+       cptr->link == false      &&
+       cptr->array->size() >= 2) // NB: content, header...
+      {
+      ++cache_file_shared_num;
+
+      for (uint32_t i = 0, n = cptr->array->size(); i < n; ++i) cache_file_shared_size += (cptr->array->getStringRep(i)->size() + 7) & ~7U;
+      }
+
+   U_RETURN(true);
+}
+
+U_NO_EXPORT bool UHTTP::moveFileDataInCacheShared(UStringRep* key, void* value)
+{
+   U_TRACE(0, "UHTTP::moveFileDataInCacheShared(%V,%p)", key, value)
+
+   U_INTERNAL_ASSERT_POINTER(value)
+
+   file_data = (UHTTP::UFileCacheData*)value;
+
+   if (file_data->array              &&
+       file_data->link == false      &&
+       file_data->array->size() >= 2 &&
+       cache_file_shared_num < cache_file_shared_info->num_entry)
+      {
+      file_data->shared = cache_file_shared_num++;
+
+      putFileDataInCacheShared(key);
+      }
+
+   U_RETURN(true);
+}
+
+U_NO_EXPORT void UHTTP::putFileDataInCacheShared(const UStringRep* key)
 {
-   U_TRACE(0, "UHTTP::renewFileDataInCache()")
+   U_TRACE(0, "UHTTP::putFileDataInCacheShared(%V)", key)
 
-   U_ASSERT_EQUALS(file_data, cache_file->elem())
+   U_INTERNAL_ASSERT_POINTER(file_data)
+   U_INTERNAL_ASSERT_POINTER(file_data->array)
+   U_INTERNAL_ASSERT_DIFFERS(file_data->shared, -1)
+   U_INTERNAL_ASSERT_EQUALS(file_data->generation, 0)
 
-   // NB: we need to do this before call eraseAfterFind()...
+   UStringRep* r;
+   char* data = getCacheFileSharedData();
+   file_cache_shared_entry* entry = getCacheFileSharedEntry(file_data->shared);
+   uint32_t i, n = file_data->array->size(), sz = 0, used, generation = __atomic_load_n(&(entry->generation), __ATOMIC_ACQUIRE);
 
-   int fd                = file_data->fd;
-   const UStringRep* key = cache_file->key();
+   U_INTERNAL_DUMP("generation = %u", generation)
 
-   if (fd != -1) UFile::close(fd);
+   // NB: if another process is writing the entry we keep our private copy...
 
-   U_INTERNAL_DUMP("file_data->fd = %d cache_file->key = %V", file_data->fd, key)
+   if ((generation & 1) != 0 ||
+       __atomic_compare_exchange_n(&(entry->generation), &generation, generation+1, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) == false)
+      {
+      return;
+      }
 
-   pathname->setBuffer(key->size());
+   for (i = 0; i < n; ++i) sz += (file_data->array->getStringRep(i)->size() + 7) & ~7U;
 
-   pathname->snprintf("%v", key);
+   used = __atomic_load_n(&(cache_file_shared_info->used), __ATOMIC_RELAXED);
 
-   U_DEBUG("renewFileDataInCache() called for file: %V - inotify %s enabled, expired=%b", pathname->rep, UServer_Base::handler_inotify ? "is" : "NOT", (u_now->tv_sec > file_data->expire));
+   do {
+      if ((used + sz) > cache_file_shared_info->size)
+         {
+         __atomic_store_n(&(entry->generation), generation, __ATOMIC_RELEASE);
 
-   cache_file->eraseAfterFind();
+         U_SRV_LOG("WARNING: shared file cache full (%u bytes), we keep a private copy of: %V", cache_file_shared_info->size, key);
 
-   checkFileForCache();
+         return;
+         }
+      }
+   while (__atomic_compare_exchange_n(&(cache_file_shared_info->used), &used, used+sz, false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED) == false);
 
-   if (fd != -1     &&
-       file->st_ino && // stat() ok...
-       file->open())
+   entry->num   = n;
+   entry->hash  = u_hash((unsigned char*)key->data(), key->size());
+   entry->etag  = file_data->etag;
+   entry->size  = file_data->size;
+   entry->mtime = file_data->mtime;
+
+   for (i = 0; i < n; ++i)
       {
-      file_data->fd = file->fd;
+      r = file_data->array->getStringRep(i);
+
+      entry->offset[i] = used;
+      entry->length[i] = r->size();
+
+      if (entry->length[i])
+         {
+         U_MEMCPY(data + used, r->data(), entry->length[i]);
+
+         used += (entry->length[i] + 7) & ~7U;
+         }
       }
 
-   U_INTERNAL_DUMP("file_data->array = %p", file_data->array)
+   __atomic_store_n(&(entry->generation), generation+2, __ATOMIC_RELEASE);
+
+   (void) getFileDataFromCacheShared(key); // NB: we release the private copy...
 }
 
-UString UHTTP::getDataFromCache(int idx)
+U_NO_EXPORT bool UHTTP::getFileDataFromCacheShared(const UStringRep* key)
 {
-   U_TRACE(0, "UHTTP::getDataFromCache(%d)", idx)
+   U_TRACE(0, "UHTTP::getFileDataFromCacheShared(%V)", key)
 
    U_INTERNAL_ASSERT_POINTER(file_data)
+   U_INTERNAL_ASSERT_DIFFERS(file_data->shared, -1)
 
-   U_INTERNAL_DUMP("u_now->tv_sec     = %#3D", u_now->tv_sec)
-   U_INTERNAL_DUMP("file_data->expire = %#3D", file_data->expire)
+   UVector<UString>* vec;
+   char* data = getCacheFileSharedData();
+   file_cache_shared_entry* entry = getCacheFileSharedEntry(file_data->shared);
+   uint32_t i, n, etag, generation = __atomic_load_n(&(entry->generation), __ATOMIC_ACQUIRE);
 
-   UString result;
+   U_INTERNAL_DUMP("generation = %u file_data->generation = %u", generation, file_data->generation)
+
+   if (generation == 0          ||
+       (generation & 1) != 0    || // NB: another process is writing the entry...
+       entry->size  != file_data->size  ||
+       entry->mtime != file_data->mtime ||
+       entry->hash  != u_hash((unsigned char*)key->data(), key->size()))
+      {
+      U_RETURN(false);
+      }
 
-   if (u_now->tv_sec > file_data->expire) renewFileDataInCache();
+   n    = entry->num;
+   etag = entry->etag;
 
-   if (file_data->array)
+   U_INTERNAL_ASSERT_RANGE(2, n, U_ENCODING_NUM * 2)
+
+   U_NEW_DBG(UVector<UString>, vec, UVector<UString>(U_ENCODING_NUM * 2));
+
+   for (i = 0; i < n; ++i)
       {
-      U_INTERNAL_ASSERT_MINOR(idx, 4)
+      if (entry->length[i] == 0) vec->push_back(UString::getStringNull());
+      else
+         {
+         UString x(data + entry->offset[i], entry->length[i]); // NB: the string point to the shared memory...
 
-      result = file_data->array->operator[](idx);
+         vec->push_back(x);
+         }
       }
 
-   U_RETURN_STRING(result);
+   // NB: we check that the entry is not changed while we are reading it...
+
+   __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+   if (__atomic_load_n(&(entry->generation), __ATOMIC_RELAXED) != generation)
+      {
+      delete vec;
+
+      U_RETURN(false);
+      }
+
+   if (file_data->nbytes) // NB: the data in shared memory are not part of the memory budget...
+      {
+      removeFileDataFromLRU(file_data);
+
+      file_data->nbytes = 0;
+      }
+
+   if (file_data->array) delete file_data->array;
+
+   file_data->etag       = etag;
+   file_data->array      = vec;
+   file_data->generation = generation;
+
+   U_RETURN(true);
 }
 
 U_NO_EXPORT bool UHTTP::processFileCache()
@@ -7679,25 +9267,39 @@ U_NO_EXPORT bool UHTTP::processFileCache()
 
    U_INTERNAL_ASSERT_POINTER(file_data)
 
-   if (checkGetRequestIfModified() == false) U_RETURN(true); // NB: we have already a response...
+   int encoding = getAcceptEncodingFromCache();
 
-#ifdef USE_LIBZ
-   if (U_http_is_accept_gzip &&
-       isDataCompressFromCache())
+   if (checkGetRequestForETag(encoding) == false ||
+       checkGetRequestIfModified()      == false)
+      {
+      if (encoding &&
+          U_http_info.nResponseCode == HTTP_NOT_MODIFIED)
+         {
+         addBytesSavedFromCache(encoding);
+         }
+
+      U_RETURN(true); // NB: we have already a response...
+      }
+
+   uint32_t sz;
+
+   if (encoding)
       {
-      U_http_is_accept_gzip = '2';
+      addBytesSavedFromCache(encoding);
 
-      *ext = getHeaderCompressFromCache();
+      *ext = getHeaderCompressFromCache(encoding);
 
-      *UClientImage_Base::body = getBodyCompressFromCache();
+      *UClientImage_Base::body = getBodyCompressFromCache(encoding);
+
+#  ifndef U_HTTP2_DISABLE
+      if (U_http_version == '2') UHTTP2::ext_from_cache = true; // NB: the HPACK encoded header block is reused...
+#  endif
 
       handlerResponse();
 
       U_RETURN(true);
       }
-#endif
 
-   uint32_t sz;
    bool result = true;
    *ext = getHeaderFromCache();
 
@@ -7714,7 +9316,7 @@ U_NO_EXPORT bool UHTTP::processFileCache()
    if (U_http_range_len &&
        checkGetRequestIfRange())
       {
-      if (checkGetRequestForRange(getBodyFromCache()) != U_PARTIAL) U_RETURN(true); // NB: we have a complete response...
+      if (checkGetRequestForRange(getBodyFromCache()) != U_PARTIAL) U_RETURN(U_http_sendfile == false); // NB: we have a complete response (or the parts are sent with sendfile())...
 
       // NB: range_start is modified only if we have as response U_PARTIAL from checkGetRequestForRange()...
 
@@ -7732,6 +9334,14 @@ U_NO_EXPORT bool UHTTP::processFileCache()
       U_http_sendfile = true;
       }
 
+#ifndef U_HTTP2_DISABLE
+   if (U_http_version == '2' &&
+       U_http_info.nResponseCode != HTTP_PARTIAL) // NB: with Content-Range the header is not the one of the cache...
+      {
+      UHTTP2::ext_from_cache = true;
+      }
+#endif
+
    handlerResponse();
 
    U_RETURN(result);
@@ -9299,7 +10909,7 @@ bool UHTTP::checkContentLength(uint32_t length, uint32_t pos)
    U_RETURN(false);
 }
 
-typedef struct { uint32_t start, end; } HTTPRange;
+typedef struct { uint32_t start, end, delimiter; } HTTPRange; // NB: delimiter is the offset of the delimiter of the part (multipart/byteranges)...
 
 /**
  * The Range: header is used with a GET request.
@@ -9344,12 +10954,25 @@ U_NO_EXPORT bool UHTTP::checkGetRequestIfRange()
       {
       if (*ptr == '"') // entity-tag
          {
-         uint32_t sz = etag->size();
+         if (file_data &&
+             file_data->etag)
+            {
+            // NB: If-Range require the strong comparison with the entity-tag of the identity content...
+
+            char buffer[U_ETAG_MAX_LEN];
+            uint32_t len = getETagFromCache(buffer, U_ENCODING_IDENTITY);
 
-         if (sz &&
-             etag->equal(ptr, sz) == false)
+            if (memcmp(ptr, buffer, len) != 0) U_RETURN(false);
+            }
+         else
             {
-            U_RETURN(false);
+            uint32_t sz = etag->size();
+
+            if (sz &&
+                etag->equal(ptr, sz) == false)
+               {
+               U_RETURN(false);
+               }
             }
          }
       else // HTTP-date
@@ -9378,7 +11001,7 @@ U_NO_EXPORT __pure int UHTTP::sortRange(const void* a, const void* b)
    U_INTERNAL_DUMP("ra->start = %u ra->end = %u", ra->start, ra->end)
    U_INTERNAL_DUMP("rb->start = %u rb->end = %u", rb->start, rb->end)
 
-   uint32_t diff = ra->start - rb->start;
+   int diff = (ra->start < rb->start ? -1 : ra->start > rb->start);
 
    U_RETURN(diff);
 }
@@ -9469,7 +11092,9 @@ U_NO_EXPORT int UHTTP::checkGetRequestForRange(const UString& data)
       {
       array.sort(sortRange);
 
-      for (i = 1, n = array.size(); i < n; ++i)
+      // NB: the overlapping (or adjacent) ranges are coalesced...
+
+      for (i = 1; i < n; )
          {
          cur  = array[i];
 
@@ -9478,18 +11103,20 @@ U_NO_EXPORT int UHTTP::checkGetRequestForRange(const UString& data)
          U_INTERNAL_DUMP("prev->start = %u prev->end = %u", prev->start, prev->end)
          U_INTERNAL_DUMP(" cur->start = %u  cur->end = %u",  cur->start,  cur->end)
 
-         if (cur->start <= prev->end)
+         if (cur->start > (prev->end + 1)) ++i;
+         else
             {
             prev->end = U_max(prev->end, cur->end);
 
             array.erase(i);
+
+            --n;
             }
          }
-
-      n = array.size();
       }
 
-   if (n == 0)
+   if (n == 0 ||
+       n > U_HTTP_MAX_RANGE) // NB: a lot of small ranges is a well known denial of service (RFC 7233 6.1)...
       {
       U_http_info.nResponseCode = HTTP_REQ_RANGE_NOT_OK;
 
@@ -9536,61 +11163,147 @@ U_NO_EXPORT int UHTTP::checkGetRequestForRange(const UString& data)
     *  ............
     *  --48af1db00244c25fa--
     * ------------------------------------------------------------
+    * NB: the parts are sent straight from data (the content in cache or the mmap of the file) or, if the response is big, with
+    *     sendfile() for each part (the delimiter of the next parts are written by UClientImage_Base::handlerWrite())...
+    * ------------------------------------------------------------
     */
 
-   char buffer[64];
-   char* ptr = buffer;
+   char* ptr;
+   const char* ctype;
+   char boundary[32];
+   uint32_t boundary_len, ctype_len, pos, sz, content_length = 0;
+
+   u_put_unalignedp32(boundary, U_MULTICHAR_CONSTANT32('U','L','i','b'));
+
+   boundary_len = 4 + u_num2str64(boundary+4, UServices::getUniqUID());
+
+   // NB: each part has the Content-Type of the entity, so we take it from the header of the response...
+
+   ctype     =                 "application/octet-stream";
+   ctype_len = U_CONSTANT_SIZE("application/octet-stream");
+
+   pos = U_STRING_FIND(*ext, 0, "Content-Type: ");
+
+   if (pos != U_NOT_FOUND)
+      {
+      uint32_t end = U_STRING_FIND(*ext, pos, U_CRLF);
+
+      U_INTERNAL_ASSERT_DIFFERS(end, U_NOT_FOUND)
 
-   u_put_unalignedp64(ptr,   U_MULTICHAR_CONSTANT64('C','o','n','t','e','n','t','-'));
-   u_put_unalignedp64(ptr+8, U_MULTICHAR_CONSTANT64('L','e','n','g','t','h',':',' '));
+      pos += U_CONSTANT_SIZE("Content-Type: ");
 
-   ptr += U_CONSTANT_SIZE("Content-Length: ");
+      ctype     = ext->c_pointer(pos);
+      ctype_len = end - pos;
 
-   UMimeMultipartMsg response(U_CONSTANT_TO_PARAM("byteranges"), UMimeMultipartMsg::NONE,
-                              buffer, U_CONSTANT_SIZE("Content-Length: ") + u_num2str32(ptr, range_size), false);
+      U_INTERNAL_ASSERT_MINOR(ctype_len, 128)
+      }
+
+   UString header(U_CAPACITY), part(U_CAPACITY * 2);
 
    for (i = 0; i < n; ++i)
       {
       cur = array[i];
 
-      uint32_t start = cur->start,
-                _end = cur->end;
+      U_INTERNAL_ASSERT(cur->start <= cur->end)
+      U_INTERNAL_ASSERT_RANGE(cur->start,cur->end,range_size-1)
 
-      U_INTERNAL_ASSERT(start <= _end)
-      U_INTERNAL_ASSERT_RANGE(start,_end,range_size-1)
+      cur->delimiter = part.size();
 
-      ptr = buffer;
+      part.snprintf_add("\r\n--%.*s\r\nContent-Type: %.*s\r\nContent-Range: bytes %u-%u/%u\r\n\r\n",
+                        boundary_len, boundary, ctype_len, ctype, cur->start, cur->end, range_size);
 
-      u_put_unalignedp64(ptr,    U_MULTICHAR_CONSTANT64('C','o','n','t','e','n','t','-'));
-      u_put_unalignedp64(ptr+8,  U_MULTICHAR_CONSTANT64('R','a','n','g','e',':',' ','b'));
-      u_put_unalignedp32(ptr+16, U_MULTICHAR_CONSTANT32('y','t','e','s'));
+      content_length += cur->end - cur->start + 1;
+      }
+
+   pos = part.size();
+
+   part.snprintf_add("\r\n--%.*s--\r\n", boundary_len, boundary);
+
+   content_length += part.size();
+
+   U_INTERNAL_DUMP("content_length = %u UServer_Base::min_size_for_sendfile = %u", content_length, UServer_Base::min_size_for_sendfile)
 
-       ptr  += U_CONSTANT_SIZE("Content-Range: bytes");
-      *ptr++ = ' ';
-       ptr  += u_num2str32(ptr, start);
-      *ptr++ = '-';
-       ptr  += u_num2str32(ptr, _end);
-      *ptr++ = '/';
-       ptr  += u_num2str32(ptr, range_size);
+   // NB: we replace Content-Type and Content-Length of the entity in the header of the response...
 
-      response.add(UMimeMultipartMsg::section(data.substr(start, _end - start + 1),
-                                              U_CTYPE_HTML, U_CONSTANT_SIZE(U_CTYPE_HTML),
-                                              UMimeMultipartMsg::NONE, "", "",
-                                              buffer, ptr - buffer));
+   sz  = ext->size();
+   ptr = ext->data();
+
+   for (const char* end = ptr + sz; ptr < end; ptr = (char*)memchr(ptr, '\n', end - ptr) + 1)
+      {
+      if (u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("Content-Type:"))   == 0 ||
+          u__strncasecmp(ptr, U_CONSTANT_TO_PARAM("Content-Length:")) == 0)
+         {
+         continue;
+         }
+
+      if (u_get_unalignedp16(ptr) == U_MULTICHAR_CONSTANT16('\r','\n')) break;
+
+      (void) header.append(ptr, (const char*)memchr(ptr, '\n', end - ptr) + 1 - ptr);
       }
 
-   ext->clear();
+   header.snprintf_add("Content-Type: multipart/byteranges; boundary=%.*s\r\n"
+                       "Content-Length: %u\r\n\r\n", boundary_len, boundary, content_length);
 
-   uint32_t content_length = response.message(*ext, false);
+   *ext = header;
 
-   (void) checkContentLength(content_length, U_NOT_FOUND);
+   U_INTERNAL_DUMP("ext = %V", ext->rep)
 
-#ifdef DEBUG
-   (void) UFile::writeToTmp(U_STRING_TO_PARAM(*ext), false, "byteranges.%P", 0);
-#endif
+   UClientImage_Base::setRequestNoCache();
 
    U_http_info.nResponseCode = HTTP_PARTIAL;
 
+#ifndef U_HTTP2_DISABLE
+   if (U_http_version != '2') // NB: with HTTP/2 we don't use sendfile()...
+#endif
+   {
+   if (content_length >= UServer_Base::min_size_for_sendfile)
+      {
+      // NB: we send with the header the first delimiter, after the first range of the file we continue with the next parts...
+
+      sendfile_part->setBuffer(part.size() + (n * 16));
+
+      for (i = 1; i < n; ++i)
+         {
+         cur = array[i];
+
+         sz = (i+1 < n ? array[i+1]->delimiter : pos) - cur->delimiter;
+
+         UClientImage_Base::addSendfilePart(*sendfile_part, cur->start, cur->end - cur->start + 1, part.c_pointer(cur->delimiter), sz);
+         }
+
+      UClientImage_Base::addSendfilePart(*sendfile_part, 0, 0, part.c_pointer(pos), part.size() - pos);
+
+      U_http_sendfile = true;
+
+      range_start = array[0]->start;
+      range_size  = array[0]->end - range_start + 1;
+
+      *UClientImage_Base::body = part.substr(0U, array[1]->delimiter);
+
+      handlerResponse();
+
+      U_RETURN(U_YES);
+      }
+   }
+
+   UString body(content_length);
+
+   for (i = 0; i < n; ++i)
+      {
+      cur = array[i];
+
+      sz = (i+1 < n ? array[i+1]->delimiter : pos) - cur->delimiter;
+
+      (void) body.append(part.c_pointer(cur->delimiter), sz);
+      (void) body.append(data.c_pointer(cur->start), cur->end - cur->start + 1);
+      }
+
+   (void) body.append(part.c_pointer(pos), part.size() - pos);
+
+   U_INTERNAL_ASSERT_EQUALS(body.size(), content_length)
+
+   *UClientImage_Base::body = body;
+
    handlerResponse();
 
    U_RETURN(U_YES);
@@ -9598,6 +11311,126 @@ U_NO_EXPORT int UHTTP::checkGetRequestForRange(const UString& data)
 
 #define U_NO_If_Unmodified_Since // I think it's not very much used...
 
+U_NO_EXPORT __pure bool UHTTP::findETag(const char* ptr, uint32_t sz, const char* tag, uint32_t len, bool weak)
+{
+   U_TRACE(0, "UHTTP::findETag(%.*S,%u,%.*S,%u,%b)", sz, ptr, sz, len, tag, len, weak)
+
+   bool bweak;
+   const char* end = ptr + sz;
+
+   while (true)
+      {
+      while (ptr < end &&
+             (*ptr == ',' || u__isspace(*ptr)))
+         {
+         ++ptr;
+         }
+
+      if (ptr >= end) break;
+
+      if (*ptr == '*') U_RETURN(true);
+
+      bweak = false;
+
+      if (           ptr[0] == 'W' &&
+          (ptr+1) < end            &&
+                     ptr[1] == '/')
+         {
+         bweak = true;
+
+         ptr += 2;
+         }
+
+      // NB: with the strong comparison a weak entity-tag never match...
+
+      if ((weak || bweak == false)         &&
+          (uint32_t)(end - ptr) >= len     &&
+          memcmp(ptr, tag, len) == 0)
+         {
+         U_RETURN(true);
+         }
+
+      // NB: the entity-tag is a quoted string, so we skip it before to search the separator...
+
+      if (*ptr == '"')
+         {
+         ptr = (const char*) memchr(ptr+1, '"', end-ptr-1);
+
+         if (ptr == 0) break;
+
+         ++ptr;
+         }
+
+      while (ptr < end && *ptr != ',') ++ptr;
+      }
+
+   U_RETURN(false);
+}
+
+U_NO_EXPORT bool UHTTP::checkGetRequestForETag(int encoding)
+{
+   U_TRACE(0, "UHTTP::checkGetRequestForETag(%d)", encoding)
+
+   U_INTERNAL_ASSERT_POINTER(file_data)
+
+   U_INTERNAL_DUMP("file_data->etag = %u U_http_info.if_match_len = %u U_http_info.if_none_match_len = %u",
+                    file_data->etag,     U_http_info.if_match_len,     U_http_info.if_none_match_len)
+
+   if (file_data->etag == 0 ||
+       (U_http_info.if_match_len      == 0 &&
+        U_http_info.if_none_match_len == 0))
+      {
+      U_RETURN(true);
+      }
+
+   char buffer[U_ETAG_MAX_LEN];
+   uint32_t len = getETagFromCache(buffer, encoding);
+
+   /**
+    * The If-Match: header make the request conditional: if none of the listed entity-tags match (strong comparison) the current entity-tag
+    * of the resource we return a "412 Precondition Failed" response. The If-None-Match: header is used by the browser to revalidate a cached
+    * entity: if one of the listed entity-tags match (weak comparison) the current one we return a "304 Not Modified" response, like
+    *
+    * HTTP/1.1 304 Not Modified
+    * Date: Fri, 31 Dec 1999 23:59:59 GMT
+    * [blank line here]
+    */
+
+   if (U_http_info.if_match_len &&
+       findETag(U_http_info.if_match, U_http_info.if_match_len, buffer, len, false) == false)
+      {
+      U_http_info.nResponseCode = HTTP_PRECON_FAILED;
+
+      setResponse(0, 0);
+
+      U_RETURN(false);
+      }
+
+   if (U_http_info.if_none_match_len)
+      {
+      U_http_info.if_modified_since = 0; // NB: If-None-Match take precedence over If-Modified-Since (RFC 7232 3.3)...
+
+      if (findETag(U_http_info.if_none_match, U_http_info.if_none_match_len, buffer, len, true))
+         {
+         U_http_info.nResponseCode = HTTP_NOT_MODIFIED;
+
+         // NB: the 304 response must have the ETag header that would have been sent in a 200 response (RFC 7232 4.1)...
+
+         ext->setBuffer(U_CAPACITY);
+
+         addETagToHeader(*ext, encoding);
+
+         (void) ext->append(U_CONSTANT_TO_PARAM(U_CRLF));
+
+         handlerResponse();
+
+         U_RETURN(false);
+         }
+      }
+
+   U_RETURN(true);
+}
+
 U_NO_EXPORT bool UHTTP::checkGetRequestIfModified()
 {
    U_TRACE_NO_PARAM(0, "UHTTP::checkGetRequestIfModified()")
@@ -9685,11 +11518,13 @@ U_NO_EXPORT void UHTTP::processGetRequest()
 
    if (U_http_sendfile)
       {
-      U_INTERNAL_ASSERT(range_size >= UServer_Base::min_size_for_sendfile)
+      U_INTERNAL_ASSERT(range_size >= UServer_Base::min_size_for_sendfile || *sendfile_part)
 
       goto sendfile;
       }
 
+   sendfile_part->clear(); // NB: the parts of a multipart/byteranges response from the cache not sent (error)...
+
    if (file->memmap(PROT_READ, &mmap) == false) goto error;
 
    if (file_data != file_not_in_cache_data)
@@ -9726,7 +11561,12 @@ U_NO_EXPORT void UHTTP::processGetRequest()
       //
       // Range: bytes=0-31
 
-      if (checkGetRequestForRange(mmap) != U_PARTIAL) return; // NB: we have already a complete response...
+      if (checkGetRequestForRange(mmap) != U_PARTIAL)
+         {
+         if (U_http_sendfile) goto sendfile; // NB: multipart/byteranges, the parts are sent with sendfile()...
+
+         return; // NB: we have already a complete response...
+         }
 
       U_http_info.nResponseCode = HTTP_PARTIAL;
 
@@ -9788,6 +11628,13 @@ next:
 sendfile:
       UClientImage_Base::setSendfile(file->fd, range_start, range_size);
 
+      if (*sendfile_part)
+         {
+         UClientImage_Base::setSendfilePart(*sendfile_part);
+
+         sendfile_part->clear();
+         }
+
       return;
       }
 
@@ -9983,6 +11830,7 @@ U_EXPORT istream& operator>>(istream& is, UHTTP::UFileCacheData& d)
             d.ptr        = ptr_file_data;
             d.mime_index = ptr_file_data->mime_index;
             d.size       = ptr_file_data->size;
+            d.etag       = ptr_file_data->etag;
             d.mtime      = ptr_file_data->mtime;
             d.expire     = ptr_file_data->expire;
 
@@ -10018,15 +11866,15 @@ U_EXPORT istream& operator>>(istream& is, UHTTP::UFileCacheData& d)
             {
             sb->sputbackc(c);
 
-            UVector<UString> vec(4U);
+            UVector<UString> vec(UHTTP::U_ENCODING_NUM * 2);
 
             is >> vec;
 
-            // content, header, gzip(content, header)
+            // content, header, gzip(content, header), brotli(content, header), zstd(content, header)
 
             if (vec.empty() == false)
                {
-               U_NEW_DBG(UVector<UString>, d.array, UVector<UString>(4U));
+               U_NEW_DBG(UVector<UString>, d.array, UVector<UString>(UHTTP::U_ENCODING_NUM * 2));
 
                UString encoded, decoded;
 
@@ -10057,6 +11905,10 @@ U_EXPORT istream& operator>>(istream& is, UHTTP::UFileCacheData& d)
                   }
 #           endif
 
+               // NB: the strong ETag is the hash of the content, so it is the same of the one present in the stored header...
+
+               if (u_is_ssi(d.mime_index) == false) d.etag = u_hash((unsigned char*)decoded.data(), decoded.size());
+
                d.array->push_back(decoded);
 
                // header
@@ -10068,11 +11920,24 @@ U_EXPORT istream& operator>>(istream& is, UHTTP::UFileCacheData& d)
 
                d.array->push_back(decoded);
 
-               encoded = vec[2];
-
-               if (encoded)
+               for (uint32_t i = 2, n = vec.size(); (i+1) < n; i += 2)
                   {
-                  // gzip(content)
+                  encoded = vec[i];
+
+                  if (encoded.empty())
+                     {
+                     // NB: missing variant (we fill the slot only if there are others variants after it)...
+
+                     if ((i+3) < n)
+                        {
+                        d.array->push_back(UString::getStringNull());
+                        d.array->push_back(UString::getStringNull());
+                        }
+
+                     continue;
+                     }
+
+                  // compress(content)
 
                   decoded.setBuffer(encoded.size());
 
@@ -10080,9 +11945,9 @@ U_EXPORT istream& operator>>(istream& is, UHTTP::UFileCacheData& d)
 
                   d.array->push_back(decoded);
 
-                  // gzip(header)
+                  // compress(header)
 
-                  encoded = vec[3];
+                  encoded = vec[i+1];
                   decoded.setBuffer(encoded.size());
 
                   UEscape::decode(encoded, decoded);
@@ -10126,7 +11991,7 @@ U_EXPORT ostream& operator<<(ostream& os, const UHTTP::UFileCacheData& d)
       os.put(' ');
       os.put('(');
 
-      if (d.array && // content, header, gzip(content, header)
+      if (d.array && // content, header, gzip(content, header), brotli(content, header), zstd(content, header)
           d.size < (64 * 1024))
          {
          U_INTERNAL_ASSERT_EQUALS(d.ptr, 0)
@@ -10160,21 +12025,31 @@ U_EXPORT ostream& operator<<(ostream& os, const UHTTP::UFileCacheData& d)
          if (d.array->size() == 2) os.write(U_CONSTANT_TO_PARAM("\n\"\"\n\"\"\n"));
          else
             {
-            str = d.array->at(2); // gzip(content)
+            for (uint32_t i = 2, n = d.array->size(); i < n; i += 2)
+               {
+               str = d.array->at(i); // compress(content)
+
+               if (str.empty())
+                  {
+                  os.write(U_CONSTANT_TO_PARAM("\n\"\"\n\"\"\n"));
 
-            pos = u_base64_encode((const unsigned char*)U_STRING_TO_PARAM(str), (unsigned char*)buffer);
+                  continue;
+                  }
 
-            os.put('\n');
-            os.write(buffer, pos);
-            os.put('\n');
+               pos = u_base64_encode((const unsigned char*)U_STRING_TO_PARAM(str), (unsigned char*)buffer);
 
-            str = d.array->at(3); // gzip(header)
+               os.put('\n');
+               os.write(buffer, pos);
+               os.put('\n');
 
-            pos = u_escape_encode((const unsigned char*)U_STRING_TO_PARAM(str), buffer, sizeof(buffer));
+               str = d.array->at(i+1); // compress(header)
 
-            os.put('\n');
-            os.write(buffer, pos);
-            os.put('\n');
+               pos = u_escape_encode((const unsigned char*)U_STRING_TO_PARAM(str), buffer, sizeof(buffer));
+
+               os.put('\n');
+               os.write(buffer, pos);
+               os.put('\n');
+               }
             }
          }
 
@@ -10228,9 +12103,15 @@ U_EXPORT const char* UHTTP::UFileCacheData::dump(bool reset) const
 {
    *UObjectIO::os << "wd                      " << wd            << '\n'
                   << "size                    " << size          << '\n'
+                  << "etag                    " << etag          << '\n'
                   << "mode                    " << mode          << '\n'
                   << "expire                  " << expire        << '\n'
                   << "mtime                   " << mtime         << '\n'
+                  << "shared                  " << shared        << '\n'
+                  << "generation              " << generation    << '\n'
+                  << "nbytes                  " << nbytes        << '\n'
+                  << "segment                 " << (int)segment  << '\n'
+                  << "evicted                 " << evicted       << '\n'
                   << "array (UVector<UString> " << (void*)&array << ')';
 
    if (reset)
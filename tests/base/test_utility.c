@@ -24,6 +24,93 @@
 
 static int compare_str(const void* str1, const void* str2) { return u_strnatcmp(*(const char**)str1, *(const char**)str2); }
 
+static void check_scan_header(uPFscanHeader pfn_scan)
+{
+   uhttpline vline[8];
+   uint32_t num, pos;
+
+   U_INTERNAL_TRACE("check_scan_header(%p)", pfn_scan)
+
+#  define U_HEADER "Host: localhost\r\nAccept: */*\r\nX-Dummy\r\nReferer: http://www.example.com/a:b\r\nUser-Agent: ApacheBench/2.3 (a very long value to fill a vector register)\r\n\r\n"
+
+   pos = pfn_scan(U_CONSTANT_TO_PARAM(U_HEADER), vline, 8, &num);
+
+   U_INTERNAL_ASSERT_EQUALS( pos, U_CONSTANT_SIZE(U_HEADER) )
+   U_INTERNAL_ASSERT_EQUALS( pos, u_findEndHeader1(U_CONSTANT_TO_PARAM("\r\n" U_HEADER)) - 2 )
+   U_INTERNAL_ASSERT_EQUALS( num, 5 )
+   U_INTERNAL_ASSERT_EQUALS( vline[0].colon, 4 )
+   U_INTERNAL_ASSERT_EQUALS( vline[0].end, 15 )
+   U_INTERNAL_ASSERT_EQUALS( vline[1].colon, 23 )
+   U_INTERNAL_ASSERT_EQUALS( vline[2].colon, U_NOT_FOUND )
+   U_INTERNAL_ASSERT_EQUALS( memcmp(U_HEADER+vline[3].colon, U_CONSTANT_TO_PARAM(": http://")), 0 )
+   U_INTERNAL_ASSERT_EQUALS( U_HEADER[vline[4].end], '\r' )
+
+   pos = pfn_scan(U_CONSTANT_TO_PARAM(U_HEADER), vline, 4, &num); /* more lines than max */
+
+   U_INTERNAL_ASSERT_EQUALS( pos, U_CONSTANT_SIZE(U_HEADER) )
+   U_INTERNAL_ASSERT_EQUALS( num, 0 )
+
+   pos = pfn_scan(U_HEADER, U_CONSTANT_SIZE(U_HEADER) - 1, vline, 8, &num); /* incomplete */
+
+   U_INTERNAL_ASSERT_EQUALS( pos, U_NOT_FOUND )
+
+   U_VAR_UNUSED(pos)
+
+#  undef U_HEADER
+}
+
+/* micro-benchmark: cycles per request to find the end of header and the lines (u_findEndHeader1() + scan byte-by-byte of every line) against u_scanHeader() */
+
+static inline uint64_t bench_clock(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+   return __builtin_ia32_rdtsc();
+#else
+   struct timespec ts;
+
+   (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+
+   return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+static void bench_scan_header(const char* name, uPFscanHeader pfn_scan, const char* buf, uint32_t sz, uint32_t loop)
+{
+   uhttpline vline[64];
+   const char* ptr;
+   const char* end;
+   uint64_t start;
+   uint32_t i, n, num, pos, nreq = 0;
+
+   start = bench_clock();
+
+   for (i = 0; i < loop; ++i)
+      {
+      for (ptr = buf, end = buf + sz; ptr < end; ptr += pos, ++nreq)
+         {
+         ptr = (const char*) memchr(ptr, '\n', end - ptr) + 1; /* skip the request line */
+
+         n = end - ptr;
+
+         if (pfn_scan) pos = pfn_scan(ptr, n, vline, 64, &num);
+         else
+            {
+            const char* p;
+
+            pos = u_findEndHeader1(ptr-2, n+2) - 2;
+
+            for (p = ptr; p < (ptr + pos - 2); p += 2)
+               {
+               while (*p != ':' && *p != '\r') ++p;
+               while (*p != '\r')              ++p;
+               }
+            }
+         }
+      }
+
+   printf("%-28s %llu cycles per request\n", name, (unsigned long long)((bench_clock() - start) / nreq));
+}
+
 static void check_match1(bPFpcupcud pfn_match)
 {
    U_INTERNAL_ASSERT( pfn_match(U_CONSTANT_TO_PARAM("01000000002345"),
@@ -303,6 +390,30 @@ int main(int argc, char* argv[])
 
    U_INTERNAL_TRACE("main(%d,%p)", argc, argv)
 
+   if (argc > 1 &&
+       strcmp(argv[1], "bench") == 0)
+      {
+      int fd = open(argc > 2 ? argv[2] : "inp/requests.http", O_RDONLY);
+      uint32_t sz = (fd != -1 ? read(fd, buf, sizeof(buf)) : 0), loop = (argc > 3 ? atoi(argv[3]) : 100000);
+
+      if (sz == 0 || sz == (uint32_t)-1) return 1;
+
+      bench_scan_header("u_findEndHeader1 + lines", 0,              buf, sz, loop);
+      bench_scan_header("u_scanHeader_c",           u_scanHeader_c, buf, sz, loop);
+#  ifdef U_SCAN_HEADER_SIMD
+      bench_scan_header("u_scanHeader_sse2",        u_scanHeader_sse2, buf, sz, loop);
+      if (u_scanHeader == u_scanHeader_avx2) bench_scan_header("u_scanHeader_avx2", u_scanHeader_avx2, buf, sz, loop);
+#  endif
+
+      return 0;
+      }
+
+   check_scan_header(u_scanHeader_c);
+   check_scan_header(u_scanHeader);
+#ifdef U_SCAN_HEADER_SIMD
+   check_scan_header(u_scanHeader_sse2);
+#endif
+
    U_INTERNAL_ASSERT( u__isdigit('1') )
    U_INTERNAL_ASSERT( u__ispunct('.') )
    U_INTERNAL_ASSERT( u__isprint('1') )
@@ -0,0 +1,57 @@
+#!/bin/sh
+
+. ../.function
+
+# Replay of the load of a page over HTTP/2 (nghttp fetches the page and the linked resources on one connection) and
+# report of the time to first byte (from the request to the first HEADERS frame received) for each class of resource: document, css/js, image, other
+
+rm -f err/http2_priority.err out/http2_priority.out \
+      out/userver_tcp.out err/userver_tcp.err \
+		trace.*userver_tcp*.[0-9]* object.*userver_tcp*.[0-9]* stack.*userver_tcp*.[0-9]*
+
+#UTRACE="0 30M 0"
+#UOBJDUMP="0 100k 10"
+#USIMERR="error.sim"
+ export UTRACE UOBJDUMP USIMERR
+
+URL=${1:-"http://localhost:8080/priority.html"}
+LOOP=${2:-10}
+
+DIR_CMD="../../examples/userver"
+
+start_prg_background userver_tcp -c benchmark/benchmarking.cfg
+
+i=0
+while [ $i -lt $LOOP ]; do
+	nghttp -nav "$URL" >>out/http2_priority.out 2>&1
+	i=`expr $i + 1`
+done
+
+awk '
+/ send HEADERS frame / {
+	match($0, /stream_id=[0-9]+/); id = substr($0, RSTART+10, RLENGTH-10)
+	start[id] = substr($0, 2, index($0, "]")-2) + 0
+	next
+}
+/^ +:path: / && id != "" { path[id] = $2; sent[id] = 1; id = ""; next }
+/ recv HEADERS frame / {
+	match($0, /stream_id=[0-9]+/); sid = substr($0, RSTART+10, RLENGTH-10)
+	if (sent[sid] == 1) {
+		t = substr($0, 2, index($0, "]")-2) - start[sid]
+		p = path[sid]
+		     if (p ~ /\.(css|js)(\?|$)/)                  c = "css/js"
+		else if (p ~ /\.(png|jpg|jpeg|gif|ico|webp)(\?|$)/) c = "image"
+		else if (p ~ /(\/|\.html?)(\?|$)/)                 c = "document"
+		else                                                c = "other"
+		sum[c] += t; cnt[c]++; if (t > max[c]) max[c] = t
+		sent[sid] = 0
+	}
+}
+END {
+	printf("%-10s %6s %12s %12s\n", "class", "count", "avg TTFB(ms)", "max TTFB(ms)")
+	for (c in cnt) printf("%-10s %6d %12.3f %12.3f\n", c, cnt[c], sum[c] * 1000 / cnt[c], max[c] * 1000)
+}' out/http2_priority.out
+
+kill_prg userver_tcp TERM
+
+mv err/userver_tcp.err err/http2_priority.err
@@ -1,6 +1,7 @@
 // test_timer.cpp
 
 #include <ulib/timer.h>
+#include <ulib/debug/crono.h>
 
 static char buffer[4096];
 
@@ -36,6 +37,8 @@ public:
       U_RETURN(-1);
       }
 
+   void setExpire() { UEventTime::setTimeToExpire(); }
+
 #if defined(U_STDCPP_ENABLE) && defined(DEBUG)
    const char* dump(bool _reset) const { return UEventTime::dump(_reset); }
 #endif
@@ -78,12 +81,101 @@ public:
 #endif
 };
 
+// micro-benchmark: timing wheel of UTimer against the sorted linked list (the previous implementation) with n live timers
+
+struct USortedEntry {
+   USortedEntry* next;
+   MyAlarm1* alarm;
+};
+
+static void bench(int n)
+{
+   U_TRACE(5, "bench(%d)", n)
+
+   int i;
+   UCrono crono;
+   MyAlarm1** vec = new MyAlarm1*[n];
+   USortedEntry* entry = new USortedEntry[n];
+
+   for (i = 0; i < n; ++i) vec[i] = U_NEW(MyAlarm1(1L + u_get_num_random(60), u_get_num_random(999999)));
+
+   crono.start();
+
+   for (i = 0; i < n; ++i) UTimer::insert(vec[i]);
+
+   crono.stop();
+
+   printf("UTimer (wheel): insert %d timers = %ld ms", n, crono.getTimeElapsed());
+
+   crono.start();
+
+   for (i = 0; i < n; ++i) UTimer::erase(vec[i]);
+
+   crono.stop();
+
+   printf(" erase = %ld ms\n", crono.getTimeElapsed());
+
+   USortedEntry* first = 0;
+
+   crono.start();
+
+   for (i = 0; i < n; ++i)
+      {
+      USortedEntry** ptr = &first;
+
+      (entry[i].alarm = vec[i])->setExpire();
+
+      while (*ptr && *((*ptr)->alarm) < *(entry[i].alarm)) ptr = &(*ptr)->next;
+
+      entry[i].next = *ptr;
+                      *ptr = entry+i;
+      }
+
+   crono.stop();
+
+   printf("sorted list:    insert %d timers = %ld ms", n, crono.getTimeElapsed());
+
+   crono.start();
+
+   for (i = 0; i < n; ++i)
+      {
+      for (USortedEntry** ptr = &first; *ptr; ptr = &(*ptr)->next)
+         {
+         if ((*ptr)->alarm == vec[i])
+            {
+            *ptr = (*ptr)->next;
+
+            break;
+            }
+         }
+      }
+
+   crono.stop();
+
+   printf(" erase = %ld ms\n", crono.getTimeElapsed());
+
+   for (i = 0; i < n; ++i) delete vec[i];
+
+   delete[] vec;
+   delete[] entry;
+}
+
 int U_EXPORT main (int argc, char* argv[])
 {
    U_ULIB_INIT(argv);
 
    U_TRACE(5,"main(%d)",argc)
 
+   if (argc > 1 &&
+       strcmp(argv[1], "bench") == 0)
+      {
+      UTimer::init(UTimer::NOSIGNAL);
+
+      bench(argc > 2 ? atoi(argv[2]) : 100000);
+
+      return 0;
+      }
+
    UTimer::init(UTimer::SYNC);
 
    UTimeVal s(0L, 50L * 1000L);